@@ -0,0 +1,186 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "exodus/consensushash.h"
+#include "exodus/exodus.h"
+#include "exodus/mdex.h"
+#include "exodus/tally.h"
+
+#include "arith_uint256.h"
+#include "chainparams.h"
+#include "sync.h"
+#include "tinyformat.h"
+#include "uint256.h"
+
+#include <boost/filesystem.hpp>
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace exodus;
+
+// Number of MetaDEx transactions in the replayed history
+static const int nReplayTransactions = 20000;
+// Number of traders
+static const int nReplayAddresses = 200;
+// Number of smart properties traded against EXODUS
+static const int nReplayProperties = 4;
+
+namespace {
+
+struct MetaDExTransaction {
+    enum Action { ADD, CANCEL_AT_PRICE, CANCEL_ALL_FOR_PAIR, CANCEL_EVERYTHING };
+
+    Action action;
+    std::string address;
+    int block;
+    unsigned int idx;
+    uint256 txid;
+    uint32_t property;
+    int64_t amount;
+    uint32_t desiredProperty;
+    int64_t desiredAmount;
+};
+
+/**
+ * A synthetic history of MetaDEx transactions: most transactions add orders within a narrow price
+ * band, which are partially filled by later orders, and the remaining ones cancel orders again.
+ */
+struct MetaDExReplay {
+    boost::filesystem::path path;
+    std::vector<std::string> addresses;
+    std::vector<MetaDExTransaction> transactions;
+    size_t nNext;
+
+    MetaDExReplay() : nNext(0) {
+        SelectParams(CBaseChainParams::REGTEST);
+
+        path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::create_directories(path);
+        t_tradelistdb = new CMPTradeList(path / "MP_tradelist", true);
+        p_txlistdb = new CMPTxList(path / "MP_txlist", true);
+
+        for (int i = 0; i < nReplayAddresses; i++) {
+            addresses.push_back(strprintf("a%033d", i));
+        }
+
+        uint64_t nSeed = 0x2545f4914f6cdd1dULL;
+        for (int i = 0; i < nReplayTransactions; i++) {
+            nSeed = nSeed * 6364136223846793005ULL + 1442695040888963407ULL;
+            uint32_t nRandom = static_cast<uint32_t>(nSeed >> 32);
+
+            MetaDExTransaction tx;
+            tx.address = addresses[nRandom % nReplayAddresses];
+            tx.block = 1000 + i / 4;
+            tx.idx = i % 4;
+            tx.txid = ArithToUint256(arith_uint256(i + 1));
+            tx.property = EXODUS_PROPERTY_EXODUS;
+            tx.desiredProperty = 3 + (nRandom >> 8) % nReplayProperties;
+            if ((nRandom >> 12) % 2) std::swap(tx.property, tx.desiredProperty);
+
+            // prices around 1 EXODUS per token, spread by +/- 5 %
+            int64_t nPrice = 95000000 + (nRandom >> 14) % 10000001;
+            tx.amount = (1 + (nRandom >> 4) % 100) * 10000000;
+            tx.desiredAmount = tx.amount * 100000000 / nPrice;
+            if (tx.property == EXODUS_PROPERTY_EXODUS) std::swap(tx.amount, tx.desiredAmount);
+
+            int nAction = (nRandom >> 20) % 100;
+            if (nAction < 85) {
+                tx.action = MetaDExTransaction::ADD;
+            } else if (nAction < 93) {
+                tx.action = MetaDExTransaction::CANCEL_AT_PRICE;
+            } else if (nAction < 98) {
+                tx.action = MetaDExTransaction::CANCEL_ALL_FOR_PAIR;
+            } else {
+                tx.action = MetaDExTransaction::CANCEL_EVERYTHING;
+            }
+            transactions.push_back(tx);
+        }
+
+        Reset();
+    }
+
+    ~MetaDExReplay() {
+        Clear();
+        delete t_tradelistdb;
+        t_tradelistdb = NULL;
+        delete p_txlistdb;
+        p_txlistdb = NULL;
+        boost::filesystem::remove_all(path);
+    }
+
+    void Clear() {
+        LOCK(cs_tally);
+        MetaDEx_CLEAR();
+        mp_tally_map.clear();
+        mp_tally_index.clear();
+        ClearConsensusBalances();
+    }
+
+    void Reset() {
+        Clear();
+
+        LOCK(cs_tally);
+        for (std::vector<std::string>::const_iterator it = addresses.begin(); it != addresses.end(); ++it) {
+            update_tally_map(*it, EXODUS_PROPERTY_EXODUS, 1000000000000000LL, BALANCE);
+            for (int i = 0; i < nReplayProperties; i++) {
+                update_tally_map(*it, 3 + i, 1000000000000000LL, BALANCE);
+            }
+        }
+        nNext = 0;
+    }
+
+    void ReplayNext() {
+        if (nNext == transactions.size()) Reset();
+        const MetaDExTransaction& tx = transactions[nNext++];
+
+        LOCK(cs_tally);
+        switch (tx.action) {
+            case MetaDExTransaction::ADD:
+                MetaDEx_ADD(tx.address, tx.property, tx.amount, tx.block, tx.desiredProperty, tx.desiredAmount, tx.txid, tx.idx);
+                break;
+            case MetaDExTransaction::CANCEL_AT_PRICE:
+                MetaDEx_CANCEL_AT_PRICE(tx.txid, tx.block, tx.address, tx.property, tx.amount, tx.desiredProperty, tx.desiredAmount);
+                break;
+            case MetaDExTransaction::CANCEL_ALL_FOR_PAIR:
+                MetaDEx_CANCEL_ALL_FOR_PAIR(tx.txid, tx.block, tx.address, tx.property, tx.desiredProperty);
+                break;
+            case MetaDExTransaction::CANCEL_EVERYTHING:
+                MetaDEx_CANCEL_EVERYTHING(tx.txid, tx.block, tx.address, EXODUS_PROPERTY_EXODUS);
+                break;
+        }
+    }
+};
+
+}
+
+static void ExodusMetaDExReplay(benchmark::State& state)
+{
+    MetaDExReplay replay;
+    while (state.KeepRunning()) {
+        replay.ReplayNext();
+    }
+}
+
+static void ExodusMetaDExIsOpen(benchmark::State& state)
+{
+    MetaDExReplay replay;
+    for (int i = 0; i < nReplayTransactions; i++) {
+        replay.ReplayNext();
+    }
+
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        LOCK(cs_tally);
+        MetaDEx_isOpen(replay.transactions[i++ % replay.transactions.size()].txid);
+    }
+}
+
+BENCHMARK(ExodusMetaDExReplay);
+BENCHMARK(ExodusMetaDExIsOpen);
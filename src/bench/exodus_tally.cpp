@@ -0,0 +1,149 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "exodus/consensushash.h"
+#include "exodus/exodus.h"
+#include "exodus/tally.h"
+
+#include "sync.h"
+#include "tinyformat.h"
+
+#include <assert.h>
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace exodus;
+
+// Number of addresses in the synthetic tally map
+static const int nTallyAddresses = 20000;
+// Number of properties held by every address
+static const int nTallyProperties = 8;
+
+namespace {
+
+// Per address storage of the balances before the switch to flat vectors, kept for comparison
+struct MapTally {
+    struct BalanceRecord {
+        int64_t balance[TALLY_TYPE_COUNT];
+    };
+
+    std::map<uint32_t, BalanceRecord> tokens;
+
+    int64_t getMoney(uint32_t propertyId, TallyType ttype) const {
+        std::map<uint32_t, BalanceRecord>::const_iterator it = tokens.find(propertyId);
+        return it != tokens.end() ? it->second.balance[ttype] : 0;
+    }
+};
+
+struct TallyFixture {
+    std::vector<std::string> addresses;
+    std::unordered_map<std::string, MapTally> mapTallies;
+
+    TallyFixture() {
+        LOCK(cs_tally);
+        for (int i = 0; i < nTallyAddresses; i++) {
+            addresses.push_back(strprintf("a%033d", i));
+            MapTally& mapTally = mapTallies[addresses.back()];
+            // properties are spread, so records are not inserted in order
+            for (int j = nTallyProperties; j > 0; j--) {
+                uint32_t propertyId = 3 + j * 7 + i % 5;
+                update_tally_map(addresses.back(), propertyId, 1000 + i, BALANCE);
+                MapTally::BalanceRecord record = {};
+                record.balance[BALANCE] = 1000 + i;
+                mapTally.tokens[propertyId] = record;
+            }
+        }
+    }
+
+    ~TallyFixture() {
+        LOCK(cs_tally);
+        mp_tally_map.clear();
+        mp_tally_index.clear();
+        ClearConsensusBalances();
+    }
+};
+
+}
+
+static void ExodusTallyUpdate(benchmark::State& state)
+{
+    TallyFixture fixture;
+    size_t i = 0;
+    int64_t amount = 1;
+    while (state.KeepRunning()) {
+        const std::string& address = fixture.addresses[i % fixture.addresses.size()];
+        update_tally_map(address, 3 + 7 + i % 5, amount, BALANCE);
+        if (++i % fixture.addresses.size() == 0) amount = -amount;
+    }
+}
+
+static void ExodusTallyBalanceLookup(benchmark::State& state)
+{
+    TallyFixture fixture;
+    size_t i = 0;
+    int64_t total = 0;
+    while (state.KeepRunning()) {
+        const std::string& address = fixture.addresses[i % fixture.addresses.size()];
+        total += getMPbalance(address, 3 + (1 + i % nTallyProperties) * 7 + i % 5, BALANCE);
+        i++;
+    }
+    assert(total > 0);
+}
+
+static void ExodusTallyBalanceLookupMap(benchmark::State& state)
+{
+    TallyFixture fixture;
+    size_t i = 0;
+    int64_t total = 0;
+    while (state.KeepRunning()) {
+        const std::string& address = fixture.addresses[i % fixture.addresses.size()];
+        std::unordered_map<std::string, MapTally>::const_iterator it = fixture.mapTallies.find(address);
+        if (it != fixture.mapTallies.end()) {
+            total += it->second.getMoney(3 + (1 + i % nTallyProperties) * 7 + i % 5, BALANCE);
+        }
+        i++;
+    }
+    assert(total > 0);
+}
+
+static void ExodusTallyIteration(benchmark::State& state)
+{
+    TallyFixture fixture;
+    int64_t total = 0;
+    while (state.KeepRunning()) {
+        LOCK(cs_tally);
+        for (std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+            for (CMPTally::const_iterator itRecord = it->second.begin(); itRecord != it->second.end(); ++itRecord) {
+                total += itRecord->second.balance[BALANCE];
+            }
+        }
+    }
+    assert(total > 0);
+}
+
+static void ExodusTallyIterationMap(benchmark::State& state)
+{
+    TallyFixture fixture;
+    int64_t total = 0;
+    while (state.KeepRunning()) {
+        for (std::unordered_map<std::string, MapTally>::const_iterator it = fixture.mapTallies.begin(); it != fixture.mapTallies.end(); ++it) {
+            const std::map<uint32_t, MapTally::BalanceRecord>& tokens = it->second.tokens;
+            for (std::map<uint32_t, MapTally::BalanceRecord>::const_iterator itRecord = tokens.begin(); itRecord != tokens.end(); ++itRecord) {
+                total += itRecord->second.balance[BALANCE];
+            }
+        }
+    }
+    assert(total > 0);
+}
+
+BENCHMARK(ExodusTallyUpdate);
+BENCHMARK(ExodusTallyBalanceLookup);
+BENCHMARK(ExodusTallyBalanceLookupMap);
+BENCHMARK(ExodusTallyIteration);
+BENCHMARK(ExodusTallyIterationMap);
@@ -0,0 +1,73 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "executor.h"
+#include "primitives/block.h"
+#include "primitives/powhashcache.h"
+#include "util.h"
+#include "utilstrencodings.h"
+#include "crypto/Lyra2Z/Lyra2.h"
+#include "crypto/Lyra2Z/Lyra2Z.h"
+
+#include <vector>
+
+// Number of headers hashed by one iteration of the batch benchmark
+static const int nBatchHeaders = 512;
+
+static void Lyra2ZHash(benchmark::State& state, int fAllowAVX2)
+{
+    lyra2_select_sponge(fAllowAVX2);
+
+    CBlockHeader header;
+    header.nTime = 1500000000;
+    uint256 hash;
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        lyra2z_hash(BEGIN(header.nVersion), BEGIN(hash));
+    }
+
+    lyra2_detect_avx2();
+}
+
+static void Lyra2ZGeneric(benchmark::State& state)
+{
+    Lyra2ZHash(state, 0);
+}
+
+// Falls back to the generic implementation if the CPU doesn't support AVX2
+static void Lyra2ZAVX2(benchmark::State& state)
+{
+    Lyra2ZHash(state, 1);
+}
+
+// PoW hashes of pre-MTP headers calculated in parallel as done for headers download and block index loading
+static void Lyra2ZBatch(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    lyra2_detect_avx2();
+    GetExecutor().Start(GetNumCores() - 1);
+
+    std::vector<CBlockHeader> headers(nBatchHeaders);
+    std::vector<int> nHeights(nBatchHeaders);
+    for (int i = 0; i < nBatchHeaders; i++) {
+        headers[i].nTime = 1500000000 + i;
+        headers[i].nNonce = i;
+        nHeights[i] = 30000 + i;
+    }
+
+    std::vector<uint256> powHashes;
+    while (state.KeepRunning()) {
+        powHashCache.Clear();
+        CalculatePoWHashes(headers, nHeights, powHashes);
+    }
+
+    GetExecutor().Stop();
+}
+
+BENCHMARK(Lyra2ZGeneric);
+BENCHMARK(Lyra2ZAVX2);
+BENCHMARK(Lyra2ZBatch);
@@ -0,0 +1,113 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "random.h"
+#include "zerocoin.h"
+#include "zerocoin_serialset.h"
+
+#include <vector>
+
+// Number of blocks in the synthetic coin group. Each block changes accumulator value
+static const int nCoinGroupBlocks = 2000;
+// Number of used coin serials, roughly the size of the mainnet set
+static const int nUsedSerials = 1000000;
+
+namespace {
+
+struct CoinGroupChain {
+    std::vector<uint256> hashes;
+    std::vector<CBlockIndex> blocks;
+    CZerocoinState state;
+
+    CoinGroupChain() : hashes(nCoinGroupBlocks), blocks(nCoinGroupBlocks) {
+        const Consensus::Params &params = Params(CBaseChainParams::MAIN).GetConsensus();
+        for (int i = 0; i < nCoinGroupBlocks; i++) {
+            hashes[i] = ArithToUint256(arith_uint256(i + 1));
+            CBlockIndex &block = blocks[i];
+            block.phashBlock = &hashes[i];
+            block.pprev = i > 0 ? &blocks[i-1] : NULL;
+            block.nHeight = i;
+            CZerocoinBlockData blockData;
+            blockData.accumulatorChanges[make_pair(1, 1)] = make_pair(CBigNum(i + 1), 1);
+            ZerocoinWriteBlockData(&block, blockData);
+            state.AddBlock(&block, params);
+        }
+    }
+};
+
+}
+
+// Find accumulator value for a spend referencing the oldest block of the group by walking back the chain
+static void ZerocoinAccumulatorLookupChainWalk(benchmark::State& state)
+{
+    CoinGroupChain chain;
+    CZerocoinState::CoinGroupInfo coinGroup;
+    chain.state.GetCoinGroupInfo(1, 1, coinGroup);
+    const uint256 &accumulatorBlockHash = chain.hashes[1];
+
+    while (state.KeepRunning()) {
+        CBlockIndex *index = coinGroup.lastBlock;
+        while (index != coinGroup.firstBlock && index->GetBlockHash() != accumulatorBlockHash)
+            index = index->pprev;
+        assert(chain.state.FindAccumulatorCheckpoint(make_pair(1, 1), index) != NULL);
+    }
+}
+
+// Same lookup through the accumulator checkpoint index
+static void ZerocoinAccumulatorLookupIndex(benchmark::State& state)
+{
+    CoinGroupChain chain;
+    const uint256 &accumulatorBlockHash = chain.hashes[1];
+
+    while (state.KeepRunning()) {
+        CZerocoinState::CAccumulatorCheckpoint checkpoint;
+        bool fFound = chain.state.GetAccumulatorCheckpoint(1, 1, accumulatorBlockHash, checkpoint);
+        assert(fFound);
+    }
+}
+
+static CBigNum RandomSerial()
+{
+    uint256 value = GetRandHash();
+    CBigNum serial;
+    BN_bin2bn(value.begin(), value.size(), &serial);
+    return serial;
+}
+
+static void ZerocoinSerialLookup(benchmark::State& state, bool fUsed)
+{
+    CZerocoinSerialSet serials;
+    std::vector<CBigNum> queries;
+    for (int i = 0; i < nUsedSerials; i++) {
+        CBigNum serial = RandomSerial();
+        serials.insert(serial);
+        if (i % 1000 == 0)
+            queries.push_back(fUsed ? serial : RandomSerial());
+    }
+
+    size_t nQuery = 0;
+    while (state.KeepRunning()) {
+        size_t nFound = serials.count(queries[nQuery++ % queries.size()]);
+        assert(nFound == (fUsed ? 1 : 0));
+    }
+}
+
+// Double spend check of the valid spend
+static void ZerocoinSerialLookupUnused(benchmark::State& state)
+{
+    ZerocoinSerialLookup(state, false);
+}
+
+static void ZerocoinSerialLookupUsed(benchmark::State& state)
+{
+    ZerocoinSerialLookup(state, true);
+}
+
+BENCHMARK(ZerocoinAccumulatorLookupChainWalk);
+BENCHMARK(ZerocoinAccumulatorLookupIndex);
+BENCHMARK(ZerocoinSerialLookupUnused);
+BENCHMARK(ZerocoinSerialLookupUsed);
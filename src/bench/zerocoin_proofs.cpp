@@ -0,0 +1,106 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "libzerocoin/Zerocoin.h"
+#include "libzerocoin/SpendMetaData.h"
+#include "zerocoin.h"
+
+#include <assert.h>
+
+#include <vector>
+
+// Number of exponents the commitment benchmarks cycle through
+static const int nCommitmentExponents = 64;
+
+namespace {
+
+struct SpendFixture {
+    libzerocoin::PrivateCoin coin;
+    libzerocoin::Accumulator accumulator;
+    libzerocoin::AccumulatorWitness witness;
+    libzerocoin::SpendMetaData metaData;
+
+    SpendFixture() :
+        coin(ZCParams, libzerocoin::ZQ_LOVELACE),
+        accumulator(ZCParams, libzerocoin::ZQ_LOVELACE),
+        witness(ZCParams, accumulator, coin.getPublicCoin()),
+        metaData(0, uint256())
+    {
+        libzerocoin::PrivateCoin other(ZCParams, libzerocoin::ZQ_LOVELACE);
+        accumulator += coin.getPublicCoin();
+        accumulator += other.getPublicCoin();
+        witness += other.getPublicCoin();
+    }
+};
+
+std::vector<CBigNum> RandomExponents(const CBigNum& range)
+{
+    std::vector<CBigNum> exponents;
+    for (int i = 0; i < nCommitmentExponents; i++)
+        exponents.push_back(CBigNum::randBignum(range));
+    return exponents;
+}
+
+}
+
+// Pedersen commitment g^s * h^r of a coin with plain modular exponentiation
+static void ZerocoinCommitmentPowMod(benchmark::State& state)
+{
+    const libzerocoin::IntegerGroupParams& group = ZCParams->coinCommitmentGroup;
+    std::vector<CBigNum> exponents = RandomExponents(group.groupOrder);
+
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        const CBigNum& s = exponents[i++ % exponents.size()];
+        const CBigNum& r = exponents[i % exponents.size()];
+        group.g.pow_mod(s, group.modulus).mul_mod(group.h.pow_mod(r, group.modulus), group.modulus);
+    }
+}
+
+// Same commitment with the precomputed powers of the generators
+static void ZerocoinCommitmentFixedBase(benchmark::State& state)
+{
+    const libzerocoin::IntegerGroupParams& group = ZCParams->coinCommitmentGroup;
+    std::vector<CBigNum> exponents = RandomExponents(group.groupOrder);
+
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        const CBigNum& s = exponents[i++ % exponents.size()];
+        const CBigNum& r = exponents[i % exponents.size()];
+        group.gPow(s).mul_mod(group.hPow(r), group.modulus);
+    }
+}
+
+static void ZerocoinMint(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        libzerocoin::PrivateCoin coin(ZCParams, libzerocoin::ZQ_LOVELACE);
+    }
+}
+
+static void ZerocoinSpend(benchmark::State& state)
+{
+    SpendFixture fixture;
+    while (state.KeepRunning()) {
+        libzerocoin::CoinSpend spend(ZCParams, fixture.coin, fixture.accumulator, fixture.witness, fixture.metaData);
+    }
+}
+
+static void ZerocoinSpendVerify(benchmark::State& state)
+{
+    SpendFixture fixture;
+    libzerocoin::CoinSpend spend(ZCParams, fixture.coin, fixture.accumulator, fixture.witness, fixture.metaData);
+    while (state.KeepRunning()) {
+        bool fValid = spend.Verify(fixture.accumulator, fixture.metaData);
+        assert(fValid);
+    }
+}
+
+BENCHMARK(ZerocoinCommitmentPowMod);
+BENCHMARK(ZerocoinCommitmentFixedBase);
+BENCHMARK(ZerocoinMint);
+BENCHMARK(ZerocoinSpend);
+BENCHMARK(ZerocoinSpendVerify);
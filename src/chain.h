@@ -151,6 +151,94 @@ enum BlockStatus: uint32_t {
     BLOCK_FAILED_MASK        =   96,
 
     BLOCK_OPT_WITNESS       =   128, //!< block data in blk*.data was received with a witness-enforcing client
+
+    BLOCK_HAVE_ZEROCOIN     =   256, //!< zerocoin mints/spends available in block index database
+};
+
+/** Zerocoin mints, spends and accumulator updates of a block. Stored in the block index database separately from
+ * CDiskBlockIndex and read on demand so that they don't stay in memory for every block of the chain
+ */
+class CZerocoinBlockData
+{
+public:
+    //! Public coin values of mints in this block, ordered by serialized value of public coin
+    //! Maps <denomination,id> to vector of public coins
+    map<pair<int,int>, vector<CBigNum>> mintedPubCoins;
+
+    //! Values of coin serials spent in this block
+    set<CBigNum> spentSerials;
+
+    //! Accumulator updates. Contains only changes made by mints in this block
+    //! Maps <denomination, id> to <accumulator value (CBigNum), number of such mints in this block>
+    //! In memory the values are kept by CZerocoinState accumulator checkpoints only
+    map<pair<int,int>, pair<CBigNum,int>> accumulatorChanges;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(mintedPubCoins);
+        READWRITE(spentSerials);
+        READWRITE(accumulatorChanges);
+    }
+
+    bool IsNull() const {
+        return mintedPubCoins.empty() && spentSerials.empty() && accumulatorChanges.empty();
+    }
+};
+
+/** Zerocoin mints and spends of the active chain per denomination. Maintained in the block index database as
+ * blocks are connected and disconnected, so the supply is known without scanning the chain
+ */
+class CZerocoinSupply
+{
+public:
+    struct CDenominationSupply
+    {
+        //! Number of minted coins
+        int64_t nMinted;
+        //! Number of spends
+        int64_t nSpent;
+        //! Number of spends reusing the serial of an earlier spend, accepted before the serial check was fixed
+        int64_t nDuplicateSpent;
+
+        CDenominationSupply() : nMinted(0), nSpent(0), nDuplicateSpent(0) {}
+
+        ADD_SERIALIZE_METHODS;
+
+        template <typename Stream, typename Operation>
+        inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+            READWRITE(nMinted);
+            READWRITE(nSpent);
+            READWRITE(nDuplicateSpent);
+        }
+
+        bool IsNull() const {
+            return nMinted == 0 && nSpent == 0 && nDuplicateSpent == 0;
+        }
+    };
+
+    //! Block the supply was last updated with
+    uint256 hashBlock;
+
+    //! Maps denomination to its mints and spends
+    map<int, CDenominationSupply> denominations;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(hashBlock);
+        READWRITE(denominations);
+    }
+
+    //! Amount created by duplicate spends, which is not part of the coinbase supply
+    CAmount GetDuplicateSpendAmount() const {
+        CAmount nTotal = 0;
+        for (map<int, CDenominationSupply>::const_iterator it = denominations.begin(); it != denominations.end(); ++it)
+            nTotal += it->second.nDuplicateSpent * it->first * COIN;
+        return nTotal;
+    }
 };
 
 /** The block chain is a tree shaped structure starting with the
@@ -213,20 +301,6 @@ public:
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
     uint32_t nSequenceId;
 
-    //! Public coin values of mints in this block, ordered by serialized value of public coin
-    //! Maps <denomination,id> to vector of public coins
-    map<pair<int,int>, vector<CBigNum>> mintedPubCoins;
-
-    //! Accumulator updates. Contains only changes made by mints in this block
-    //! Maps <denomination, id> to <accumulator value (CBigNum), number of such mints in this block>
-    map<pair<int,int>, pair<CBigNum,int>> accumulatorChanges;
-	
-	//! Same as accumulatorChanges but for alternative modulus
-	map<pair<int,int>, pair<CBigNum,int>> alternativeAccumulatorChanges;
-	
-    //! Values of coin serials spent in this block
-	set<CBigNum> spentSerials;
-
     void SetNull()
     {
         phashBlock = NULL;
@@ -250,10 +324,6 @@ public:
 
         nVersionMTP = 0;
         mtpHashValue = reserved[0] = reserved[1] = uint256();
-
-        mintedPubCoins.clear();
-        accumulatorChanges.clear();
-        spentSerials.clear();
     }
 
     CBlockIndex()
@@ -399,6 +469,12 @@ public:
     uint256 hashPrev;
     int nDiskBlockVersion;
 
+    //! Zerocoin mints/spends and accumulator updates stored in the record by older versions. Always written empty,
+    //! block index database holds them in CZerocoinBlockData now
+    map<pair<int,int>, vector<CBigNum>> mintedPubCoins;
+    map<pair<int,int>, pair<CBigNum,int>> accumulatorChanges;
+    set<CBigNum> spentSerials;
+
     CDiskBlockIndex() {
         hashPrev = uint256();
         // value doesn't really matter but we won't leave it uninitialized
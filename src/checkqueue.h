@@ -5,6 +5,8 @@
 #ifndef BITCOIN_CHECKQUEUE_H
 #define BITCOIN_CHECKQUEUE_H
 
+#include "executor.h"
+
 #include <algorithm>
 #include <vector>
 
@@ -22,9 +24,9 @@ class CCheckQueueControl;
   * operator(), returning a bool.
   *
   * One thread (the master) is assumed to push batches of verifications
-  * onto the queue, where they are processed by N-1 worker threads. When
-  * the master is done adding work, it temporarily joins the worker pool
-  * as an N'th worker, until all jobs are done.
+  * onto the queue. Every batch schedules helper tasks on the shared executor
+  * (see executor.h) that process verifications until the queue is empty. When
+  * the master is done adding work, it joins the helpers until all jobs are done.
   */
 template <typename T>
 class CCheckQueue
@@ -33,9 +35,6 @@ private:
     //! Mutex to protect the inner state
     boost::mutex mutex;
 
-    //! Worker threads block on this when out of work
-    boost::condition_variable condWorker;
-
     //! Master thread blocks on this when out of work
     boost::condition_variable condMaster;
 
@@ -43,10 +42,10 @@ private:
     //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
     std::vector<T> queue;
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle;
+    //! The number of helpers scheduled on the executor that haven't finished yet.
+    int nHelpers;
 
-    //! The total number of workers (including the master).
+    //! The number of workers (including the master) currently processing the queue.
     int nTotal;
 
     //! The temporary evaluation result.
@@ -59,16 +58,19 @@ private:
      */
     unsigned int nTodo;
 
-    //! Whether we're shutting down.
-    bool fQuit;
-
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
+    //! Executor running the helpers
+    CExecutor& executor;
+
+    //! Helpers scheduled on the executor. Declared last so it waits for the helpers, which reference this
+    //! queue, before the rest is destroyed. The helpers that haven't started find the queue empty and return
+    CExecutorTaskGroup helpers;
+
     /** Internal function that does bulk of the verification work. */
     bool Loop(bool fMaster = false)
     {
-        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
         unsigned int nNow = 0;
@@ -88,26 +90,29 @@ private:
                     nTotal++;
                 }
                 // logically, the do loop starts here
+                if (queue.empty() && !fMaster) {
+                    // Nothing left for the helper, give the executor thread back
+                    nTotal--;
+                    nHelpers--;
+                    return true;
+                }
                 while (queue.empty()) {
-                    if ((fMaster || fQuit) && nTodo == 0) {
+                    if (nTodo == 0) {
                         nTotal--;
                         bool fRet = fAllOk;
                         // reset the status for new work later
-                        if (fMaster)
-                            fAllOk = true;
+                        fAllOk = true;
                         // return the current status
                         return fRet;
                     }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
+                    condMaster.wait(lock); // wait
                 }
                 // Decide how many work units to process now.
                 // * Do not try to do everything at once, but aim for increasingly smaller batches so
                 //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
+                // * Try to account for helpers which will start shortly.
                 // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
+                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (std::max(nTotal, nHelpers) + 1)));
                 vChecks.resize(nNow);
                 for (unsigned int i = 0; i < nNow; i++) {
                     // We want the lock on the mutex to be as short as possible, so swap jobs from the global
@@ -128,13 +133,8 @@ private:
 
 public:
     //! Create a new check queue
-    CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), fQuit(false), nBatchSize(nBatchSizeIn) {}
-
-    //! Worker thread
-    void Thread()
-    {
-        Loop();
-    }
+    CCheckQueue(unsigned int nBatchSizeIn, CExecutor& executorIn = GetExecutor()) :
+        nHelpers(0), nTotal(0), fAllOk(true), nTodo(0), nBatchSize(nBatchSizeIn), executor(executorIn), helpers(executorIn) {}
 
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait()
@@ -145,26 +145,27 @@ public:
     //! Add a batch of checks to the queue
     void Add(std::vector<T>& vChecks)
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        BOOST_FOREACH (T& check, vChecks) {
-            queue.push_back(T());
-            check.swap(queue.back());
+        int nNewHelpers;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            BOOST_FOREACH (T& check, vChecks) {
+                queue.push_back(T());
+                check.swap(queue.back());
+            }
+            nTodo += vChecks.size();
+            // one helper per executor thread is enough
+            nNewHelpers = std::min((int)vChecks.size(), executor.GetThreadCount() - nHelpers);
+            if (nNewHelpers > 0)
+                nHelpers += nNewHelpers;
         }
-        nTodo += vChecks.size();
-        if (vChecks.size() == 1)
-            condWorker.notify_one();
-        else if (vChecks.size() > 1)
-            condWorker.notify_all();
-    }
-
-    ~CCheckQueue()
-    {
+        for (int i = 0; i < nNewHelpers; i++)
+            helpers.Add([this] { Loop(); });
     }
 
     bool IsIdle()
     {
         boost::unique_lock<boost::mutex> lock(mutex);
-        return (nTotal == nIdle && nTodo == 0 && fAllOk == true);
+        return (nTotal == 0 && nTodo == 0 && fAllOk == true);
     }
 
 };
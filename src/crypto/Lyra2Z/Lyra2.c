@@ -24,6 +24,45 @@
 #include "Lyra2.h"
 #include "Sponge.h"
 
+#if defined(_MSC_VER)
+#define LYRA2_THREAD_LOCAL __declspec(thread)
+#else
+#define LYRA2_THREAD_LOCAL __thread
+#endif
+
+//Memory matrices up to this size are kept between the calls in the per-thread scratch buffer. Lyra2Z
+//needs a bit over 6kB, bigger matrices (pre-Lyra2Z blocks) are allocated for every call
+#define LYRA2_MAX_SCRATCH_BYTES (64 * 1024)
+
+static LYRA2_THREAD_LOCAL void *scratchBuffer = NULL;
+
+//Row operations of the sponge, replaced by their AVX2 versions if the CPU supports it
+static void (*pReducedSqueezeRow0)(uint64_t*, uint64_t*, uint64_t) = reducedSqueezeRow0;
+static void (*pReducedDuplexRow1)(uint64_t*, uint64_t*, uint64_t*, uint64_t) = reducedDuplexRow1;
+static void (*pReducedDuplexRowSetup)(uint64_t*, uint64_t*, uint64_t*, uint64_t*, uint64_t) = reducedDuplexRowSetup;
+static void (*pReducedDuplexRow)(uint64_t*, uint64_t*, uint64_t*, uint64_t*, uint64_t) = reducedDuplexRow;
+
+int lyra2_select_sponge(int fAllowAVX2) {
+#if defined(LYRA2_AVX2)
+    if (fAllowAVX2 && lyra2_cpu_has_avx2()) {
+        pReducedSqueezeRow0 = reducedSqueezeRow0_avx2;
+        pReducedDuplexRow1 = reducedDuplexRow1_avx2;
+        pReducedDuplexRowSetup = reducedDuplexRowSetup_avx2;
+        pReducedDuplexRow = reducedDuplexRow_avx2;
+        return 1;
+    }
+#endif
+    pReducedSqueezeRow0 = reducedSqueezeRow0;
+    pReducedDuplexRow1 = reducedDuplexRow1;
+    pReducedDuplexRowSetup = reducedDuplexRowSetup;
+    pReducedDuplexRow = reducedDuplexRow;
+    return 0;
+}
+
+int lyra2_detect_avx2(void) {
+    return lyra2_select_sponge(1);
+}
+
 /**
  * Executes Lyra2 based on the G function from Blake2b. This version supports salts and passwords
  * whose combined length is smaller than the size of the memory matrix, (i.e., (nRows x nCols x b) bits,
@@ -63,18 +102,27 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     const int64_t ROW_LEN_INT64 = BLOCK_LEN_INT64 * nCols;
     const int64_t ROW_LEN_BYTES = ROW_LEN_INT64 * 8;
 
-    i = (int64_t) ((int64_t) nRows * (int64_t) ROW_LEN_BYTES);
-    uint64_t *wholeMatrix = malloc(i);
-    if (wholeMatrix == NULL) {
-      return -1;
+    //The matrix doesn't need to be zeroed: every row is written before it is read for the first time.
+    //Pointers to each row of the matrix are placed right after it
+    const uint64_t matrixSize = nRows * ROW_LEN_BYTES + nRows * sizeof (uint64_t*);
+    uint64_t *wholeMatrix;
+    if (matrixSize <= LYRA2_MAX_SCRATCH_BYTES) {
+      if (scratchBuffer == NULL) {
+        scratchBuffer = malloc(LYRA2_MAX_SCRATCH_BYTES);
+        if (scratchBuffer == NULL) {
+          return -1;
+        }
+      }
+      wholeMatrix = scratchBuffer;
     }
-    memset(wholeMatrix, 0, i);
-
-    //Allocates pointers to each row of the matrix
-    uint64_t **memMatrix = malloc(nRows * sizeof (uint64_t*));
-    if (memMatrix == NULL) {
-      return -1;
+    else {
+      wholeMatrix = malloc(matrixSize);
+      if (wholeMatrix == NULL) {
+        return -1;
+      }
     }
+
+    uint64_t **memMatrix = (uint64_t **) ((byte *) wholeMatrix + nRows * ROW_LEN_BYTES);
     //Places the pointers in the correct positions
     uint64_t *ptrWord = wholeMatrix;
     for (i = 0; i < nRows; i++) {
@@ -123,10 +171,7 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
 
     //======================= Initializing the Sponge State ====================//
     //Sponge state: 16 uint64_t, BLOCK_LEN_INT64 words of them for the bitrate (b) and the remainder for the capacity (c)
-    uint64_t *state = malloc(16 * sizeof (uint64_t));
-    if (state == NULL) {
-      return -1;
-    }
+    ALIGN uint64_t state[16];
     initState(state);
     //==========================================================================/
 
@@ -139,12 +184,12 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     }
 
     //Initializes M[0] and M[1]
-    reducedSqueezeRow0(state, memMatrix[0], nCols); //The locally copied password is most likely overwritten here
-    reducedDuplexRow1(state, memMatrix[0], memMatrix[1], nCols);
+    pReducedSqueezeRow0(state, memMatrix[0], nCols); //The locally copied password is most likely overwritten here
+    pReducedDuplexRow1(state, memMatrix[0], memMatrix[1], nCols);
 
     do {
       //M[row] = rand; //M[row*] = M[row*] XOR rotW(rand)
-      reducedDuplexRowSetup(state, memMatrix[prev], memMatrix[rowa], memMatrix[row], nCols);
+      pReducedDuplexRowSetup(state, memMatrix[prev], memMatrix[rowa], memMatrix[row], nCols);
 
 
       //updates the value of row* (deterministically picked during Setup))
@@ -177,7 +222,7 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
         //------------------------------------------------------------------------------------------
 
         //Performs a reduced-round duplexing operation over M[row*] XOR M[prev], updating both M[row*] and M[row]
-        reducedDuplexRow(state, memMatrix[prev], memMatrix[rowa], memMatrix[row], nCols);
+        pReducedDuplexRow(state, memMatrix[prev], memMatrix[rowa], memMatrix[row], nCols);
 
         //update prev: it now points to the last row ever computed
         prev = row;
@@ -201,12 +246,12 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     //==========================================================================/
 
     //========================= Freeing the memory =============================//
-    free(memMatrix);
-    free(wholeMatrix);
+    if (wholeMatrix != scratchBuffer) {
+      free(wholeMatrix);
+    }
 
-    //Wiping out the sponge's internal state before freeing it
+    //Wiping out the sponge's internal state
     memset(state, 0, 16 * sizeof (uint64_t));
-    free(state);
     //==========================================================================/
 
     return 0;
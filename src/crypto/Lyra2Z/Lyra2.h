@@ -43,6 +43,11 @@ extern "C" {
 
     int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *salt, uint64_t saltlen, uint64_t timeCost, uint64_t nRows, uint64_t nCols);
 
+    //Selects the AVX2 implementation of the sponge if the CPU supports it. Returns 1 if AVX2 is used
+    int lyra2_detect_avx2(void);
+    //Same as above but can be used to force the generic implementation. Not thread safe, call before hashing
+    int lyra2_select_sponge(int fAllowAVX2);
+
 #ifdef __cplusplus
 }
 
@@ -32,6 +32,10 @@
 #define ALIGN
 #endif
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LYRA2_AVX2
+#endif
+
 
 /*Blake2b IV Array*/
 static const uint64_t blake2b_IV[8] =
@@ -89,6 +93,15 @@ void reducedDuplexRow1(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut, uint6
 void reducedDuplexRowSetup(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols);
 void reducedDuplexRow(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols);
 
+//---- AVX2 versions of the row operations (Sponge_avx2.c)
+#if defined(LYRA2_AVX2)
+void reducedSqueezeRow0_avx2(uint64_t* state, uint64_t* row, uint64_t nCols);
+void reducedDuplexRow1_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut, uint64_t nCols);
+void reducedDuplexRowSetup_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols);
+void reducedDuplexRow_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols);
+#endif
+int lyra2_cpu_has_avx2(void);
+
 //---- Misc
 void printArray(unsigned char *array, unsigned int size, char *name);
 
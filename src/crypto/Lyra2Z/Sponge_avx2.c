@@ -0,0 +1,199 @@
+/**
+ * AVX2 implementation of the row operations of the Lyra2 sponge. The sponge state is kept in four
+ * 256-bit registers, one register holds one row of the 4x4 matrix processed by Blake2b's G function,
+ * so every half-round of ROUND_LYRA is computed as four G functions at once.
+ *
+ * Functions here produce exactly the same output as their counterparts in Sponge.c and are only
+ * called after the CPU support for AVX2 is detected at runtime (see lyra2_select_sponge).
+ *
+ * This software is hereby placed in the public domain.
+ */
+#include "Lyra2.h"
+#include "Sponge.h"
+
+#if defined(LYRA2_AVX2)
+
+#include <immintrin.h>
+
+#define LYRA2_AVX2_TARGET __attribute__((target("avx2")))
+
+#define ROTR32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define ROTR24(x) _mm256_shuffle_epi8((x), _mm256_setr_epi8( \
+    3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, \
+    3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10))
+#define ROTR16(x) _mm256_shuffle_epi8((x), _mm256_setr_epi8( \
+    2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, \
+    2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9))
+#define ROTR63(x) _mm256_or_si256(_mm256_add_epi64((x), (x)), _mm256_srli_epi64((x), 63))
+
+/*Four Blake2b's G functions over the columns (or diagonals) of the state*/
+#define G4(a, b, c, d) \
+  do { \
+    a = _mm256_add_epi64(a, b); \
+    d = ROTR32(_mm256_xor_si256(d, a)); \
+    c = _mm256_add_epi64(c, d); \
+    b = ROTR24(_mm256_xor_si256(b, c)); \
+    a = _mm256_add_epi64(a, b); \
+    d = ROTR16(_mm256_xor_si256(d, a)); \
+    c = _mm256_add_epi64(c, d); \
+    b = ROTR63(_mm256_xor_si256(b, c)); \
+  } while(0)
+
+/*One round of the Blake2b's compression function, same as ROUND_LYRA*/
+#define ROUND_LYRA_AVX2(a, b, c, d) \
+  do { \
+    G4(a, b, c, d); \
+    b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1)); \
+    c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2)); \
+    d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(2, 1, 0, 3)); \
+    G4(a, b, c, d); \
+    b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3)); \
+    c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2)); \
+    d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(0, 3, 2, 1)); \
+  } while(0)
+
+#define LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+#define STORE(p, x) _mm256_storeu_si256((__m256i *)(p), (x))
+
+#define LOAD_STATE(state, a, b, c, d) \
+    a = LOAD(state); b = LOAD(state + 4); c = LOAD(state + 8); d = LOAD(state + 12)
+#define STORE_STATE(state, a, b, c, d) \
+    STORE(state, a); STORE(state + 4, b); STORE(state + 8, c); STORE(state + 12, d)
+
+/*M[rowInOut][col] ^= rotW(rand), rand is the first BLOCK_LEN_INT64 words of the state*/
+#define XOR_ROTW(ptr, a, b, c) \
+  do { \
+    __m256i ra = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(2, 1, 0, 3)); \
+    __m256i rb = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3)); \
+    __m256i rc = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(2, 1, 0, 3)); \
+    STORE(ptr, _mm256_xor_si256(LOAD(ptr), _mm256_blend_epi32(ra, rc, 0x03))); \
+    STORE(ptr + 4, _mm256_xor_si256(LOAD(ptr + 4), _mm256_blend_epi32(rb, ra, 0x03))); \
+    STORE(ptr + 8, _mm256_xor_si256(LOAD(ptr + 8), _mm256_blend_epi32(rc, rb, 0x03))); \
+  } while(0)
+
+LYRA2_AVX2_TARGET
+void reducedSqueezeRow0_avx2(uint64_t* state, uint64_t* rowOut, uint64_t nCols) {
+    uint64_t* ptrWord = rowOut + (nCols-1)*BLOCK_LEN_INT64; //In Lyra2: pointer to M[0][C-1]
+    __m256i a, b, c, d;
+    uint64_t i;
+
+    LOAD_STATE(state, a, b, c, d);
+    for (i = 0; i < nCols; i++) {
+        //M[row][C-1-col] = H.reduced_squeeze()
+        STORE(ptrWord, a);
+        STORE(ptrWord + 4, b);
+        STORE(ptrWord + 8, c);
+        ptrWord -= BLOCK_LEN_INT64;
+
+        ROUND_LYRA_AVX2(a, b, c, d);
+    }
+    STORE_STATE(state, a, b, c, d);
+}
+
+LYRA2_AVX2_TARGET
+void reducedDuplexRow1_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut, uint64_t nCols) {
+    uint64_t* ptrWordIn = rowIn; //In Lyra2: pointer to prev
+    uint64_t* ptrWordOut = rowOut + (nCols-1)*BLOCK_LEN_INT64; //In Lyra2: pointer to row
+    __m256i a, b, c, d;
+    uint64_t i;
+
+    LOAD_STATE(state, a, b, c, d);
+    for (i = 0; i < nCols; i++) {
+        __m256i in0 = LOAD(ptrWordIn), in1 = LOAD(ptrWordIn + 4), in2 = LOAD(ptrWordIn + 8);
+
+        //Absorbing "M[prev][col]"
+        a = _mm256_xor_si256(a, in0);
+        b = _mm256_xor_si256(b, in1);
+        c = _mm256_xor_si256(c, in2);
+
+        ROUND_LYRA_AVX2(a, b, c, d);
+
+        //M[row][C-1-col] = M[prev][col] XOR rand
+        STORE(ptrWordOut, _mm256_xor_si256(in0, a));
+        STORE(ptrWordOut + 4, _mm256_xor_si256(in1, b));
+        STORE(ptrWordOut + 8, _mm256_xor_si256(in2, c));
+
+        ptrWordIn += BLOCK_LEN_INT64;
+        ptrWordOut -= BLOCK_LEN_INT64;
+    }
+    STORE_STATE(state, a, b, c, d);
+}
+
+LYRA2_AVX2_TARGET
+void reducedDuplexRowSetup_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    uint64_t* ptrWordIn = rowIn; //In Lyra2: pointer to prev
+    uint64_t* ptrWordInOut = rowInOut; //In Lyra2: pointer to row*
+    uint64_t* ptrWordOut = rowOut + (nCols-1)*BLOCK_LEN_INT64; //In Lyra2: pointer to row
+    __m256i a, b, c, d;
+    uint64_t i;
+
+    LOAD_STATE(state, a, b, c, d);
+    for (i = 0; i < nCols; i++) {
+        __m256i in0 = LOAD(ptrWordIn), in1 = LOAD(ptrWordIn + 4), in2 = LOAD(ptrWordIn + 8);
+
+        //Absorbing "M[prev] [+] M[row*]"
+        a = _mm256_xor_si256(a, _mm256_add_epi64(in0, LOAD(ptrWordInOut)));
+        b = _mm256_xor_si256(b, _mm256_add_epi64(in1, LOAD(ptrWordInOut + 4)));
+        c = _mm256_xor_si256(c, _mm256_add_epi64(in2, LOAD(ptrWordInOut + 8)));
+
+        ROUND_LYRA_AVX2(a, b, c, d);
+
+        //M[row][col] = M[prev][col] XOR rand
+        STORE(ptrWordOut, _mm256_xor_si256(in0, a));
+        STORE(ptrWordOut + 4, _mm256_xor_si256(in1, b));
+        STORE(ptrWordOut + 8, _mm256_xor_si256(in2, c));
+
+        //M[row*][col] = M[row*][col] XOR rotW(rand)
+        XOR_ROTW(ptrWordInOut, a, b, c);
+
+        ptrWordInOut += BLOCK_LEN_INT64;
+        ptrWordIn += BLOCK_LEN_INT64;
+        ptrWordOut -= BLOCK_LEN_INT64;
+    }
+    STORE_STATE(state, a, b, c, d);
+}
+
+LYRA2_AVX2_TARGET
+void reducedDuplexRow_avx2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    uint64_t* ptrWordInOut = rowInOut; //In Lyra2: pointer to row*
+    uint64_t* ptrWordIn = rowIn; //In Lyra2: pointer to prev
+    uint64_t* ptrWordOut = rowOut; //In Lyra2: pointer to row
+    __m256i a, b, c, d;
+    uint64_t i;
+
+    LOAD_STATE(state, a, b, c, d);
+    for (i = 0; i < nCols; i++) {
+        //Absorbing "M[prev] [+] M[row*]"
+        a = _mm256_xor_si256(a, _mm256_add_epi64(LOAD(ptrWordIn), LOAD(ptrWordInOut)));
+        b = _mm256_xor_si256(b, _mm256_add_epi64(LOAD(ptrWordIn + 4), LOAD(ptrWordInOut + 4)));
+        c = _mm256_xor_si256(c, _mm256_add_epi64(LOAD(ptrWordIn + 8), LOAD(ptrWordInOut + 8)));
+
+        ROUND_LYRA_AVX2(a, b, c, d);
+
+        //M[rowOut][col] = M[rowOut][col] XOR rand. Rows may be the same so memory is re-read every time
+        STORE(ptrWordOut, _mm256_xor_si256(LOAD(ptrWordOut), a));
+        STORE(ptrWordOut + 4, _mm256_xor_si256(LOAD(ptrWordOut + 4), b));
+        STORE(ptrWordOut + 8, _mm256_xor_si256(LOAD(ptrWordOut + 8), c));
+
+        //M[rowInOut][col] = M[rowInOut][col] XOR rotW(rand)
+        XOR_ROTW(ptrWordInOut, a, b, c);
+
+        ptrWordOut += BLOCK_LEN_INT64;
+        ptrWordInOut += BLOCK_LEN_INT64;
+        ptrWordIn += BLOCK_LEN_INT64;
+    }
+    STORE_STATE(state, a, b, c, d);
+}
+
+int lyra2_cpu_has_avx2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+int lyra2_cpu_has_avx2(void) {
+    return 0;
+}
+
+#endif
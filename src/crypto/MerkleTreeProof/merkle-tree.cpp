@@ -191,6 +191,43 @@ bool MerkleTree::checkProofOrdered(const Elements& proof,
     return tempHash == root;
 }
 
+bool MerkleTree::checkProofOrdered(const uint8_t *proof, size_t proofSize,
+        const uint8_t root[MERKLE_TREE_ELEMENT_SIZE_B],
+        const uint8_t element[MERKLE_TREE_ELEMENT_SIZE_B], size_t index)
+{
+    --index; // `index` argument starts at 1
+    uint8_t tempHash[MERKLE_TREE_ELEMENT_SIZE_B];
+    uint8_t combined[MERKLE_TREE_ELEMENT_SIZE_B * 2];
+    std::copy(element, element + MERKLE_TREE_ELEMENT_SIZE_B, tempHash);
+    for (size_t i = 0; i < proofSize; ++i) {
+        size_t remaining = proofSize - i;
+        const uint8_t *node = proof + i * MERKLE_TREE_ELEMENT_SIZE_B;
+
+        // Same index adjustment as in the function above
+        while (((index & 1) == 0) && (index >= (1u << remaining))) {
+            index = index / 2;
+        }
+
+        if (index & 1) {
+            std::copy(node, node + MERKLE_TREE_ELEMENT_SIZE_B, combined);
+            std::copy(tempHash, tempHash + MERKLE_TREE_ELEMENT_SIZE_B,
+                    combined + MERKLE_TREE_ELEMENT_SIZE_B);
+        } else {
+            std::copy(tempHash, tempHash + MERKLE_TREE_ELEMENT_SIZE_B, combined);
+            std::copy(node, node + MERKLE_TREE_ELEMENT_SIZE_B,
+                    combined + MERKLE_TREE_ELEMENT_SIZE_B);
+        }
+
+        blake2b_state state;
+        blake2b_init(&state, MERKLE_TREE_ELEMENT_SIZE_B);
+        blake2b_4r_update(&state, combined, sizeof(combined));
+        blake2b_4r_final(&state, tempHash, sizeof(tempHash));
+
+        index = index / 2;
+    }
+    return std::equal(tempHash, tempHash + MERKLE_TREE_ELEMENT_SIZE_B, root);
+}
+
 void MerkleTree::getLayers()
 {
     layers_.clear();
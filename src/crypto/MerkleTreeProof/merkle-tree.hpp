@@ -199,6 +199,15 @@ public :
     static bool checkProofOrdered(const Elements& proof, const Buffer& root,
             const Buffer& element, size_t index);
 
+    /** Same as above for the proof given as `proofSize` hashes stored
+     * back to back in `proof`
+     *
+     * Doesn't allocate memory.
+     */
+    static bool checkProofOrdered(const uint8_t *proof, size_t proofSize,
+            const uint8_t root[MERKLE_TREE_ELEMENT_SIZE_B],
+            const uint8_t element[MERKLE_TREE_ELEMENT_SIZE_B], size_t index);
+
 private :
     /** Layers data structure
      *
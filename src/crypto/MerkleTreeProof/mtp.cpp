@@ -1,6 +1,8 @@
 #include "mtp.h"
 #include "util.h"
 #include "arith_uint256.h"
+#include "crypto/common.h"
+#include "executor.h"
 
 extern "C" {
 #include "blake2/blake2.h"
@@ -16,6 +18,9 @@ extern "C" {
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include "merkle-tree.hpp"
 #include "primitives/block.h"
 #include "streams.h"
@@ -40,6 +45,8 @@ const unsigned T_COST = 1;
 const unsigned M_COST = 1024 * 1024 * 4;
 const unsigned LANES = 4;
 
+static_assert((M_COST & (M_COST - 1)) == 0, "mtp_verify() expects M_COST to be a power of two");
+
 void StoreBlock(void *output, const block *src)
 {
     for (unsigned i = 0; i < ARGON2_QWORDS_IN_BLOCK; ++i) {
@@ -201,6 +208,92 @@ struct TargetHelper
     }
 };
 
+/** Number of rounds which openings are checked by one task */
+const int ROUNDS_PER_CHECK_TASK = 8;
+
+/** Block of Argon2 memory revealed by the proof, to be checked against the Merkle root */
+struct MtpOpening
+{
+    const block *data;
+    /** Index of the block in the memory, starting at 1 */
+    uint32_t index;
+    const char *name;
+};
+
+/** Scratch space used by the verification of one proof */
+struct MtpVerifyBuffers
+{
+    block blocks_ij[L];
+    MtpOpening openings[L * 3];
+};
+
+/**
+ * Verification buffers are taken from the pool and returned there when the verification is done.
+ * Thread waiting for the parallel checks may start verifying another proof meanwhile, so the buffers
+ * can't be simply kept per thread
+ */
+class MtpVerifyBuffersHolder
+{
+public:
+    MtpVerifyBuffersHolder()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (pool.empty()) {
+            buffers.reset(new MtpVerifyBuffers());
+        } else {
+            buffers = std::move(pool.back());
+            pool.pop_back();
+        }
+    }
+
+    ~MtpVerifyBuffersHolder()
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        pool.push_back(std::move(buffers));
+    }
+
+    MtpVerifyBuffers *operator->() { return buffers.get(); }
+
+private:
+    std::unique_ptr<MtpVerifyBuffers> buffers;
+
+    static std::mutex cs;
+    static std::vector<std::unique_ptr<MtpVerifyBuffers>> pool;
+};
+
+std::mutex MtpVerifyBuffersHolder::cs;
+std::vector<std::unique_ptr<MtpVerifyBuffers>> MtpVerifyBuffersHolder::pool;
+
+bool CheckOpening(const MtpOpening &opening, const uint8_t hash_root_mtp[16],
+        const uint8_t *proof, size_t proofSize)
+{
+    uint8_t digest[MERKLE_TREE_ELEMENT_SIZE_B];
+    compute_blake2b(*opening.data, digest);
+    if (!MerkleTree::checkProofOrdered(proof, proofSize, hash_root_mtp, digest, opening.index)) {
+        LogPrintf("error : checkProofOrdered in %s\n", opening.name);
+        return false;
+    }
+    return true;
+}
+
+/** Check Merkle proofs of all the openings on the executor */
+bool CheckOpenings(const MtpOpening openings[L * 3], const uint8_t hash_root_mtp[16],
+        const CMTPProofs &proof_mtp)
+{
+    std::atomic<bool> fValid(true);
+    CExecutorTaskGroup tasks;
+    for (int nFirst = 0; nFirst < L * 3; nFirst += ROUNDS_PER_CHECK_TASK * 3) {
+        tasks.Add([&fValid, openings, hash_root_mtp, &proof_mtp, nFirst] {
+            for (int i = nFirst; i < nFirst + ROUNDS_PER_CHECK_TASK * 3 && fValid; ++i) {
+                if (!CheckOpening(openings[i], hash_root_mtp, proof_mtp.GetProof(i), proof_mtp.GetProofSize(i)))
+                    fValid = false;
+            }
+        });
+    }
+    tasks.Wait();
+    return fValid;
+}
+
 } // unnamed namespace
 
 namespace impl
@@ -209,21 +302,12 @@ namespace impl
 bool mtp_verify(const char* input, const uint32_t target,
         const uint8_t hash_root_mtp[16], uint32_t nonce,
         const uint64_t block_mtp[MTP_L*2][128],
-        const std::deque<std::vector<uint8_t>> proof_mtp[MTP_L*3],
+        const CMTPProofs& proof_mtp,
         uint256 pow_limit,
         uint256 *mtpHashValue)
 {
-    MerkleTree::Elements proof_blocks[L * 3];
-    MerkleTree::Buffer root;
-    block blocks[L * 2];
-    root.insert(root.begin(), &hash_root_mtp[0], &hash_root_mtp[16]);
-    for (int i = 0; i < (L * 3); ++i) {
-        proof_blocks[i] = proof_mtp[i];
-    }
-    for(int i = 0; i < (L * 2); ++i) {
-        std::memcpy(blocks[i].v, block_mtp[i],
-                sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
-    }
+    // blocks of the proof are used in place
+    const block *blocks = reinterpret_cast<const block *>(block_mtp);
 
 #define TEST_OUTLEN 32
 #define TEST_PWDLEN 80
@@ -263,27 +347,6 @@ bool mtp_verify(const char* input, const uint32_t target,
 #undef TEST_SECRETLEN
 #undef TEST_ADLEN
 
-    uint32_t memory_blocks = context_verify.m_cost;
-    if (memory_blocks < (2 * ARGON2_SYNC_POINTS * context_verify.lanes)) {
-        memory_blocks = 2 * ARGON2_SYNC_POINTS * context_verify.lanes;
-    }
-    uint32_t segment_length = memory_blocks / (context_verify.lanes * ARGON2_SYNC_POINTS);
-    memory_blocks = segment_length * (context_verify.lanes * ARGON2_SYNC_POINTS);
-
-    argon2_instance_t instance;
-    instance.version = context_verify.version;
-    instance.memory = NULL;
-    instance.passes = context_verify.t_cost;
-    instance.memory_blocks = context_verify.m_cost;
-    instance.segment_length = segment_length;
-    instance.lane_length = segment_length * ARGON2_SYNC_POINTS;
-    instance.lanes = context_verify.lanes;
-    instance.threads = context_verify.threads;
-    instance.type = Argon2_d;
-    if (instance.threads > instance.lanes) {
-        instance.threads = instance.lanes;
-    }
-
     // step 7
     uint256 y[L + 1];
     std::memset(&y[0], 0, sizeof(y));
@@ -297,35 +360,31 @@ bool mtp_verify(const char* input, const uint32_t target,
 
     // get hash_zero
     uint8_t h0[ARGON2_PREHASH_SEED_LENGTH];
-    initial_hash(h0, &context_verify, instance.type);
-    
-    // step 8
+    initial_hash(h0, &context_verify, Argon2_d);
+
+    uint32_t memory_blocks = M_COST;
+    if (memory_blocks < (2 * ARGON2_SYNC_POINTS * LANES)) {
+        memory_blocks = 2 * ARGON2_SYNC_POINTS * LANES;
+    }
+    uint32_t segment_length = memory_blocks / (LANES * ARGON2_SYNC_POINTS);
+    uint32_t lane_length = segment_length * ARGON2_SYNC_POINTS;
+
+    argon2_instance_t instance;
+    instance.segment_length = segment_length;
+    instance.lane_length = lane_length;
+
+    MtpVerifyBuffersHolder buffers;
+
+    // step 8. Chain of y values only depends on the blocks of the proof, so it is computed first
+    // and the openings are checked against the Merkle root afterwards
     for (uint32_t j = 1; j <= L; ++j) {
-        // compute ij
-        std::string s = "0x" + y[j - 1].GetHex();
-        boost::multiprecision::uint256_t t(s);
-        uint32_t ij = numeric_cast<uint32_t>(t % M_COST);
-
-        // retrieve x[ij-1] and x[phi(i)] from proof
-        block prev_block, ref_block, t_prev_block, t_ref_block;
-        std::memcpy(t_prev_block.v, block_mtp[(j * 2) - 2],
-                sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
-        std::memcpy(t_ref_block.v, block_mtp[j*2 - 1],
-                sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
-        copy_block(&prev_block , &t_prev_block);
-        copy_block(&ref_block , &t_ref_block);
-        clear_internal_memory(t_prev_block.v, ARGON2_BLOCK_SIZE);
-        clear_internal_memory(t_ref_block.v, ARGON2_BLOCK_SIZE);
+        // compute ij. M_COST is a power of two so only the lowest bits of y[j-1] matter
+        uint32_t ij = ReadLE32(y[j - 1].begin()) % M_COST;
 
-        //prev_index
-        //compute
-        uint32_t memory_blocks_2 = M_COST;
-        if (memory_blocks_2 < (2 * ARGON2_SYNC_POINTS * LANES)) {
-            memory_blocks_2 = 2 * ARGON2_SYNC_POINTS * LANES;
-        }
+        const block &prev_block = blocks[(j * 2) - 2];
+        const block &ref_block = blocks[(j * 2) - 1];
 
-        uint32_t segment_length_2 = memory_blocks_2 / (LANES * ARGON2_SYNC_POINTS);
-        uint32_t lane_length = segment_length_2 * ARGON2_SYNC_POINTS;
+        //prev_index
         uint32_t ij_prev = 0;
         if ((ij % lane_length) == 0) {
             ij_prev = ij + lane_length - 1;
@@ -336,79 +395,52 @@ bool mtp_verify(const char* input, const uint32_t target,
             ij_prev = ij - 1;
         }
 
-        //hash[prev_index]
-        uint8_t digest_prev[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(prev_block, digest_prev);
-        MerkleTree::Buffer hash_prev(digest_prev,
-                digest_prev + sizeof(digest_prev));
-        if (!MerkleTree::checkProofOrdered(proof_blocks[(j * 3) - 2],
-                    root, hash_prev, ij_prev + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij_prev]\n");
-            return false;
-        }
-
         //compute ref_index
         uint64_t prev_block_opening = prev_block.v[0];
         uint32_t ref_lane = static_cast<uint32_t>((prev_block_opening >> 32) % LANES);
         uint32_t pseudo_rand = static_cast<uint32_t>(prev_block_opening & 0xFFFFFFFF);
         uint32_t lane = ij / lane_length;
-        uint32_t slice = (ij - (lane * lane_length)) / segment_length_2;
+        uint32_t slice = (ij - (lane * lane_length)) / segment_length;
         uint32_t pos_index = ij - (lane * lane_length)
-            - (slice * segment_length_2);
+            - (slice * segment_length);
         if (slice == 0) {
             ref_lane = lane;
         }
 
-        argon2_instance_t instance;
-        instance.segment_length = segment_length_2;
-        instance.lane_length = lane_length;
-
         argon2_position_t position { 0, lane , (uint8_t)slice, pos_index };
         uint32_t ref_index = IndexBeta(&instance, &position, pseudo_rand,
                 ref_lane == position.lane);
 
         uint32_t computed_ref_block = (lane_length * ref_lane) + ref_index;
 
-        uint8_t digest_ref[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(ref_block, digest_ref);
-        MerkleTree::Buffer hash_ref(digest_ref, digest_ref + sizeof(digest_ref));
-        if (!MerkleTree::checkProofOrdered(proof_blocks[(j * 3) - 1],
-                    root, hash_ref, computed_ref_block + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij_ref]\n");
-            return false;
-        }
-
         // compute x[ij]
-        block block_ij;
-        fill_block_mtp(&blocks[(j * 2) - 2], &blocks[(j * 2) - 1],
-                &block_ij, 0, computed_ref_block, h0);
-
-        // verify opening
-        // hash x[ij]
-        uint8_t digest_ij[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(block_ij, digest_ij);
-        MerkleTree::Buffer hash_ij(digest_ij, digest_ij + sizeof(digest_ij));
-
-        if (!MerkleTree::checkProofOrdered(proof_blocks[(j * 3) - 3], root,
-                    hash_ij, ij + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij]\n");
-            return false;
-        }
+        block &block_ij = buffers->blocks_ij[j - 1];
+        fill_block_mtp(&prev_block, &ref_block, &block_ij, 0, computed_ref_block, h0);
+
+        MtpOpening *openings = &buffers->openings[(j * 3) - 3];
+        openings[0] = MtpOpening{&block_ij, ij + 1, "x[ij]"};
+        openings[1] = MtpOpening{&prev_block, ij_prev + 1, "x[ij_prev]"};
+        openings[2] = MtpOpening{&ref_block, computed_ref_block + 1, "x[ij_ref]"};
 
         // compute y(j)
-        block blockhash;
-        copy_block(&blockhash, &block_ij);
         uint8_t blockhash_bytes[ARGON2_BLOCK_SIZE];
-        StoreBlock(&blockhash_bytes, &blockhash);
+        StoreBlock(&blockhash_bytes, &block_ij);
         blake2b_state ctx_yj;
         blake2b_init(&ctx_yj, 32);
         blake2b_update(&ctx_yj, &y[j - 1], 32);
         blake2b_update(&ctx_yj, blockhash_bytes, ARGON2_BLOCK_SIZE);
         blake2b_final(&ctx_yj, &y[j], 32);
-        clear_internal_memory(block_ij.v, ARGON2_BLOCK_SIZE);
-        clear_internal_memory(blockhash.v, ARGON2_BLOCK_SIZE);
         clear_internal_memory(blockhash_bytes, ARGON2_BLOCK_SIZE);
-    }    
+    }
+
+    // Merkle paths of the openings are checked in parallel
+    bool fOpeningsValid = CheckOpenings(buffers->openings, hash_root_mtp, proof_mtp);
+    for (int i = 0; i < L; ++i) {
+        clear_internal_memory(buffers->blocks_ij[i].v, ARGON2_BLOCK_SIZE);
+    }
+    if (!fOpeningsValid) {
+        return false;
+    }
 
     // step 9
     bool negative;
@@ -416,10 +448,6 @@ bool mtp_verify(const char* input, const uint32_t target,
     arith_uint256 bn_target;
     bn_target.SetCompact(target, &negative, &overflow); // diff = 1
 
-    for (int i = 0; i < (L * 2); ++i) {
-        clear_internal_memory(blocks[i].v, ARGON2_BLOCK_SIZE);
-    }
-
     if (mtpHashValue)
         *mtpHashValue = y[L];
 
@@ -435,7 +463,7 @@ namespace {
 
 bool mtp_hash1(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
         unsigned int& nonce, uint64_t block_mtp[MTP_L*2][128],
-        std::deque<std::vector<uint8_t>> proof_mtp[MTP_L*3], uint256 pow_limit,
+        CMTPProofs& proof_mtp, uint256 pow_limit,
         uint256& output)
 {
 #define TEST_OUTLEN 32
@@ -623,8 +651,9 @@ bool mtp_hash1(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
         std::memcpy(block_mtp[i], &blocks[i],
                 sizeof(uint64_t) * ARGON2_QWORDS_IN_BLOCK);
     }
+    proof_mtp.Clear();
     for (int i = 0; i < L * 3; ++i) {
-        proof_mtp[i] = proof_blocks[i];
+        proof_mtp.AddProof(proof_blocks[i]);
     }
     std::memcpy(&output, &y[L], sizeof(uint256));
 
@@ -644,7 +673,7 @@ bool mtp_hash1(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
 
 void mtp_hash(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
         unsigned int& nonce, uint64_t block_mtp[MTP_L*2][128],
-        std::deque<std::vector<uint8_t>> proof_mtp[MTP_L*3], uint256 pow_limit,
+        CMTPProofs& proof_mtp, uint256 pow_limit,
         uint256& output)
 {
     bool done = false;
@@ -700,4 +729,21 @@ bool verify(uint32_t nonce, CBlockHeader const & blockHeader, uint256 const & po
             , nonce, blockHeader.mtpHashData->nBlockMTP, blockHeader.mtpHashData->nProofMTP, powLimit, mtpHashValue);
 }
 
+void verify(const std::vector<const CBlockHeader*> &blockHeaders, uint256 const & powLimit,
+        std::vector<bool> &results, std::vector<uint256> *mtpHashValues)
+{
+    std::vector<uint256> hashValues(blockHeaders.size());
+
+    // every proof is verified in parallel on the executor already, headers are taken one after another
+    results.assign(blockHeaders.size(), false);
+    for (size_t i = 0; i < blockHeaders.size(); i++) {
+        const CBlockHeader &blockHeader = *blockHeaders[i];
+        if (blockHeader.mtpHashData)
+            results[i] = verify(blockHeader.nNonce, blockHeader, powLimit, &hashValues[i]);
+    }
+
+    if (mtpHashValues)
+        mtpHashValues->swap(hashValues);
+}
+
 }
\ No newline at end of file
@@ -5,10 +5,14 @@ extern "C" {
 #include <inttypes.h>
 }
 #include "uint256.h"
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
 #include <deque>
 #include <vector>
 
 class CBlockHeader;
+class CMTPProofs;
 
 namespace mtp
 {
@@ -38,6 +42,16 @@ uint256 hash(CBlockHeader & blockHeader, uint256 const & powLimit);
  */
 bool verify(uint32_t nonce, CBlockHeader const & blockHeader, uint256 const & powLimit, uint256 *mtpHashValue=nullptr);
 
+/** Verify MTP proofs of several block headers at once
+ *
+ * Every header is checked against its own `nNonce`. Headers without MTP data fail the verification.
+ * \param blockHeaders  [in]  Headers to verify
+ * \param pow_limit     [in]  Network limit (hash must be less than that)
+ * \param results       [out] Verification result for every header
+ * \param mtpHashValues [out] Calculated MTP hash value for every header
+ */
+void verify(const std::vector<const CBlockHeader*> &blockHeaders, uint256 const & powLimit,
+        std::vector<bool> &results, std::vector<uint256> *mtpHashValues=nullptr);
 
 //Implementation details
 namespace impl
@@ -62,7 +76,7 @@ void mtp_hash(const char* input,
         uint8_t hash_root_mtp[16],
         unsigned int& nonce,
         uint64_t block_mtp[MTP_L*2][128],
-        std::deque<std::vector<uint8_t>> proof_mtp[MTP_L*3],
+        CMTPProofs& proof_mtp,
         uint256 pow_limit,
         uint256& output);
 
@@ -86,11 +100,88 @@ bool mtp_verify(const char* input,
         const uint8_t hash_root_mtp[16],
         const uint32_t nonce,
         const uint64_t block_mtp[MTP_L*2][128],
-        const std::deque<std::vector<uint8_t>> proof_mtp[MTP_L*3],
+        const CMTPProofs& proof_mtp,
         uint256 pow_limit,
         uint256 *mtpHashValue=nullptr);
 }
 
 }
 
+/**
+ * Merkle proofs of all the MTP openings stored back to back in a single buffer of 16 byte nodes.
+ * Nodes of the proof `i` are [nOffsets[i], nOffsets[i+1]) so no node is allocated on its own
+ * and the proofs can be (de)serialized directly from/to the buffer
+ */
+class CMTPProofs
+{
+public:
+    //! Size of a Merkle tree node (128 bit of blake2b)
+    static const size_t NODE_SIZE = 16;
+    //! Number of proofs, one for every opening
+    static const int PROOF_COUNT = mtp::MTP_L * 3;
+    //! Length of a valid proof for the 4M blocks of MTP memory, used to preallocate the buffer
+    static const size_t EXPECTED_PROOF_SIZE = 22;
+
+    CMTPProofs()
+    {
+        Clear();
+    }
+
+    void Clear()
+    {
+        vNodes.clear();
+        std::fill(nOffsets, nOffsets + PROOF_COUNT + 1, 0);
+        nProofs = 0;
+    }
+
+    //! Append room for the next proof of nNodes nodes and return pointer to it. Proofs are added in order
+    uint8_t *AppendProof(size_t nNodes)
+    {
+        assert(nProofs < PROOF_COUNT && nNodes < 256);
+        if (vNodes.capacity() == 0)
+            vNodes.reserve(PROOF_COUNT * EXPECTED_PROOF_SIZE * NODE_SIZE);
+
+        size_t nOffset = nOffsets[nProofs];
+        vNodes.resize((nOffset + nNodes) * NODE_SIZE);
+        nProofs++;
+        std::fill(nOffsets + nProofs, nOffsets + PROOF_COUNT + 1, nOffset + nNodes);
+        return vNodes.data() + nOffset * NODE_SIZE;
+    }
+
+    void AddProof(const uint8_t *pNodes, size_t nNodes)
+    {
+        uint8_t *pDest = AppendProof(nNodes);
+        if (nNodes > 0)
+            memcpy(pDest, pNodes, nNodes * NODE_SIZE);
+    }
+
+    void AddProof(const std::deque<std::vector<uint8_t>> &proof)
+    {
+        uint8_t *pDest = AppendProof(proof.size());
+        for (const std::vector<uint8_t> &node: proof) {
+            assert(node.size() == NODE_SIZE);
+            pDest = std::copy(node.begin(), node.end(), pDest);
+        }
+    }
+
+    //! Number of nodes in the proof i
+    size_t GetProofSize(int i) const { return nOffsets[i + 1] - nOffsets[i]; }
+    const uint8_t *GetProof(int i) const { return vNodes.data() + nOffsets[i] * NODE_SIZE; }
+    uint8_t *GetProof(int i) { return vNodes.data() + nOffsets[i] * NODE_SIZE; }
+
+    //! Total number of nodes in all the proofs
+    size_t GetNodeCount() const { return nOffsets[PROOF_COUNT]; }
+
+    friend bool operator==(const CMTPProofs &a, const CMTPProofs &b)
+    {
+        return std::equal(a.nOffsets, a.nOffsets + PROOF_COUNT + 1, b.nOffsets) && a.vNodes == b.vNodes;
+    }
+
+private:
+    std::vector<uint8_t> vNodes;
+    //! Proofs are at most 255 nodes long (see CMTPHashData serialization) so 16 bits are enough
+    uint16_t nOffsets[PROOF_COUNT + 1];
+    int nProofs;
+};
+
 #endif
@@ -0,0 +1,227 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "executor.h"
+
+#include "util.h"
+
+#include <algorithm>
+
+// Index of the queue owned by the current thread, 0 if thread is not a worker of the executor
+static thread_local int nCurrentWorkerQueue = 0;
+static thread_local CExecutor *pCurrentExecutor = NULL;
+
+CExecutor::CExecutor() : nThreads(0), fStop(false), nQueueDepth(0), nStolen(0), nExecuted(0)
+{
+    // queues are never reallocated so workers and waiting threads can access them without locking the vector
+    for (int i = 0; i <= MAX_EXECUTOR_THREADS; i++)
+        queues.emplace_back(new WorkQueue());
+}
+
+CExecutor::~CExecutor()
+{
+    Stop();
+}
+
+void CExecutor::Start(int nThreadsIn)
+{
+    std::unique_lock<std::mutex> lock(csWorkers);
+    if (!threads.empty())
+        return;
+
+    fStop = false;
+    nThreadsIn = std::min(nThreadsIn, MAX_EXECUTOR_THREADS);
+    for (int i = 1; i <= nThreadsIn; i++)
+        threads.emplace_back(&CExecutor::ThreadWorker, this, i);
+    nThreads = nThreadsIn;
+}
+
+void CExecutor::Stop()
+{
+    std::vector<std::thread> threadsToJoin;
+    {
+        std::unique_lock<std::mutex> lock(csWorkers);
+        fStop = true;
+        threadsToJoin.swap(threads);
+    }
+    condWorkers.notify_all();
+
+    for (std::thread &t: threadsToJoin)
+        t.join();
+
+    nThreads = 0;
+}
+
+void CExecutor::Submit(Task task)
+{
+    int nQueue = pCurrentExecutor == this ? nCurrentWorkerQueue : 0;
+    // counter is increased first so it never goes below zero
+    nQueueDepth++;
+    {
+        WorkQueue &queue = *queues[nQueue];
+        std::unique_lock<std::mutex> lock(queue.cs);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    // Taking the mutex ensures the worker either sees the new queue depth or is already waiting
+    { std::unique_lock<std::mutex> lock(csWorkers); }
+    condWorkers.notify_one();
+}
+
+bool CExecutor::PopTask(int nQueue, bool fBack, Task &task)
+{
+    WorkQueue &queue = *queues[nQueue];
+    std::unique_lock<std::mutex> lock(queue.cs);
+    if (queue.tasks.empty())
+        return false;
+
+    if (fBack) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+    }
+    else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+    }
+    nQueueDepth--;
+    return true;
+}
+
+bool CExecutor::RunPendingTask()
+{
+    int nOwnQueue = pCurrentExecutor == this ? nCurrentWorkerQueue : 0;
+    Task task;
+
+    // Own queue is used as a stack to keep recently submitted (hot) data in cache, the shared one is FIFO
+    bool fFound = (nOwnQueue != 0 && PopTask(nOwnQueue, true, task)) || PopTask(0, false, task);
+
+    if (!fFound) {
+        // Steal the oldest task from the other workers. Tasks can be left in the queues of stopped
+        // workers so check all the queues
+        for (int i = 1; i <= MAX_EXECUTOR_THREADS && !fFound && nQueueDepth > 0; i++) {
+            int nQueue = (nOwnQueue + i - 1) % MAX_EXECUTOR_THREADS + 1;
+            if (nQueue != nOwnQueue && PopTask(nQueue, false, task)) {
+                fFound = true;
+                nStolen++;
+            }
+        }
+    }
+
+    if (!fFound)
+        return false;
+
+    task();
+    nExecuted++;
+    return true;
+}
+
+void CExecutor::ThreadWorker(int nWorker)
+{
+    RenameThread(strprintf("zcoin-worker-%d", nWorker).c_str());
+    pCurrentExecutor = this;
+    nCurrentWorkerQueue = nWorker;
+
+    for (;;) {
+        if (RunPendingTask())
+            continue;
+
+        // queued tasks are finished before the worker stops, nobody else runs them
+        std::unique_lock<std::mutex> lock(csWorkers);
+        condWorkers.wait(lock, [this] { return nQueueDepth > 0 || fStop; });
+        if (fStop && nQueueDepth == 0)
+            break;
+    }
+}
+
+CExecutor::Stats CExecutor::GetStats() const
+{
+    Stats stats;
+    stats.nQueueDepth = nQueueDepth;
+    stats.nStolen = nStolen;
+    stats.nExecuted = nExecuted;
+    stats.nThreads = nThreads;
+    return stats;
+}
+
+CExecutor &GetExecutor()
+{
+    static CExecutor executor;
+    return executor;
+}
+
+// CExecutorTaskGroup
+
+CExecutorTaskGroup::CExecutorTaskGroup(CExecutor &executorIn) : executor(executorIn), state(std::make_shared<State>())
+{
+}
+
+CExecutorTaskGroup::~CExecutorTaskGroup()
+{
+    WaitForTasks();
+}
+
+void CExecutorTaskGroup::Add(CExecutor::Task task)
+{
+    {
+        std::unique_lock<std::mutex> lock(state->cs);
+        state->tasks.push_back(std::move(task));
+        state->nPending++;
+    }
+
+    std::shared_ptr<State> groupState = state;
+    executor.Submit([groupState] { RunTask(*groupState); });
+}
+
+bool CExecutorTaskGroup::RunTask(State &state)
+{
+    CExecutor::Task task;
+    {
+        std::unique_lock<std::mutex> lock(state.cs);
+        // the waiting thread could have taken the task already
+        if (state.tasks.empty())
+            return false;
+        task = std::move(state.tasks.front());
+        state.tasks.pop_front();
+    }
+
+    std::exception_ptr taskException;
+    try {
+        task();
+    }
+    catch (...) {
+        taskException = std::current_exception();
+    }
+
+    std::unique_lock<std::mutex> lock(state.cs);
+    if (taskException && !state.exception)
+        state.exception = taskException;
+    if (--state.nPending == 0)
+        state.cond.notify_all();
+    return true;
+}
+
+void CExecutorTaskGroup::WaitForTasks()
+{
+    // help with the pending work of the group instead of sleeping
+    while (RunTask(*state))
+        ;
+
+    // all the remaining tasks of the group are being executed by other threads
+    std::unique_lock<std::mutex> lock(state->cs);
+    state->cond.wait(lock, [this] { return state->nPending == 0; });
+}
+
+void CExecutorTaskGroup::Wait()
+{
+    WaitForTasks();
+
+    std::exception_ptr taskException;
+    {
+        std::unique_lock<std::mutex> lock(state->cs);
+        taskException = state->exception;
+        state->exception = nullptr;
+    }
+    if (taskException)
+        std::rethrow_exception(taskException);
+}
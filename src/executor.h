@@ -0,0 +1,129 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_EXECUTOR_H
+#define BITCOIN_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Maximum number of worker threads of the executor */
+static const int MAX_EXECUTOR_THREADS = 64;
+
+/**
+ * Process-wide pool of worker threads shared by script checks and zerocoin proof
+ * generation/verification.
+ *
+ * Every worker has its own deque of tasks. Workers take tasks from the back of their own
+ * deque and steal from the front of other deques when they run out of work. Tasks submitted
+ * from outside of the pool go to the shared deque. Tasks that have to be waited for are added
+ * through CExecutorTaskGroup, whose waiting thread executes the pending tasks of its own group,
+ * so tasks can safely submit and wait for other tasks, and everything still works when no
+ * worker threads are started.
+ */
+class CExecutor
+{
+public:
+    typedef std::function<void()> Task;
+
+    struct Stats {
+        //! Number of tasks waiting in the queues
+        size_t nQueueDepth;
+        //! Number of tasks taken from the queue of other worker
+        uint64_t nStolen;
+        //! Total number of executed tasks
+        uint64_t nExecuted;
+        //! Number of worker threads
+        int nThreads;
+    };
+
+    CExecutor();
+    ~CExecutor();
+
+    //! Start worker threads. Does nothing if already started
+    void Start(int nThreadsIn);
+    //! Stop and join worker threads once the queued tasks are done
+    void Stop();
+
+    //! Queue the task for execution. Nothing waits for the task, see CExecutorTaskGroup
+    void Submit(Task task);
+
+    int GetThreadCount() const { return nThreads; }
+    Stats GetStats() const;
+
+private:
+    struct WorkQueue {
+        std::mutex cs;
+        std::deque<Task> tasks;
+    };
+
+    //! queues[0] is shared, queues[i] belongs to the worker i
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<int> nThreads;
+
+    std::mutex csWorkers;
+    std::condition_variable condWorkers;
+    bool fStop;
+
+    std::atomic<size_t> nQueueDepth;
+    std::atomic<uint64_t> nStolen;
+    std::atomic<uint64_t> nExecuted;
+
+    bool PopTask(int nQueue, bool fBack, Task &task);
+    //! Execute one pending task in the calling worker. Returns false if there was nothing to do
+    bool RunPendingTask();
+    void ThreadWorker(int nWorker);
+};
+
+//! Executor instance used by the whole process
+CExecutor &GetExecutor();
+
+/**
+ * Group of tasks submitted to the executor that can be waited for as a whole. The tasks are kept
+ * in the queue of the group, the executor gets one runner per task that executes the next task of
+ * the group. Waiting thread executes the tasks of the group meanwhile but never tasks of other
+ * groups, which may take long or need locks the waiting thread can't take. The first exception
+ * thrown by a task is rethrown by Wait()
+ */
+class CExecutorTaskGroup
+{
+public:
+    CExecutorTaskGroup(CExecutor &executorIn = GetExecutor());
+    //! Waits for the tasks still running, exceptions are ignored
+    ~CExecutorTaskGroup();
+
+    void Add(CExecutor::Task task);
+    void Wait();
+
+private:
+    //! Shared with the runners, which can still be queued in the executor after the group is gone
+    struct State {
+        std::mutex cs;
+        std::condition_variable cond;
+        //! Tasks that haven't started yet
+        std::deque<CExecutor::Task> tasks;
+        //! Tasks that haven't finished yet
+        size_t nPending;
+        std::exception_ptr exception;
+
+        State() : nPending(0) {}
+    };
+
+    CExecutor &executor;
+    std::shared_ptr<State> state;
+
+    //! Execute the next task of the group. Returns false if all the tasks have started
+    static bool RunTask(State &state);
+    void WaitForTasks();
+};
+
+#endif // BITCOIN_EXECUTOR_H
@@ -0,0 +1,83 @@
+/**
+ * @file consensusbalances.cpp
+ *
+ * This file contains the incrementally maintained balance stage of the consensus hash.
+ */
+
+#include "exodus/consensusbalances.h"
+
+namespace exodus
+{
+void CConsensusBalances::Set(const std::string& address, const std::string& data)
+{
+    std::string prefix = address.substr(0, CONSENSUS_BUCKET_PREFIX_SIZE);
+
+    if (data.empty()) {
+        std::map<std::string, Bucket>::iterator itBucket = buckets.find(prefix);
+        if (itBucket == buckets.end()) return;
+
+        Bucket& bucket = itBucket->second;
+        if (bucket.entries.erase(address) == 0) return;
+        --nEntries;
+        if (bucket.entries.empty()) {
+            buckets.erase(itBucket);
+        } else {
+            bucket.fDirty = true;
+        }
+        return;
+    }
+
+    Bucket& bucket = buckets[prefix];
+    std::pair<std::map<std::string, std::string>::iterator, bool> inserted = bucket.entries.insert(std::make_pair(address, data));
+    if (inserted.second) {
+        ++nEntries;
+    } else if (inserted.first->second != data) {
+        inserted.first->second = data;
+    } else {
+        return;
+    }
+    bucket.fDirty = true;
+}
+
+void CConsensusBalances::Write(SHA256_CTX* shaCtx) const
+{
+    for (std::map<std::string, Bucket>::const_iterator itBucket = buckets.begin(); itBucket != buckets.end(); ++itBucket) {
+        const std::map<std::string, std::string>& entries = itBucket->second.entries;
+        for (std::map<std::string, std::string>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+            SHA256_Update(shaCtx, it->second.data(), it->second.size());
+        }
+    }
+}
+
+uint256 CConsensusBalances::GetRoot()
+{
+    SHA256_CTX rootCtx;
+    SHA256_Init(&rootCtx);
+
+    for (std::map<std::string, Bucket>::iterator itBucket = buckets.begin(); itBucket != buckets.end(); ++itBucket) {
+        Bucket& bucket = itBucket->second;
+        if (bucket.fDirty) {
+            SHA256_CTX bucketCtx;
+            SHA256_Init(&bucketCtx);
+            for (std::map<std::string, std::string>::const_iterator it = bucket.entries.begin(); it != bucket.entries.end(); ++it) {
+                SHA256_Update(&bucketCtx, it->second.data(), it->second.size());
+            }
+            SHA256_Final(bucket.hash.begin(), &bucketCtx);
+            bucket.fDirty = false;
+        }
+        SHA256_Update(&rootCtx, bucket.hash.begin(), bucket.hash.size());
+    }
+
+    uint256 root;
+    SHA256_Final(root.begin(), &rootCtx);
+
+    return root;
+}
+
+void CConsensusBalances::Clear()
+{
+    buckets.clear();
+    changed.clear();
+    nEntries = 0;
+}
+}
@@ -0,0 +1,95 @@
+#ifndef EXODUS_CONSENSUSBALANCES_H
+#define EXODUS_CONSENSUSBALANCES_H
+
+#include "uint256.h"
+
+#include <openssl/sha.h>
+
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <unordered_set>
+
+namespace exodus
+{
+//! Number of leading address characters which select the bucket of an address
+size_t const CONSENSUS_BUCKET_PREFIX_SIZE = 3;
+
+/** Incrementally maintained balance stage of the consensus hash.
+ *
+ * The balance strings of each address are cached in buckets, which are selected by the first
+ * characters of the address. As the buckets and their entries are both sorted, iterating over
+ * them yields the addresses in lexicographical order, as required by the consensus hash.
+ *
+ * Changed addresses are only marked, and refreshed in one go before the balances are hashed,
+ * so only the buckets of changed addresses are hashed again to obtain the root of the balances.
+ */
+class CConsensusBalances
+{
+private:
+    struct Bucket {
+        Bucket() : fDirty(true) {}
+
+        //! Balance strings of the addresses in the bucket
+        std::map<std::string, std::string> entries;
+        //! Hash of the entries, valid if not dirty
+        uint256 hash;
+        bool fDirty;
+    };
+
+    std::map<std::string, Bucket> buckets;
+    std::unordered_set<std::string> changed;
+    size_t nEntries;
+
+public:
+    CConsensusBalances() : nEntries(0) {}
+
+    /** Marks the balances of the address as changed. */
+    void MarkChanged(const std::string& address) { changed.insert(address); }
+
+    /** Returns true, if there are addresses which were not refreshed yet. */
+    bool HasChanges() const { return !changed.empty(); }
+
+    /**
+     * Refreshes the balance strings of the changed addresses. The functor returns the balance
+     * string of an address, an empty string removes the address.
+     */
+    template <typename GetBalanceString>
+    void Refresh(GetBalanceString getBalanceString)
+    {
+        for (std::unordered_set<std::string>::const_iterator it = changed.begin(); it != changed.end(); ++it) {
+            Set(*it, getBalanceString(*it));
+        }
+        changed.clear();
+    }
+
+    /** Stores the balance string of the address, an empty string removes the address. */
+    void Set(const std::string& address, const std::string& data);
+
+    /** Calls the functor with the address and the balance string of all addresses in lexicographical order. */
+    template <typename Visitor>
+    void ForEach(Visitor visitor) const
+    {
+        for (std::map<std::string, Bucket>::const_iterator itBucket = buckets.begin(); itBucket != buckets.end(); ++itBucket) {
+            const std::map<std::string, std::string>& entries = itBucket->second.entries;
+            for (std::map<std::string, std::string>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+                visitor(it->first, it->second);
+            }
+        }
+    }
+
+    /** Updates the SHA256 context with the balance strings of all addresses in lexicographical order. */
+    void Write(SHA256_CTX* shaCtx) const;
+
+    /** Returns the hash over the hashes of all buckets, only the changed buckets are hashed again. */
+    uint256 GetRoot();
+
+    /** Returns the number of addresses with balances. */
+    size_t size() const { return nEntries; }
+
+    /** Removes all entries and pending changes. */
+    void Clear();
+};
+}
+
+#endif // EXODUS_CONSENSUSBALANCES_H
@@ -5,12 +5,14 @@
  */
 
 #include "exodus/consensushash.h"
+#include "exodus/consensusbalances.h"
 #include "exodus/dex.h"
 #include "exodus/mdex.h"
 #include "exodus/log.h"
 #include "exodus/exodus.h"
 #include "exodus/parse_string.h"
 #include "exodus/sp.h"
+#include "exodus/tally.h"
 
 #include "arith_uint256.h"
 #include "uint256.h"
@@ -18,6 +20,7 @@
 #include <stdint.h>
 #include <algorithm>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <openssl/sha.h>
@@ -29,6 +32,10 @@ bool ShouldConsensusHashBlock(int block) {
         return true;
     }
 
+    return IsConsensusHashBlockRequested(block);
+}
+
+bool IsConsensusHashBlockRequested(int block) {
     if (!mapArgs.count("-exodusshowblockconsensushash")) {
         return false;
     }
@@ -98,87 +105,40 @@ std::string GenerateConsensusString(const uint32_t propertyId, const std::string
     return strprintf("%d|%s", propertyId, address);
 }
 
-/**
- * Obtains a hash of the active state to use for consensus verification and checkpointing.
- *
- * For increased flexibility, so other implementations like OmniWallet and OmniChest can
- * also apply this methodology without necessarily using the same exact data types (which
- * would be needed to hash the data bytes directly), create a string in the following
- * format for each entry to use for hashing:
- *
- * ---STAGE 1 - BALANCES---
- * Format specifiers & placeholders:
- *   "%s|%d|%d|%d|%d|%d" - "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
- *
- * Note: empty balance records and the pending tally are ignored. Addresses are sorted based
- * on lexicographical order, and balance records are sorted by the property identifiers.
- *
- * ---STAGE 2 - DEX SELL OFFERS---
- * Format specifiers & placeholders:
- *   "%s|%s|%d|%d|%d|%d|%d" - "txid|address|propertyid|offeramount|btcdesired|minfee|timelimit"
- *
- * Note: ordered ascending by txid.
- *
- * ---STAGE 3 - DEX ACCEPTS---
- * Format specifiers & placeholders:
- *   "%s|%s|%d|%d|%d" - "matchedselloffertxid|buyer|acceptamount|acceptamountremaining|acceptblock"
- *
- * Note: ordered ascending by matchedselloffertxid followed by buyer.
- *
- * ---STAGE 4 - METADEX TRADES---
- * Format specifiers & placeholders:
- *   "%s|%s|%d|%d|%d|%d|%d" - "txid|address|propertyidforsale|amountforsale|propertyiddesired|amountdesired|amountremaining"
- *
- * Note: ordered ascending by txid.
- *
- * ---STAGE 5 - CROWDSALES---
- * Format specifiers & placeholders:
- *   "%d|%d|%d|%d|%d" - "propertyid|propertyiddesired|deadline|usertokens|issuertokens"
- *
- * Note: ordered by property ID.
- *
- * ---STAGE 6 - PROPERTIES---
- * Format specifiers & placeholders:
- *   "%d|%s" - "propertyid|issueraddress"
- *
- * Note: ordered by property ID.
- *
- * The byte order is important, and we assume:
- *   SHA256("abc") = "ad1500f261ff10b49c7a1796a36103b02322ae5dde404141eacf018fbf1678ba"
- *
- */
-uint256 GetConsensusHash()
+//! Balance stage of the consensus hash, guarded by cs_tally
+static CConsensusBalances consensusBalances;
+
+//! Returns the balance strings of all properties of the address, which are sorted by property identifier
+static std::string GetConsensusBalanceString(const std::string& address)
 {
-    // allocate and init a SHA256_CTX
-    SHA256_CTX shaCtx;
-    SHA256_Init(&shaCtx);
+    std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.find(address);
+    if (it == mp_tally_map.end()) return "";
 
-    LOCK(cs_tally);
+    std::string result;
+    const CMPTally& tally = it->second;
+    for (CMPTally::const_iterator itRecord = tally.begin(); itRecord != tally.end(); ++itRecord) {
+        result += GenerateConsensusString(tally, address, itRecord->first); // empty balances yield empty strings
+    }
 
-    if (exodus_debug_consensus_hash) PrintToLog("Beginning generation of current consensus hash...\n");
+    return result;
+}
 
-    // Balances - loop through the tally map, updating the sha context with the data from each balance and tally type
-    // Placeholders:  "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
-    // Sort alphabetically first
-    std::map<std::string, CMPTally> tallyMapSorted;
-    for (std::unordered_map<string, CMPTally>::iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
-        tallyMapSorted.insert(std::make_pair(uoit->first,uoit->second));
-    }
-    for (std::map<string, CMPTally>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
-        const std::string& address = my_it->first;
-        CMPTally& tally = my_it->second;
-        tally.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = (tally.next()))) {
-            std::string dataStr = GenerateConsensusString(tally, address, propertyId);
-            if (dataStr.empty()) continue; // skip empty balances
-            if (exodus_debug_consensus_hash) PrintToLog("Adding balance data to consensus hash: %s\n", dataStr);
-            SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
-        }
-    }
+static void RefreshConsensusBalances()
+{
+    AssertLockHeld(cs_tally);
 
-    // DEx sell offers - loop through the DEx and add each sell offer to the consensus hash (ordered by txid)
-    // Placeholders: "txid|address|propertyid|offeramount|btcdesired|minfee|timelimit"
+    consensusBalances.Refresh(GetConsensusBalanceString);
+}
+
+static void LogBalanceString(const std::string& address, const std::string& dataStr)
+{
+    PrintToLog("Adding balance data to consensus hash: %s\n", dataStr);
+}
+
+// DEx sell offers - loop through the DEx and add each sell offer to the consensus hash (ordered by txid)
+// Placeholders: "txid|address|propertyid|offeramount|btcdesired|minfee|timelimit"
+static void UpdateWithDExOffers(SHA256_CTX* shaCtx)
+{
     std::vector<std::pair<arith_uint256, std::string> > vecDExOffers;
     for (OfferMap::iterator it = my_offers.begin(); it != my_offers.end(); ++it) {
         const CMPOffer& selloffer = it->second;
@@ -191,11 +151,14 @@ uint256 GetConsensusHash()
     for (std::vector<std::pair<arith_uint256, std::string> >::iterator it = vecDExOffers.begin(); it != vecDExOffers.end(); ++it) {
         const std::string& dataStr = it->second;
         if (exodus_debug_consensus_hash) PrintToLog("Adding DEx offer data to consensus hash: %s\n", dataStr);
-        SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
+        SHA256_Update(shaCtx, dataStr.c_str(), dataStr.length());
     }
+}
 
-    // DEx accepts - loop through the accepts map and add each accept to the consensus hash (ordered by matchedtxid then buyer)
-    // Placeholders: "matchedselloffertxid|buyer|acceptamount|acceptamountremaining|acceptblock"
+// DEx accepts - loop through the accepts map and add each accept to the consensus hash (ordered by matchedtxid then buyer)
+// Placeholders: "matchedselloffertxid|buyer|acceptamount|acceptamountremaining|acceptblock"
+static void UpdateWithDExAccepts(SHA256_CTX* shaCtx)
+{
     std::vector<std::pair<std::string, std::string> > vecAccepts;
     for (AcceptMap::const_iterator it = my_accepts.begin(); it != my_accepts.end(); ++it) {
         const CMPAccept& accept = it->second;
@@ -209,11 +172,14 @@ uint256 GetConsensusHash()
     for (std::vector<std::pair<std::string, std::string> >::iterator it = vecAccepts.begin(); it != vecAccepts.end(); ++it) {
         const std::string& dataStr = it->second;
         if (exodus_debug_consensus_hash) PrintToLog("Adding DEx accept to consensus hash: %s\n", dataStr);
-        SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
+        SHA256_Update(shaCtx, dataStr.c_str(), dataStr.length());
     }
+}
 
-    // MetaDEx trades - loop through the MetaDEx maps and add each open trade to the consensus hash (ordered by txid)
-    // Placeholders: "txid|address|propertyidforsale|amountforsale|propertyiddesired|amountdesired|amountremaining"
+// MetaDEx trades - loop through the MetaDEx maps and add each open trade to the consensus hash (ordered by txid)
+// Placeholders: "txid|address|propertyidforsale|amountforsale|propertyiddesired|amountdesired|amountremaining"
+static void UpdateWithMetaDExTrades(SHA256_CTX* shaCtx)
+{
     std::vector<std::pair<arith_uint256, std::string> > vecMetaDExTrades;
     for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
         const md_PricesMap& prices = my_it->second;
@@ -230,13 +196,16 @@ uint256 GetConsensusHash()
     for (std::vector<std::pair<arith_uint256, std::string> >::iterator it = vecMetaDExTrades.begin(); it != vecMetaDExTrades.end(); ++it) {
         const std::string& dataStr = it->second;
         if (exodus_debug_consensus_hash) PrintToLog("Adding MetaDEx trade data to consensus hash: %s\n", dataStr);
-        SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
+        SHA256_Update(shaCtx, dataStr.c_str(), dataStr.length());
     }
+}
 
-    // Crowdsales - loop through open crowdsales and add to the consensus hash (ordered by property ID)
-    // Note: the variables of the crowdsale (amount, bonus etc) are not part of the crowdsale map and not included here to
-    // avoid additionalal loading of SP entries from the database
-    // Placeholders: "propertyid|propertyiddesired|deadline|usertokens|issuertokens"
+// Crowdsales - loop through open crowdsales and add to the consensus hash (ordered by property ID)
+// Note: the variables of the crowdsale (amount, bonus etc) are not part of the crowdsale map and not included here to
+// avoid additionalal loading of SP entries from the database
+// Placeholders: "propertyid|propertyiddesired|deadline|usertokens|issuertokens"
+static void UpdateWithCrowdsales(SHA256_CTX* shaCtx)
+{
     std::vector<std::pair<uint32_t, std::string> > vecCrowds;
     for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
         const CMPCrowd& crowd = it->second;
@@ -248,8 +217,81 @@ uint256 GetConsensusHash()
     for (std::vector<std::pair<uint32_t, std::string> >::iterator it = vecCrowds.begin(); it != vecCrowds.end(); ++it) {
         std::string dataStr = (*it).second;
         if (exodus_debug_consensus_hash) PrintToLog("Adding Crowdsale entry to consensus hash: %s\n", dataStr);
-        SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
+        SHA256_Update(shaCtx, dataStr.c_str(), dataStr.length());
     }
+}
+
+/**
+ * Obtains a hash of the active state to use for consensus verification and checkpointing.
+ *
+ * For increased flexibility, so other implementations like OmniWallet and OmniChest can
+ * also apply this methodology without necessarily using the same exact data types (which
+ * would be needed to hash the data bytes directly), create a string in the following
+ * format for each entry to use for hashing:
+ *
+ * ---STAGE 1 - BALANCES---
+ * Format specifiers & placeholders:
+ *   "%s|%d|%d|%d|%d|%d" - "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
+ *
+ * Note: empty balance records and the pending tally are ignored. Addresses are sorted based
+ * on lexicographical order, and balance records are sorted by the property identifiers.
+ *
+ * ---STAGE 2 - DEX SELL OFFERS---
+ * Format specifiers & placeholders:
+ *   "%s|%s|%d|%d|%d|%d|%d" - "txid|address|propertyid|offeramount|btcdesired|minfee|timelimit"
+ *
+ * Note: ordered ascending by txid.
+ *
+ * ---STAGE 3 - DEX ACCEPTS---
+ * Format specifiers & placeholders:
+ *   "%s|%s|%d|%d|%d" - "matchedselloffertxid|buyer|acceptamount|acceptamountremaining|acceptblock"
+ *
+ * Note: ordered ascending by matchedselloffertxid followed by buyer.
+ *
+ * ---STAGE 4 - METADEX TRADES---
+ * Format specifiers & placeholders:
+ *   "%s|%s|%d|%d|%d|%d|%d" - "txid|address|propertyidforsale|amountforsale|propertyiddesired|amountdesired|amountremaining"
+ *
+ * Note: ordered ascending by txid.
+ *
+ * ---STAGE 5 - CROWDSALES---
+ * Format specifiers & placeholders:
+ *   "%d|%d|%d|%d|%d" - "propertyid|propertyiddesired|deadline|usertokens|issuertokens"
+ *
+ * Note: ordered by property ID.
+ *
+ * ---STAGE 6 - PROPERTIES---
+ * Format specifiers & placeholders:
+ *   "%d|%s" - "propertyid|issueraddress"
+ *
+ * Note: ordered by property ID.
+ *
+ * The byte order is important, and we assume:
+ *   SHA256("abc") = "ad1500f261ff10b49c7a1796a36103b02322ae5dde404141eacf018fbf1678ba"
+ *
+ */
+uint256 GetConsensusHash()
+{
+    // allocate and init a SHA256_CTX
+    SHA256_CTX shaCtx;
+    SHA256_Init(&shaCtx);
+
+    LOCK(cs_tally);
+
+    if (exodus_debug_consensus_hash) PrintToLog("Beginning generation of current consensus hash...\n");
+
+    // Balances - the balance strings of each address are cached, and already sorted alphabetically
+    // Placeholders:  "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
+    RefreshConsensusBalances();
+    if (exodus_debug_consensus_hash) {
+        consensusBalances.ForEach(LogBalanceString);
+    }
+    consensusBalances.Write(&shaCtx);
+
+    UpdateWithDExOffers(&shaCtx);
+    UpdateWithDExAccepts(&shaCtx);
+    UpdateWithMetaDExTrades(&shaCtx);
+    UpdateWithCrowdsales(&shaCtx);
 
     // Properties - loop through each property and store the issuer (to capture state changes via change issuer transactions)
     // Note: we are loading every SP from the DB to check the issuer, if using consensus_hash_every_block debug option this
@@ -277,6 +319,56 @@ uint256 GetConsensusHash()
     return consensusHash;
 }
 
+/**
+ * Obtains a commitment to the active state, which is cheap enough to be calculated for every block.
+ *
+ * The commitment is the SHA256 hash of:
+ *
+ * - the root of the balances: the SHA256 hash over the hashes of the buckets of addresses, where
+ *   each bucket holds the addresses with the same first CONSENSUS_BUCKET_PREFIX_SIZE characters,
+ *   and is hashed like stage 1 of the consensus hash
+ * - the stages 2 to 5 of the consensus hash (DEx offers and accepts, MetaDEx trades, crowdsales)
+ * - the next property identifiers of both ecosystems in the format "%d|%d"
+ *
+ * Only the buckets with changed balances are hashed again. The property issuers are not covered,
+ * because they would have to be loaded from the database.
+ */
+uint256 GetConsensusCommitment()
+{
+    SHA256_CTX shaCtx;
+    SHA256_Init(&shaCtx);
+
+    LOCK(cs_tally);
+
+    RefreshConsensusBalances();
+    uint256 balancesRoot = consensusBalances.GetRoot();
+    if (exodus_debug_consensus_hash) PrintToLog("Balances root of %d addresses: %s\n", consensusBalances.size(), balancesRoot.GetHex());
+    SHA256_Update(&shaCtx, balancesRoot.begin(), balancesRoot.size());
+
+    UpdateWithDExOffers(&shaCtx);
+    UpdateWithDExAccepts(&shaCtx);
+    UpdateWithMetaDExTrades(&shaCtx);
+    UpdateWithCrowdsales(&shaCtx);
+
+    std::string dataStr = strprintf("%d|%d", _my_sps->peekNextSPID(EXODUS_PROPERTY_EXODUS), _my_sps->peekNextSPID(EXODUS_PROPERTY_TEXODUS));
+    SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
+
+    uint256 commitment;
+    SHA256_Final((unsigned char*)&commitment, &shaCtx);
+
+    return commitment;
+}
+
+void MarkConsensusBalancesChanged(const std::string& address)
+{
+    consensusBalances.MarkChanged(address);
+}
+
+void ClearConsensusBalances()
+{
+    consensusBalances.Clear();
+}
+
 uint256 GetMetaDExHash(const uint32_t propertyId)
 {
     SHA256_CTX shaCtx;
@@ -318,23 +410,24 @@ uint256 GetBalancesHash(const uint32_t hashPropertyId)
 
     LOCK(cs_tally);
 
-    std::map<std::string, CMPTally> tallyMapSorted;
-    for (std::unordered_map<string, CMPTally>::iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
-        tallyMapSorted.insert(std::make_pair(uoit->first,uoit->second));
-    }
-    for (std::map<string, CMPTally>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
-        const std::string& address = my_it->first;
-        CMPTally& tally = my_it->second;
-        tally.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = (tally.next()))) {
-            if (propertyId != hashPropertyId) continue;
-            std::string dataStr = GenerateConsensusString(tally, address, propertyId);
-            if (dataStr.empty()) continue;
-            if (exodus_debug_consensus_hash) PrintToLog("Adding data to balances hash: %s\n", dataStr);
-            SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
+    // only the holders of the property are sorted alphabetically, the tally map isn't copied
+    std::vector<std::string> holders;
+    const CMPTallyIndex::HolderMap* holderMap = mp_tally_index.getHolders(hashPropertyId);
+    if (holderMap) {
+        holders.reserve(holderMap->size());
+        for (CMPTallyIndex::HolderMap::const_iterator it = holderMap->begin(); it != holderMap->end(); ++it) {
+            holders.push_back(it->first);
         }
     }
+    std::sort(holders.begin(), holders.end());
+    for (std::vector<std::string>::const_iterator it = holders.begin(); it != holders.end(); ++it) {
+        std::unordered_map<std::string, CMPTally>::const_iterator itTally = mp_tally_map.find(*it);
+        if (itTally == mp_tally_map.end()) continue;
+        std::string dataStr = GenerateConsensusString(itTally->second, *it, hashPropertyId);
+        if (dataStr.empty()) continue;
+        if (exodus_debug_consensus_hash) PrintToLog("Adding data to balances hash: %s\n", dataStr);
+        SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
+    }
 
     uint256 balancesHash;
     SHA256_Final((unsigned char*)&balancesHash, &shaCtx);
@@ -3,14 +3,28 @@
 
 #include "uint256.h"
 
+#include <string>
+
 namespace exodus
 {
 /** Checks if a given block should be consensus hashed. */
 bool ShouldConsensusHashBlock(int block);
 
+/** Checks if the consensus hash of a given block was explicitly requested. */
+bool IsConsensusHashBlockRequested(int block);
+
 /** Obtains a hash of all balances to use for consensus verification and checkpointing. */
 uint256 GetConsensusHash();
 
+/** Obtains a commitment to the active state, which is cheap enough to be calculated for every block. */
+uint256 GetConsensusCommitment();
+
+/** Marks the balances of the address as changed, so they are hashed again. Requires cs_tally. */
+void MarkConsensusBalancesChanged(const std::string& address);
+
+/** Removes all cached balances, when the tally map is cleared. Requires cs_tally. */
+void ClearConsensusBalances();
+
 /** Obtains a hash of the overall MetaDEx state (default) or a specific orderbook (supply a property ID). */
 uint256 GetMetaDExHash(const uint32_t propertyId = 0);
 
@@ -6,13 +6,11 @@
 #include "exodus/tx.h"
 
 #include "amount.h"
+#include "serialize.h"
 #include "tinyformat.h"
 #include "uint256.h"
 
-#include <openssl/sha.h>
-
 #include <stdint.h>
-#include <fstream>
 #include <map>
 #include <string>
 
@@ -87,25 +85,18 @@ public:
     {
     }
 
-    void saveOffer(std::ofstream& file, SHA256_CTX* shaCtx, const std::string& address) const
-    {
-        std::string lineOut = strprintf("%s,%d,%d,%d,%d,%d,%d,%d,%s",
-                address,
-                offerBlock,
-                offer_amount_original,
-                property,
-                XZC_desired_original,
-                (EXODUS_PROPERTY_XZC),
-                min_fee,
-                blocktimelimit,
-                txid.ToString()
-        );
-
-        // add the line to the hash
-        SHA256_Update(shaCtx, lineOut.c_str(), lineOut.length());
-
-        // write the line
-        file << lineOut << std::endl;
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(offerBlock);
+        READWRITE(offer_amount_original);
+        READWRITE(property);
+        READWRITE(XZC_desired_original);
+        READWRITE(min_fee);
+        READWRITE(blocktimelimit);
+        READWRITE(txid);
+        READWRITE(subaction);
     }
 };
 
@@ -143,6 +134,12 @@ public:
 
     int getAcceptBlock() const { return block; }
 
+    CMPAccept()
+      : accept_amount_original(0), accept_amount_remaining(0), blocktimelimit(0), property(0),
+        offer_amount_original(0), XZC_desired_original(0), block(0)
+    {
+    }
+
     CMPAccept(int64_t amountAccepted, int blockIn, uint8_t paymentWindow, uint32_t propertyId,
               int64_t offerAmountOriginal, int64_t amountDesired, const uint256& txid)
       : accept_amount_remaining(amountAccepted), blocktimelimit(paymentWindow),
@@ -195,25 +192,18 @@ public:
         return bRet;
     }
 
-    void saveAccept(std::ofstream& file, SHA256_CTX* shaCtx, const std::string& address, const std::string& buyer) const
-    {
-        std::string lineOut = strprintf("%s,%d,%s,%d,%d,%d,%d,%d,%d,%s",
-                address,
-                property,
-                buyer,
-                block,
-                accept_amount_remaining,
-                accept_amount_original,
-                blocktimelimit,
-                offer_amount_original,
-                XZC_desired_original,
-                offer_txid.ToString());
-
-        // add the line to the hash
-        SHA256_Update(shaCtx, lineOut.c_str(), lineOut.length());
-
-        // write the line
-        file << lineOut << std::endl;
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(accept_amount_original);
+        READWRITE(accept_amount_remaining);
+        READWRITE(blocktimelimit);
+        READWRITE(property);
+        READWRITE(offer_amount_original);
+        READWRITE(XZC_desired_original);
+        READWRITE(offer_txid);
+        READWRITE(block);
     }
 };
 
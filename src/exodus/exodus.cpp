@@ -20,6 +20,7 @@
 #include "exodus/persistence.h"
 #include "exodus/rules.h"
 #include "exodus/script.h"
+#include "exodus/snapshot.h"
 #include "exodus/sp.h"
 #include "exodus/tally.h"
 #include "exodus/tx.h"
@@ -34,6 +35,7 @@
 #include "coincontrol.h"
 #include "coins.h"
 #include "core_io.h"
+#include "executor.h"
 #include "init.h"
 #include "main.h"
 #include "primitives/block.h"
@@ -63,13 +65,18 @@
 #include <openssl/sha.h>
 
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
 
 #include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -85,7 +92,6 @@ using leveldb::Status;
 using std::endl;
 using std::make_pair;
 using std::map;
-using std::ofstream;
 using std::pair;
 using std::string;
 using std::vector;
@@ -251,6 +257,7 @@ CrowdMap exodus::my_crowds;
 
 // this is the master list of all amounts for all addresses for all properties, map is unsorted
 std::unordered_map<std::string, CMPTally> exodus::mp_tally_map;
+CMPTallyIndex exodus::mp_tally_index;
 
 CMPTally* exodus::getTally(const std::string& address)
 {
@@ -425,7 +432,6 @@ std::string exodus::getTokenLabel(uint32_t propertyId)
 // optionally counts the number of addresses who own that property: n_owners_total
 int64_t exodus::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
 {
-    int64_t prev = 0;
     int64_t owners = 0;
     int64_t totalTokens = 0;
 
@@ -437,19 +443,8 @@ int64_t exodus::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
     }
 
     if (!property.fixed || n_owners_total) {
-        for (std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-            const CMPTally& tally = it->second;
-
-            totalTokens += tally.getMoney(propertyId, BALANCE);
-            totalTokens += tally.getMoney(propertyId, SELLOFFER_RESERVE);
-            totalTokens += tally.getMoney(propertyId, ACCEPT_RESERVE);
-            totalTokens += tally.getMoney(propertyId, METADEX_RESERVE);
-
-            if (prev != totalTokens) {
-                prev = totalTokens;
-                owners++;
-            }
-        }
+        totalTokens = mp_tally_index.getTotal(propertyId);
+        owners = mp_tally_index.getHolderCount(propertyId);
         int64_t cachedFee = p_feecache->GetCachedAmount(propertyId);
         totalTokens += cachedFee;
     }
@@ -495,6 +490,10 @@ bool exodus::update_tally_map(const std::string& who, uint32_t propertyId, int64
 
     CMPTally& tally = my_it->second;
     bRet = tally.updateMoney(propertyId, amount, ttype);
+    if (bRet && ttype != PENDING) {
+        mp_tally_index.update(who, propertyId, amount);
+        MarkConsensusBalancesChanged(who);
+    }
 
     after = getMPbalance(who, propertyId, ttype);
     if (!bRet) {
@@ -629,6 +628,31 @@ void CheckWalletUpdate(bool forceUpdate)
 #endif
 }
 
+/** Checks whether the script contains the "exodus" marker bytes anywhere. */
+static bool ScriptContainsExMarker(const CScript& script)
+{
+    static const std::vector<unsigned char> vchMarker = GetExMarker();
+    return std::search(script.begin(), script.end(), vchMarker.begin(), vchMarker.end()) != script.end();
+}
+
+/**
+ * Checks whether the transaction may carry an Exodus payload: it has an output paying
+ * to the Exodus address (given as script) or an output containing the marker bytes.
+ *
+ * The check doesn't depend on the state and matches every transaction, for which
+ * GetEncodingClass() doesn't return NO_MARKER, on all networks.
+ */
+static bool MayHaveExodusPayload(const CTransaction& tx, const CScript& scriptExodus)
+{
+    for (unsigned int n = 0; n < tx.vout.size(); ++n) {
+        const CScript& script = tx.vout[n].scriptPubKey;
+        if (script == scriptExodus || ScriptContainsExMarker(script)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * Returns the encoding class, used to embed a payload.
  *
@@ -644,25 +668,19 @@ int exodus::GetEncodingClass(const CTransaction& tx, int nBlock)
     bool hasOpReturn = false;
 
     /* Fast Search
-     * Perform a string comparison on hex for each scriptPubKey & look directly for Exodus hash160 bytes or exodus marker bytes
+     * Perform a byte comparison for each scriptPubKey & look directly for Exodus hash160 bytes or exodus marker bytes
      * This allows to drop non-Exodus transactions with less work
      */
-    std::string strClassC = "65786f647573";
-    std::string strClassAB = "76a914030de47b81d0e0a2932746e939de3a7352a3f19288ac";
+    static const std::vector<unsigned char> vchClassAB = ParseHex("76a914030de47b81d0e0a2932746e939de3a7352a3f19288ac");
     bool examineClosely = false;
     for (unsigned int n = 0; n < tx.vout.size(); ++n) {
-        const CTxOut& output = tx.vout[n];
-        std::string strSPB = HexStr(output.scriptPubKey.begin(), output.scriptPubKey.end());
-        if (strSPB != strClassAB) { // not an exodus marker
-            if (nBlock < 0) { // class C not enabled yet, no need to search for marker bytes
-                continue;
-            } else {
-                if (strSPB.find(strClassC) != std::string::npos) {
-                    examineClosely = true;
-                    break;
-                }
-            }
-        } else {
+        const CScript& script = tx.vout[n].scriptPubKey;
+        if (script.size() == vchClassAB.size() && std::equal(script.begin(), script.end(), vchClassAB.begin())) {
+            examineClosely = true;
+            break;
+        }
+        // class C not enabled yet, no need to search for marker bytes
+        if (nBlock >= 0 && ScriptContainsExMarker(script)) {
             examineClosely = true;
             break;
         }
@@ -739,14 +757,11 @@ static unsigned int nCacheHits = 0;
 static unsigned int nCacheMiss = 0;
 
 /**
- * Fetches transaction inputs and adds them to the coins view cache.
+ * Clears the coins view cache, if it grew above the configured size.
  *
- * Note: cs_tx_cache should be locked, when adding and accessing inputs!
- *
- * @param tx[in]  The transaction to fetch inputs for
- * @return True, if all inputs were successfully added to the cache
+ * Note: cs_tx_cache should be locked!
  */
-static bool FillTxInputCache(const CTransaction& tx)
+static void LimitTxInputCache()
 {
     static unsigned int nCacheSize = GetArg("-exodustxcache", 500000);
 
@@ -755,6 +770,44 @@ static bool FillTxInputCache(const CTransaction& tx)
                 __func__, view.GetCacheSize(), nCacheHits, nCacheMiss);
         view.Flush();
     }
+}
+
+/**
+ * Adds previous outputs, which were fetched ahead of time, to the coins view cache.
+ *
+ * Note: cs_tx_cache should be locked!
+ *
+ * @param prevOuts[in]  The outputs with their outpoints
+ */
+static void AddPrevOutsToInputCache(const std::vector<std::pair<COutPoint, CTxOut> >& prevOuts)
+{
+    LimitTxInputCache();
+
+    for (std::vector<std::pair<COutPoint, CTxOut> >::const_iterator it = prevOuts.begin(); it != prevOuts.end(); ++it) {
+        unsigned int nOut = it->first.n;
+        CCoinsModifier coins = view.ModifyCoins(it->first.hash);
+
+        if (coins->IsAvailable(nOut)) {
+            continue;
+        }
+        if (nOut >= coins->vout.size()) {
+            coins->vout.resize(nOut+1);
+        }
+        coins->vout[nOut] = it->second;
+    }
+}
+
+/**
+ * Fetches transaction inputs and adds them to the coins view cache.
+ *
+ * Note: cs_tx_cache should be locked, when adding and accessing inputs!
+ *
+ * @param tx[in]  The transaction to fetch inputs for
+ * @return True, if all inputs were successfully added to the cache
+ */
+static bool FillTxInputCache(const CTransaction& tx)
+{
+    LimitTxInputCache();
 
     for (std::vector<CTxIn>::const_iterator it = tx.vin.begin(); it != tx.vin.end(); ++it) {
         const CTxIn& txIn = *it;
@@ -1279,6 +1332,17 @@ public:
     {
     }
 
+    /** Returns the number of blocks scanned per second since the start. */
+    double blocksPerSecond(const CBlockIndex* pblockNow) const
+    {
+        int64_t timeSinceStart = GetTimeMillis() - m_timeStart;
+        if (timeSinceStart <= 0) {
+            return 0.0;
+        }
+
+        return 1000.0 * (pblockNow->nHeight - m_pblockFirst->nHeight) / timeSinceStart;
+    }
+
     /** Prints the current progress to the console and notifies the UI. */
     void update(const CBlockIndex* pblockNow) const
     {
@@ -1292,8 +1356,8 @@ public:
         int64_t nRemainingTime = estimateRemainingTime(dProgress);
 
         std::string strProgress = strprintf(
-                "Still scanning.. at block %d of %d. Progress: %.2f %%, about %s remaining..\n",
-                nCurrentBlock, nLastBlock, dProgress, remainingTimeAsString(nRemainingTime));
+                "Still scanning.. at block %d of %d. Progress: %.2f %%, %.1f blocks/s, about %s remaining..\n",
+                nCurrentBlock, nLastBlock, dProgress, blocksPerSecond(pblockNow), remainingTimeAsString(nRemainingTime));
         std::string strProgressUI = strprintf(
                 "Still scanning.. at block %d of %d.\nProgress: %.2f %% (about %s remaining)",
                 nCurrentBlock, nLastBlock, dProgress, remainingTimeAsString(nRemainingTime));
@@ -1303,12 +1367,77 @@ public:
     }
 };
 
+//! Number of blocks read and pre-filtered ahead of the block processed by the initial scan
+static const int EXODUS_SCAN_PREFETCH_BLOCKS = 64;
+
+/**
+ * Block of the initial scan, which is read from the disk and pre-filtered by the
+ * executor, while the preceding blocks are being processed.
+ */
+struct ScanBlock
+{
+    CBlockIndex* pblockindex;
+    CBlock block;
+    bool fRead;
+    //! Whether the transaction at the same position may carry an Exodus payload
+    std::vector<bool> vMayHavePayload;
+    //! Inputs of these transactions, fetched for the input cache
+    std::vector<std::pair<COutPoint, CTxOut> > prevOuts;
+    //! Declared last, so it waits for the prefetch task before the data is destroyed
+    CExecutorTaskGroup tasks;
+
+    ScanBlock() : pblockindex(NULL), fRead(false) {}
+};
+
+/**
+ * Reads the block from the disk, marks transactions, which may carry an Exodus payload,
+ * and fetches their inputs using the transaction index.
+ *
+ * Runs on the executor, so neither cs_main nor cs_tally can be used here.
+ */
+static void PrefetchScanBlock(ScanBlock& scanBlock, const CScript& scriptExodus, const std::atomic<bool>& fAbort)
+{
+    scanBlock.block.SetNull();
+    scanBlock.vMayHavePayload.clear();
+    scanBlock.prevOuts.clear();
+    scanBlock.fRead = false;
+
+    if (fAbort) return;
+
+    if (!ReadBlockFromDisk(scanBlock.block, scanBlock.pblockindex, Params().GetConsensus())) {
+        return;
+    }
+    scanBlock.fRead = true;
+
+    const std::vector<CTransaction>& vtx = scanBlock.block.vtx;
+    scanBlock.vMayHavePayload.resize(vtx.size(), false);
+    for (unsigned int i = 0; i < vtx.size(); ++i) {
+        if (!MayHaveExodusPayload(vtx[i], scriptExodus)) continue;
+        scanBlock.vMayHavePayload[i] = true;
+
+        if (vtx[i].IsCoinBase()) continue;
+        BOOST_FOREACH(const CTxIn& txIn, vtx[i].vin) {
+            // inputs, which can't be fetched here, are fetched again by FillTxInputCache()
+            CTransaction txPrev;
+            uint256 hashBlock;
+            if (ReadTransactionFromTxIndex(txIn.prevout.hash, txPrev, hashBlock) && txIn.prevout.n < txPrev.vout.size()) {
+                scanBlock.prevOuts.push_back(std::make_pair(txIn.prevout, txPrev.vout[txIn.prevout.n]));
+            }
+        }
+    }
+}
+
 /**
  * Scans the blockchain for meta transactions.
  *
  * It scans the blockchain, starting at the given block index, to the current
  * tip, much like as if new block were arriving and being processed on the fly.
  *
+ * Up to EXODUS_SCAN_PREFETCH_BLOCKS blocks ahead are read from the disk in parallel,
+ * and their transactions are pre-filtered by the marker, while the inputs of the
+ * remaining ones are put into the input cache. The state is still updated by a single
+ * thread in the block order, transactions without marker only clear pending amounts.
+ *
  * Every 30 seconds the progress of the scan is reported.
  *
  * In case the current block being processed is not part of the active chain, or
@@ -1337,6 +1466,27 @@ static int exodus_initial_scan(int nFirstBlock)
     // used to print the progress to the console and notifies the UI
     ProgressReporter progressReporter(chainActive[nFirstBlock], chainActive[nLastBlock]);
 
+    const CScript scriptExodus = GetScriptForDestination(ExodusAddress().Get());
+
+    // set when the scan stops early, so the remaining prefetch tasks finish without work
+    std::atomic<bool> fAbort(false);
+    std::vector<std::unique_ptr<ScanBlock> > window(EXODUS_SCAN_PREFETCH_BLOCKS);
+    for (size_t i = 0; i < window.size(); ++i) {
+        window[i].reset(new ScanBlock());
+    }
+
+    int nNextPrefetch = nFirstBlock;
+    auto prefetchUpTo = [&](int nMaxBlock) {
+        for (; nNextPrefetch <= std::min(nMaxBlock, nLastBlock); ++nNextPrefetch) {
+            ScanBlock* scanBlock = window[nNextPrefetch % EXODUS_SCAN_PREFETCH_BLOCKS].get();
+            scanBlock->pblockindex = chainActive[nNextPrefetch];
+            scanBlock->tasks.Add([scanBlock, &scriptExodus, &fAbort] {
+                PrefetchScanBlock(*scanBlock, scriptExodus, fAbort);
+            });
+        }
+    };
+    prefetchUpTo(nFirstBlock + EXODUS_SCAN_PREFETCH_BLOCKS - 1);
+
     for (nBlock = nFirstBlock; nBlock <= nLastBlock; ++nBlock)
     {
         if (ShutdownRequested()) {
@@ -1344,8 +1494,9 @@ static int exodus_initial_scan(int nFirstBlock)
             break;
         }
 
-        CBlockIndex* pblockindex = chainActive[nBlock];
-        if (NULL == pblockindex) break;
+        ScanBlock& scanBlock = *window[nBlock % EXODUS_SCAN_PREFETCH_BLOCKS];
+        CBlockIndex* pblockindex = scanBlock.pblockindex;
+        if (NULL == pblockindex || chainActive[nBlock] != pblockindex) break;
         std::string strBlockHash = pblockindex->GetBlockHash().GetHex();
 
         if (exodus_debug_exo) PrintToLog("%s(%d; max=%d):%s, line %d, file: %s\n",
@@ -1357,11 +1508,16 @@ static int exodus_initial_scan(int nFirstBlock)
         }
 
         // Get block to parse.
-        CBlock block;
-
-        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) {
+        scanBlock.tasks.Wait();
+        if (!scanBlock.fRead) {
             break;
         }
+        const CBlock& block = scanBlock.block;
+
+        {
+            LOCK(cs_tx_cache);
+            AddPrevOutsToInputCache(scanBlock.prevOuts);
+        }
 
         // Parse block.
         unsigned parsed = 0;
@@ -1369,8 +1525,14 @@ static int exodus_initial_scan(int nFirstBlock)
         exodus_handler_block_begin(nBlock, pblockindex);
 
         for (unsigned i = 0; i < block.vtx.size(); i++) {
-            if (exodus_handler_tx(block.vtx[i], nBlock, i, pblockindex)) {
-                parsed++;
+            if (scanBlock.vMayHavePayload[i]) {
+                if (exodus_handler_tx(block.vtx[i], nBlock, i, pblockindex)) {
+                    parsed++;
+                }
+            } else {
+                // same as exodus_handler_tx() does for transactions without marker
+                LOCK(cs_tally);
+                PendingDelete(block.vtx[i].GetHash());
             }
         }
 
@@ -1379,17 +1541,27 @@ static int exodus_initial_scan(int nFirstBlock)
         // Sum total parsed.
         nTxsFoundTotal += parsed;
         nTxsTotal += block.vtx.size();
+
+        // the slot of this block is free now
+        prefetchUpTo(nBlock + EXODUS_SCAN_PREFETCH_BLOCKS);
     }
 
+    fAbort = true;
+
     if (nBlock < nLastBlock) {
         PrintToLog("Scan stopped early at block %d of block %d\n", nBlock, nLastBlock);
     }
 
     PrintToLog("%zu transactions processed, %zu meta transactions found\n", nTxsTotal, nTxsFoundTotal);
+    if (nBlock > nFirstBlock) {
+        PrintToLog("%d blocks scanned, %.1f blocks/s\n", nBlock - nFirstBlock, progressReporter.blocksPerSecond(chainActive[nBlock - 1]));
+    }
 
     return 0;
 }
 
+// The text state files written by older versions are read once to migrate to the binary snapshots
+
 int input_exodus_balances_string(const std::string& s)
 {
     // "address=propertybalancedata"
@@ -1610,6 +1782,8 @@ static int exodus_file_load(const string &filename, int what, bool verifyHash =
   {
     case FILETYPE_BALANCES:
       mp_tally_map.clear();
+      mp_tally_index.clear();
+      ClearConsensusBalances();
       inputLineFunc = input_exodus_balances_string;
       break;
 
@@ -1637,7 +1811,7 @@ static int exodus_file_load(const string &filename, int what, bool verifyHash =
       // memory leak ... gotta unallocate inner layers first....
       // TODO
       // ...
-      metadex.clear();
+      MetaDEx_CLEAR();
       inputLineFunc = input_mp_mdexorder_string;
       break;
 
@@ -1713,6 +1887,8 @@ static int exodus_file_load(const string &filename, int what, bool verifyHash =
   return res;
 }
 
+
+//! Prefixes of the text state files written by older versions
 static char const * const statePrefix[NUM_FILETYPES] = {
     "balances",
     "offers",
@@ -1722,6 +1898,229 @@ static char const * const statePrefix[NUM_FILETYPES] = {
     "mdexorders",
 };
 
+//! Prefix of the binary state snapshot files
+static char const * const snapshotPrefix = "snapshot";
+
+//! Produces the snapshots written by exodus_save_state()
+static CStateSnapshotBuilder snapshotBuilder;
+
+static boost::filesystem::path snapshot_path(const uint256& blockHash)
+{
+    return MPPersistencePath / strprintf("%s-%s.dat", snapshotPrefix, blockHash.ToString());
+}
+
+template <typename T>
+static void add_state_record(SnapshotRecords& records, int what, const std::string& key, const T& obj)
+{
+    CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+    ssValue << obj;
+    records[SnapshotKey(what, key)].assign(ssValue.begin(), ssValue.end());
+}
+
+/**
+ * Serializes the whole state into records, keyed by the type of the state and the
+ * identifier of the object within its type.
+ */
+static void collect_state_records(SnapshotRecords& records)
+{
+    for (std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        const CMPTally& tally = it->second;
+        for (CMPTally::const_iterator itRecord = tally.begin(); itRecord != tally.end(); ++itRecord) {
+            uint32_t propertyId = itRecord->first;
+            int64_t balance = itRecord->second.balance[BALANCE];
+            int64_t sellReserved = itRecord->second.balance[SELLOFFER_RESERVE];
+            int64_t acceptReserved = itRecord->second.balance[ACCEPT_RESERVE];
+            int64_t metadexReserved = itRecord->second.balance[METADEX_RESERVE];
+
+            // zero balances are not persisted, same as pending amounts
+            if (0 == balance && 0 == sellReserved && 0 == acceptReserved && 0 == metadexReserved) {
+                continue;
+            }
+            ssValue << propertyId << balance << sellReserved << acceptReserved << metadexReserved;
+        }
+
+        if (!ssValue.empty()) {
+            records[SnapshotKey(FILETYPE_BALANCES, it->first)].assign(ssValue.begin(), ssValue.end());
+        }
+    }
+
+    for (OfferMap::const_iterator it = my_offers.begin(); it != my_offers.end(); ++it) {
+        add_state_record(records, FILETYPE_OFFERS, it->first, it->second);
+    }
+
+    for (AcceptMap::const_iterator it = my_accepts.begin(); it != my_accepts.end(); ++it) {
+        add_state_record(records, FILETYPE_ACCEPTS, it->first, it->second);
+    }
+
+    CDataStream ssGlobals(SER_DISK, CLIENT_VERSION);
+    ssGlobals << exodus_prev << _my_sps->peekNextSPID(EXODUS_PROPERTY_EXODUS) << _my_sps->peekNextSPID(EXODUS_PROPERTY_TEXODUS);
+    records[SnapshotKey(FILETYPE_GLOBALS, "")].assign(ssGlobals.begin(), ssGlobals.end());
+
+    for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
+        add_state_record(records, FILETYPE_CROWDSALES, it->first, it->second);
+    }
+
+    for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+        const md_PricesMap& prices = my_it->second;
+        for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
+            const md_Set& indexes = it->second;
+            for (md_Set::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+                const uint256& txid = it->getHash();
+                add_state_record(records, FILETYPE_MDEXORDERS, std::string(txid.begin(), txid.end()), *it);
+            }
+        }
+    }
+}
+
+/**
+ * Replaces the state with the one stored in the records.
+ *
+ * @return 0 on success, -1 if a record couldn't be restored
+ */
+static int restore_state_records(const SnapshotRecords& records)
+{
+    mp_tally_map.clear();
+    mp_tally_index.clear();
+    ClearConsensusBalances();
+    my_offers.clear();
+    my_accepts.clear();
+    my_crowds.clear();
+    MetaDEx_CLEAR();
+
+    try {
+        for (SnapshotRecords::const_iterator it = records.begin(); it != records.end(); ++it) {
+            const std::string& key = it->first.second;
+            CDataStream ssValue(it->second, SER_DISK, CLIENT_VERSION);
+
+            switch (it->first.first) {
+            case FILETYPE_BALANCES:
+                while (!ssValue.empty()) {
+                    uint32_t propertyId;
+                    int64_t balance, sellReserved, acceptReserved, metadexReserved;
+                    ssValue >> propertyId >> balance >> sellReserved >> acceptReserved >> metadexReserved;
+
+                    if (balance) update_tally_map(key, propertyId, balance, BALANCE);
+                    if (sellReserved) update_tally_map(key, propertyId, sellReserved, SELLOFFER_RESERVE);
+                    if (acceptReserved) update_tally_map(key, propertyId, acceptReserved, ACCEPT_RESERVE);
+                    if (metadexReserved) update_tally_map(key, propertyId, metadexReserved, METADEX_RESERVE);
+                }
+                break;
+
+            case FILETYPE_OFFERS: {
+                CMPOffer offer;
+                ssValue >> offer;
+                if (!my_offers.insert(std::make_pair(key, offer)).second) return -1;
+                break;
+            }
+
+            case FILETYPE_ACCEPTS: {
+                CMPAccept accept;
+                ssValue >> accept;
+                if (!my_accepts.insert(std::make_pair(key, accept)).second) return -1;
+                break;
+            }
+
+            case FILETYPE_GLOBALS: {
+                uint32_t nextSPID, nextTestSPID;
+                ssValue >> exodus_prev >> nextSPID >> nextTestSPID;
+                _my_sps->init(nextSPID, nextTestSPID);
+                break;
+            }
+
+            case FILETYPE_CROWDSALES: {
+                CMPCrowd crowd;
+                ssValue >> crowd;
+                if (!my_crowds.insert(std::make_pair(key, crowd)).second) return -1;
+                break;
+            }
+
+            case FILETYPE_MDEXORDERS: {
+                CMPMetaDEx mdexObj;
+                ssValue >> mdexObj;
+                if (!MetaDEx_INSERT(mdexObj)) return -1;
+                break;
+            }
+
+            default:
+                return -1;
+            }
+        }
+    } catch (const std::exception& e) {
+        PrintToLog("%s(): failed to restore the state: %s\n", __func__, e.what());
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Loads the state from the snapshot taken after the given block, and verifies it
+ * against the consensus commitment recorded in the snapshot.
+ *
+ * @return 0 on success, -1 if the snapshot is missing or invalid
+ */
+static int load_state_snapshot(CBlockIndex const *pBlockIndex)
+{
+    const uint256& blockHash = pBlockIndex->GetBlockHash();
+
+    CStateSnapshot snapshot;
+    if (!ReadStateSnapshot(snapshot_path(blockHash), snapshot) || snapshot.blockHash != blockHash) {
+        return -1;
+    }
+
+    SnapshotRecords records;
+    if (snapshot.IsBase()) {
+        records.swap(snapshot.records);
+    } else {
+        CStateSnapshot base;
+        if (!ReadStateSnapshot(snapshot_path(snapshot.baseHash), base) || !base.IsBase() || base.blockHash != snapshot.baseHash) {
+            PrintToLog("%s(): base snapshot %s of block %s is missing or invalid\n", __func__, snapshot.baseHash.GetHex(), blockHash.GetHex());
+            return -1;
+        }
+        records.swap(base.records);
+        snapshot.ApplyTo(records);
+    }
+
+    if (restore_state_records(records) < 0) {
+        PrintToLog("%s(): failed to restore the state of block %s\n", __func__, blockHash.GetHex());
+        return -1;
+    }
+
+    uint256 consensusCommitment = GetConsensusCommitment();
+    if (consensusCommitment != snapshot.consensusCommitment) {
+        PrintToLog("%s(): consensus commitment mismatch for block %s: %s, expected %s\n", __func__,
+                blockHash.GetHex(), consensusCommitment.GetHex(), snapshot.consensusCommitment.GetHex());
+        return -1;
+    }
+
+    PrintToLog("%s(): loaded %s snapshot of block %d (%d records)\n", __func__,
+            snapshot.IsBase() ? "base" : "delta", pBlockIndex->nHeight, records.size());
+
+    return 0;
+}
+
+/**
+ * Loads the state from the text state files written by older versions after the given
+ * block, and writes it as a snapshot so that the text files are not read again.
+ *
+ * @return 0 on success, -1 if any of the files is missing or invalid
+ */
+static int load_legacy_state_files(CBlockIndex const *pBlockIndex)
+{
+    for (int i = 0; i < NUM_FILETYPES; ++i) {
+        boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[i], pBlockIndex->GetBlockHash().ToString());
+        if (exodus_file_load(path.string(), i, true) < 0) {
+            return -1;
+        }
+    }
+
+    PrintToLog("%s(): migrating the state of block %d to a snapshot\n", __func__, pBlockIndex->nHeight);
+    exodus_save_state(pBlockIndex);
+
+    return 0;
+}
+
 // returns the height of the state loaded
 static int load_most_relevant_state()
 {
@@ -1791,14 +2190,10 @@ static int load_most_relevant_state()
   if (curTip != NULL) abortRollBackBlock = curTip->nHeight - (MAX_STATE_HISTORY+1);
   while (NULL != curTip && persistedBlocks.size() > 0 && curTip->nHeight > abortRollBackBlock) {
     if (persistedBlocks.find(spBlockIndex->GetBlockHash()) != persistedBlocks.end()) {
-      int success = -1;
-      for (int i = 0; i < NUM_FILETYPES; ++i) {
-        boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[i], curTip->GetBlockHash().ToString());
-        const std::string strFile = path.string();
-        success = exodus_file_load(strFile, i, true);
-        if (success < 0) {
-          break;
-        }
+      // binary snapshot first, text state files are written by the older versions
+      int success = load_state_snapshot(curTip);
+      if (success < 0) {
+        success = load_legacy_state_files(curTip);
       }
 
       if (success >= 0) {
@@ -1830,181 +2225,12 @@ static int load_most_relevant_state()
   return res;
 }
 
-static int write_exodus_balances(std::ofstream& file, SHA256_CTX* shaCtx)
-{
-    std::unordered_map<std::string, CMPTally>::iterator iter;
-    for (iter = mp_tally_map.begin(); iter != mp_tally_map.end(); ++iter) {
-        bool emptyWallet = true;
-
-        std::string lineOut = (*iter).first;
-        lineOut.append("=");
-        CMPTally& curAddr = (*iter).second;
-        curAddr.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = curAddr.next())) {
-            int64_t balance = (*iter).second.getMoney(propertyId, BALANCE);
-            int64_t sellReserved = (*iter).second.getMoney(propertyId, SELLOFFER_RESERVE);
-            int64_t acceptReserved = (*iter).second.getMoney(propertyId, ACCEPT_RESERVE);
-            int64_t metadexReserved = (*iter).second.getMoney(propertyId, METADEX_RESERVE);
-
-            // we don't allow 0 balances to read in, so if we don't write them
-            // it makes things match up better between persisted state and processed state
-            if (0 == balance && 0 == sellReserved && 0 == acceptReserved && 0 == metadexReserved) {
-                continue;
-            }
-
-            emptyWallet = false;
-
-            lineOut.append(strprintf("%d:%d,%d,%d,%d;",
-                    propertyId,
-                    balance,
-                    sellReserved,
-                    acceptReserved,
-                    metadexReserved));
-        }
-
-        if (false == emptyWallet) {
-            // add the line to the hash
-            SHA256_Update(shaCtx, lineOut.c_str(), lineOut.length());
-
-            // write the line
-            file << lineOut << endl;
-        }
-    }
-
-    return 0;
-}
-
-static int write_mp_offers(ofstream &file, SHA256_CTX *shaCtx)
-{
-  OfferMap::const_iterator iter;
-  for (iter = my_offers.begin(); iter != my_offers.end(); ++iter) {
-    // decompose the key for address
-    std::vector<std::string> vstr;
-    boost::split(vstr, (*iter).first, boost::is_any_of("-"), token_compress_on);
-    CMPOffer const &offer = (*iter).second;
-    offer.saveOffer(file, shaCtx, vstr[0]);
-  }
-
-
-  return 0;
-}
-
-static int write_mp_metadex(ofstream &file, SHA256_CTX *shaCtx)
-{
-  for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it)
-  {
-    md_PricesMap & prices = my_it->second;
-    for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it)
-    {
-      md_Set & indexes = (it->second);
-      for (md_Set::iterator it = indexes.begin(); it != indexes.end(); ++it)
-      {
-        CMPMetaDEx meta = *it;
-        meta.saveOffer(file, shaCtx);
-      }
-    }
-  }
-
-  return 0;
-}
-
-static int write_mp_accepts(ofstream &file, SHA256_CTX *shaCtx)
-{
-  AcceptMap::const_iterator iter;
-  for (iter = my_accepts.begin(); iter != my_accepts.end(); ++iter) {
-    // decompose the key for address
-    std::vector<std::string> vstr;
-    boost::split(vstr, (*iter).first, boost::is_any_of("-+"), token_compress_on);
-    CMPAccept const &accept = (*iter).second;
-    accept.saveAccept(file, shaCtx, vstr[0], vstr[1]);
-  }
-
-  return 0;
-}
-
-static int write_globals_state(ofstream &file, SHA256_CTX *shaCtx)
-{
-  unsigned int nextSPID = _my_sps->peekNextSPID(EXODUS_PROPERTY_EXODUS);
-  unsigned int nextTestSPID = _my_sps->peekNextSPID(EXODUS_PROPERTY_TEXODUS);
-  std::string lineOut = strprintf("%d,%d,%d",
-    exodus_prev,
-    nextSPID,
-    nextTestSPID);
-
-  // add the line to the hash
-  SHA256_Update(shaCtx, lineOut.c_str(), lineOut.length());
-
-  // write the line
-  file << lineOut << endl;
-
-  return 0;
-}
-
-static int write_mp_crowdsales(std::ofstream& file, SHA256_CTX* shaCtx)
-{
-    for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
-        // decompose the key for address
-        const CMPCrowd& crowd = it->second;
-        crowd.saveCrowdSale(file, shaCtx, it->first);
-    }
-
-    return 0;
-}
-
-static int write_state_file( CBlockIndex const *pBlockIndex, int what )
+static bool is_state_prefix( std::string const &str )
 {
-  boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[what], pBlockIndex->GetBlockHash().ToString());
-  const std::string strFile = path.string();
-
-  std::ofstream file;
-  file.open(strFile.c_str());
-
-  SHA256_CTX shaCtx;
-  SHA256_Init(&shaCtx);
-
-  int result = 0;
-
-  switch(what) {
-  case FILETYPE_BALANCES:
-    result = write_exodus_balances(file, &shaCtx);
-    break;
-
-  case FILETYPE_OFFERS:
-    result = write_mp_offers(file, &shaCtx);
-    break;
-
-  case FILETYPE_ACCEPTS:
-    result = write_mp_accepts(file, &shaCtx);
-    break;
-
-  case FILETYPE_GLOBALS:
-    result = write_globals_state(file, &shaCtx);
-    break;
-
-  case FILETYPE_CROWDSALES:
-      result = write_mp_crowdsales(file, &shaCtx);
-      break;
-
-  case FILETYPE_MDEXORDERS:
-      result = write_mp_metadex(file, &shaCtx);
-      break;
+  if (boost::equals(str, snapshotPrefix)) {
+    return true;
   }
 
-  // generate and wite the double hash of all the contents written
-  uint256 hash1;
-  SHA256_Final((unsigned char*)&hash1, &shaCtx);
-  uint256 hash2;
-  SHA256((unsigned char*)&hash1, sizeof(hash1), (unsigned char*)&hash2);
-  file << "!" << hash2.ToString() << endl;
-
-  file.flush();
-  file.close();
-  return result;
-}
-
-static bool is_state_prefix( std::string const &str )
-{
   for (int i = 0; i < NUM_FILETYPES; ++i) {
     if (boost::equals(str,  statePrefix[i])) {
       return true;
@@ -2042,14 +2268,32 @@ static void prune_state_files( CBlockIndex const *topIndex )
     }
   }
 
-  // for each blockHash in the set, determine the distance from the given block
+  // base snapshots of the delta snapshots which are kept, must be kept as well
+  std::set<uint256> requiredBaseHashes;
   std::set<uint256>::const_iterator iter;
+  for (iter = statefulBlockHashes.begin(); iter != statefulBlockHashes.end(); ++iter) {
+    CBlockIndex const *curIndex = GetBlockIndex(*iter);
+    if (NULL == curIndex || (topIndex->nHeight - curIndex->nHeight) > MAX_STATE_HISTORY) {
+      continue;
+    }
+
+    uint256 baseHash;
+    if (ReadStateSnapshotBase(snapshot_path(*iter), baseHash) && !baseHash.IsNull()) {
+      requiredBaseHashes.insert(baseHash);
+    }
+  }
+
+  // for each blockHash in the set, determine the distance from the given block
   for (iter = statefulBlockHashes.begin(); iter != statefulBlockHashes.end(); ++iter) {
     // look up the CBlockIndex for height info
     CBlockIndex const *curIndex = GetBlockIndex(*iter);
 
     // if we have nothing int the index, or this block is too old..
     if (NULL == curIndex || (topIndex->nHeight - curIndex->nHeight) > MAX_STATE_HISTORY ) {
+     if (requiredBaseHashes.count(*iter)) {
+      continue;
+     }
+
      if (exodus_debug_persistence)
      {
       if (curIndex) {
@@ -2065,19 +2309,34 @@ static void prune_state_files( CBlockIndex const *topIndex )
         boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[i], strBlockHash);
         boost::filesystem::remove(path);
       }
+      boost::filesystem::remove(snapshot_path(*iter));
     }
   }
 }
 
 int exodus_save_state( CBlockIndex const *pBlockIndex )
 {
+    // start with a new base snapshot, if the current one is gone
+    int nBaseHeight = snapshotBuilder.GetBaseHeight();
+    uint256 baseHashAtHeight;
+    if (nBaseHeight >= 0 && nBaseHeight < pBlockIndex->nHeight) {
+        baseHashAtHeight = pBlockIndex->GetAncestor(nBaseHeight)->GetBlockHash();
+        if (!boost::filesystem::exists(snapshot_path(baseHashAtHeight))) {
+            snapshotBuilder.Reset();
+        }
+    }
+
     // write the new state as of the given block
-    write_state_file(pBlockIndex, FILETYPE_BALANCES);
-    write_state_file(pBlockIndex, FILETYPE_OFFERS);
-    write_state_file(pBlockIndex, FILETYPE_ACCEPTS);
-    write_state_file(pBlockIndex, FILETYPE_GLOBALS);
-    write_state_file(pBlockIndex, FILETYPE_CROWDSALES);
-    write_state_file(pBlockIndex, FILETYPE_MDEXORDERS);
+    SnapshotRecords records;
+    collect_state_records(records);
+
+    CStateSnapshot snapshot;
+    snapshotBuilder.Build(pBlockIndex->GetBlockHash(), pBlockIndex->nHeight, baseHashAtHeight, records, GetConsensusCommitment(), snapshot);
+    if (!WriteStateSnapshot(snapshot_path(pBlockIndex->GetBlockHash()), snapshot)) {
+        // the next snapshot can't refer to a base which wasn't written
+        if (snapshot.IsBase()) snapshotBuilder.Reset();
+        PrintToLog("%s(): failed to write the state snapshot of block %d\n", __func__, pBlockIndex->nHeight);
+    }
 
     // clean-up the directory
     prune_state_files(pBlockIndex);
@@ -2096,10 +2355,12 @@ void clear_all_state()
 
     // Memory based storage
     mp_tally_map.clear();
+    mp_tally_index.clear();
+    ClearConsensusBalances();
     my_offers.clear();
     my_accepts.clear();
     my_crowds.clear();
-    metadex.clear();
+    MetaDEx_CLEAR();
     my_pending.clear();
     ResetConsensusParams();
     ClearActivations();
@@ -2116,6 +2377,7 @@ void clear_all_state()
     p_feehistory->Clear();
     assert(p_txlistdb->setDBVersion() == DB_VERSION); // new set of databases, set DB version
     exodus_prev = 0;
+    snapshotBuilder.Reset();
 }
 
 /**
@@ -3213,6 +3475,196 @@ unsigned int n_found = 0;
   return (n_found);
 }
 
+// Secondary index keys of the STO and trade databases. The keys are binary encoded and start with a
+// control character, so they sort apart from, and never collide with, the address and txid keys of the
+// records. Numbers are big-endian, so the keys of a prefix are ordered by them.
+static const char INDEX_BLOCK = 0x01;           // block, record key
+static const char STO_INDEX_TXID = 0x02;        // txid, recipient address
+static const char TRADE_INDEX_PAIR = 0x03;      // property id 1, property id 2, block, txid 1, txid 2
+static const char TRADE_INDEX_ADDRESS = 0x04;   // address length, address, block, index, txid -> property ids
+static const char TRADE_INDEX_TXID = 0x05;      // txid, matched txid, position of the txid in the record key
+static const std::string INDEX_VERSION_KEY("\x0f" "indexversion");
+static const std::string INDEX_VERSION("1");
+
+static bool IsIndexKey(const leveldb::Slice& key)
+{
+    return !key.empty() && (unsigned char)key[0] < 0x10;
+}
+
+static void AppendIndexKey(std::string& key, uint32_t n)
+{
+    key.push_back((char)(n >> 24));
+    key.push_back((char)(n >> 16));
+    key.push_back((char)(n >> 8));
+    key.push_back((char)n);
+}
+
+static void AppendIndexKey(std::string& key, const uint256& hash)
+{
+    key.append((const char*)hash.begin(), hash.size());
+}
+
+static uint32_t ReadIndexKey32(const leveldb::Slice& key, size_t pos)
+{
+    const unsigned char* p = (const unsigned char*)key.data() + pos;
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint256 ReadIndexKeyHash(const leveldb::Slice& key, size_t pos)
+{
+    uint256 hash;
+    memcpy(hash.begin(), key.data() + pos, hash.size());
+    return hash;
+}
+
+static std::string BlockIndexKey(int block, const std::string& recordKey = "")
+{
+    std::string key(1, INDEX_BLOCK);
+    AppendIndexKey(key, (uint32_t)block);
+    key += recordKey;
+    return key;
+}
+
+static std::string STOTxidIndexKey(const uint256& txid, const std::string& address = "")
+{
+    std::string key(1, STO_INDEX_TXID);
+    AppendIndexKey(key, txid);
+    key += address;
+    return key;
+}
+
+static std::string TradePairIndexPrefix(uint32_t propertyId1, uint32_t propertyId2)
+{
+    std::string key(1, TRADE_INDEX_PAIR);
+    AppendIndexKey(key, propertyId1);
+    AppendIndexKey(key, propertyId2);
+    return key;
+}
+
+static std::string TradeAddressIndexPrefix(const std::string& address)
+{
+    std::string key(1, TRADE_INDEX_ADDRESS);
+    key.push_back((char)std::min(address.size(), (size_t)0xff));
+    key += address;
+    return key;
+}
+
+static std::string TradeTxidIndexPrefix(const uint256& txid)
+{
+    std::string key(1, TRADE_INDEX_TXID);
+    AppendIndexKey(key, txid);
+    return key;
+}
+
+/**
+ * Positions the iterator at the last key with the given prefix.
+ *
+ * @return True, if there is such a key
+ */
+static bool SeekToLastWithPrefix(leveldb::Iterator* it, const std::string& prefix)
+{
+    std::string end = prefix;
+    while (!end.empty() && (unsigned char)end[end.size() - 1] == 0xff) {
+        end.erase(end.size() - 1);
+    }
+    if (end.empty()) {
+        it->SeekToLast();
+    } else {
+        ++end[end.size() - 1];
+        it->Seek(end);
+        if (it->Valid()) {
+            it->Prev();
+        } else {
+            it->SeekToLast();
+        }
+    }
+
+    return it->Valid() && it->key().starts_with(prefix);
+}
+
+/**
+ * Derives the secondary keys of a STO record from the receipts of the recipient.
+ *
+ * Receipts are formatted as "txid:block:propertyid:amount," and concatenated.
+ */
+static void GetSTOIndexKeys(const std::string& address, const std::string& strValue, std::vector<std::string>& keys)
+{
+    std::vector<std::string> vecReceipts;
+    boost::split(vecReceipts, strValue, boost::is_any_of(","), token_compress_on);
+    for (std::vector<std::string>::const_iterator it = vecReceipts.begin(); it != vecReceipts.end(); ++it) {
+        std::vector<std::string> vecFields;
+        boost::split(vecFields, *it, boost::is_any_of(":"), token_compress_on);
+        if (4 != vecFields.size()) continue;
+        keys.push_back(STOTxidIndexKey(uint256S(vecFields[0]), address));
+        keys.push_back(BlockIndexKey(atoi(vecFields[1]), address));
+    }
+}
+
+/**
+ * Derives the secondary keys and their values of a trade record.
+ *
+ * New trades are formatted as "address:propertyidforsale:propertyiddesired:block:index" with the
+ * txid as key, matched trades as "address1:address2:prop1:prop2:amount1:amount2:block:fee" with
+ * the key "txid1+txid2".
+ *
+ * @return False, if the record couldn't be parsed
+ */
+static bool GetTradeIndexEntries(const std::string& strKey, const std::string& strValue, std::vector<std::pair<std::string, std::string> >& entries)
+{
+    std::vector<std::string> vstr;
+    boost::split(vstr, strValue, boost::is_any_of(":"), token_compress_on);
+
+    try {
+        if (strKey.size() == 64 && vstr.size() == 5) {
+            uint256 txid = uint256S(strKey);
+            uint32_t propertyIdForSale = boost::lexical_cast<uint32_t>(vstr[1]);
+            uint32_t propertyIdDesired = boost::lexical_cast<uint32_t>(vstr[2]);
+            int block = boost::lexical_cast<int>(vstr[3]);
+            int index = boost::lexical_cast<int>(vstr[4]);
+
+            std::string addressKey = TradeAddressIndexPrefix(vstr[0]);
+            AppendIndexKey(addressKey, (uint32_t)block);
+            AppendIndexKey(addressKey, (uint32_t)index);
+            AppendIndexKey(addressKey, txid);
+            std::string addressValue;
+            AppendIndexKey(addressValue, propertyIdForSale);
+            AppendIndexKey(addressValue, propertyIdDesired);
+            entries.push_back(std::make_pair(addressKey, addressValue));
+            entries.push_back(std::make_pair(BlockIndexKey(block, strKey), std::string()));
+            return true;
+        }
+        if (strKey.size() == 129 && vstr.size() == 8) {
+            uint256 txid1 = uint256S(strKey.substr(0, 64));
+            uint256 txid2 = uint256S(strKey.substr(65, 64));
+            uint32_t prop1 = boost::lexical_cast<uint32_t>(vstr[2]);
+            uint32_t prop2 = boost::lexical_cast<uint32_t>(vstr[3]);
+            int block = boost::lexical_cast<int>(vstr[6]);
+
+            std::string pairKey = TradePairIndexPrefix(prop1, prop2);
+            AppendIndexKey(pairKey, (uint32_t)block);
+            AppendIndexKey(pairKey, txid1);
+            AppendIndexKey(pairKey, txid2);
+            entries.push_back(std::make_pair(pairKey, std::string()));
+
+            std::string txidKey1 = TradeTxidIndexPrefix(txid1);
+            AppendIndexKey(txidKey1, txid2);
+            txidKey1.push_back(0);
+            entries.push_back(std::make_pair(txidKey1, std::string()));
+
+            std::string txidKey2 = TradeTxidIndexPrefix(txid2);
+            AppendIndexKey(txidKey2, txid1);
+            txidKey2.push_back(1);
+            entries.push_back(std::make_pair(txidKey2, std::string()));
+
+            entries.push_back(std::make_pair(BlockIndexKey(block, strKey), std::string()));
+            return true;
+        }
+    } catch (const boost::bad_lexical_cast& e) {
+    }
+
+    return false;
+}
+
 // MPSTOList here
 std::string CMPSTOList::getMySTOReceipts(string filterAddress)
 {
@@ -3222,6 +3674,7 @@ std::string CMPSTOList::getMySTOReceipts(string filterAddress)
   Iterator* it = NewIterator();
   for(it->SeekToFirst(); it->Valid(); it->Next()) {
       skey = it->key();
+      if (IsIndexKey(skey)) continue;
       string recipientAddress = skey.ToString();
       if(!IsMyAddress(recipientAddress)) continue; // not ours, not interested
       if((!filterAddress.empty()) && (filterAddress != recipientAddress)) continue; // not the filtered address
@@ -3264,14 +3717,15 @@ void CMPSTOList::getRecipients(const uint256 txid, string filterAddress, UniValu
   // the fee is variable based on version of STO - provide number of recipients and allow calling function to work out fee
   *numRecipients = 0;
 
-  Slice skey, svalue;
+  // the recipients are listed by the txid index, ordered by address
+  const std::string prefix = STOTxidIndexKey(txid);
   Iterator* it = NewIterator();
-  for(it->SeekToFirst(); it->Valid(); it->Next())
+  for(it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next())
   {
-      skey = it->key();
-      string recipientAddress = skey.ToString();
-      svalue = it->value();
-      string strValue = svalue.ToString();
+      string recipientAddress(it->key().data() + prefix.size(), it->key().size() - prefix.size());
+      string strValue;
+      if (!pdb->Get(readoptions, recipientAddress, &strValue).ok()) continue;
+      ++nRead;
       // see if txid is in the data
       size_t txidMatch = strValue.find(txid.ToString());
       if(txidMatch!=std::string::npos)
@@ -3348,43 +3802,69 @@ void CMPSTOList::recordSTOReceive(string address, const uint256 &txid, int nBloc
 {
   if (!pdb) return;
 
-  bool addressExists = s_stolistdb->exists(address);
-  if (addressExists)
+  const string key = address;
+  const string newValue = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
+
+  //retrieve existing record
+  string strValue;
+  Status status = pdb->Get(readoptions, key, &strValue);
+  if (status.ok())
   {
-      //retrieve existing record
-      std::vector<std::string> vstr;
-      string strValue;
-      Status status = pdb->Get(readoptions, address, &strValue);
-      if (status.ok())
-      {
-          // add details to record
-          // see if we are overwriting (check)
-          size_t txidMatch = strValue.find(txid.ToString());
-          if(txidMatch!=std::string::npos) PrintToLog("STODEBUG : Duplicating entry for %s : %s\n",address,txid.ToString());
-
-          const string key = address;
-          const string newValue = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
-          strValue += newValue;
-          // write updated record
-          Status status;
-          if (pdb)
-          {
-              status = pdb->Put(writeoptions, key, strValue);
-              PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
-          }
-      }
+      // see if we are overwriting (check)
+      size_t txidMatch = strValue.find(txid.ToString());
+      if(txidMatch!=std::string::npos) PrintToLog("STODEBUG : Duplicating entry for %s : %s\n",address,txid.ToString());
+  }
+  else if (status.IsNotFound())
+  {
+      strValue.clear();
   }
   else
   {
-      const string key = address;
-      const string value = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
-      Status status;
-      if (pdb)
-      {
-          status = pdb->Put(writeoptions, key, value);
-          PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
+      return;
+  }
+
+  // add details to record, and write it together with the secondary keys
+  strValue += newValue;
+  leveldb::WriteBatch batch;
+  batch.Put(key, strValue);
+  batch.Put(STOTxidIndexKey(txid, address), "");
+  batch.Put(BlockIndexKey(nBlock, address), "");
+  status = pdb->Write(writeoptions, &batch);
+  ++nWritten;
+  PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
+}
+
+/**
+ * Adds the secondary keys for the records written before the index was introduced.
+ */
+void CMPSTOList::buildIndex()
+{
+  std::string strVersion;
+  if (pdb->Get(readoptions, INDEX_VERSION_KEY, &strVersion).ok() && strVersion == INDEX_VERSION) return;
+
+  unsigned int n_found = 0;
+  leveldb::WriteBatch batch;
+  leveldb::Iterator* it = NewIterator();
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      if (IsIndexKey(it->key())) continue;
+      std::vector<std::string> keys;
+      GetSTOIndexKeys(it->key().ToString(), it->value().ToString(), keys);
+      for (std::vector<std::string>::const_iterator itKey = keys.begin(); itKey != keys.end(); ++itKey) {
+          batch.Put(*itKey, "");
       }
+      ++n_found;
   }
+  delete it;
+
+  batch.Put(INDEX_VERSION_KEY, INDEX_VERSION);
+  leveldb::Status status = pdb->Write(syncoptions, &batch);
+  PrintToLog("%s(): indexed %d STO records: %s\n", __func__, n_found, status.ToString());
+}
+
+void CMPSTOList::Clear()
+{
+  CDBBase::Clear();
+  if (pdb) pdb->Put(syncoptions, INDEX_VERSION_KEY, INDEX_VERSION);
 }
 
 void CMPSTOList::printAll()
@@ -3396,6 +3876,7 @@ void CMPSTOList::printAll()
   for(it->SeekToFirst(); it->Valid(); it->Next())
   {
     skey = it->key();
+    if (IsIndexKey(skey)) continue;
     svalue = it->value();
     ++count;
     PrintToLog("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
@@ -3417,11 +3898,23 @@ void CMPSTOList::printStats()
 int CMPSTOList::deleteAboveBlock(int blockNum)
 {
   unsigned int n_found = 0;
-  std::vector<std::string> vecSTORecords;
+  std::set<std::string> setAddresses;
+  leveldb::WriteBatch batch;
+
+  // the block index lists the recipients with receipts in or above the block
   leveldb::Iterator* it = NewIterator();
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+  for (it->Seek(BlockIndexKey(blockNum)); it->Valid() && it->key().starts_with(std::string(1, INDEX_BLOCK)); it->Next()) {
+      setAddresses.insert(std::string(it->key().data() + 5, it->key().size() - 5));
+      batch.Delete(it->key());
+  }
+  delete it;
+
+  std::vector<std::string> vecSTORecords;
+  for (std::set<std::string>::const_iterator itAddress = setAddresses.begin(); itAddress != setAddresses.end(); ++itAddress) {
+      std::string oldValue;
+      if (!pdb->Get(readoptions, *itAddress, &oldValue).ok()) continue;
       std::string newValue;
-      std::string oldValue = it->value().ToString();
+      std::string removedValue;
       bool needsUpdate = false;
       boost::split(vecSTORecords, oldValue, boost::is_any_of(","), boost::token_compress_on);
       for (uint32_t i = 0; i<vecSTORecords.size(); i++) {
@@ -3431,21 +3924,26 @@ int CMPSTOList::deleteAboveBlock(int blockNum)
           if (atoi(vecSTORecordFields[1]) < blockNum) {
               newValue += vecSTORecords[i].append(","); // STO before the reorg, add data back to new value string
           } else {
+              removedValue += vecSTORecords[i].append(",");
               needsUpdate = true;
           }
       }
       if (needsUpdate) { // rewrite record with existing key and new value
           ++n_found;
-          leveldb::Status status = pdb->Put(writeoptions, it->key().ToString(), newValue);
+          std::vector<std::string> removedKeys;
+          GetSTOIndexKeys(*itAddress, removedValue, removedKeys);
+          for (std::vector<std::string>::const_iterator itKey = removedKeys.begin(); itKey != removedKeys.end(); ++itKey) {
+              batch.Delete(*itKey);
+          }
+          batch.Put(*itAddress, newValue);
           PrintToLog("DEBUG STO - rewriting STO data after reorg\n");
-          PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
       }
   }
 
+  leveldb::Status status = pdb->Write(writeoptions, &batch);
+  PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
   PrintToLog("%s(%d); stodb updated records= %d\n", __FUNCTION__, blockNum, n_found);
 
-  delete it;
-
   return (n_found);
 }
 
@@ -3460,11 +3958,24 @@ bool CMPTradeList::getMatchingTrades(const uint256& txid, uint32_t propertyId, U
 
   std::vector<std::string> vstr;
   string txidStr = txid.ToString();
+
+  // the txid index lists the matched trades of the txid, the records are processed in the order of their keys
+  std::set<std::string> setKeys;
+  const std::string prefix = TradeTxidIndexPrefix(txid);
   leveldb::Iterator* it = NewIterator();
-  for(it->SeekToFirst(); it->Valid(); it->Next()) {
-      // search key to see if this is a matching trade
-      std::string strKey = it->key().ToString();
-      std::string strValue = it->value().ToString();
+  for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+      if (it->key().size() != prefix.size() + 33) continue;
+      std::string otherTxidStr = ReadIndexKeyHash(it->key(), prefix.size()).ToString();
+      bool fFirst = it->key()[prefix.size() + 32] == 0;
+      setKeys.insert(fFirst ? txidStr + "+" + otherTxidStr : otherTxidStr + "+" + txidStr);
+  }
+  delete it;
+
+  for (std::set<std::string>::const_iterator itKey = setKeys.begin(); itKey != setKeys.end(); ++itKey) {
+      const std::string& strKey = *itKey;
+      std::string strValue;
+      if (!pdb->Get(readoptions, strKey, &strValue).ok()) continue;
+      ++nRead;
       std::string matchTxid;
       size_t txidMatch = strKey.find(txidStr);
       if (txidMatch == std::string::npos) continue; // no match
@@ -3520,8 +4031,6 @@ bool CMPTradeList::getMatchingTrades(const uint256& txid, uint32_t propertyId, U
       ++count;
   }
 
-  // clean up
-  delete it;
   if (count) { return true; } else { return false; }
 }
 
@@ -3534,13 +4043,36 @@ bool CompareTradePair(const std::pair<int64_t, UniValue>& firstJSONObj, const st
 void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyIdSideB, UniValue& responseArray, uint64_t count)
 {
   if (!pdb) return;
-  leveldb::Iterator* it = NewIterator();
   std::vector<std::pair<int64_t, UniValue> > vecResponse;
   bool propertyIdSideAIsDivisible = isPropertyDivisible(propertyIdSideA);
   bool propertyIdSideBIsDivisible = isPropertyDivisible(propertyIdSideB);
-  for(it->SeekToFirst(); it->Valid(); it->Next()) {
-      std::string strKey = it->key().ToString();
-      std::string strValue = it->value().ToString();
+
+  // the pair index is ordered by block, so only the most recent trades of both orientations are read
+  const uint64_t limit = std::max(count, (uint64_t)1);
+  std::vector<std::pair<int64_t, std::string> > vecCandidates;
+  leveldb::Iterator* it = NewIterator();
+  for (int side = 0; side < 2; ++side) {
+      const std::string prefix = side == 0 ? TradePairIndexPrefix(propertyIdSideA, propertyIdSideB) : TradePairIndexPrefix(propertyIdSideB, propertyIdSideA);
+      uint64_t found = 0;
+      bool fValid = SeekToLastWithPrefix(it, prefix);
+      while (fValid && found < limit) {
+          std::string key = it->key().ToString();
+          it->Prev();
+          fValid = it->Valid() && it->key().starts_with(prefix);
+          if (key.size() != prefix.size() + 68) continue;
+          int64_t blockNum = ReadIndexKey32(key, prefix.size());
+          std::string strKey = ReadIndexKeyHash(key, prefix.size() + 4).ToString() + "+" + ReadIndexKeyHash(key, prefix.size() + 36).ToString();
+          vecCandidates.push_back(std::make_pair(blockNum, strKey));
+          ++found;
+      }
+  }
+  delete it;
+
+  for (std::vector<std::pair<int64_t, std::string> >::const_iterator itCandidate = vecCandidates.begin(); itCandidate != vecCandidates.end(); ++itCandidate) {
+      const std::string& strKey = itCandidate->second;
+      std::string strValue;
+      if (!pdb->Get(readoptions, strKey, &strValue).ok()) continue;
+      ++nRead;
       std::vector<std::string> vecKeys;
       std::vector<std::string> vecValues;
       uint256 sellerTxid, matchingTxid;
@@ -3603,23 +4135,12 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
       vecResponse.push_back(make_pair(blockNum, trade));
   }
 
-  // sort the response most recent first before adding to the array
+  // sort the response most recent first, and add the most recent trades in ascending order
   std::sort(vecResponse.begin(), vecResponse.end(), CompareTradePair);
-  uint64_t processed = 0;
-  for (std::vector<std::pair<int64_t, UniValue> >::iterator it = vecResponse.begin(); it != vecResponse.end(); ++it) {
+  if (vecResponse.size() > limit) vecResponse.resize(limit);
+  for (std::vector<std::pair<int64_t, UniValue> >::reverse_iterator it = vecResponse.rbegin(); it != vecResponse.rend(); ++it) {
       responseArray.push_back(it->second);
-      processed++;
-      if (processed >= count) break;
-  }
-
-  std::vector<UniValue> responseArrayValues = responseArray.getValues();
-  std::reverse(responseArrayValues.begin(), responseArrayValues.end());
-  responseArray.clear();
-  for (std::vector<UniValue>::iterator it = responseArrayValues.begin(); it != responseArrayValues.end(); ++it) {
-      responseArray.push_back(*it);
   }
-
-  delete it;
 }
 
 // obtains a vector of txids where the supplied address participated in a trade (needed for gettradehistory_MP)
@@ -3628,42 +4149,53 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
 void CMPTradeList::getTradesForAddress(std::string address, std::vector<uint256>& vecTransactions, uint32_t propertyIdFilter)
 {
   if (!pdb) return;
-  std::map<std::string,uint256> mapTrades;
+  // the address index is ordered by block and index, the value holds the property ids of the trade
+  const std::string prefix = TradeAddressIndexPrefix(address);
   leveldb::Iterator* it = NewIterator();
-  for(it->SeekToFirst(); it->Valid(); it->Next()) {
-      std::string strKey = it->key().ToString();
-      std::string strValue = it->value().ToString();
-      std::vector<std::string> vecValues;
-      if (strKey.size() != 64) continue; // only interested in trades
-      uint256 txid = uint256S(strKey);
-      size_t addressMatch = strValue.find(address);
-      if (addressMatch == std::string::npos) continue;
-      boost::split(vecValues, strValue, boost::is_any_of(":"), token_compress_on);
-      if (vecValues.size() != 5) {
-          PrintToLog("TRADEDB error - unexpected number of tokens in value (%s)\n", strValue);
+  for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+      if (it->key().size() != prefix.size() + 40 || it->value().size() != 8) {
+          PrintToLog("TRADEDB error - unexpected address index entry for %s\n", address);
           continue;
       }
-      uint32_t propertyIdForSale = boost::lexical_cast<uint32_t>(vecValues[1]);
-      uint32_t propertyIdDesired = boost::lexical_cast<uint32_t>(vecValues[2]);
-      int64_t blockNum = boost::lexical_cast<uint32_t>(vecValues[3]);
-      int64_t txIndex = boost::lexical_cast<uint32_t>(vecValues[4]);
+      uint32_t propertyIdForSale = ReadIndexKey32(it->value(), 0);
+      uint32_t propertyIdDesired = ReadIndexKey32(it->value(), 4);
       if (propertyIdFilter != 0 && propertyIdFilter != propertyIdForSale && propertyIdFilter != propertyIdDesired) continue;
-      std::string sortKey = strprintf("%06d%010d", blockNum, txIndex);
-      mapTrades.insert(std::make_pair(sortKey, txid));
+      vecTransactions.push_back(ReadIndexKeyHash(it->key(), prefix.size() + 8));
   }
   delete it;
-  for (std::map<std::string,uint256>::iterator it = mapTrades.begin(); it != mapTrades.end(); it++) {
-      vecTransactions.push_back(it->second);
+}
+
+void CMPTradeList::writeRecord(const std::string& key, const std::string& value)
+{
+  leveldb::WriteBatch batch;
+  std::vector<std::pair<std::string, std::string> > entries;
+
+  // remove the secondary keys of a replaced record
+  std::string oldValue;
+  if (pdb->Get(readoptions, key, &oldValue).ok() && GetTradeIndexEntries(key, oldValue, entries)) {
+      for (std::vector<std::pair<std::string, std::string> >::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+          batch.Delete(it->first);
+      }
+      entries.clear();
+  }
+
+  batch.Put(key, value);
+  if (GetTradeIndexEntries(key, value, entries)) {
+      for (std::vector<std::pair<std::string, std::string> >::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+          batch.Put(it->first, it->second);
+      }
   }
+
+  Status status = pdb->Write(writeoptions, &batch);
+  ++nWritten;
+  if (exodus_debug_tradedb) PrintToLog("%s(): %s\n", __FUNCTION__, status.ToString());
 }
 
 void CMPTradeList::recordNewTrade(const uint256& txid, const std::string& address, uint32_t propertyIdForSale, uint32_t propertyIdDesired, int blockNum, int blockIndex)
 {
   if (!pdb) return;
   std::string strValue = strprintf("%s:%d:%d:%d:%d", address, propertyIdForSale, propertyIdDesired, blockNum, blockIndex);
-  Status status = pdb->Put(writeoptions, txid.ToString(), strValue);
-  ++nWritten;
-  if (exodus_debug_tradedb) PrintToLog("%s(): %s\n", __FUNCTION__, status.ToString());
+  writeRecord(txid.ToString(), strValue);
 }
 
 void CMPTradeList::recordMatchedTrade(const uint256 txid1, const uint256 txid2, string address1, string address2, unsigned int prop1, unsigned int prop2, uint64_t amount1, uint64_t amount2, int blockNum, int64_t fee)
@@ -3671,13 +4203,7 @@ void CMPTradeList::recordMatchedTrade(const uint256 txid1, const uint256 txid2,
   if (!pdb) return;
   const string key = txid1.ToString() + "+" + txid2.ToString();
   const string value = strprintf("%s:%s:%u:%u:%lu:%lu:%d:%d", address1, address2, prop1, prop2, amount1, amount2, blockNum, fee);
-  Status status;
-  if (pdb)
-  {
-    status = pdb->Put(writeoptions, key, value);
-    ++nWritten;
-    if (exodus_debug_tradedb) PrintToLog("%s(): %s\n", __FUNCTION__, status.ToString());
-  }
+  writeRecord(key, value);
 }
 
 /**
@@ -3687,33 +4213,64 @@ void CMPTradeList::recordMatchedTrade(const uint256 txid1, const uint256 txid2,
  */
 int CMPTradeList::deleteAboveBlock(int blockNum)
 {
-  leveldb::Slice skey, svalue;
-  unsigned int count = 0;
-  std::vector<std::string> vstr;
-  int block = 0;
   unsigned int n_found = 0;
+  leveldb::WriteBatch batch;
+
+  // the block index lists the trades in or above the block
   leveldb::Iterator* it = NewIterator();
-  for(it->SeekToFirst(); it->Valid(); it->Next())
-  {
-    skey = it->key();
-    svalue = it->value();
-    ++count;
-    string strvalue = it->value().ToString();
-    boost::split(vstr, strvalue, boost::is_any_of(":"), token_compress_on);
-    if (7 == vstr.size()) block = atoi(vstr[6]); // trade matches have 7 tokens, key is txid+txid, only care about block
-    if (5 == vstr.size()) block = atoi(vstr[3]); // trades have 5 tokens, key is txid, only care about block
-    if (block >= blockNum) {
-        ++n_found;
-        PrintToLog("%s() DELETING FROM TRADEDB: %s=%s\n", __FUNCTION__, skey.ToString(), svalue.ToString());
-        pdb->Delete(writeoptions, skey);
-    }
+  for (it->Seek(BlockIndexKey(blockNum)); it->Valid() && it->key().starts_with(std::string(1, INDEX_BLOCK)); it->Next()) {
+      std::string strKey(it->key().data() + 5, it->key().size() - 5);
+      batch.Delete(it->key());
+      std::string strValue;
+      if (!pdb->Get(readoptions, strKey, &strValue).ok()) continue;
+      ++n_found;
+      PrintToLog("%s() DELETING FROM TRADEDB: %s=%s\n", __FUNCTION__, strKey, strValue);
+      std::vector<std::pair<std::string, std::string> > entries;
+      GetTradeIndexEntries(strKey, strValue, entries);
+      for (std::vector<std::pair<std::string, std::string> >::const_iterator itEntry = entries.begin(); itEntry != entries.end(); ++itEntry) {
+          batch.Delete(itEntry->first);
+      }
+      batch.Delete(strKey);
   }
+  delete it;
 
+  pdb->Write(writeoptions, &batch);
   PrintToLog("%s(%d); tradedb n_found= %d\n", __FUNCTION__, blockNum, n_found);
 
+  return (n_found);
+}
+
+/**
+ * Adds the secondary keys for the records written before the index was introduced.
+ */
+void CMPTradeList::buildIndex()
+{
+  std::string strVersion;
+  if (pdb->Get(readoptions, INDEX_VERSION_KEY, &strVersion).ok() && strVersion == INDEX_VERSION) return;
+
+  unsigned int n_found = 0;
+  leveldb::WriteBatch batch;
+  leveldb::Iterator* it = NewIterator();
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      if (IsIndexKey(it->key())) continue;
+      std::vector<std::pair<std::string, std::string> > entries;
+      if (!GetTradeIndexEntries(it->key().ToString(), it->value().ToString(), entries)) continue;
+      for (std::vector<std::pair<std::string, std::string> >::const_iterator itEntry = entries.begin(); itEntry != entries.end(); ++itEntry) {
+          batch.Put(itEntry->first, itEntry->second);
+      }
+      ++n_found;
+  }
   delete it;
 
-  return (n_found);
+  batch.Put(INDEX_VERSION_KEY, INDEX_VERSION);
+  leveldb::Status status = pdb->Write(syncoptions, &batch);
+  PrintToLog("%s(): indexed %d trade records: %s\n", __func__, n_found, status.ToString());
+}
+
+void CMPTradeList::Clear()
+{
+  CDBBase::Clear();
+  if (pdb) pdb->Put(syncoptions, INDEX_VERSION_KEY, INDEX_VERSION);
 }
 
 void CMPTradeList::printStats()
@@ -3724,10 +4281,10 @@ void CMPTradeList::printStats()
 int CMPTradeList::getMPTradeCountTotal()
 {
     int count = 0;
-    Slice skey, svalue;
     Iterator* it = NewIterator();
     for(it->SeekToFirst(); it->Valid(); it->Next())
     {
+        if (IsIndexKey(it->key())) continue;
         ++count;
     }
     delete it;
@@ -3743,6 +4300,7 @@ void CMPTradeList::printAll()
   for(it->SeekToFirst(); it->Valid(); it->Next())
   {
     skey = it->key();
+    if (IsIndexKey(skey)) continue;
     svalue = it->value();
     ++count;
     PrintToLog("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
@@ -3906,10 +4464,13 @@ int exodus_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
     // transactions were found in the block, signal the UI accordingly
     if (countMP > 0) CheckWalletUpdate(true);
 
-    // calculate and print a consensus hash if required
-    if (ShouldConsensusHashBlock(nBlockNow)) {
+    // calculate and print a consensus hash if required, the cheap commitment is used when hashing every block
+    if (IsConsensusHashBlockRequested(nBlockNow)) {
         uint256 consensusHash = GetConsensusHash();
         PrintToLog("Consensus hash for block %d: %s\n", nBlockNow, consensusHash.GetHex());
+    } else if (ShouldConsensusHashBlock(nBlockNow)) {
+        uint256 consensusCommitment = GetConsensusCommitment();
+        PrintToLog("Consensus commitment for block %d: %s\n", nBlockNow, consensusCommitment.GetHex());
     }
 
     // request checkpoint verification
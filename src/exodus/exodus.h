@@ -185,14 +185,22 @@ public:
 };
 
 /** LevelDB based storage for STO recipients.
+ *
+ * Receipts are listed with the recipient address as key. Secondary keys map the STO txid and the
+ * block to the recipients, so lookups and reorgs don't have to scan the whole database.
  */
 class CMPSTOList : public CDBBase
 {
+private:
+    /** Adds the secondary keys for the records written before the index was introduced. */
+    void buildIndex();
+
 public:
     CMPSTOList(const boost::filesystem::path& path, bool fWipe)
     {
         leveldb::Status status = Open(path, fWipe);
         PrintToLog("Loading send-to-owners database: %s\n", status.ToString());
+        if (status.ok()) buildIndex();
     }
 
     virtual ~CMPSTOList()
@@ -207,17 +215,29 @@ public:
     void printAll();
     bool exists(string address);
     void recordSTOReceive(std::string, const uint256&, int, unsigned int, uint64_t);
+    void Clear();
 };
 
 /** LevelDB based storage for the trade history. Trades are listed with key "txid1+txid2".
+ *
+ * Secondary keys map the property pair, the address, the txid and the block to the trades, so
+ * range queries seek straight to the relevant records.
  */
 class CMPTradeList : public CDBBase
 {
+private:
+    /** Writes the record and its secondary keys, replacing the secondary keys of a previous record. */
+    void writeRecord(const std::string& key, const std::string& value);
+
+    /** Adds the secondary keys for the records written before the index was introduced. */
+    void buildIndex();
+
 public:
     CMPTradeList(const boost::filesystem::path& path, bool fWipe)
     {
         leveldb::Status status = Open(path, fWipe);
         PrintToLog("Loading trades database: %s\n", status.ToString());
+        if (status.ok()) buildIndex();
     }
 
     virtual ~CMPTradeList()
@@ -235,6 +255,7 @@ public:
     void getTradesForAddress(std::string address, std::vector<uint256>& vecTransactions, uint32_t propertyIdFilter = 0);
     void getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyIdSideB, UniValue& response, uint64_t count);
     int getMPTradeCountTotal();
+    void Clear();
 };
 
 /** LevelDB based storage for transactions, with txid as key and validity bit, and other data as value.
@@ -323,6 +344,8 @@ int exodus_save_state( CBlockIndex const *pBlockIndex );
 namespace exodus
 {
 extern std::unordered_map<std::string, CMPTally> mp_tally_map;
+//! Holders of each property, maintained by update_tally_map()
+extern CMPTallyIndex mp_tally_index;
 extern CMPTxList *p_txlistdb;
 extern CMPTradeList *t_tradelistdb;
 extern CMPSTOList *s_stolistdb;
@@ -20,16 +20,16 @@
 #include <boost/multiprecision/cpp_int.hpp>
 #include <boost/rational.hpp>
 
-#include <openssl/sha.h>
-
 #include <assert.h>
 #include <stdint.h>
 
-#include <fstream>
+#include <algorithm>
 #include <limits>
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 typedef boost::multiprecision::cpp_dec_float_100 dec_float;
 typedef boost::multiprecision::checked_int128_t int128_t;
@@ -42,6 +42,82 @@ using namespace exodus;
 //! Global map for price and order data
 md_PropertiesMap exodus::metadex;
 
+namespace {
+//! Location of an open trade in the MetaDEx maps
+struct md_Position
+{
+    md_PropertiesMap::iterator property;
+    md_PricesMap::iterator price;
+    md_Set::iterator trade;
+};
+
+//! Orders positions like a scan over the MetaDEx maps: by property, price, block and index within block
+struct md_PositionCompare
+{
+    bool operator()(const md_Position& lhs, const md_Position& rhs) const
+    {
+        if (lhs.property->first != rhs.property->first) return lhs.property->first < rhs.property->first;
+        if (lhs.price->first != rhs.price->first) return lhs.price->first < rhs.price->first;
+        return MetaDEx_compare()(*lhs.trade, *rhs.trade);
+    }
+};
+
+struct md_TxidHasher
+{
+    size_t operator()(const uint256& txid) const { return txid.GetCheapHash(); }
+};
+}
+
+//! Open trades by txid
+static std::unordered_map<uint256, md_Position, md_TxidHasher> md_txidIndex;
+//! Txids of the open trades of each address
+static std::unordered_map<std::string, std::set<uint256> > md_addressIndex;
+
+static void IndexTrade(md_PropertiesMap::iterator itProperty, md_PricesMap::iterator itPrice, md_Set::iterator itTrade)
+{
+    md_Position position = {itProperty, itPrice, itTrade};
+    md_txidIndex[itTrade->getHash()] = position;
+    md_addressIndex[itTrade->getAddr()].insert(itTrade->getHash());
+}
+
+static void UnindexTrade(const CMPMetaDEx& trade)
+{
+    std::unordered_map<std::string, std::set<uint256> >::iterator it = md_addressIndex.find(trade.getAddr());
+    if (it != md_addressIndex.end()) {
+        it->second.erase(trade.getHash());
+        if (it->second.empty()) md_addressIndex.erase(it);
+    }
+    md_txidIndex.erase(trade.getHash());
+}
+
+// Removes a trade from the MetaDEx maps, an emptied price level is removed as well
+static void RemoveTrade(md_Position position)
+{
+    UnindexTrade(*position.trade);
+
+    md_Set& indexes = position.price->second;
+    indexes.erase(position.trade);
+    if (indexes.empty()) position.property->second.erase(position.price);
+}
+
+// Returns the open trades of an address, ordered like a scan over the MetaDEx maps
+static std::vector<md_Position> GetTradesOfAddress(const std::string& address)
+{
+    std::vector<md_Position> positions;
+
+    std::unordered_map<std::string, std::set<uint256> >::const_iterator it = md_addressIndex.find(address);
+    if (it == md_addressIndex.end()) return positions;
+
+    for (std::set<uint256>::const_iterator itTxid = it->second.begin(); itTxid != it->second.end(); ++itTxid) {
+        std::unordered_map<uint256, md_Position, md_TxidHasher>::const_iterator itPosition = md_txidIndex.find(*itTxid);
+        assert(itPosition != md_txidIndex.end());
+        positions.push_back(itPosition->second);
+    }
+    std::sort(positions.begin(), positions.end(), md_PositionCompare());
+
+    return positions;
+}
+
 md_PricesMap* exodus::get_Prices(uint32_t prop)
 {
     md_PropertiesMap::iterator it = metadex.find(prop);
@@ -51,7 +127,7 @@ md_PricesMap* exodus::get_Prices(uint32_t prop)
     return (md_PricesMap*) NULL;
 }
 
-md_Set* exodus::get_Indexes(md_PricesMap* p, rational_t price)
+md_Set* exodus::get_Indexes(md_PricesMap* p, const CMPMetaDExPrice& price)
 {
     md_PricesMap::iterator it = p->find(price);
 
@@ -95,6 +171,22 @@ static bool rangeInt64(const rational_t& value)
     return (rangeInt64(value.numerator()) && rangeInt64(value.denominator()));
 }
 
+CMPMetaDExPrice::CMPMetaDExPrice(int64_t num, int64_t denom)
+  : numerator(0), denominator(1)
+{
+    assert(0 <= num && 0 <= denom);
+
+    if (denom) {
+        numerator = num;
+        denominator = denom;
+    }
+}
+
+rational_t CMPMetaDExPrice::ToRational() const
+{
+    return rational_t(int128_t(numerator), int128_t(denominator));
+}
+
 // Used by CMPMetaDEx::displayUnitPrice
 static int64_t xToRoundUpInt64(const rational_t& value)
 {
@@ -142,24 +234,29 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
     if (exodus_debug_metadex1) PrintToLog("%s(%s: prop=%d, desprop=%d, desprice= %s);newo: %s\n",
         __FUNCTION__, pnew->getAddr(), propertyForSale, propertyDesired, xToString(pnew->inversePrice()), pnew->ToString());
 
-    md_PricesMap* const ppriceMap = get_Prices(propertyDesired);
+    md_PropertiesMap::iterator propertyIt = metadex.find(propertyDesired);
 
     // nothing for the desired property exists in the market, sorry!
-    if (!ppriceMap) {
+    if (propertyIt == metadex.end()) {
         PrintToLog("%s()=%d:%s NOT FOUND ON THE MARKET\n", __FUNCTION__, NewReturn, getTradeReturnType(NewReturn));
         return NewReturn;
     }
 
+    md_PricesMap* const ppriceMap = &(propertyIt->second);
+    const CMPMetaDExPrice buyersPrice = pnew->inversePriceKey();
+
     // within the desired property map (given one property) iterate over the items looking at prices
-    for (md_PricesMap::iterator priceIt = ppriceMap->begin(); priceIt != ppriceMap->end(); ++priceIt) { // check all prices
-        const rational_t sellersPrice = priceIt->first;
+    md_PricesMap::iterator priceIt = ppriceMap->begin();
+    while (priceIt != ppriceMap->end()) { // check all prices
+        const CMPMetaDExPrice& sellersPrice = priceIt->first;
 
         if (exodus_debug_metadex2) PrintToLog("comparing prices: desprice %s needs to be GREATER THAN OR EQUAL TO %s\n",
-            xToString(pnew->inversePrice()), xToString(sellersPrice));
+            xToString(pnew->inversePrice()), xToString(sellersPrice.ToRational()));
 
         // Is the desired price check satisfied? The buyer's inverse price must be larger than that of the seller.
-        if (pnew->inversePrice() < sellersPrice) {
-            continue;
+        // The prices are sorted in ascending order, so none of the remaining price levels can satisfy it either.
+        if (buyersPrice < sellersPrice) {
+            break;
         }
 
         md_Set* const pofferSet = &(priceIt->second);
@@ -168,10 +265,10 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
         md_Set::iterator offerIt = pofferSet->begin();
         while (offerIt != pofferSet->end()) { // specific price, check all properties
             const CMPMetaDEx* const pold = &(*offerIt);
-            assert(pold->unitPrice() == sellersPrice);
+            assert(pold->unitPriceKey() == sellersPrice);
 
             if (exodus_debug_metadex1) PrintToLog("Looking at existing: %s (its prop= %d, its des prop= %d) = %s\n",
-                xToString(sellersPrice), pold->getProperty(), pold->getDesProperty(), pold->ToString());
+                xToString(sellersPrice.ToRational()), pold->getProperty(), pold->getDesProperty(), pold->ToString());
 
             // does the desired property match?
             if (pold->getDesProperty() != propertyForSale) {
@@ -179,14 +276,14 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
                 continue;
             }
 
-            if (exodus_debug_metadex1) PrintToLog("MATCH FOUND, Trade: %s = %s\n", xToString(sellersPrice), pold->ToString());
+            if (exodus_debug_metadex1) PrintToLog("MATCH FOUND, Trade: %s = %s\n", xToString(sellersPrice.ToRational()), pold->ToString());
 
             // match found, execute trade now!
             const int64_t seller_amountForSale = pold->getAmountRemaining();
             const int64_t buyer_amountOffered = pnew->getAmountRemaining();
 
             if (exodus_debug_metadex1) PrintToLog("$$ trading using price: %s; seller: forsale=%d, desired=%d, remaining=%d, buyer amount offered=%d\n",
-                xToString(sellersPrice), pold->getAmountForSale(), pold->getAmountDesired(), pold->getAmountRemaining(), pnew->getAmountRemaining());
+                xToString(sellersPrice.ToRational()), pold->getAmountForSale(), pold->getAmountDesired(), pold->getAmountRemaining(), pnew->getAmountRemaining());
             if (exodus_debug_metadex1) PrintToLog("$$ old: %s\n", pold->ToString());
             if (exodus_debug_metadex1) PrintToLog("$$ new: %s\n", pnew->ToString());
 
@@ -198,8 +295,8 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
             assert(pnew->getProperty() != pnew->getDesProperty());
             assert(pnew->getProperty() == pold->getDesProperty());
             assert(pold->getProperty() == pnew->getDesProperty());
-            assert(pold->unitPrice() <= pnew->inversePrice());
-            assert(pnew->unitPrice() <= pold->inversePrice());
+            assert(sellersPrice <= buyersPrice);
+            assert(pnew->unitPriceKey() <= pold->inversePriceKey());
 
             ///////////////////////////
 
@@ -232,11 +329,11 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
 
             // If the resulting adjusted unit price is higher than Alice' price, the
             // orders shall not execute, and no representable fill is made
-            const rational_t xEffectivePrice(nWouldPay, nCouldBuy);
+            const CMPMetaDExPrice xEffectivePrice(nWouldPay, nCouldBuy);
 
-            if (xEffectivePrice > pnew->inversePrice()) {
+            if (xEffectivePrice > buyersPrice) {
                 if (exodus_debug_metadex1) PrintToLog(
-                        "-- effective price is too expensive: %s\n", xToString(xEffectivePrice));
+                        "-- effective price is too expensive: %s\n", xToString(xEffectivePrice.ToRational()));
                 ++offerIt;
                 continue;
             }
@@ -252,8 +349,8 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
             ///////////////////////////
 
             // postconditions
-            assert(xEffectivePrice >= pold->unitPrice());
-            assert(xEffectivePrice <= pnew->inversePrice());
+            assert(xEffectivePrice >= sellersPrice);
+            assert(xEffectivePrice <= buyersPrice);
             assert(0 <= seller_amountLeft);
             assert(0 <= buyer_amountLeft);
             assert(seller_amountForSale == seller_amountLeft + buyer_amountGot);
@@ -315,12 +412,13 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
 
             if (exodus_debug_metadex1) PrintToLog("++ erased old: %s\n", offerIt->ToString());
             // erase the old seller element
+            UnindexTrade(*offerIt);
             pofferSet->erase(offerIt++);
 
             // insert the updated one in place of the old
             if (0 < seller_replacement.getAmountRemaining()) {
                 PrintToLog("++ inserting seller_replacement: %s\n", seller_replacement.ToString());
-                pofferSet->insert(seller_replacement);
+                IndexTrade(propertyIt, priceIt, pofferSet->insert(offerIt, seller_replacement));
             }
 
             if (bBuyerSatisfied) {
@@ -329,6 +427,13 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
             }
         } // specific price, check all properties
 
+        // remove the price level, if all offers were filled
+        if (pofferSet->empty()) {
+            ppriceMap->erase(priceIt++);
+        } else {
+            ++priceIt;
+        }
+
         if (bBuyerSatisfied) break;
     } // check all prices
 
@@ -426,28 +531,6 @@ std::string CMPMetaDEx::ToString() const
         property, FormatMP(property, amount_forsale), desired_property, FormatMP(desired_property, amount_desired));
 }
 
-void CMPMetaDEx::saveOffer(std::ofstream& file, SHA256_CTX* shaCtx) const
-{
-    std::string lineOut = strprintf("%s,%d,%d,%d,%d,%d,%d,%d,%s,%d",
-        addr,
-        block,
-        amount_forsale,
-        property,
-        amount_desired,
-        desired_property,
-        subaction,
-        idx,
-        txid.ToString(),
-        amount_remaining
-    );
-
-    // add the line to the hash
-    SHA256_Update(shaCtx, lineOut.c_str(), lineOut.length());
-
-    // write the line
-    file << lineOut << std::endl;
-}
-
 bool MetaDEx_compare::operator()(const CMPMetaDEx &lhs, const CMPMetaDEx &rhs) const
 {
     if (lhs.getBlock() == rhs.getBlock()) return lhs.getIdx() < rhs.getIdx();
@@ -456,39 +539,29 @@ bool MetaDEx_compare::operator()(const CMPMetaDEx &lhs, const CMPMetaDEx &rhs) c
 
 bool exodus::MetaDEx_INSERT(const CMPMetaDEx& objMetaDEx)
 {
-    // Create an empty price map (to use in case price map for this property does not already exist)
-    md_PricesMap temp_prices;
-    // Attempt to obtain the price map for the property
-    md_PricesMap *p_prices = get_Prices(objMetaDEx.getProperty());
-
-    // Create an empty set of metadex objects (to use in case no set currently exists at this price)
-    md_Set temp_indexes;
-    md_Set *p_indexes = NULL;
-
-    // Prepare for return code
-    std::pair <md_Set::iterator, bool> ret;
-
-    // Attempt to obtain a set of metadex objects for this price from the price map
-    if (p_prices) p_indexes = get_Indexes(p_prices, objMetaDEx.unitPrice());
-    // See if the set was populated, if not no set exists at this price level, use the empty set that we created earlier
-    if (!p_indexes) p_indexes = &temp_indexes;
+    // Obtain the price map for the property and the set of metadex objects at this price, both are created if they don't exist yet
+    md_PropertiesMap::iterator itProperty = metadex.insert(std::make_pair(objMetaDEx.getProperty(), md_PricesMap())).first;
+    md_PricesMap::iterator itPrice = itProperty->second.insert(std::make_pair(objMetaDEx.unitPriceKey(), md_Set())).first;
 
     // Attempt to insert the metadex object into the set
-    ret = p_indexes->insert(objMetaDEx);
+    std::pair<md_Set::iterator, bool> ret = itPrice->second.insert(objMetaDEx);
     if (false == ret.second) return false;
 
-    // If a prices map did not exist for this property, set p_prices to the temp empty price map
-    if (!p_prices) p_prices = &temp_prices;
-
-    // Update the prices map with the new set at this price
-    (*p_prices)[objMetaDEx.unitPrice()] = *p_indexes;
-
-    // Set the metadex map for the property to the updated (or new if it didn't exist) price map
-    metadex[objMetaDEx.getProperty()] = *p_prices;
+    IndexTrade(itProperty, itPrice, ret.first);
 
     return true;
 }
 
+/**
+ * Removes every order without touching the balances.
+ */
+void exodus::MetaDEx_CLEAR()
+{
+    metadex.clear();
+    md_txidIndex.clear();
+    md_addressIndex.clear();
+}
+
 // pretty much directly linked to the ADD TX21 command off the wire
 int exodus::MetaDEx_ADD(const std::string& sender_addr, uint32_t prop, int64_t amount, int block, uint32_t property_desired, int64_t amount_desired, const uint256& txid, unsigned int idx)
 {
@@ -529,49 +602,40 @@ int exodus::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block, con
 {
     int rc = METADEX_ERROR -20;
     CMPMetaDEx mdex(sender_addr, 0, prop, amount, property_desired, amount_desired, uint256(), 0, CMPTransaction::CANCEL_AT_PRICE);
-    md_PricesMap* prices = get_Prices(prop);
-    const CMPMetaDEx* p_mdex = NULL;
+    const CMPMetaDExPrice price = mdex.unitPriceKey();
 
     if (exodus_debug_metadex1) PrintToLog("%s():%s\n", __FUNCTION__, mdex.ToString());
 
     if (exodus_debug_metadex2) MetaDEx_debug_print();
 
-    if (!prices) {
+    if (!get_Prices(prop)) {
         PrintToLog("%s() NOTHING FOUND for %s\n", __FUNCTION__, mdex.ToString());
         return rc -1;
     }
 
-    // within the desired property map (given one property) iterate over the items
-    for (md_PricesMap::iterator my_it = prices->begin(); my_it != prices->end(); ++my_it) {
-        rational_t sellers_price = my_it->first;
-
-        if (mdex.unitPrice() != sellers_price) continue;
-
-        md_Set* indexes = &(my_it->second);
-
-        for (md_Set::iterator iitt = indexes->begin(); iitt != indexes->end();) {
-            p_mdex = &(*iitt);
+    // iterate over the orders of the sender, in the order of the price map of the property
+    std::vector<md_Position> positions = GetTradesOfAddress(sender_addr);
+    for (std::vector<md_Position>::const_iterator it = positions.begin(); it != positions.end(); ++it) {
+        const CMPMetaDEx* p_mdex = &(*it->trade);
 
-            if (exodus_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
+        if (exodus_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
 
-            if ((p_mdex->getDesProperty() != property_desired) || (p_mdex->getAddr() != sender_addr)) {
-                ++iitt;
-                continue;
-            }
+        if ((p_mdex->getProperty() != prop) || (it->price->first != price) || (p_mdex->getDesProperty() != property_desired)) {
+            continue;
+        }
 
-            rc = 0;
-            PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, p_mdex->ToString());
+        rc = 0;
+        PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, p_mdex->ToString());
 
-            // move from reserve to main
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
+        // move from reserve to main
+        assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
+        assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
 
-            // record the cancellation
-            bool bValid = true;
-            p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
+        // record the cancellation
+        bool bValid = true;
+        p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
 
-            indexes->erase(iitt++);
-        }
+        RemoveTrade(*it);
     }
 
     if (exodus_debug_metadex2) MetaDEx_debug_print();
@@ -582,45 +646,39 @@ int exodus::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block, con
 int exodus::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int block, const std::string& sender_addr, uint32_t prop, uint32_t property_desired)
 {
     int rc = METADEX_ERROR -30;
-    md_PricesMap* prices = get_Prices(prop);
-    const CMPMetaDEx* p_mdex = NULL;
 
     PrintToLog("%s(%d,%d)\n", __FUNCTION__, prop, property_desired);
 
     if (exodus_debug_metadex3) MetaDEx_debug_print();
 
-    if (!prices) {
+    if (!get_Prices(prop)) {
         PrintToLog("%s() NOTHING FOUND\n", __FUNCTION__);
         return rc -1;
     }
 
-    // within the desired property map (given one property) iterate over the items
-    for (md_PricesMap::iterator my_it = prices->begin(); my_it != prices->end(); ++my_it) {
-        md_Set* indexes = &(my_it->second);
-
-        for (md_Set::iterator iitt = indexes->begin(); iitt != indexes->end();) {
-            p_mdex = &(*iitt);
+    // iterate over the orders of the sender, in the order of the price map of the property
+    std::vector<md_Position> positions = GetTradesOfAddress(sender_addr);
+    for (std::vector<md_Position>::const_iterator it = positions.begin(); it != positions.end(); ++it) {
+        const CMPMetaDEx* p_mdex = &(*it->trade);
 
-            if (exodus_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
+        if (exodus_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
 
-            if ((p_mdex->getDesProperty() != property_desired) || (p_mdex->getAddr() != sender_addr)) {
-                ++iitt;
-                continue;
-            }
+        if ((p_mdex->getProperty() != prop) || (p_mdex->getDesProperty() != property_desired)) {
+            continue;
+        }
 
-            rc = 0;
-            PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, p_mdex->ToString());
+        rc = 0;
+        PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, p_mdex->ToString());
 
-            // move from reserve to main
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
+        // move from reserve to main
+        assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
+        assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
 
-            // record the cancellation
-            bool bValid = true;
-            p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
+        // record the cancellation
+        bool bValid = true;
+        p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
 
-            indexes->erase(iitt++);
-        }
+        RemoveTrade(*it);
     }
 
     if (exodus_debug_metadex3) MetaDEx_debug_print();
@@ -629,7 +687,7 @@ int exodus::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int block,
 }
 
 /**
- * Scans the orderbook and remove everything for an address.
+ * Removes everything for an address from the orderbook.
  */
 int exodus::MetaDEx_CANCEL_EVERYTHING(const uint256& txid, unsigned int block, const std::string& sender_addr, unsigned char ecosystem)
 {
@@ -641,44 +699,29 @@ int exodus::MetaDEx_CANCEL_EVERYTHING(const uint256& txid, unsigned int block, c
 
     PrintToLog("<<<<<<\n");
 
-    for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        unsigned int prop = my_it->first;
+    // iterate over the orders of the sender, in the order of the MetaDEx maps
+    std::vector<md_Position> positions = GetTradesOfAddress(sender_addr);
+    for (std::vector<md_Position>::const_iterator it = positions.begin(); it != positions.end(); ++it) {
+        unsigned int prop = it->property->first;
 
         // skip property, if it is not in the expected ecosystem
         if (isMainEcosystemProperty(ecosystem) && !isMainEcosystemProperty(prop)) continue;
         if (isTestEcosystemProperty(ecosystem) && !isTestEcosystemProperty(prop)) continue;
 
-        PrintToLog(" ## property: %u\n", prop);
-        md_PricesMap& prices = my_it->second;
-
-        for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            rational_t price = it->first;
-            md_Set& indexes = it->second;
-
-            PrintToLog("  # Price Level: %s\n", xToString(price));
-
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
-                PrintToLog("%s= %s\n", xToString(price), it->ToString());
-
-                if (it->getAddr() != sender_addr) {
-                    ++it;
-                    continue;
-                }
+        const CMPMetaDEx& obj = *it->trade;
 
-                rc = 0;
-                PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
+        rc = 0;
+        PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, obj.ToString());
 
-                // move from reserve to balance
-                assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
-                assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
+        // move from reserve to balance
+        assert(update_tally_map(obj.getAddr(), obj.getProperty(), -obj.getAmountRemaining(), METADEX_RESERVE));
+        assert(update_tally_map(obj.getAddr(), obj.getProperty(), obj.getAmountRemaining(), BALANCE));
 
-                // record the cancellation
-                bool bValid = true;
-                p_txlistdb->recordMetaDExCancelTX(txid, it->getHash(), bValid, block, it->getProperty(), it->getAmountRemaining());
+        // record the cancellation
+        bool bValid = true;
+        p_txlistdb->recordMetaDExCancelTX(txid, obj.getHash(), bValid, block, obj.getProperty(), obj.getAmountRemaining());
 
-                indexes.erase(it++);
-            }
-        }
+        RemoveTrade(*it);
     }
     PrintToLog(">>>>>>\n");
 
@@ -696,7 +739,7 @@ int exodus::MetaDEx_SHUTDOWN_ALLPAIR()
     PrintToLog("%s()\n", __FUNCTION__);
     for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
         md_PricesMap& prices = my_it->second;
-        for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
+        for (md_PricesMap::iterator it = prices.begin(); it != prices.end();) {
             md_Set& indexes = it->second;
             for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
                 if (it->getDesProperty() > EXODUS_PROPERTY_TEXODUS && it->getProperty() > EXODUS_PROPERTY_TEXODUS) { // no EXODUS/TEXODUS side to the trade
@@ -704,9 +747,17 @@ int exodus::MetaDEx_SHUTDOWN_ALLPAIR()
                     // move from reserve to balance
                     assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
                     assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
+                    UnindexTrade(*it);
                     indexes.erase(it++);
+                } else {
+                    ++it;
                 }
             }
+            if (indexes.empty()) {
+                prices.erase(it++);
+            } else {
+                ++it;
+            }
         }
     }
     return rc;
@@ -723,34 +774,28 @@ int exodus::MetaDEx_SHUTDOWN()
         md_PricesMap& prices = my_it->second;
         for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
             md_Set& indexes = it->second;
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
+            for (md_Set::iterator it = indexes.begin(); it != indexes.end(); ++it) {
                 PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
                 // move from reserve to balance
                 assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
                 assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
-                indexes.erase(it++);
             }
         }
+        prices.clear();
     }
+    md_txidIndex.clear();
+    md_addressIndex.clear();
     return rc;
 }
 
-// searches the metadex maps to see if a trade is still open
-// allows search to be optimized if propertyIdForSale is specified
+// looks up whether a trade is still open
+// if propertyIdForSale is specified, the trade must also sell this property
 bool exodus::MetaDEx_isOpen(const uint256& txid, uint32_t propertyIdForSale)
 {
-    for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        if (propertyIdForSale != 0 && propertyIdForSale != my_it->first) continue;
-        md_PricesMap & prices = my_it->second;
-        for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            md_Set & indexes = (it->second);
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end(); ++it) {
-                CMPMetaDEx obj = *it;
-                if( obj.getHash().GetHex() == txid.GetHex() ) return true;
-            }
-        }
-    }
-    return false;
+    std::unordered_map<uint256, md_Position, md_TxidHasher>::const_iterator it = md_txidIndex.find(txid);
+    if (it == md_txidIndex.end()) return false;
+
+    return (propertyIdForSale == 0 || propertyIdForSale == it->second.property->first);
 }
 
 /**
@@ -815,7 +860,7 @@ void exodus::MetaDEx_debug_print(bool bShowPriceLevel, bool bDisplay)
         md_PricesMap& prices = my_it->second;
 
         for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            rational_t price = it->first;
+            const rational_t price = it->first.ToRational();
             md_Set& indexes = it->second;
 
             if (bShowPriceLevel) PrintToLog("  # Price Level: %s\n", xToString(price));
@@ -837,14 +882,8 @@ void exodus::MetaDEx_debug_print(bool bShowPriceLevel, bool bDisplay)
  */
 const CMPMetaDEx* exodus::MetaDEx_RetrieveTrade(const uint256& txid)
 {
-    for (md_PropertiesMap::iterator propIter = metadex.begin(); propIter != metadex.end(); ++propIter) {
-        md_PricesMap & prices = propIter->second;
-        for (md_PricesMap::iterator pricesIter = prices.begin(); pricesIter != prices.end(); ++pricesIter) {
-            md_Set & indexes = pricesIter->second;
-            for (md_Set::iterator tradesIter = indexes.begin(); tradesIter != indexes.end(); ++tradesIter) {
-                if (txid == (*tradesIter).getHash()) return &(*tradesIter);
-            }
-        }
-    }
-    return (CMPMetaDEx*) NULL;
+    std::unordered_map<uint256, md_Position, md_TxidHasher>::const_iterator it = md_txidIndex.find(txid);
+    if (it == md_txidIndex.end()) return (CMPMetaDEx*) NULL;
+
+    return &(*it->second.trade);
 }
@@ -3,6 +3,7 @@
 
 #include "exodus/tx.h"
 
+#include "serialize.h"
 #include "uint256.h"
 
 #include <boost/lexical_cast.hpp>
@@ -10,11 +11,8 @@
 #include <boost/multiprecision/cpp_int.hpp>
 #include <boost/rational.hpp>
 
-#include <openssl/sha.h>
-
 #include <stdint.h>
 
-#include <fstream>
 #include <map>
 #include <set>
 #include <string>
@@ -32,6 +30,56 @@ typedef boost::rational<boost::multiprecision::checked_int128_t> rational_t;
 /** Converts price to string. */
 std::string xToString(const rational_t& value);
 
+/** A unit price of the order book, the fraction of two non-negative amounts.
+ *
+ * The fraction is not reduced. Prices are ordered by cross-multiplying the
+ * plain 64 bit integers, which avoids the multiprecision arithmetic of
+ * rational_t on every comparison within the order book.
+ */
+class CMPMetaDExPrice
+{
+private:
+    uint64_t numerator;
+    uint64_t denominator;
+
+    //! Compares numerator * other.denominator with other.numerator * denominator
+    int Compare(const CMPMetaDExPrice& other) const
+    {
+        uint64_t lhsHigh, lhsLow, rhsHigh, rhsLow;
+        Multiply(numerator, other.denominator, lhsHigh, lhsLow);
+        Multiply(other.numerator, denominator, rhsHigh, rhsLow);
+        if (lhsHigh != rhsHigh) return lhsHigh < rhsHigh ? -1 : 1;
+        if (lhsLow != rhsLow) return lhsLow < rhsLow ? -1 : 1;
+        return 0;
+    }
+
+    //! Calculates the full 128 bit product of two 64 bit integers
+    static void Multiply(uint64_t a, uint64_t b, uint64_t& high, uint64_t& low)
+    {
+        const uint64_t aLow = a & 0xffffffff, aHigh = a >> 32;
+        const uint64_t bLow = b & 0xffffffff, bHigh = b >> 32;
+        const uint64_t lowLow = aLow * bLow;
+        const uint64_t lowHigh = aLow * bHigh;
+        const uint64_t highLow = aHigh * bLow;
+        const uint64_t middle = (lowLow >> 32) + (lowHigh & 0xffffffff) + (highLow & 0xffffffff);
+        low = (middle << 32) | (lowLow & 0xffffffff);
+        high = aHigh * bHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+    }
+
+public:
+    /** Creates the price num / denom, where a zero denominator results in a price of zero. */
+    CMPMetaDExPrice(int64_t num, int64_t denom);
+
+    rational_t ToRational() const;
+
+    bool operator<(const CMPMetaDExPrice& other) const { return Compare(other) < 0; }
+    bool operator>(const CMPMetaDExPrice& other) const { return Compare(other) > 0; }
+    bool operator<=(const CMPMetaDExPrice& other) const { return Compare(other) <= 0; }
+    bool operator>=(const CMPMetaDExPrice& other) const { return Compare(other) >= 0; }
+    bool operator==(const CMPMetaDExPrice& other) const { return Compare(other) == 0; }
+    bool operator!=(const CMPMetaDExPrice& other) const { return Compare(other) != 0; }
+};
+
 /** A trade on the distributed exchange.
  */
 class CMPMetaDEx
@@ -94,12 +142,31 @@ public:
     rational_t unitPrice() const;
     rational_t inversePrice() const;
 
+    /** The unit price as key of the order book. */
+    CMPMetaDExPrice unitPriceKey() const { return CMPMetaDExPrice(amount_desired, amount_forsale); }
+    /** The inverse price as key of the order book. */
+    CMPMetaDExPrice inversePriceKey() const { return CMPMetaDExPrice(amount_forsale, amount_desired); }
+
     /** Used for display of unit prices to 8 decimal places at UI layer. */
     std::string displayUnitPrice() const;
     /** Used for display of unit prices with 50 decimal places at RPC layer. */
     std::string displayFullUnitPrice() const;
 
-    void saveOffer(std::ofstream& file, SHA256_CTX* shaCtx) const;
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(block);
+        READWRITE(txid);
+        READWRITE(idx);
+        READWRITE(property);
+        READWRITE(amount_forsale);
+        READWRITE(desired_property);
+        READWRITE(amount_desired);
+        READWRITE(amount_remaining);
+        READWRITE(subaction);
+        READWRITE(addr);
+    }
 };
 
 namespace exodus
@@ -113,16 +180,17 @@ struct MetaDEx_compare
 //! Set of objects sorted by block+idx
 typedef std::set<CMPMetaDEx, MetaDEx_compare> md_Set; 
 //! Map of prices; there is a set of sorted objects for each price
-typedef std::map<rational_t, md_Set> md_PricesMap;
+typedef std::map<CMPMetaDExPrice, md_Set> md_PricesMap;
 //! Map of properties; there is a map of prices for each property
 typedef std::map<uint32_t, md_PricesMap> md_PropertiesMap;
 
 //! Global map for price and order data
+//! Only modify it with the MetaDEx_ functions, which keep the indexes by txid and address in sync
 extern md_PropertiesMap metadex;
 
 // TODO: explore a property-pair, instead of a single property as map's key........
 md_PricesMap* get_Prices(uint32_t prop);
-md_Set* get_Indexes(md_PricesMap* p, rational_t price);
+md_Set* get_Indexes(md_PricesMap* p, const CMPMetaDExPrice& price);
 // ---------------
 
 int MetaDEx_ADD(const std::string& sender_addr, uint32_t, int64_t, int block, uint32_t property_desired, int64_t amount_desired, const uint256& txid, unsigned int idx);
@@ -132,6 +200,7 @@ int MetaDEx_CANCEL_EVERYTHING(const uint256& txid, uint32_t block, const std::st
 int MetaDEx_SHUTDOWN();
 int MetaDEx_SHUTDOWN_ALLPAIR();
 bool MetaDEx_INSERT(const CMPMetaDEx& objMetaDEx);
+void MetaDEx_CLEAR();
 void MetaDEx_debug_print(bool bShowPriceLevel = false, bool bDisplay = false);
 bool MetaDEx_isOpen(const uint256& txid, uint32_t propertyIdForSale = 0);
 int MetaDEx_getStatus(const uint256& txid, uint32_t propertyIdForSale, int64_t amountForSale, int64_t totalSold = -1);
@@ -0,0 +1,189 @@
+/**
+ * @file snapshot.cpp
+ *
+ * This file contains the binary format of the persisted Exodus state.
+ */
+
+#include "exodus/snapshot.h"
+
+#include "clientversion.h"
+#include "hash.h"
+#include "streams.h"
+#include "util.h"
+
+#include <boost/filesystem.hpp>
+
+#include <stdio.h>
+
+#include <algorithm>
+
+namespace exodus
+{
+bool CStateSnapshot::ApplyTo(SnapshotRecords& baseRecords) const
+{
+    if (IsBase()) return false;
+
+    for (std::set<SnapshotKey>::const_iterator it = erased.begin(); it != erased.end(); ++it) {
+        baseRecords.erase(*it);
+    }
+    for (SnapshotRecords::const_iterator it = records.begin(); it != records.end(); ++it) {
+        baseRecords[it->first] = it->second;
+    }
+
+    return true;
+}
+
+bool WriteStateSnapshot(const boost::filesystem::path& path, const CStateSnapshot& snapshot)
+{
+    CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+    ssSnapshot << snapshot;
+    uint256 checksum = Hash(ssSnapshot.begin(), ssSnapshot.end());
+    ssSnapshot << checksum;
+
+    // write to the temporary file first, so an interrupted write never leaves a truncated snapshot behind
+    boost::filesystem::path pathTmp = path;
+    pathTmp += ".tmp";
+
+    FILE* file = fopen(pathTmp.string().c_str(), "wb");
+    if (file == NULL) {
+        return error("%s: failed to open %s", __func__, pathTmp.string());
+    }
+    bool fWritten = fwrite(&ssSnapshot[0], 1, ssSnapshot.size(), file) == ssSnapshot.size();
+    fWritten = fflush(file) == 0 && fWritten;
+    fclose(file);
+
+    if (!fWritten) {
+        boost::filesystem::remove(pathTmp);
+        return error("%s: failed to write %s", __func__, pathTmp.string());
+    }
+
+    try {
+        boost::filesystem::rename(pathTmp, path);
+    } catch (const boost::filesystem::filesystem_error& e) {
+        return error("%s: %s", __func__, e.what());
+    }
+
+    return true;
+}
+
+bool ReadStateSnapshot(const boost::filesystem::path& path, CStateSnapshot& snapshot)
+{
+    FILE* file = fopen(path.string().c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    std::vector<char> vch;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long nSize = ftell(file);
+        if (nSize > 0) {
+            vch.resize(nSize);
+            rewind(file);
+            if (fread(vch.data(), 1, vch.size(), file) != vch.size()) {
+                vch.clear();
+            }
+        }
+    }
+    fclose(file);
+
+    if (vch.size() < sizeof(uint256)) {
+        return error("%s: failed to read %s", __func__, path.string());
+    }
+
+    uint256 checksum;
+    std::copy(vch.end() - sizeof(uint256), vch.end(), checksum.begin());
+    vch.resize(vch.size() - sizeof(uint256));
+    if (Hash(vch.begin(), vch.end()) != checksum) {
+        return error("%s: checksum mismatch in %s", __func__, path.string());
+    }
+
+    try {
+        CDataStream ssSnapshot(vch, SER_DISK, CLIENT_VERSION);
+        ssSnapshot >> snapshot;
+    } catch (const std::exception& e) {
+        return error("%s: deserialize error in %s: %s", __func__, path.string(), e.what());
+    }
+
+    return true;
+}
+
+bool ReadStateSnapshotBase(const boost::filesystem::path& path, uint256& baseHash)
+{
+    CAutoFile file(fopen(path.string().c_str(), "rb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        return false;
+    }
+
+    try {
+        int32_t nVersion, nHeight;
+        uint256 blockHash;
+        file >> nVersion;
+        if (nVersion != CStateSnapshot::CURRENT_VERSION) {
+            return false;
+        }
+        file >> blockHash >> nHeight >> baseHash;
+    } catch (const std::exception& e) {
+        return false;
+    }
+
+    return true;
+}
+
+static uint256 GetRecordDigest(const std::vector<unsigned char>& vch)
+{
+    return Hash(vch.begin(), vch.end());
+}
+
+void CStateSnapshotBuilder::Build(const uint256& blockHash, int nHeight, const uint256& baseHashAtHeight,
+        SnapshotRecords& records, const uint256& consensusCommitment, CStateSnapshot& snapshot)
+{
+    snapshot = CStateSnapshot();
+    snapshot.blockHash = blockHash;
+    snapshot.nHeight = nHeight;
+    snapshot.consensusCommitment = consensusCommitment;
+
+    bool fNewBase = baseHash.IsNull() || nDeltas >= SNAPSHOT_DELTAS_PER_BASE || nHeight <= nBaseHeight
+            || baseHash != baseHashAtHeight;
+
+    if (fNewBase) {
+        baseHash = blockHash;
+        nBaseHeight = nHeight;
+        nDeltas = 0;
+        baseDigests.clear();
+        for (SnapshotRecords::const_iterator it = records.begin(); it != records.end(); ++it) {
+            baseDigests.insert(baseDigests.end(), std::make_pair(it->first, GetRecordDigest(it->second)));
+        }
+        snapshot.records.swap(records);
+        return;
+    }
+
+    snapshot.baseHash = baseHash;
+    ++nDeltas;
+
+    // both maps are ordered by key, so they are merged in one pass
+    std::map<SnapshotKey, uint256>::const_iterator itBase = baseDigests.begin();
+    for (SnapshotRecords::iterator it = records.begin(); it != records.end(); ++it) {
+        while (itBase != baseDigests.end() && itBase->first < it->first) {
+            snapshot.erased.insert(snapshot.erased.end(), itBase->first);
+            ++itBase;
+        }
+        if (itBase != baseDigests.end() && itBase->first == it->first) {
+            bool fChanged = itBase->second != GetRecordDigest(it->second);
+            ++itBase;
+            if (!fChanged) continue;
+        }
+        snapshot.records[it->first].swap(it->second);
+    }
+    for (; itBase != baseDigests.end(); ++itBase) {
+        snapshot.erased.insert(snapshot.erased.end(), itBase->first);
+    }
+}
+
+void CStateSnapshotBuilder::Reset()
+{
+    baseHash.SetNull();
+    nBaseHeight = -1;
+    nDeltas = 0;
+    baseDigests.clear();
+}
+}
@@ -0,0 +1,106 @@
+#ifndef EXODUS_SNAPSHOT_H
+#define EXODUS_SNAPSHOT_H
+
+#include "serialize.h"
+#include "uint256.h"
+
+#include <boost/filesystem/path.hpp>
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace exodus
+{
+//! Maximal number of delta snapshots written after a base snapshot
+int const SNAPSHOT_DELTAS_PER_BASE = 100;
+
+//! Record identifier: record type (one of the FILETYPE_* values) and key, unique within the type
+typedef std::pair<uint8_t, std::string> SnapshotKey;
+//! Serialized state records
+typedef std::map<SnapshotKey, std::vector<unsigned char> > SnapshotRecords;
+
+/** Binary snapshot of the state after a block.
+ *
+ * A base snapshot holds all the records, a delta snapshot holds the records which were added
+ * or changed since the base snapshot, and the keys of the erased ones. The consensus commitment
+ * of the state is stored to verify the state restored from the snapshot.
+ */
+class CStateSnapshot
+{
+public:
+    static const int32_t CURRENT_VERSION = 2;
+
+    int32_t nVersion;
+    uint256 blockHash;
+    int32_t nHeight;
+    //! Block hash of the base snapshot, null for base snapshots
+    uint256 baseHash;
+    uint256 consensusCommitment;
+    SnapshotRecords records;
+    std::set<SnapshotKey> erased;
+
+    CStateSnapshot() : nVersion(CURRENT_VERSION), nHeight(0) {}
+
+    bool IsBase() const { return baseHash.IsNull(); }
+
+    /** Applies the delta snapshot to the records of its base snapshot. */
+    bool ApplyTo(SnapshotRecords& baseRecords) const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersionIn) {
+        READWRITE(nVersion);
+        if (nVersion != CURRENT_VERSION) {
+            throw std::ios_base::failure("unknown snapshot version");
+        }
+        READWRITE(blockHash);
+        READWRITE(nHeight);
+        READWRITE(baseHash);
+        READWRITE(consensusCommitment);
+        READWRITE(records);
+        READWRITE(erased);
+    }
+};
+
+/** Writes the snapshot followed by the checksum of its content. */
+bool WriteStateSnapshot(const boost::filesystem::path& path, const CStateSnapshot& snapshot);
+/** Reads the snapshot in one go and verifies its checksum. */
+bool ReadStateSnapshot(const boost::filesystem::path& path, CStateSnapshot& snapshot);
+/** Reads the block hash of the base snapshot from the header of the snapshot, the checksum is not verified. */
+bool ReadStateSnapshotBase(const boost::filesystem::path& path, uint256& baseHash);
+
+/** Produces base and delta snapshots from the full sets of state records.
+ *
+ * Only the digests of the records of the last base snapshot are kept in memory.
+ */
+class CStateSnapshotBuilder
+{
+private:
+    uint256 baseHash;
+    int nBaseHeight;
+    int nDeltas;
+    std::map<SnapshotKey, uint256> baseDigests;
+
+public:
+    CStateSnapshotBuilder() : nBaseHeight(-1), nDeltas(0) {}
+
+    /**
+     * Creates the snapshot of the records after the block. A new base snapshot is started when
+     * there is no base yet, after SNAPSHOT_DELTAS_PER_BASE deltas, or if the block of the base is
+     * not the ancestor of the block at its height (baseHashAtHeight).
+     */
+    void Build(const uint256& blockHash, int nHeight, const uint256& baseHashAtHeight,
+            SnapshotRecords& records, const uint256& consensusCommitment, CStateSnapshot& snapshot);
+
+    int GetBaseHeight() const { return nBaseHeight; }
+
+    void Reset();
+};
+}
+
+#endif // EXODUS_SNAPSHOT_H
@@ -40,17 +40,15 @@ OwnerAddrType STO_GetReceivers(const std::string& sender, uint32_t property, int
 
     {
         LOCK(cs_tally);
-        std::unordered_map<std::string, CMPTally>::iterator it;
+        // Only the holders of the property are visited
+        static const CMPTallyIndex::HolderMap noHolders;
+        const CMPTallyIndex::HolderMap* holders = mp_tally_index.getHolders(property);
+        if (holders == NULL) holders = &noHolders;
 
-        for (it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+        CMPTallyIndex::HolderMap::const_iterator it;
+        for (it = holders->begin(); it != holders->end(); ++it) {
             const std::string& address = it->first;
-            const CMPTally& tally = it->second;
-
-            int64_t tokens = 0;
-            tokens += tally.getMoney(property, BALANCE);
-            tokens += tally.getMoney(property, SELLOFFER_RESERVE);
-            tokens += tally.getMoney(property, ACCEPT_RESERVE);
-            tokens += tally.getMoney(property, METADEX_RESERVE);
+            int64_t tokens = it->second;
 
             // Do not include the sender
             if (address == sender) {
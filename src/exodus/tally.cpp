@@ -4,14 +4,55 @@
 #include "exodus/exodus.h"
 
 #include <stdint.h>
-#include <map>
+#include <algorithm>
+#include <limits>
 
 /**
  * Creates an empty tally.
  */
-CMPTally::CMPTally()
+CMPTally::CMPTally() : nNext(0)
 {
-    my_it = mp_token.begin();
+}
+
+//! Orders balance records by property identifier
+static bool ComparePropertyId(const std::pair<uint32_t, CMPTally::BalanceRecord>& record, uint32_t propertyId)
+{
+    return record.first < propertyId;
+}
+
+/**
+ * Returns the balance record of the token.
+ *
+ * @param propertyId  The identifier of the tally to lookup
+ * @return The balance record, or NULL, if there is none
+ */
+const CMPTally::BalanceRecord* CMPTally::findRecord(uint32_t propertyId) const
+{
+    TokenMap::const_iterator it = std::lower_bound(mp_token.begin(), mp_token.end(), propertyId, ComparePropertyId);
+    if (it == mp_token.end() || it->first != propertyId) {
+        return NULL;
+    }
+
+    return &it->second;
+}
+
+/**
+ * Returns the balance record of the token, an empty one is inserted if there is none.
+ *
+ * @param propertyId  The identifier of the tally to lookup
+ * @return The balance record
+ */
+CMPTally::BalanceRecord& CMPTally::getRecord(uint32_t propertyId)
+{
+    TokenMap::iterator it = std::lower_bound(mp_token.begin(), mp_token.end(), propertyId, ComparePropertyId);
+    if (it == mp_token.end() || it->first != propertyId) {
+        BalanceRecord record = {};
+        // keep the internal iterator on the same record
+        if (nNext > (size_t)(it - mp_token.begin())) ++nNext;
+        it = mp_token.insert(it, std::make_pair(propertyId, record));
+    }
+
+    return it->second;
 }
 
 /**
@@ -22,9 +63,9 @@ CMPTally::CMPTally()
 uint32_t CMPTally::init()
 {
     uint32_t propertyId = 0;
-    my_it = mp_token.begin();
-    if (my_it != mp_token.end()) {
-        propertyId = my_it->first;
+    nNext = 0;
+    if (nNext < mp_token.size()) {
+        propertyId = mp_token[nNext].first;
     }
     return propertyId;
 }
@@ -37,9 +78,9 @@ uint32_t CMPTally::init()
 uint32_t CMPTally::next()
 {
     uint32_t ret = 0;
-    if (my_it != mp_token.end()) {
-        ret = my_it->first;
-        ++my_it;
+    if (nNext < mp_token.size()) {
+        ret = mp_token[nNext].first;
+        ++nNext;
     }
     return ret;
 }
@@ -73,7 +114,8 @@ bool CMPTally::updateMoney(uint32_t propertyId, int64_t amount, TallyType ttype)
         return false;
     }
     bool fUpdated = false;
-    int64_t now64 = mp_token[propertyId].balance[ttype];
+    BalanceRecord& record = getRecord(propertyId);
+    int64_t now64 = record.balance[ttype];
 
     if (isOverflow(now64, amount)) {
         PrintToLog("%s(): ERROR: arithmetic overflow [%d + %d]\n", __func__, now64, amount);
@@ -86,7 +128,7 @@ bool CMPTally::updateMoney(uint32_t propertyId, int64_t amount, TallyType ttype)
     } else {
 
         now64 += amount;
-        mp_token[propertyId].balance[ttype] = now64;
+        record.balance[ttype] = now64;
 
         fUpdated = true;
     }
@@ -107,11 +149,10 @@ int64_t CMPTally::getMoney(uint32_t propertyId, TallyType ttype) const
         return 0;
     }
     int64_t money = 0;
-    TokenMap::const_iterator it = mp_token.find(propertyId);
+    const BalanceRecord* record = findRecord(propertyId);
 
-    if (it != mp_token.end()) {
-        const BalanceRecord& record = it->second;
-        money = record.balance[ttype];
+    if (record) {
+        money = record->balance[ttype];
     }
 
     return money;
@@ -128,14 +169,13 @@ int64_t CMPTally::getMoney(uint32_t propertyId, TallyType ttype) const
  */
 int64_t CMPTally::getMoneyAvailable(uint32_t propertyId) const
 {
-    TokenMap::const_iterator it = mp_token.find(propertyId);
+    const BalanceRecord* record = findRecord(propertyId);
 
-    if (it != mp_token.end()) {
-        const BalanceRecord& record = it->second;
-        if (record.balance[PENDING] < 0) {
-            return record.balance[BALANCE] + record.balance[PENDING];
+    if (record) {
+        if (record->balance[PENDING] < 0) {
+            return record->balance[BALANCE] + record->balance[PENDING];
         } else {
-            return record.balance[BALANCE];
+            return record->balance[BALANCE];
         }
     }
 
@@ -154,13 +194,12 @@ int64_t CMPTally::getMoneyAvailable(uint32_t propertyId) const
 int64_t CMPTally::getMoneyReserved(uint32_t propertyId) const
 {
     int64_t money = 0;
-    TokenMap::const_iterator it = mp_token.find(propertyId);
+    const BalanceRecord* record = findRecord(propertyId);
 
-    if (it != mp_token.end()) {
-        const BalanceRecord& record = it->second;
-        money += record.balance[SELLOFFER_RESERVE];
-        money += record.balance[ACCEPT_RESERVE];
-        money += record.balance[METADEX_RESERVE];
+    if (record) {
+        money += record->balance[SELLOFFER_RESERVE];
+        money += record->balance[ACCEPT_RESERVE];
+        money += record->balance[METADEX_RESERVE];
     }
 
     return money;
@@ -228,15 +267,14 @@ int64_t CMPTally::print(uint32_t propertyId, bool bDivisible) const
     int64_t pending = 0;
     int64_t metadex_reserve = 0;
 
-    TokenMap::const_iterator it = mp_token.find(propertyId);
+    const BalanceRecord* record = findRecord(propertyId);
 
-    if (it != mp_token.end()) {
-        const BalanceRecord& record = it->second;
-        balance = record.balance[BALANCE];
-        selloffer_reserve = record.balance[SELLOFFER_RESERVE];
-        accept_reserve = record.balance[ACCEPT_RESERVE];
-        pending = record.balance[PENDING];
-        metadex_reserve = record.balance[METADEX_RESERVE];
+    if (record) {
+        balance = record->balance[BALANCE];
+        selloffer_reserve = record->balance[SELLOFFER_RESERVE];
+        accept_reserve = record->balance[ACCEPT_RESERVE];
+        pending = record->balance[PENDING];
+        metadex_reserve = record->balance[METADEX_RESERVE];
     }
 
     if (bDivisible) {
@@ -251,3 +289,74 @@ int64_t CMPTally::print(uint32_t propertyId, bool bDivisible) const
 
     return (balance + selloffer_reserve + accept_reserve + metadex_reserve);
 }
+
+/**
+ * Records the change of the amount held by the address.
+ *
+ * @param address     The address of the holder
+ * @param propertyId  The identifier of the property
+ * @param amount      The change of the amount held
+ */
+void CMPTallyIndex::update(const std::string& address, uint32_t propertyId, int64_t amount)
+{
+    if (0 == amount) return;
+
+    PropertyHolders& property = properties[propertyId];
+    property.total += amount;
+
+    HolderMap::iterator it = property.holders.insert(std::make_pair(address, 0)).first;
+    it->second += amount;
+    if (0 == it->second) {
+        property.holders.erase(it);
+        if (property.holders.empty()) {
+            properties.erase(propertyId);
+        }
+    }
+}
+
+/**
+ * Returns the holders of the property.
+ *
+ * @param propertyId  The identifier of the property
+ * @return The map of holders and their amounts, or NULL, if there are no holders
+ */
+const CMPTallyIndex::HolderMap* CMPTallyIndex::getHolders(uint32_t propertyId) const
+{
+    std::unordered_map<uint32_t, PropertyHolders>::const_iterator it = properties.find(propertyId);
+    if (it == properties.end()) {
+        return NULL;
+    }
+
+    return &it->second.holders;
+}
+
+/**
+ * Returns the total amount held by all holders of the property.
+ */
+int64_t CMPTallyIndex::getTotal(uint32_t propertyId) const
+{
+    std::unordered_map<uint32_t, PropertyHolders>::const_iterator it = properties.find(propertyId);
+    if (it == properties.end()) {
+        return 0;
+    }
+
+    return it->second.total;
+}
+
+/**
+ * Returns the number of holders of the property.
+ */
+size_t CMPTallyIndex::getHolderCount(uint32_t propertyId) const
+{
+    const HolderMap* holders = getHolders(propertyId);
+
+    return holders ? holders->size() : 0;
+}
+
+/**
+ * Removes all entries.
+ */
+void CMPTallyIndex::clear()
+{
+    properties.clear();
+}
@@ -1,8 +1,12 @@
 #ifndef EXODUS_TALLY_H
 #define EXODUS_TALLY_H
 
+#include <stddef.h>
 #include <stdint.h>
-#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 //! Balance record types
 enum TallyType {
@@ -15,20 +19,34 @@ enum TallyType {
 };
 
 /** Balance records of a single entity.
+ *
+ * The balance records are stored in a flat vector, sorted by property identifier, as most
+ * entities only hold a few different tokens. Readers should prefer the const iterators over
+ * the internal iterator, which modifies the tally.
  */
 class CMPTally
 {
-private:
-    typedef struct {
+public:
+    //! Balances of a single token, indexed by tally type
+    struct BalanceRecord {
         int64_t balance[TALLY_TYPE_COUNT];
-    } BalanceRecord;
+    };
+
+    //! Balance records for different tokens, sorted by property identifier
+    typedef std::vector<std::pair<uint32_t, BalanceRecord> > TokenMap;
+    typedef TokenMap::const_iterator const_iterator;
 
-    //! Map of balance records
-    typedef std::map<uint32_t, BalanceRecord> TokenMap;
+private:
     //! Balance records for different tokens
     TokenMap mp_token;
-    //! Internal iterator pointing to a balance record
-    TokenMap::iterator my_it;
+    //! Position of the internal iterator
+    size_t nNext;
+
+    /** Returns the balance record of the token, or NULL, if there is none. */
+    const BalanceRecord* findRecord(uint32_t propertyId) const;
+
+    /** Returns the balance record of the token, an empty one is inserted if there is none. */
+    BalanceRecord& getRecord(uint32_t propertyId);
 
 public:
     /** Creates an empty tally. */
@@ -40,6 +58,12 @@ public:
     /** Advances the internal iterator. */
     uint32_t next();
 
+    /** Returns an iterator to the first balance record. */
+    const_iterator begin() const { return mp_token.begin(); }
+
+    /** Returns an iterator past the last balance record. */
+    const_iterator end() const { return mp_token.end(); }
+
     /** Updates the number of tokens for the given tally type. */
     bool updateMoney(uint32_t propertyId, int64_t amount, TallyType ttype);
 
@@ -62,5 +86,42 @@ public:
     int64_t print(uint32_t propertyId = 1, bool bDivisible = true) const;
 };
 
+/** Index of the holders of each property.
+ *
+ * For every property the amount held by each holder (balance and reserves, without
+ * pending amounts) and the total amount are maintained. Holders without tokens are
+ * not included.
+ */
+class CMPTallyIndex
+{
+public:
+    typedef std::unordered_map<std::string, int64_t> HolderMap;
+
+private:
+    struct PropertyHolders {
+        PropertyHolders() : total(0) {}
+
+        int64_t total;
+        HolderMap holders;
+    };
+
+    std::unordered_map<uint32_t, PropertyHolders> properties;
+
+public:
+    /** Records the change of the amount held by the address. */
+    void update(const std::string& address, uint32_t propertyId, int64_t amount);
+
+    /** Returns the holders of the property, or NULL, if there are none. */
+    const HolderMap* getHolders(uint32_t propertyId) const;
+
+    /** Returns the total amount held by all holders of the property. */
+    int64_t getTotal(uint32_t propertyId) const;
+
+    /** Returns the number of holders of the property. */
+    size_t getHolderCount(uint32_t propertyId) const;
+
+    /** Removes all entries. */
+    void clear();
+};
 
 #endif // EXODUS_TALLY_H
@@ -0,0 +1,139 @@
+#include "exodus/consensusbalances.h"
+
+#include "test/test_bitcoin.h"
+#include "uint256.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <openssl/sha.h>
+
+#include <map>
+#include <string>
+
+using namespace exodus;
+
+static uint256 HashAll(const std::map<std::string, std::string>& balances)
+{
+    SHA256_CTX shaCtx;
+    SHA256_Init(&shaCtx);
+    for (std::map<std::string, std::string>::const_iterator it = balances.begin(); it != balances.end(); ++it) {
+        SHA256_Update(&shaCtx, it->second.data(), it->second.size());
+    }
+    uint256 hash;
+    SHA256_Final(hash.begin(), &shaCtx);
+    return hash;
+}
+
+static uint256 HashAll(const CConsensusBalances& balances)
+{
+    SHA256_CTX shaCtx;
+    SHA256_Init(&shaCtx);
+    balances.Write(&shaCtx);
+    uint256 hash;
+    SHA256_Final(hash.begin(), &shaCtx);
+    return hash;
+}
+
+BOOST_FIXTURE_TEST_SUITE(exodus_consensusbalances_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(consensus_balances_order)
+{
+    std::map<std::string, std::string> expected;
+    expected["aB"] = "aB|1|5|0|0|0";
+    expected["aBc1"] = "aBc1|1|6|0|0|0";
+    expected["aBc"] = "aBc|1|7|0|0|0";
+    expected["ZZZ"] = "ZZZ|3|1|0|0|0";
+    expected["aBd"] = "aBd|1|1|0|0|0aBd|2|1|0|0|0";
+
+    CConsensusBalances balances;
+    for (std::map<std::string, std::string>::const_reverse_iterator it = expected.rbegin(); it != expected.rend(); ++it) {
+        balances.Set(it->first, it->second);
+    }
+    BOOST_CHECK_EQUAL(balances.size(), expected.size());
+
+    std::map<std::string, std::string> visited;
+    std::string last;
+    balances.ForEach([&](const std::string& address, const std::string& data) {
+        BOOST_CHECK(last < address);
+        last = address;
+        visited[address] = data;
+    });
+    BOOST_CHECK(visited == expected);
+    BOOST_CHECK(HashAll(balances) == HashAll(expected));
+
+    // empty strings remove the address
+    balances.Set("aBc", "");
+    balances.Set("unknown", "");
+    expected.erase("aBc");
+    BOOST_CHECK_EQUAL(balances.size(), expected.size());
+    BOOST_CHECK(HashAll(balances) == HashAll(expected));
+}
+
+BOOST_AUTO_TEST_CASE(consensus_balances_root)
+{
+    CConsensusBalances balances;
+    uint256 emptyRoot = balances.GetRoot();
+
+    balances.Set("aaa1", "aaa1|1|1|0|0|0");
+    balances.Set("bbb1", "bbb1|1|1|0|0|0");
+    uint256 root = balances.GetRoot();
+    BOOST_CHECK(root != emptyRoot);
+    BOOST_CHECK(balances.GetRoot() == root);
+
+    // unchanged data keeps the root
+    balances.Set("aaa1", "aaa1|1|1|0|0|0");
+    BOOST_CHECK(balances.GetRoot() == root);
+
+    balances.Set("aaa2", "aaa2|1|1|0|0|0");
+    uint256 changedRoot = balances.GetRoot();
+    BOOST_CHECK(changedRoot != root);
+
+    // the root only depends on the content
+    CConsensusBalances other;
+    other.Set("bbb1", "bbb1|1|1|0|0|0");
+    other.Set("aaa2", "aaa2|1|1|0|0|0");
+    other.Set("aaa1", "aaa1|1|1|0|0|0");
+    BOOST_CHECK(other.GetRoot() == changedRoot);
+
+    balances.Set("aaa2", "");
+    BOOST_CHECK(balances.GetRoot() == root);
+
+    balances.Clear();
+    BOOST_CHECK_EQUAL(balances.size(), 0);
+    BOOST_CHECK(balances.GetRoot() == emptyRoot);
+}
+
+BOOST_AUTO_TEST_CASE(consensus_balances_refresh)
+{
+    std::map<std::string, std::string> state;
+    state["aaa1"] = "aaa1|1|1|0|0|0";
+    state["bbb1"] = "bbb1|1|1|0|0|0";
+
+    CConsensusBalances balances;
+    balances.MarkChanged("aaa1");
+    balances.MarkChanged("bbb1");
+    BOOST_CHECK(balances.HasChanges());
+
+    int nCalls = 0;
+    auto getBalanceString = [&](const std::string& address) {
+        ++nCalls;
+        std::map<std::string, std::string>::const_iterator it = state.find(address);
+        return it != state.end() ? it->second : std::string();
+    };
+
+    balances.Refresh(getBalanceString);
+    BOOST_CHECK(!balances.HasChanges());
+    BOOST_CHECK_EQUAL(nCalls, 2);
+    BOOST_CHECK(HashAll(balances) == HashAll(state));
+
+    // only the changed addresses are refreshed
+    state.erase("aaa1");
+    balances.MarkChanged("aaa1");
+    balances.MarkChanged("aaa1");
+    balances.Refresh(getBalanceString);
+    BOOST_CHECK_EQUAL(nCalls, 3);
+    BOOST_CHECK_EQUAL(balances.size(), 1);
+    BOOST_CHECK(HashAll(balances) == HashAll(state));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
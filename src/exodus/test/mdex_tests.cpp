@@ -0,0 +1,90 @@
+#include "exodus/mdex.h"
+
+#include "test/test_bitcoin.h"
+#include "uint256.h"
+
+#include <stdint.h>
+
+#include <limits>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace exodus;
+
+BOOST_FIXTURE_TEST_SUITE(exodus_mdex_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(mdex_price_order)
+{
+    const int64_t nMax = std::numeric_limits<int64_t>::max();
+
+    BOOST_CHECK(CMPMetaDExPrice(1, 2) == CMPMetaDExPrice(2, 4));
+    BOOST_CHECK(CMPMetaDExPrice(1, 3) < CMPMetaDExPrice(1, 2));
+    BOOST_CHECK(CMPMetaDExPrice(3, 2) > CMPMetaDExPrice(1, 1));
+    BOOST_CHECK(CMPMetaDExPrice(0, 5) == CMPMetaDExPrice(0, 1));
+    BOOST_CHECK(CMPMetaDExPrice(0, 1) < CMPMetaDExPrice(1, nMax));
+
+    // a zero denominator results in a price of zero
+    BOOST_CHECK(CMPMetaDExPrice(7, 0) == CMPMetaDExPrice(0, 1));
+
+    // products exceed 64 bit
+    BOOST_CHECK(CMPMetaDExPrice(nMax, nMax - 1) < CMPMetaDExPrice(nMax - 1, nMax - 2));
+    BOOST_CHECK(CMPMetaDExPrice(nMax - 1, nMax) < CMPMetaDExPrice(nMax, nMax));
+    BOOST_CHECK(CMPMetaDExPrice(nMax, 3) > CMPMetaDExPrice(nMax - 1, 3));
+    BOOST_CHECK(CMPMetaDExPrice(nMax, nMax) == CMPMetaDExPrice(1, 1));
+
+    // same order as rational_t
+    const int64_t values[] = {1, 2, 3, 7, 1000, 4294967295LL, 4294967296LL, 4294967297LL, nMax / 3, nMax - 1, nMax};
+    for (size_t a = 0; a < sizeof(values) / sizeof(values[0]); a++) {
+        for (size_t b = 0; b < sizeof(values) / sizeof(values[0]); b++) {
+            for (size_t c = 0; c < sizeof(values) / sizeof(values[0]); c++) {
+                for (size_t d = 0; d < sizeof(values) / sizeof(values[0]); d++) {
+                    CMPMetaDExPrice lhs(values[a], values[b]);
+                    CMPMetaDExPrice rhs(values[c], values[d]);
+                    rational_t lhsRational(values[a], values[b]);
+                    rational_t rhsRational(values[c], values[d]);
+                    BOOST_CHECK_EQUAL(lhs < rhs, lhsRational < rhsRational);
+                    BOOST_CHECK_EQUAL(lhs == rhs, lhsRational == rhsRational);
+                    BOOST_CHECK(lhs.ToRational() == lhsRational);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mdex_insert_lookup)
+{
+    MetaDEx_CLEAR();
+
+    CMPMetaDEx first("aAddress1", 100, 3, 10, 1, 20, uint256S("1"), 1, CMPTransaction::ADD);
+    CMPMetaDEx second("aAddress2", 101, 3, 5, 1, 10, uint256S("2"), 1, CMPTransaction::ADD);
+    CMPMetaDEx third("aAddress1", 101, 4, 5, 1, 5, uint256S("3"), 2, CMPTransaction::ADD);
+
+    BOOST_CHECK(MetaDEx_INSERT(first));
+    BOOST_CHECK(MetaDEx_INSERT(second));
+    BOOST_CHECK(MetaDEx_INSERT(third));
+    BOOST_CHECK(!MetaDEx_INSERT(first));
+
+    // equal prices share the price level
+    BOOST_CHECK_EQUAL(metadex.size(), 2);
+    BOOST_CHECK_EQUAL(get_Prices(3)->size(), 1);
+    BOOST_CHECK_EQUAL(get_Indexes(get_Prices(3), CMPMetaDExPrice(2, 1))->size(), 2);
+    BOOST_CHECK(get_Indexes(get_Prices(3), CMPMetaDExPrice(1, 1)) == NULL);
+
+    BOOST_CHECK(MetaDEx_isOpen(uint256S("2")));
+    BOOST_CHECK(MetaDEx_isOpen(uint256S("2"), 3));
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("2"), 4));
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("4")));
+
+    const CMPMetaDEx* pTrade = MetaDEx_RetrieveTrade(uint256S("3"));
+    BOOST_CHECK(pTrade != NULL);
+    BOOST_CHECK_EQUAL(pTrade->getAddr(), "aAddress1");
+    BOOST_CHECK_EQUAL(pTrade->getProperty(), 4);
+    BOOST_CHECK(MetaDEx_RetrieveTrade(uint256S("4")) == NULL);
+
+    MetaDEx_CLEAR();
+    BOOST_CHECK(metadex.empty());
+    BOOST_CHECK(!MetaDEx_isOpen(uint256S("1")));
+    BOOST_CHECK(MetaDEx_RetrieveTrade(uint256S("3")) == NULL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
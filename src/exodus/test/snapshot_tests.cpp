@@ -0,0 +1,150 @@
+#include "exodus/snapshot.h"
+
+#include "exodus/dex.h"
+#include "exodus/exodus.h"
+
+#include "arith_uint256.h"
+#include "clientversion.h"
+#include "streams.h"
+#include "test/test_bitcoin.h"
+#include "uint256.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <stdio.h>
+
+using namespace exodus;
+
+static std::vector<unsigned char> Value(const std::string& str)
+{
+    return std::vector<unsigned char>(str.begin(), str.end());
+}
+
+BOOST_FIXTURE_TEST_SUITE(exodus_snapshot_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(snapshot_delta)
+{
+    CStateSnapshotBuilder builder;
+
+    SnapshotRecords records;
+    records[SnapshotKey(FILETYPE_BALANCES, "a")] = Value("1");
+    records[SnapshotKey(FILETYPE_BALANCES, "b")] = Value("2");
+    records[SnapshotKey(FILETYPE_OFFERS, "a-1")] = Value("3");
+    SnapshotRecords baseRecords = records;
+
+    uint256 hash1 = uint256S("1"), hash2 = uint256S("2"), hash3 = uint256S("3");
+
+    CStateSnapshot base;
+    builder.Build(hash1, 10, uint256(), records, uint256S("aa"), base);
+    BOOST_CHECK(base.IsBase());
+    BOOST_CHECK(base.records == baseRecords);
+    BOOST_CHECK(base.consensusCommitment == uint256S("aa"));
+    BOOST_CHECK_EQUAL(builder.GetBaseHeight(), 10);
+
+    // b is changed, a-1 is erased, c is added
+    records = baseRecords;
+    records[SnapshotKey(FILETYPE_BALANCES, "b")] = Value("4");
+    records.erase(SnapshotKey(FILETYPE_OFFERS, "a-1"));
+    records[SnapshotKey(FILETYPE_BALANCES, "c")] = Value("5");
+    SnapshotRecords expected = records;
+
+    CStateSnapshot delta;
+    builder.Build(hash2, 11, hash1, records, uint256S("bb"), delta);
+    BOOST_CHECK(!delta.IsBase());
+    BOOST_CHECK(delta.baseHash == hash1);
+    BOOST_CHECK_EQUAL(delta.records.size(), 2);
+    BOOST_CHECK_EQUAL(delta.erased.size(), 1);
+    BOOST_CHECK(delta.erased.count(SnapshotKey(FILETYPE_OFFERS, "a-1")));
+
+    SnapshotRecords restored = base.records;
+    BOOST_CHECK(delta.ApplyTo(restored));
+    BOOST_CHECK(restored == expected);
+
+    // the block of the base is not the ancestor anymore
+    records = expected;
+    CStateSnapshot rebased;
+    builder.Build(hash3, 11, hash2, records, uint256S("cc"), rebased);
+    BOOST_CHECK(rebased.IsBase());
+    BOOST_CHECK(rebased.records == expected);
+    BOOST_CHECK(!rebased.ApplyTo(restored));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_base_interval)
+{
+    CStateSnapshotBuilder builder;
+    SnapshotRecords records;
+    CStateSnapshot snapshot;
+
+    uint256 baseHash = uint256S("1");
+    builder.Build(baseHash, 0, uint256(), records, uint256(), snapshot);
+    BOOST_CHECK(snapshot.IsBase());
+
+    for (int i = 1; i <= SNAPSHOT_DELTAS_PER_BASE; ++i) {
+        builder.Build(ArithToUint256(arith_uint256(i + 1)), i, baseHash, records, uint256(), snapshot);
+        BOOST_CHECK(!snapshot.IsBase());
+    }
+
+    builder.Build(uint256S("ff"), SNAPSHOT_DELTAS_PER_BASE + 1, baseHash, records, uint256(), snapshot);
+    BOOST_CHECK(snapshot.IsBase());
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_file)
+{
+    boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+    CStateSnapshot snapshot;
+    snapshot.blockHash = uint256S("1");
+    snapshot.nHeight = 5;
+    snapshot.baseHash = uint256S("2");
+    snapshot.consensusCommitment = uint256S("3");
+    snapshot.records[SnapshotKey(FILETYPE_GLOBALS, "")] = Value("globals");
+    snapshot.erased.insert(SnapshotKey(FILETYPE_BALANCES, "a"));
+
+    BOOST_CHECK(WriteStateSnapshot(path, snapshot));
+
+    CStateSnapshot loaded;
+    BOOST_CHECK(ReadStateSnapshot(path, loaded));
+    BOOST_CHECK(loaded.blockHash == snapshot.blockHash);
+    BOOST_CHECK_EQUAL(loaded.nHeight, snapshot.nHeight);
+    BOOST_CHECK(loaded.baseHash == snapshot.baseHash);
+    BOOST_CHECK(loaded.consensusCommitment == snapshot.consensusCommitment);
+    BOOST_CHECK(loaded.records == snapshot.records);
+    BOOST_CHECK(loaded.erased == snapshot.erased);
+
+    uint256 baseHash;
+    BOOST_CHECK(ReadStateSnapshotBase(path, baseHash));
+    BOOST_CHECK(baseHash == snapshot.baseHash);
+
+    // corrupt the last byte of the content
+    FILE* file = fopen(path.string().c_str(), "r+b");
+    BOOST_CHECK(file != NULL);
+    fseek(file, -(long)sizeof(uint256) - 1, SEEK_END);
+    fputc(0xff, file);
+    fclose(file);
+    BOOST_CHECK(!ReadStateSnapshot(path, loaded));
+
+    boost::filesystem::remove(path);
+    BOOST_CHECK(!ReadStateSnapshot(path, loaded));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_accept_serialization)
+{
+    CMPAccept accept(100, 60, 10, 1, 5, 1000, 2000, uint256S("1"));
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << accept;
+    CMPAccept loaded;
+    ss >> loaded;
+
+    BOOST_CHECK_EQUAL(loaded.getAcceptAmount(), 100);
+    BOOST_CHECK_EQUAL(loaded.getAcceptAmountRemaining(), 60);
+    BOOST_CHECK_EQUAL(loaded.getAcceptBlock(), 10);
+    BOOST_CHECK_EQUAL(loaded.getBlockTimeLimit(), 1);
+    BOOST_CHECK_EQUAL(loaded.getProperty(), 5);
+    BOOST_CHECK_EQUAL(loaded.getOfferAmountOriginal(), 1000);
+    BOOST_CHECK_EQUAL(loaded.getXZCDesiredOriginal(), 2000);
+    BOOST_CHECK(loaded.getHash() == uint256S("1"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -172,6 +172,34 @@ BOOST_AUTO_TEST_CASE(tally_entry_order)
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(9), 10);
     BOOST_CHECK_EQUAL(tally.getMoneyAvailable(70), 1);
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(70), 0);
+
+    // const iteration yields the same order
+    const CMPTally& constTally = tally;
+    uint32_t expected[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 70};
+    size_t n = 0;
+    for (CMPTally::const_iterator it = constTally.begin(); it != constTally.end(); ++it, ++n) {
+        BOOST_CHECK(n < sizeof(expected) / sizeof(expected[0]));
+        BOOST_CHECK_EQUAL(it->first, expected[n]);
+        BOOST_CHECK_EQUAL(it->second.balance[BALANCE], constTally.getMoney(it->first, BALANCE));
+    }
+    BOOST_CHECK_EQUAL(n, 10);
+}
+
+BOOST_AUTO_TEST_CASE(tally_insert_while_iterating)
+{
+    CMPTally tally;
+    BOOST_CHECK(tally.updateMoney(5, 1, BALANCE));
+    BOOST_CHECK(tally.updateMoney(10, 1, BALANCE));
+
+    BOOST_CHECK_EQUAL(5, tally.init());
+    BOOST_CHECK_EQUAL(5, tally.next());
+
+    // records inserted in front of the internal iterator are skipped, the others are visited
+    BOOST_CHECK(tally.updateMoney(1, 1, BALANCE));
+    BOOST_CHECK(tally.updateMoney(7, 1, BALANCE));
+    BOOST_CHECK_EQUAL(7, tally.next());
+    BOOST_CHECK_EQUAL(10, tally.next());
+    BOOST_CHECK_EQUAL(0, tally.next());
 }
 
 BOOST_AUTO_TEST_CASE(tally_equality)
@@ -318,5 +346,36 @@ BOOST_AUTO_TEST_CASE(tally_overflow)
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(3), int64_t(9223372036854775807LL));
 }
 
+BOOST_AUTO_TEST_CASE(tally_index)
+{
+    CMPTallyIndex index;
+    BOOST_CHECK(index.getHolders(1) == NULL);
+    BOOST_CHECK_EQUAL(index.getTotal(1), 0);
+    BOOST_CHECK_EQUAL(index.getHolderCount(1), 0);
+
+    index.update("a", 1, 100);
+    index.update("b", 1, 50);
+    index.update("a", 2, 7);
+    index.update("a", 1, 25);
+    BOOST_CHECK_EQUAL(index.getTotal(1), 175);
+    BOOST_CHECK_EQUAL(index.getHolderCount(1), 2);
+    BOOST_CHECK_EQUAL(index.getHolders(1)->at("a"), 125);
+    BOOST_CHECK_EQUAL(index.getHolders(1)->at("b"), 50);
+    BOOST_CHECK_EQUAL(index.getTotal(2), 7);
+
+    // holders without tokens are removed
+    index.update("b", 1, -50);
+    BOOST_CHECK_EQUAL(index.getTotal(1), 125);
+    BOOST_CHECK_EQUAL(index.getHolderCount(1), 1);
+    BOOST_CHECK(index.getHolders(1)->count("b") == 0);
+
+    index.update("a", 2, -7);
+    BOOST_CHECK(index.getHolders(2) == NULL);
+    BOOST_CHECK_EQUAL(index.getTotal(2), 0);
+
+    index.clear();
+    BOOST_CHECK(index.getHolders(1) == NULL);
+    BOOST_CHECK_EQUAL(index.getTotal(1), 0);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+#include "exodus/exodus.h"
+
+#include "test/test_bitcoin.h"
+#include "uint256.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace exodus;
+
+BOOST_FIXTURE_TEST_SUITE(exodus_tradelist_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(tradelist_address_index)
+{
+    boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+    {
+        CMPTradeList tradeList(path, true);
+
+        tradeList.recordNewTrade(uint256S("3"), "aAddress1", 1, 3, 102, 1);
+        tradeList.recordNewTrade(uint256S("1"), "aAddress1", 1, 5, 100, 7);
+        tradeList.recordNewTrade(uint256S("2"), "aAddress2", 1, 3, 101, 2);
+        tradeList.recordNewTrade(uint256S("4"), "aAddress10", 4, 3, 100, 2);
+        tradeList.recordMatchedTrade(uint256S("3"), uint256S("2"), "aAddress1", "aAddress2", 1, 3, 10, 20, 102, 0);
+        BOOST_CHECK_EQUAL(tradeList.getMPTradeCountTotal(), 5);
+
+        // trades of the address, ordered by block
+        std::vector<uint256> trades;
+        tradeList.getTradesForAddress("aAddress1", trades);
+        BOOST_CHECK_EQUAL(trades.size(), 2);
+        BOOST_CHECK(trades[0] == uint256S("1"));
+        BOOST_CHECK(trades[1] == uint256S("3"));
+
+        trades.clear();
+        tradeList.getTradesForAddress("aAddress1", trades, 5);
+        BOOST_CHECK_EQUAL(trades.size(), 1);
+        BOOST_CHECK(trades[0] == uint256S("1"));
+
+        trades.clear();
+        tradeList.getTradesForAddress("aAddress", trades);
+        BOOST_CHECK(trades.empty());
+
+        // the trades of block 102 are removed, including the match
+        BOOST_CHECK_EQUAL(tradeList.deleteAboveBlock(102), 2);
+        BOOST_CHECK_EQUAL(tradeList.getMPTradeCountTotal(), 3);
+
+        trades.clear();
+        tradeList.getTradesForAddress("aAddress1", trades);
+        BOOST_CHECK_EQUAL(trades.size(), 1);
+        BOOST_CHECK(trades[0] == uint256S("1"));
+    }
+
+    {
+        // the index survives reopening
+        CMPTradeList tradeList(path, false);
+        BOOST_CHECK_EQUAL(tradeList.getMPTradeCountTotal(), 3);
+
+        std::vector<uint256> trades;
+        tradeList.getTradesForAddress("aAddress2", trades);
+        BOOST_CHECK_EQUAL(trades.size(), 1);
+        BOOST_CHECK(trades[0] == uint256S("2"));
+
+        tradeList.Clear();
+        BOOST_CHECK_EQUAL(tradeList.getMPTradeCountTotal(), 0);
+    }
+
+    boost::filesystem::remove_all(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
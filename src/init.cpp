@@ -17,6 +17,8 @@
 #include "checkpoints.h"
 #include "compat/sanity.h"
 #include "consensus/validation.h"
+#include "crypto/Lyra2Z/Lyra2.h"
+#include "executor.h"
 #include "exodus/exodus.h"
 #include "httpserver.h"
 #include "httprpc.h"
@@ -244,6 +246,7 @@ void Shutdown() {
 #endif
     GenerateBitcoins(false, 0, Params());
     StopNode();
+    GetExecutor().Stop();
 
     CFlatDB<CZnodeMan> flatdb1("zncache.dat", "magicZnodeCache");
     flatdb1.Dump(mnodeman);
@@ -406,6 +409,10 @@ std::string HelpMessage(HelpMessageMode mode) {
                       "Warning: Reverting this setting requires re-downloading the entire blockchain. "
                       "(default: 0 = disable pruning blocks, >%u = target size in MiB to use for block files)"),
             MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024));
+    strUsage += HelpMessageOpt("-prunemtpdata=<n>", strprintf(
+            _("Don't store MTP proof data of blocks which are at least <n> blocks deep when downloaded. Such blocks are not served to peers "
+                      "(default: %u = keep MTP data of all blocks, >=%u = depth in blocks)"),
+            DEFAULT_MTP_DATA_PRUNE_DEPTH, MIN_BLOCKS_TO_KEEP));
     strUsage += HelpMessageOpt("-reindex-chainstate", _("Rebuild chain state from the currently indexed blocks"));
     strUsage += HelpMessageOpt("-reindex", _("Rebuild chain state and block index from the blk*.dat files on disk"));
 #ifndef WIN32
@@ -585,6 +592,9 @@ std::string HelpMessage(HelpMessageMode mode) {
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>",
                                    strprintf("Limit size of signature cache to <n> MiB (default: %u)",
                                              DEFAULT_MAX_SIG_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxzerocoincachesize=<n>",
+                                   strprintf("Limit size of the cache of verified zerocoin mints and spends to <n> MiB (default: %u)",
+                                             DEFAULT_MAX_ZEROCOIN_CACHE_SIZE));
         strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf(
                 "Maximum tip age in seconds to consider node in initial block download (default: %u)",
                 DEFAULT_MAX_TIP_AGE));
@@ -1234,6 +1244,18 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
         fPruneMode = true;
     }
 
+    // Zcoin - MTP
+    nMTPDataPruneDepth = GetArg("-prunemtpdata", DEFAULT_MTP_DATA_PRUNE_DEPTH);
+    if (nMTPDataPruneDepth < 0) {
+        return InitError(_("MTP data pruning cannot be configured with a negative value."));
+    }
+    if (nMTPDataPruneDepth) {
+        if (nMTPDataPruneDepth < (int)MIN_BLOCKS_TO_KEEP) {
+            return InitError(strprintf(_("MTP data pruning configured below the minimum depth of %u blocks."), MIN_BLOCKS_TO_KEEP));
+        }
+        LogPrintf("MTP proof data of blocks at least %d blocks deep is not stored.\n", nMTPDataPruneDepth);
+    }
+
     RegisterAllCoreRPCCommands(tableRPC);
 #ifdef ENABLE_WALLET
     bool fDisableWallet = GetBoolArg("-disablewallet", false);
@@ -1378,11 +1400,13 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
     LogPrintf("Using at most %i connections (%i file descriptors available)\n", nMaxConnections, nFD);
     std::ostringstream strErrors;
 
-    LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
-    if (nScriptCheckThreads) {
-        for (int i = 0; i < nScriptCheckThreads - 1; i++)
-            threadGroup.create_thread(&ThreadScriptCheck);
-    }
+    LogPrintf("Using %u threads for script and zerocoin verification\n", nScriptCheckThreads);
+    // Thread connecting the block works as one of the verification threads
+    if (nScriptCheckThreads)
+        GetExecutor().Start(nScriptCheckThreads - 1);
+
+    if (lyra2_detect_avx2())
+        LogPrintf("Lyra2: using AVX2 sponge\n");
 
     // Start the lightweight task scheduler thread
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, &scheduler);
@@ -1830,6 +1854,10 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
     LogPrintf("Step 9: data directory maintenance **********************\n");
     // if pruning, unset the service bit and perform the initial blockstore prune
     // after any wallet rescanning has taken place.
+    if (nMTPDataPruneDepth && !fPruneMode) {
+        LogPrintf("Unsetting NODE_NETWORK on MTP data prune mode\n");
+        nLocalServices = ServiceFlags(nLocalServices & ~NODE_NETWORK);
+    }
     if (fPruneMode) {
         LogPrintf("Unsetting NODE_NETWORK on prune mode\n");
         nLocalServices = ServiceFlags(nLocalServices & ~NODE_NETWORK);
@@ -2054,6 +2082,13 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
 
         // Run a thread to flush wallet periodically
         threadGroup.create_thread(boost::bind(&ThreadFlushWalletDB, boost::ref(pwalletMain->strWalletFile)));
+
+        // Keep witnesses of the zerocoin mints up to date so spends don't have to recalculate them
+        scheduler.scheduleEvery(boost::bind(&CWallet::UpdateZerocoinWitnesses, pwalletMain), ZEROCOIN_WITNESS_UPDATE_INTERVAL);
+
+        // Pregenerate zerocoin mints so minting doesn't have to wait for them
+        if (GetArg("-zerocoinmintpool", DEFAULT_ZEROCOIN_MINT_POOL_SIZE) > 0)
+            threadGroup.create_thread(boost::bind(&ThreadZerocoinMintPool, pwalletMain));
     }
 #endif
 
@@ -15,6 +15,31 @@
 
 namespace libzerocoin {
 
+// Product of the values in [begin, end). Halves are multiplied recursively, so the
+// factors of every multiplication have similar sizes
+static Bignum ProductTree(const std::vector<Bignum>& values, size_t begin, size_t end) {
+	if (end - begin == 1)
+		return values[begin];
+	size_t middle = begin + (end - begin) / 2;
+	return ProductTree(values, begin, middle) * ProductTree(values, middle, end);
+}
+
+// Stores at position i of result the accumulator value raised to every value in
+// [begin, end) except values[i]
+static void AllButOne(const AccumulatorAndProofParams* params, const Bignum& value,
+                      const std::vector<Bignum>& values, size_t begin, size_t end, std::vector<Bignum>& result) {
+	if (end - begin == 1) {
+		result[begin] = value;
+		return;
+	}
+	size_t middle = begin + (end - begin) / 2;
+	const CBigNumMontgomeryContext& mont = params->accumulatorMontgomery();
+	AllButOne(params, value.pow_mod(ProductTree(values, middle, end), params->accumulatorModulus, mont),
+	          values, begin, middle, result);
+	AllButOne(params, value.pow_mod(ProductTree(values, begin, middle), params->accumulatorModulus, mont),
+	          values, middle, end, result);
+}
+
 //Accumulator class
 Accumulator::Accumulator(const AccumulatorAndProofParams* p, const Bignum &v, const CoinDenomination d): params(p), value(v), denomination(d) {
 	if (!(params->initialized)) {
@@ -58,12 +83,39 @@ void Accumulator::accumulate(const PublicCoin& coin, bool validateCoin) {
 
 	if(!validateCoin || coin.validate()) {
 		// Compute new accumulator = "old accumulator"^{element} mod N
-		this->value = this->value.pow_mod(coin.getValue(), this->params->accumulatorModulus);
+		this->value = this->value.pow_mod(coin.getValue(), this->params->accumulatorModulus, this->params->accumulatorMontgomery());
 	} else {
 		throw ZerocoinException("Coin is not valid");
 	}
 }
 
+void Accumulator::accumulate(const std::vector<PublicCoin>& coins, bool validateCoin) {
+	// Make sure we're initialized
+	if(!(this->value)) {
+		throw ZerocoinException("Accumulator is not initialized");
+	}
+
+	if(coins.empty()) {
+		return;
+	}
+
+	std::vector<Bignum> values;
+	values.reserve(coins.size());
+	for(const PublicCoin& coin: coins) {
+		if(this->denomination != coin.getDenomination()) {
+			throw ZerocoinException("Wrong denomination for coin");
+		}
+		if(validateCoin && !coin.validate()) {
+			throw ZerocoinException("Coin is not valid");
+		}
+		values.push_back(coin.getValue());
+	}
+
+	// Compute new accumulator = "old accumulator"^{element_1 * ... * element_n} mod N
+	this->value = this->value.pow_mod(ProductTree(values, 0, values.size()), this->params->accumulatorModulus,
+	                                  this->params->accumulatorMontgomery());
+}
+
 CoinDenomination Accumulator::getDenomination() const {
 	return static_cast<CoinDenomination> (this->denomination);
 }
@@ -107,4 +159,30 @@ AccumulatorWitness& AccumulatorWitness::operator +=(const PublicCoin& rhs) {
 	return *this;
 }
 
+std::vector<AccumulatorWitness> AccumulatorWitness::ForCoins(const Params* p, const Accumulator& checkpoint,
+                                                             const std::vector<PublicCoin>& coins) {
+	std::vector<AccumulatorWitness> witnesses;
+	if(coins.empty()) {
+		return witnesses;
+	}
+
+	std::vector<Bignum> values;
+	values.reserve(coins.size());
+	for(const PublicCoin& coin: coins) {
+		if(checkpoint.getDenomination() != coin.getDenomination()) {
+			throw ZerocoinException("Wrong denomination for coin");
+		}
+		values.push_back(coin.getValue());
+	}
+
+	std::vector<Bignum> witnessValues(coins.size());
+	AllButOne(&p->accumulatorParams, checkpoint.getValue(), values, 0, values.size(), witnessValues);
+
+	witnesses.reserve(coins.size());
+	for(size_t i = 0; i < coins.size(); i++) {
+		witnesses.push_back(AccumulatorWitness(p, Accumulator(p, witnessValues[i], checkpoint.getDenomination()), coins[i]));
+	}
+	return witnesses;
+}
+
 } /* namespace libzerocoin */
@@ -61,6 +61,20 @@ public:
 	 **/
     void accumulate(const PublicCoin &coin, bool validateCoin=false);
 
+	/**
+	 * Accumulate several coins at once. The coin values are multiplied
+	 * in a product tree first and the accumulator is raised to the
+	 * product with a single exponentiation. The result is the same as
+	 * accumulating the coins one by one.
+	 *
+	 * @param coins	PublicCoins to accumulate.
+	 *
+	 * @throw		Zerocoin exception if a coin is not valid. The
+	 * 				accumulator is left unchanged in this case.
+	 *
+	 **/
+    void accumulate(const std::vector<PublicCoin> &coins, bool validateCoin=false);
+
 	CoinDenomination getDenomination() const;
 	/** Get the accumulator result
 	 *
@@ -142,6 +156,19 @@ public:
 	 * @return
 	 */
 	AccumulatorWitness& operator +=(const PublicCoin& rhs);
+
+	/** Constructs witnesses for coins added to the accumulator together,
+	 * e.g. the coins of one block. The witness of every coin accumulates
+	 * all the other coins. The coins are split in halves recursively, each
+	 * half is accumulated into the witnesses of the other one, so this takes
+	 * O(n log n) exponentiations instead of n^2
+	 * @param p pointer to params
+	 * @param checkpoint the last known accumulator value before the coins were added
+	 * @param coins the coins we want witnesses to
+	 * @return the witness of coins[i] at position i
+	 */
+	static std::vector<AccumulatorWitness> ForCoins(const Params* p, const Accumulator& checkpoint,
+	                                                const std::vector<PublicCoin>& coins);
 private:
     const Params* params;
     Accumulator witness;
@@ -30,13 +30,16 @@ namespace libzerocoin {
         Bignum e = commitmentToCoin.getContents();
         Bignum r = commitmentToCoin.getRandomness();
 
+        const IntegerGroupParams &group = params->accumulatorPoKCommitmentGroup;
+        const CBigNumMontgomeryContext &accMontgomery = params->accumulatorMontgomery();
+
         Bignum r_1 = Bignum::randBignum(params->accumulatorModulus / 4);
         Bignum r_2 = Bignum::randBignum(params->accumulatorModulus / 4);
         Bignum r_3 = Bignum::randBignum(params->accumulatorModulus / 4);
 
-        this->C_e = g_n.pow_mod(e, params->accumulatorModulus) * h_n.pow_mod(r_1, params->accumulatorModulus);
-        this->C_u = witness.getValue() * h_n.pow_mod(r_2, params->accumulatorModulus);
-        this->C_r = g_n.pow_mod(r_2, params->accumulatorModulus) * h_n.pow_mod(r_3, params->accumulatorModulus);
+        this->C_e = g_n.pow_mod(e, params->accumulatorModulus, accMontgomery) * h_n.pow_mod(r_1, params->accumulatorModulus, accMontgomery);
+        this->C_u = witness.getValue() * h_n.pow_mod(r_2, params->accumulatorModulus, accMontgomery);
+        this->C_r = g_n.pow_mod(r_2, params->accumulatorModulus, accMontgomery) * h_n.pow_mod(r_3, params->accumulatorModulus, accMontgomery);
 
         Bignum r_alpha = Bignum::randBignum(params->maxCoinValue * Bignum(2).pow(params->k_prime + params->k_dprime));
         if (!(Bignum::randBignum(Bignum(3)) % 2)) {
@@ -78,31 +81,29 @@ namespace libzerocoin {
             r_delta = 0 - r_delta;
         }
 
-        this->st_1 = (sg.pow_mod(r_alpha, params->accumulatorPoKCommitmentGroup.modulus) *
-                      sh.pow_mod(r_phi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                     params->accumulatorPoKCommitmentGroup.modulus;
+        this->st_1 = (group.gPow(r_alpha) * group.hPow(r_phi)) % group.modulus;
         this->st_2 = (((commitmentToCoin.getCommitmentValue() *
-                        sg.inverse(params->accumulatorPoKCommitmentGroup.modulus)).pow_mod(r_gamma,
-                                                                                           params->accumulatorPoKCommitmentGroup.modulus)) *
-                      sh.pow_mod(r_psi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                     params->accumulatorPoKCommitmentGroup.modulus;
-        this->st_3 = ((sg * commitmentToCoin.getCommitmentValue()).pow_mod(r_sigma,
-                                                                           params->accumulatorPoKCommitmentGroup.modulus) *
-                      sh.pow_mod(r_xi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                     params->accumulatorPoKCommitmentGroup.modulus;
+                        sg.inverse(group.modulus)).pow_mod(r_gamma, group.modulus, group.montgomery())) *
+                      group.hPow(r_psi)) %
+                     group.modulus;
+        this->st_3 = ((sg * commitmentToCoin.getCommitmentValue()).pow_mod(r_sigma, group.modulus, group.montgomery()) *
+                      group.hPow(r_xi)) %
+                     group.modulus;
 
         this->t_1 =
-                (h_n.pow_mod(r_zeta, params->accumulatorModulus) * g_n.pow_mod(r_epsilon, params->accumulatorModulus)) %
+                (h_n.pow_mod(r_zeta, params->accumulatorModulus, accMontgomery) *
+                 g_n.pow_mod(r_epsilon, params->accumulatorModulus, accMontgomery)) %
                 params->accumulatorModulus;
         this->t_2 =
-                (h_n.pow_mod(r_eta, params->accumulatorModulus) * g_n.pow_mod(r_alpha, params->accumulatorModulus)) %
+                (h_n.pow_mod(r_eta, params->accumulatorModulus, accMontgomery) *
+                 g_n.pow_mod(r_alpha, params->accumulatorModulus, accMontgomery)) %
                 params->accumulatorModulus;
-        this->t_3 = (C_u.pow_mod(r_alpha, params->accumulatorModulus) *
-                     ((h_n.inverse(params->accumulatorModulus)).pow_mod(r_beta, params->accumulatorModulus))) %
+        this->t_3 = (C_u.pow_mod(r_alpha, params->accumulatorModulus, accMontgomery) *
+                     ((h_n.inverse(params->accumulatorModulus)).pow_mod(r_beta, params->accumulatorModulus, accMontgomery))) %
                     params->accumulatorModulus;
-        this->t_4 = (C_r.pow_mod(r_alpha, params->accumulatorModulus) *
-                     ((h_n.inverse(params->accumulatorModulus)).pow_mod(r_delta, params->accumulatorModulus)) *
-                     ((g_n.inverse(params->accumulatorModulus)).pow_mod(r_beta, params->accumulatorModulus))) %
+        this->t_4 = (C_r.pow_mod(r_alpha, params->accumulatorModulus, accMontgomery) *
+                     ((h_n.inverse(params->accumulatorModulus)).pow_mod(r_delta, params->accumulatorModulus, accMontgomery)) *
+                     ((g_n.inverse(params->accumulatorModulus)).pow_mod(r_beta, params->accumulatorModulus, accMontgomery))) %
                     params->accumulatorModulus;
 
         CHashWriter hasher(0, 0);
@@ -144,38 +145,32 @@ namespace libzerocoin {
 
         Bignum c = Bignum(hasher.GetHash()); //this hash should be of length k_prime bits
 
-        Bignum st_1_prime = (valueOfCommitmentToCoin.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) *
-                             sg.pow_mod(s_alpha, params->accumulatorPoKCommitmentGroup.modulus) *
-                             sh.pow_mod(s_phi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                            params->accumulatorPoKCommitmentGroup.modulus;
-        Bignum st_2_prime = (sg.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) * ((valueOfCommitmentToCoin *
-                                                                                              sg.inverse(
-                                                                                                      params->accumulatorPoKCommitmentGroup.modulus)).pow_mod(
-                s_gamma, params->accumulatorPoKCommitmentGroup.modulus)) *
-                             sh.pow_mod(s_psi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                            params->accumulatorPoKCommitmentGroup.modulus;
-        Bignum st_3_prime = (sg.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) *
-                             (sg * valueOfCommitmentToCoin).pow_mod(s_sigma,
-                                                                    params->accumulatorPoKCommitmentGroup.modulus) *
-                             sh.pow_mod(s_xi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                            params->accumulatorPoKCommitmentGroup.modulus;
-
-        Bignum t_1_prime =
-                (C_r.pow_mod(c, params->accumulatorModulus) * h_n.pow_mod(s_zeta, params->accumulatorModulus) *
-                 g_n.pow_mod(s_epsilon, params->accumulatorModulus)) % params->accumulatorModulus;
-        Bignum t_2_prime =
-                (C_e.pow_mod(c, params->accumulatorModulus) * h_n.pow_mod(s_eta, params->accumulatorModulus) *
-                 g_n.pow_mod(s_alpha, params->accumulatorModulus)) % params->accumulatorModulus;
-
-        Bignum t_3_prime = ((a.getValue()).pow_mod(c, params->accumulatorModulus) *
-                            C_u.pow_mod(s_alpha, params->accumulatorModulus) *
-                            ((h_n.inverse(params->accumulatorModulus)).pow_mod(s_beta, params->accumulatorModulus))) %
-                           params->accumulatorModulus;
-
-        Bignum t_4_prime = (C_r.pow_mod(s_alpha, params->accumulatorModulus) *
-                            ((h_n.inverse(params->accumulatorModulus)).pow_mod(s_delta, params->accumulatorModulus)) *
-                            ((g_n.inverse(params->accumulatorModulus)).pow_mod(s_beta, params->accumulatorModulus))) %
-                           params->accumulatorModulus;
+        // Every value below is a product of two or three powers. Two of them are computed at once with
+        // simultaneous exponentiation, the result is the same as of multiplying separate pow_mod() results
+        // The powers of sh come from the precomputed table of the group
+        const IntegerGroupParams &group = params->accumulatorPoKCommitmentGroup;
+        const Bignum &groupModulus = group.modulus;
+        const CBigNumMontgomeryContext &groupMontgomery = group.montgomery();
+        const Bignum &accModulus = params->accumulatorModulus;
+        const CBigNumMontgomeryContext &accMontgomery = params->accumulatorMontgomery();
+
+        Bignum st_1_prime = valueOfCommitmentToCoin.pow_mod2(c, sg, s_alpha, groupModulus, groupMontgomery)
+                .mul_mod(group.hPow(s_phi), groupModulus);
+        Bignum st_2_prime = sg.pow_mod2(c, (valueOfCommitmentToCoin * sg.inverse(groupModulus)), s_gamma, groupModulus, groupMontgomery)
+                .mul_mod(group.hPow(s_psi), groupModulus);
+        Bignum st_3_prime = sg.pow_mod2(c, (sg * valueOfCommitmentToCoin), s_sigma, groupModulus, groupMontgomery)
+                .mul_mod(group.hPow(s_xi), groupModulus);
+
+        Bignum t_1_prime = C_r.pow_mod2(c, h_n, s_zeta, accModulus, accMontgomery)
+                .mul_mod(g_n.pow_mod(s_epsilon, accModulus, accMontgomery), accModulus);
+        Bignum t_2_prime = C_e.pow_mod2(c, h_n, s_eta, accModulus, accMontgomery)
+                .mul_mod(g_n.pow_mod(s_alpha, accModulus, accMontgomery), accModulus);
+
+        Bignum t_3_prime = (a.getValue()).pow_mod2(c, C_u, s_alpha, accModulus, accMontgomery)
+                .mul_mod((h_n.inverse(accModulus)).pow_mod(s_beta, accModulus, accMontgomery), accModulus);
+
+        Bignum t_4_prime = C_r.pow_mod2(s_alpha, (h_n.inverse(accModulus)), s_delta, accModulus, accMontgomery)
+                .mul_mod((g_n.inverse(accModulus)).pow_mod(s_beta, accModulus, accMontgomery), accModulus);
 
         bool result = false;
 
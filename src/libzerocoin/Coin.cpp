@@ -13,6 +13,9 @@
 #include <stdexcept>
 #include <openssl/rand.h>
 #include "Zerocoin.h"
+#include "ParallelTasks.h"
+
+#include <memory>
 
 namespace libzerocoin {
 secp256k1_context* init_ctx() {
@@ -65,7 +68,8 @@ bool PublicCoin::validate() const{
 }
 
 //PrivateCoin class
-PrivateCoin::PrivateCoin(const Params* p, CoinDenomination denomination, int version): params(p), publicCoin(p) {
+PrivateCoin::PrivateCoin(const Params* p, CoinDenomination denomination, int version,
+                         const std::function<bool()>& fCancelled): params(p), publicCoin(p) {
     this->version = version;
 	// Verify that the parameters are valid
 	if(this->params->initialized == false) {
@@ -76,14 +80,37 @@ PrivateCoin::PrivateCoin(const Params* p, CoinDenomination denomination, int ver
 	// Mint a new coin with a random serial number using the fast process.
 	// This is more vulnerable to timing attacks so don't mint coins when
 	// somebody could be timing you.
-	this->mintCoinFast(denomination);
+	this->mintCoinFast(denomination, fCancelled);
 #else
 	// Mint a new coin with a random serial number using the standard process.
-	this->mintCoin(denomination);
+	this->mintCoin(denomination, fCancelled);
 #endif
 
 }
 
+std::vector<PrivateCoin> PrivateCoin::mintCoins(const Params* p, const std::vector<CoinDenomination>& denominations,
+                                                int version, const std::function<bool()>& fCancelled) {
+	std::vector<std::unique_ptr<PrivateCoin>> coins(denominations.size());
+	// declared after the coins so the tasks still running are waited for before the coins are destroyed
+	ParallelTasks mintTasks(denominations.size());
+
+	for (size_t i = 0; i < denominations.size(); i++) {
+		mintTasks.Add([&, i] {
+			// loop until we find a coin passing the full validation
+			do {
+				coins[i].reset(new PrivateCoin(p, denominations[i], version, fCancelled));
+			} while (!coins[i]->getPublicCoin().validate());
+		});
+	}
+	mintTasks.Wait();
+
+	std::vector<PrivateCoin> result;
+	result.reserve(coins.size());
+	for (const std::unique_ptr<PrivateCoin>& coin : coins)
+		result.push_back(*coin);
+	return result;
+}
+
 /**
  *
  * @return the coins serial number
@@ -104,13 +131,16 @@ unsigned int PrivateCoin::getVersion() const {
      return this->version;
 }
 
-void PrivateCoin::mintCoin(const CoinDenomination denomination) {
+void PrivateCoin::mintCoin(const CoinDenomination denomination, const std::function<bool()>& fCancelled) {
 
 	Bignum s;
 
 	// Repeat this process up to MAX_COINMINT_ATTEMPTS times until
 	// we obtain a prime number
 	for (uint32_t attempt = 0; attempt < MAX_COINMINT_ATTEMPTS; attempt++) {
+		if (fCancelled && fCancelled())
+			throw ZerocoinException("Minting of the coin was cancelled");
+
 		if (this->version == 2) {
 
 			// Create a key pair
@@ -163,7 +193,7 @@ void PrivateCoin::mintCoin(const CoinDenomination denomination) {
 			"Unable to mint a new Zerocoin (too many attempts)");
 }
 
-void PrivateCoin::mintCoinFast(const CoinDenomination denomination) {
+void PrivateCoin::mintCoinFast(const CoinDenomination denomination, const std::function<bool()>& fCancelled) {
 	Bignum s;
 
 	if(this->version == 2) {
@@ -189,11 +219,14 @@ void PrivateCoin::mintCoinFast(const CoinDenomination denomination) {
 
 	// Manually compute a Pedersen commitment to the serial number "s" under randomness "r"
 	// C = g^s * h^r mod p
-	Bignum commitmentValue = this->params->coinCommitmentGroup.g.pow_mod(s, this->params->coinCommitmentGroup.modulus).mul_mod(this->params->coinCommitmentGroup.h.pow_mod(r, this->params->coinCommitmentGroup.modulus), this->params->coinCommitmentGroup.modulus);
+	Bignum commitmentValue = this->params->coinCommitmentGroup.gPow(s).mul_mod(this->params->coinCommitmentGroup.hPow(r), this->params->coinCommitmentGroup.modulus);
 
 	// Repeat this process up to MAX_COINMINT_ATTEMPTS times until
 	// we obtain a prime number
 	for (uint32_t attempt = 0; attempt < MAX_COINMINT_ATTEMPTS; attempt++) {
+		if (fCancelled && fCancelled())
+			throw ZerocoinException("Minting of the coin was cancelled");
+
 		// First verify that the commitment is a prime number
 		// in the appropriate range. If not, we'll throw this coin
 		// away and generate a new one.
@@ -219,7 +252,7 @@ void PrivateCoin::mintCoinFast(const CoinDenomination denomination) {
 		// r = r + r_delta mod q
 		// C = C * h mod p
 		r = (r + r_delta) % this->params->coinCommitmentGroup.groupOrder;
-		commitmentValue = commitmentValue.mul_mod(this->params->coinCommitmentGroup.h.pow_mod(r_delta, this->params->coinCommitmentGroup.modulus), this->params->coinCommitmentGroup.modulus);
+		commitmentValue = commitmentValue.mul_mod(this->params->coinCommitmentGroup.hPow(r_delta), this->params->coinCommitmentGroup.modulus);
 	}
 
 	// We only get here if we did not find a coin within
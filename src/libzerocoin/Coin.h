@@ -16,6 +16,10 @@
 #include <secp256k1_recovery.h>
 #include "bitcoin_bignum/bignum.h"
 #include "Params.h"
+
+#include <functional>
+#include <vector>
+
 namespace libzerocoin {
 
 enum  CoinDenomination {
@@ -96,7 +100,22 @@ public:
     PrivateCoin(const Params* p, Stream& strm): params(p), publicCoin(p) {
         strm >> *this;
     }
-    PrivateCoin(const Params* p, CoinDenomination denomination = ZQ_LOVELACE, int version = ZEROCOIN_TX_VERSION_1);
+    /**
+     * Mints a new coin.
+     * @param fCancelled polled before every attempt, minting throws ZerocoinException once it returns true
+     */
+    PrivateCoin(const Params* p, CoinDenomination denomination = ZQ_LOVELACE, int version = ZEROCOIN_TX_VERSION_1,
+                const std::function<bool()>& fCancelled = std::function<bool()>());
+
+    /**
+     * Mints coins of the given denominations in parallel. Every returned
+     * coin passes PublicCoin::validate().
+     * @param fCancelled polled by all the minting tasks, see the constructor
+     * @return coins in the order of the denominations
+     * @throws ZerocoinException if minting failed or was cancelled
+     */
+    static std::vector<PrivateCoin> mintCoins(const Params* p, const std::vector<CoinDenomination>& denominations,
+                                              int version, const std::function<bool()>& fCancelled = std::function<bool()>());
     const PublicCoin& getPublicCoin() const;
     const Bignum& getSerialNumber() const;
     const Bignum& getRandomness() const;
@@ -164,7 +183,7 @@ private:
      * the resulting commitment is prime. Stores the
      * resulting commitment (coin) and randomness (trapdoor).
      **/
-    void mintCoin(const CoinDenomination denomination);
+    void mintCoin(const CoinDenomination denomination, const std::function<bool()>& fCancelled);
 
     /**
      * @brief Mint a new coin using a faster process.
@@ -180,7 +199,7 @@ private:
      * to timing attacks. Don't use it if you think someone
      * could be timing your coin minting.
      **/
-    void mintCoinFast(const CoinDenomination denomination);
+    void mintCoinFast(const CoinDenomination denomination, const std::function<bool()>& fCancelled);
 
 };
 
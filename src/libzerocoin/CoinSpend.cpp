@@ -16,6 +16,7 @@
  */
 		
 #include "Zerocoin.h"
+#include "ParallelTasks.h"
 
 namespace libzerocoin {
 
@@ -95,54 +96,87 @@ CoinDenomination CoinSpend::getDenomination() const {
 }
 
 bool CoinSpend::Verify(const Accumulator& a, const SpendMetaData &m) const {
+	uint256 metahash = signatureHash(m);
+	return VerifyAccumulatorAndCommitment(a)
+		&& serialNumberSoK.Verify(coinSerialNumber, serialCommitmentToCoinValue, this->version == ZEROCOIN_TX_VERSION_1_5 ? metahash : uint256())
+		&& VerifySignature(metahash);
+}
+
+bool CoinSpend::VerifyAccumulatorAndCommitment(const Accumulator& a) const {
     if (!HasValidSerial())
         return false;
 
-	uint256 metahash = signatureHash(m);
-	// Verify both of the sub-proofs using the given meta-data
-    int ret = (a.getDenomination() == this->denomination)
+    return (a.getDenomination() == this->denomination)
                 && commitmentPoK.Verify(serialCommitmentToCoinValue, accCommitmentToCoinValue)
-                && accumulatorPoK.Verify(a, accCommitmentToCoinValue)
-                && serialNumberSoK.Verify(coinSerialNumber, serialCommitmentToCoinValue, this->version == ZEROCOIN_TX_VERSION_1_5 ? metahash : uint256());
-    if (!ret) {
-            return false;
+                && accumulatorPoK.Verify(a, accCommitmentToCoinValue);
+}
+
+bool CoinSpend::VerifySignature(const uint256 &metahash) const {
+    if (this->version != 2)
+        return true;
+
+    // Check if this is a coin that requires a signatures
+    if (coinSerialNumber.bitSize() > 160)
+        return false;
+
+    // Check sizes
+    if (this->ecdsaPubkey.size() != 33 || this->ecdsaSignature.size() != 64) {
+        return false;
     }
 
+    // Verify signature
+    secp256k1_pubkey pubkey;
+    secp256k1_ecdsa_signature signature;
 
-    if (this->version != 2) {
-        return ret;
+    if (!secp256k1_ec_pubkey_parse(ctx, &pubkey, ecdsaPubkey.data(), 33)) {
+        return false;
     }
-    else {
-        // Check if this is a coin that requires a signatures
-        if (coinSerialNumber.bitSize() > 160)
-            return false;
-
-        // Check sizes
-        if (this->ecdsaPubkey.size() != 33 || this->ecdsaSignature.size() != 64) {
-            return false;
-        }
-
-        // Verify signature
-        secp256k1_pubkey pubkey;
-        secp256k1_ecdsa_signature signature;
-
-        if (!secp256k1_ec_pubkey_parse(ctx, &pubkey, ecdsaPubkey.data(), 33)) {
-            return false;
-        }
-
-        // Recompute and compare hash of public key
-        if (coinSerialNumber != PrivateCoin::serialNumberFromSerializedPublicKey(ctx, &pubkey)) {
-            return false;
-        }
-
-        secp256k1_ecdsa_signature_parse_compact(ctx, &signature, ecdsaSignature.data());
-        if (!secp256k1_ecdsa_verify(ctx, &signature, metahash.begin(), &pubkey)) {
-            return false;
-        }
 
-        return true;
+    // Recompute and compare hash of public key
+    if (coinSerialNumber != PrivateCoin::serialNumberFromSerializedPublicKey(ctx, &pubkey)) {
+        return false;
+    }
+
+    secp256k1_ecdsa_signature_parse_compact(ctx, &signature, ecdsaSignature.data());
+    if (!secp256k1_ecdsa_verify(ctx, &signature, metahash.begin(), &pubkey)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool CoinSpend::VerifyBatch(const vector<const CoinSpend *> &spends, const vector<Accumulator> &accumulators,
+                            const vector<SpendMetaData> &metaData, vector<bool> &results) {
+    size_t numberOfSpends = spends.size();
+    if (accumulators.size() != numberOfSpends || metaData.size() != numberOfSpends)
+        throw ZerocoinException("CoinSpend::VerifyBatch: size mismatch");
+
+    // vector<bool> can't be written to from several threads at once
+    vector<char> passed(numberOfSpends, 0);
+
+    // Spends are verified in parallel. Serial number signatures of knowledge add their own tasks to the
+    // same executor, waiting task executes them itself if all the threads are busy
+    ParallelTasks verifyTasks(numberOfSpends);
+    for (size_t i = 0; i < numberOfSpends; i++) {
+        verifyTasks.Add([i, &spends, &accumulators, &metaData, &passed] {
+            try {
+                passed[i] = spends[i]->Verify(accumulators[i], metaData[i]);
+            }
+            catch (std::exception &) {
+                passed[i] = false;
+            }
+        });
+    }
+    verifyTasks.Wait();
+
+    bool fAllPassed = true;
+    results.assign(numberOfSpends, false);
+    for (size_t i = 0; i < numberOfSpends; i++) {
+        results[i] = passed[i] != 0;
+        fAllPassed = fAllPassed && results[i];
     }
 
+    return fAllPassed;
 }
 
 bool CoinSpend::HasValidSerial() const { 
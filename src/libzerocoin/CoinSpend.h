@@ -110,6 +110,17 @@ public:
 	bool HasValidSerial() const;
 	bool Verify(const Accumulator& a, const SpendMetaData &metaData) const;
 
+	/** Verifies a number of spends at once. Proofs of different spends are checked in parallel.
+	 *
+	 * @param spends spends to verify
+	 * @param accumulators accumulator value for each of the spends
+	 * @param metaData meta data for each of the spends
+	 * @param results set to the result of verification of the corresponding spend
+	 * @return true if all the spends are valid
+	 */
+	static bool VerifyBatch(const vector<const CoinSpend *> &spends, const vector<Accumulator> &accumulators,
+			const vector<SpendMetaData> &metaData, vector<bool> &results);
+
 	ADD_SERIALIZE_METHODS;
 	template <typename Stream, typename Operation>
 	inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
@@ -144,6 +155,9 @@ public:
 private:
 	const Params *params;
     const uint256 signatureHash(const SpendMetaData &m) const;
+    // parts of Verify() that don't use serial number signature of knowledge
+    bool VerifyAccumulatorAndCommitment(const Accumulator& a) const;
+    bool VerifySignature(const uint256 &metahash) const;
 	// Denomination is stored as an INT because storing
 	// and enum raises amigiuities in the serialize code //FIXME if possible
 	int denomination;
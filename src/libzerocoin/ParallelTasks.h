@@ -14,23 +14,22 @@
 #define PARALLELTASKS_H
 
 /**
- * Implementation of thread pool for parallelizing spend creation and verification
+ * Parallelizing spend creation and verification. Tasks are run by the process-wide executor
+ * shared with script checks
  */ 
 
-#include <vector>
+#include <memory>
 #include <functional>
 
-#define BOOST_THREAD_PROVIDES_FUTURE
-
-
-#include <boost/thread/future.hpp>
 #include <boost/thread.hpp>
 
+#include "../executor.h"
+
 namespace libzerocoin {
 
 class ParallelTasks {
 private:
-    vector<boost::future<void>> tasks;
+    std::unique_ptr<CExecutorTaskGroup> tasks;
 
 public:
     ParallelTasks(int n=0);
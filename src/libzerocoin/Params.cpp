@@ -27,19 +27,109 @@ Params::Params(CBigNum N, CBigNum Nseed, uint32_t securityLevel) {
 	this->initialized = true;
 }
 
-AccumulatorAndProofParams::AccumulatorAndProofParams() {
+AccumulatorAndProofParams::AccumulatorAndProofParams() : precomputed(new Precomputed()) {
 	this->initialized = false;
 }
 
-IntegerGroupParams::IntegerGroupParams() {
+AccumulatorAndProofParams::AccumulatorAndProofParams(const AccumulatorAndProofParams& other) :
+	initialized(other.initialized),
+	accumulatorModulus(other.accumulatorModulus),
+	accumulatorBase(other.accumulatorBase),
+	minCoinValue(other.minCoinValue),
+	maxCoinValue(other.maxCoinValue),
+	accumulatorPoKCommitmentGroup(other.accumulatorPoKCommitmentGroup),
+	accumulatorQRNCommitmentGroup(other.accumulatorQRNCommitmentGroup),
+	k_prime(other.k_prime),
+	k_dprime(other.k_dprime),
+	precomputed(new Precomputed()) {
+}
+
+AccumulatorAndProofParams& AccumulatorAndProofParams::operator=(const AccumulatorAndProofParams& other) {
+	if (this != &other) {
+		this->initialized = other.initialized;
+		this->accumulatorModulus = other.accumulatorModulus;
+		this->accumulatorBase = other.accumulatorBase;
+		this->minCoinValue = other.minCoinValue;
+		this->maxCoinValue = other.maxCoinValue;
+		this->accumulatorPoKCommitmentGroup = other.accumulatorPoKCommitmentGroup;
+		this->accumulatorQRNCommitmentGroup = other.accumulatorQRNCommitmentGroup;
+		this->k_prime = other.k_prime;
+		this->k_dprime = other.k_dprime;
+		this->precomputed.reset(new Precomputed());
+	}
+	return *this;
+}
+
+const CBigNumMontgomeryContext& AccumulatorAndProofParams::accumulatorMontgomery() const {
+	Precomputed& result = *this->precomputed;
+	std::call_once(result.initialized, [&] {
+		result.mont.reset(new CBigNumMontgomeryContext(this->accumulatorModulus));
+	});
+	return *result.mont;
+}
+
+IntegerGroupParams::IntegerGroupParams() : precomputed(new Precomputed()) {
 	this->initialized = false;
 }
 
+IntegerGroupParams::IntegerGroupParams(const IntegerGroupParams& other) :
+	initialized(other.initialized),
+	g(other.g),
+	h(other.h),
+	modulus(other.modulus),
+	groupOrder(other.groupOrder),
+	precomputed(new Precomputed()) {
+}
+
+IntegerGroupParams& IntegerGroupParams::operator=(const IntegerGroupParams& other) {
+	if (this != &other) {
+		this->initialized = other.initialized;
+		this->g = other.g;
+		this->h = other.h;
+		this->modulus = other.modulus;
+		this->groupOrder = other.groupOrder;
+		this->precomputed.reset(new Precomputed());
+	}
+	return *this;
+}
+
+const IntegerGroupParams::Precomputed& IntegerGroupParams::getPrecomputed() const {
+	Precomputed& result = *this->precomputed;
+	std::call_once(result.initialized, [&] {
+		result.mont.reset(new CBigNumMontgomeryContext(this->modulus));
+		// Without a known order the exponents can't be reduced and the
+		// powers can't be tabulated, as for the QRN group
+		if (this->groupOrder > 0) {
+			result.g.reset(new CBigNumFixedBase(this->g, this->modulus, this->groupOrder, *result.mont));
+			result.h.reset(new CBigNumFixedBase(this->h, this->modulus, this->groupOrder, *result.mont));
+		}
+	});
+	return result;
+}
+
+Bignum IntegerGroupParams::gPow(const Bignum& e) const {
+	const Precomputed& precomputed = getPrecomputed();
+	if (!precomputed.g)
+		return this->g.pow_mod(e, this->modulus, *precomputed.mont);
+	return precomputed.g->pow_mod(e);
+}
+
+Bignum IntegerGroupParams::hPow(const Bignum& e) const {
+	const Precomputed& precomputed = getPrecomputed();
+	if (!precomputed.h)
+		return this->h.pow_mod(e, this->modulus, *precomputed.mont);
+	return precomputed.h->pow_mod(e);
+}
+
+const CBigNumMontgomeryContext& IntegerGroupParams::montgomery() const {
+	return *getPrecomputed().mont;
+}
+
 Bignum IntegerGroupParams::randomElement() const {
 	// The generator of the group raised
 	// to a random number less than the order of the group
 	// provides us with a uniformly distributed random number.
-	return this->g.pow_mod(Bignum::randBignum(this->groupOrder),this->modulus);
+	return this->gPow(Bignum::randBignum(this->groupOrder));
 }
 
 } /* namespace libzerocoin */
@@ -13,6 +13,9 @@
 #define PARAMS_H_
 #include "Zerocoin.h"
 
+#include <memory>
+#include <mutex>
+
 namespace libzerocoin {
 
 class IntegerGroupParams {
@@ -23,6 +26,13 @@ public:
 	**/
 	IntegerGroupParams();
 
+	/**
+	 * Copies the group parameters. The precomputed values are not
+	 * shared, the copy sets up its own on first use.
+	 */
+	IntegerGroupParams(const IntegerGroupParams& other);
+	IntegerGroupParams& operator=(const IntegerGroupParams& other);
+
 	/**
 	 * Generates a random group element
 	 * @return a random element in the group.
@@ -52,6 +62,28 @@ public:
 	 */
     CBigNum groupOrder;
 
+	/**
+	 * Computes g^e mod modulus using the precomputed powers of g.
+	 * The group parameters must not change after the first call.
+	 * @param e the exponent
+	 * @return g^e mod modulus
+	 */
+	CBigNum gPow(const CBigNum& e) const;
+
+	/**
+	 * Computes h^e mod modulus using the precomputed powers of h.
+	 * The group parameters must not change after the first call.
+	 * @param e the exponent
+	 * @return h^e mod modulus
+	 */
+	CBigNum hPow(const CBigNum& e) const;
+
+	/**
+	 * The Montgomery context of the modulus, for exponentiations
+	 * of other bases.
+	 */
+	const CBigNumMontgomeryContext& montgomery() const;
+
 	ADD_SERIALIZE_METHODS;
 
 	template <typename Stream, typename Operation>
@@ -61,8 +93,25 @@ public:
 		READWRITE(h);
 		READWRITE(modulus);
 		READWRITE(groupOrder);
+		if (ser_action.ForRead())
+			precomputed.reset(new Precomputed());
+	};
+
+private:
+	/**
+	 * Montgomery context of the modulus and the powers of the
+	 * generators, set up on first use.
+	 */
+	struct Precomputed {
+		std::once_flag initialized;
+		std::unique_ptr<CBigNumMontgomeryContext> mont;
+		std::unique_ptr<CBigNumFixedBase> g;
+		std::unique_ptr<CBigNumFixedBase> h;
 	};
 
+	std::unique_ptr<Precomputed> precomputed;
+
+	const Precomputed& getPrecomputed() const;
 };
 
 class AccumulatorAndProofParams {
@@ -85,6 +134,13 @@ public:
 	**/
 	AccumulatorAndProofParams();
 
+	/**
+	 * Copies the parameters. The Montgomery context of the
+	 * accumulator modulus is not shared.
+	 */
+	AccumulatorAndProofParams(const AccumulatorAndProofParams& other);
+	AccumulatorAndProofParams& operator=(const AccumulatorAndProofParams& other);
+
 	//AccumulatorAndProofParams(Bignum accumulatorModulus);
 
 	bool initialized;
@@ -138,6 +194,13 @@ public:
 	 * The statistical zero-knowledgeness of the accumulator proof.
 	 */
 	uint32_t k_dprime;
+
+	/**
+	 * The Montgomery context of the accumulator modulus, set up on
+	 * first use. The modulus must not change after that.
+	 */
+	const CBigNumMontgomeryContext& accumulatorMontgomery() const;
+
 	ADD_SERIALIZE_METHODS;
 
 	template <typename Stream, typename Operation>
@@ -151,7 +214,17 @@ public:
 		READWRITE(maxCoinValue);
 		READWRITE(k_prime);
 		READWRITE(k_dprime);
+		if (ser_action.ForRead())
+			precomputed.reset(new Precomputed());
 	};
+
+private:
+	struct Precomputed {
+		std::once_flag initialized;
+		std::unique_ptr<CBigNumMontgomeryContext> mont;
+	};
+
+	std::unique_ptr<Precomputed> precomputed;
 };
 
 class Params {
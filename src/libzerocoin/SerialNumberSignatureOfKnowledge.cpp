@@ -29,11 +29,6 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 		throw ZerocoinException("Groups are not structured correctly.");
 	}
 
-	Bignum a = params->coinCommitmentGroup.g;
-	Bignum b = params->coinCommitmentGroup.h;
-	Bignum g = params->serialNumberSoKCommitmentGroup.g;
-	Bignum h = params->serialNumberSoKCommitmentGroup.h;
-
 	CHashWriter hasher(0,0);
 	hasher << *params << commitmentToCoin.getCommitmentValue() << coin.getSerialNumber();
     if (!msghash.IsNull())
@@ -45,9 +40,6 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 
 
 	for(uint32_t i=0; i < params->zkp_iterations; i++) {
-		//FIXME we really ought to use one BN_CTX for all of these
-		// operations for performance reasons, not the one that
-		// is created individually  by the wrapper
 		r[i] = Bignum::randBignum(params->coinCommitmentGroup.groupOrder);
 		v[i] = Bignum::randBignum(params->serialNumberSoKCommitmentGroup.groupOrder);
 	}
@@ -85,10 +77,10 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 			s_notprime[i]       = r[i];
 			sprime[i]           = v[i];
 		} else {
-            challenges.Add([this, i, &r, &v, &b, &commitmentToCoin, &coin] {
+            challenges.Add([this, i, &r, &v, &commitmentToCoin, &coin] {
                 s_notprime[i]   = r[i] - coin.getRandomness();
                 sprime[i]       = v[i] - (commitmentToCoin.getRandomness() *
-			                              b.pow_mod(r[i] - coin.getRandomness(), params->serialNumberSoKCommitmentGroup.groupOrder));
+			                              params->coinCommitmentGroup.hPow(r[i] - coin.getRandomness()));
             });
 		}
     }
@@ -98,15 +90,13 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Params*
 inline Bignum SerialNumberSignatureOfKnowledge::challengeCalculation(const Bignum& a_exp,const Bignum& b_exp,
         const Bignum& h_exp) const {
 
-	Bignum a = params->coinCommitmentGroup.g;
-	Bignum b = params->coinCommitmentGroup.h;
-	Bignum g = params->serialNumberSoKCommitmentGroup.g;
-	Bignum h = params->serialNumberSoKCommitmentGroup.h;
-
-	Bignum exponent = (a.pow_mod(a_exp, params->serialNumberSoKCommitmentGroup.groupOrder)
-	                   * b.pow_mod(b_exp, params->serialNumberSoKCommitmentGroup.groupOrder)) % params->serialNumberSoKCommitmentGroup.groupOrder;
+	// The order of the serial number group is the modulus of the coin
+	// commitment group, so a^a_exp and b^b_exp are powers of its generators
+	Bignum exponent = params->coinCommitmentGroup.gPow(a_exp)
+	                  .mul_mod(params->coinCommitmentGroup.hPow(b_exp), params->serialNumberSoKCommitmentGroup.groupOrder);
 
-	return (g.pow_mod(exponent, params->serialNumberSoKCommitmentGroup.modulus) * h.pow_mod(h_exp, params->serialNumberSoKCommitmentGroup.modulus)) % params->serialNumberSoKCommitmentGroup.modulus;
+	return params->serialNumberSoKCommitmentGroup.gPow(exponent)
+	       .mul_mod(params->serialNumberSoKCommitmentGroup.hPow(h_exp), params->serialNumberSoKCommitmentGroup.modulus);
 }
 
 bool SerialNumberSignatureOfKnowledge::Verify(const Bignum& coinSerialNumber, const Bignum& valueOfCommitmentToCoin,
@@ -114,11 +104,6 @@ bool SerialNumberSignatureOfKnowledge::Verify(const Bignum& coinSerialNumber, co
 
     ParallelTasks::DoNotDisturb dnd;
 
-	Bignum a = params->coinCommitmentGroup.g;
-	Bignum b = params->coinCommitmentGroup.h;
-	Bignum g = params->serialNumberSoKCommitmentGroup.g;
-	Bignum h = params->serialNumberSoKCommitmentGroup.h;
-
 	// Make sure that the serial number has a unique representation
 	if (coinSerialNumber < 0 || coinSerialNumber >= params->coinCommitmentGroup.groupOrder){
 		return false;
@@ -136,17 +121,17 @@ bool SerialNumberSignatureOfKnowledge::Verify(const Bignum& coinSerialNumber, co
     ParallelTasks challenges(params->zkp_iterations);
 
 	for(uint32_t i = 0; i < params->zkp_iterations; i++) {
-        challenges.Add([this, i, hashbytes, &b, &h, &tprime, &coinSerialNumber, &valueOfCommitmentToCoin] {
+        challenges.Add([this, i, hashbytes, &tprime, &coinSerialNumber, &valueOfCommitmentToCoin] {
             int bit = i % 8;
             int byte = i / 8;
             bool challenge_bit = ((hashbytes[byte] >> bit) & 0x01);
             if(challenge_bit) {
                 tprime[i] = challengeCalculation(coinSerialNumber, s_notprime[i], sprime[i]);
             } else {
-                Bignum exp = b.pow_mod(s_notprime[i], params->serialNumberSoKCommitmentGroup.groupOrder);
-                tprime[i] = ((valueOfCommitmentToCoin.pow_mod(exp, params->serialNumberSoKCommitmentGroup.modulus) % params->serialNumberSoKCommitmentGroup.modulus) *
-                             (h.pow_mod(sprime[i], params->serialNumberSoKCommitmentGroup.modulus) % params->serialNumberSoKCommitmentGroup.modulus)) %
-                            params->serialNumberSoKCommitmentGroup.modulus;
+                const IntegerGroupParams& group = params->serialNumberSoKCommitmentGroup;
+                Bignum exp = params->coinCommitmentGroup.hPow(s_notprime[i]);
+                tprime[i] = valueOfCommitmentToCoin.pow_mod(exp, group.modulus, group.montgomery())
+                            .mul_mod(group.hPow(sprime[i]), group.modulus);
             }
         });
 	}
@@ -20,33 +20,38 @@ public:
     explicit bignum_error(const std::string& str) : std::runtime_error(str) {}
 };
 
-/** RAII encapsulated BN_CTX (OpenSSL bignum context) */
+/** OpenSSL bignum context of the current thread. OpenSSL functions allocate their temporaries in stack frames of the
+ * context, so all the nested operations of a thread share one context instead of allocating a new one every time */
 class CAutoBN_CTX
 {
 protected:
     BN_CTX* pctx;
-    BN_CTX* operator=(BN_CTX* pnew) { return pctx = pnew; }
+
+    static BN_CTX* GetThreadContext()
+    {
+        struct CThreadContext {
+            BN_CTX* pctx;
+            CThreadContext() : pctx(BN_CTX_new()) {}
+            ~CThreadContext() { if (pctx != NULL) BN_CTX_free(pctx); }
+        };
+        static thread_local CThreadContext context;
+        return context.pctx;
+    }
 
 public:
     CAutoBN_CTX()
     {
-        pctx = BN_CTX_new();
+        pctx = GetThreadContext();
         if (pctx == NULL)
             throw bignum_error("CAutoBN_CTX : BN_CTX_new() returned NULL");
     }
 
-    ~CAutoBN_CTX()
-    {
-        if (pctx != NULL)
-            BN_CTX_free(pctx);
-    }
-
     operator BN_CTX*() { return pctx; }
     BN_CTX& operator*() { return *pctx; }
-    BN_CTX** operator&() { return &pctx; }
     bool operator!() { return (pctx == NULL); }
 };
 
+class CBigNumMontgomeryContext;
 
 /** C++ wrapper for BIGNUM (OpenSSL bignum) */class CBigNum
 {
@@ -554,6 +559,45 @@ public:
         return ret;
     }
 
+    /**
+     * modular exponentiation with the Montgomery context of m prepared beforehand
+     * @param e exponent
+     * @param m modulus, should be odd
+     * @param mont Montgomery context of m
+     */
+    CBigNum pow_mod(const CBigNum& e, const CBigNum& m, const CBigNumMontgomeryContext& mont) const;
+
+    /**
+     * simultaneous modular exponentiation: (this^e1 * b^e2) mod m
+     * Both powers are computed in one pass which is noticeably faster than two pow_mod calls
+     * @param e1 exponent for this
+     * @param b second base
+     * @param e2 exponent for b
+     * @param m modulus, should be odd
+     */
+    CBigNum pow_mod2(const CBigNum& e1, const CBigNum& b, const CBigNum& e2, const CBigNum& m) const {
+        if (!BN_is_odd(&m))
+            // Montgomery multiplication is not possible
+            return pow_mod(e1, m).mul_mod(b.pow_mod(e2, m), m);
+
+        CAutoBN_CTX pctx;
+        CBigNum ret;
+        // g^-x = (g^-1)^x
+        CBigNum base1 = e1 < 0 ? this->inverse(m) : *this;
+        CBigNum base2 = e2 < 0 ? b.inverse(m) : b;
+        CBigNum posE1 = e1 < 0 ? e1 * -1 : e1;
+        CBigNum posE2 = e2 < 0 ? e2 * -1 : e2;
+        if (!BN_mod_exp2_mont(&ret, &base1, &posE1, &base2, &posE2, &m, pctx, NULL))
+            throw bignum_error("CBigNum::pow_mod2 : BN_mod_exp2_mont failed");
+
+        return ret;
+    }
+
+    /**
+     * simultaneous modular exponentiation with the Montgomery context of m prepared beforehand
+     */
+    CBigNum pow_mod2(const CBigNum& e1, const CBigNum& b, const CBigNum& e2, const CBigNum& m, const CBigNumMontgomeryContext& mont) const;
+
     /**
      * Calculates the inverse of this element mod m.
      * i.e. i such this*i = 1 mod m
@@ -802,6 +846,158 @@ inline bool operator<(const CBigNum& a, const CBigNum& b)  { return (BN_cmp(&a,
 inline bool operator>(const CBigNum& a, const CBigNum& b)  { return (BN_cmp(&a, &b) > 0); }
 inline std::ostream& operator<<(std::ostream &strm, const CBigNum &b) { return strm << b.ToString(10); }
 
+/** Montgomery context of an odd modulus, set up once for all the exponentiations modulo it. Exponentiations only read
+ * the context, so it can be shared between threads */
+class CBigNumMontgomeryContext
+{
+private:
+    BN_MONT_CTX* pmont;
+
+    CBigNumMontgomeryContext(const CBigNumMontgomeryContext&) = delete;
+    CBigNumMontgomeryContext& operator=(const CBigNumMontgomeryContext&) = delete;
+
+public:
+    explicit CBigNumMontgomeryContext(const CBigNum& m)
+    {
+        CAutoBN_CTX pctx;
+        pmont = BN_MONT_CTX_new();
+        if (pmont == NULL)
+            throw bignum_error("CBigNumMontgomeryContext : BN_MONT_CTX_new failed");
+        if (!BN_MONT_CTX_set(pmont, &m, pctx)) {
+            BN_MONT_CTX_free(pmont);
+            throw bignum_error("CBigNumMontgomeryContext : BN_MONT_CTX_set failed");
+        }
+    }
+
+    ~CBigNumMontgomeryContext()
+    {
+        BN_MONT_CTX_free(pmont);
+    }
+
+    BN_MONT_CTX* get() const
+    {
+        return pmont;
+    }
+};
+
+inline CBigNum CBigNum::pow_mod(const CBigNum& e, const CBigNum& m, const CBigNumMontgomeryContext& mont) const
+{
+    CAutoBN_CTX pctx;
+    CBigNum ret;
+    // g^-x = (g^-1)^x
+    CBigNum base = e < 0 ? this->inverse(m) : *this;
+    CBigNum posE = e < 0 ? e * -1 : e;
+    if (!BN_mod_exp_mont(&ret, &base, &posE, &m, pctx, mont.get()))
+        throw bignum_error("CBigNum::pow_mod : BN_mod_exp_mont failed");
+    return ret;
+}
+
+inline CBigNum CBigNum::pow_mod2(const CBigNum& e1, const CBigNum& b, const CBigNum& e2, const CBigNum& m, const CBigNumMontgomeryContext& mont) const
+{
+    CAutoBN_CTX pctx;
+    CBigNum ret;
+    CBigNum base1 = e1 < 0 ? this->inverse(m) : *this;
+    CBigNum base2 = e2 < 0 ? b.inverse(m) : b;
+    CBigNum posE1 = e1 < 0 ? e1 * -1 : e1;
+    CBigNum posE2 = e2 < 0 ? e2 * -1 : e2;
+    if (!BN_mod_exp2_mont(&ret, &base1, &posE1, &base2, &posE2, &m, pctx, mont.get()))
+        throw bignum_error("CBigNum::pow_mod2 : BN_mod_exp2_mont failed");
+    return ret;
+}
+
+/**
+ * Powers of a fixed base modulo an odd modulus. The base raised to every window value at every window position of the
+ * exponent is computed once, an exponentiation then takes one Montgomery multiplication per window of the exponent
+ * and no squarings. Exponents are reduced modulo the order of the base, exponents that don't fit into the table after
+ * that are passed to pow_mod. The table is only read after construction, so it can be shared between threads
+ */
+class CBigNumFixedBase
+{
+private:
+    static const int nWindowBits = 4;
+    static const int nWindowValues = (1 << nWindowBits) - 1;
+
+    CBigNum base;
+    CBigNum modulus;
+    CBigNum order;
+    const CBigNumMontgomeryContext& mont;
+    int nWindows;
+    //! base^(j * 2^(nWindowBits*i)) in Montgomery form at index i*nWindowValues + j-1
+    std::vector<CBigNum> table;
+
+public:
+    /**
+     * @param base the base
+     * @param modulus odd modulus
+     * @param order order of the base modulo the modulus, exponents are reduced modulo it
+     * @param mont Montgomery context of the modulus, must outlive the table
+     */
+    CBigNumFixedBase(const CBigNum& base, const CBigNum& modulus, const CBigNum& order, const CBigNumMontgomeryContext& mont)
+        : base(base), modulus(modulus), order(order), mont(mont)
+    {
+        CAutoBN_CTX pctx;
+
+        nWindows = (order.bitSize() + nWindowBits - 1) / nWindowBits;
+        table.resize(nWindows * nWindowValues);
+
+        // base^(2^(nWindowBits*i)) in Montgomery form
+        CBigNum power = base % modulus;
+        if (!BN_to_montgomery(&power, &power, mont.get(), pctx))
+            throw bignum_error("CBigNumFixedBase : BN_to_montgomery failed");
+
+        for (int i = 0; i < nWindows; i++) {
+            int nRow = i * nWindowValues;
+            table[nRow] = power;
+            for (int j = 1; j < nWindowValues; j++) {
+                if (!BN_mod_mul_montgomery(&table[nRow + j], &table[nRow + j - 1], &power, mont.get(), pctx))
+                    throw bignum_error("CBigNumFixedBase : BN_mod_mul_montgomery failed");
+            }
+            if (!BN_mod_mul_montgomery(&power, &table[nRow + nWindowValues - 1], &power, mont.get(), pctx))
+                throw bignum_error("CBigNumFixedBase : BN_mod_mul_montgomery failed");
+        }
+    }
+
+    /**
+     * modular exponentiation: base^e mod modulus
+     * @param e exponent
+     */
+    CBigNum pow_mod(const CBigNum& e) const
+    {
+        CAutoBN_CTX pctx;
+
+        CBigNum exponent = e;
+        if (order > 0 && !BN_nnmod(&exponent, &e, &order, pctx))
+            throw bignum_error("CBigNumFixedBase::pow_mod : BN_nnmod failed");
+        if (exponent < 0 || exponent.bitSize() > nWindows * nWindowBits)
+            return base.pow_mod(e, modulus, mont);
+
+        CBigNum result;
+        bool fEmpty = true;
+        for (int i = 0; i < nWindows; i++) {
+            int nValue = 0;
+            for (int bit = nWindowBits - 1; bit >= 0; bit--)
+                nValue = (nValue << 1) | BN_is_bit_set(&exponent, i * nWindowBits + bit);
+            if (nValue == 0)
+                continue;
+
+            const CBigNum& power = table[i * nWindowValues + nValue - 1];
+            if (fEmpty) {
+                result = power;
+                fEmpty = false;
+            } else if (!BN_mod_mul_montgomery(&result, &result, &power, mont.get(), pctx)) {
+                throw bignum_error("CBigNumFixedBase::pow_mod : BN_mod_mul_montgomery failed");
+            }
+        }
+
+        if (fEmpty)
+            return CBigNum(1) % modulus;
+
+        if (!BN_from_montgomery(&result, &result, mont.get(), pctx))
+            throw bignum_error("CBigNumFixedBase::pow_mod : BN_from_montgomery failed");
+        return result;
+    }
+};
+
 typedef CBigNum Bignum;
 
 #endif
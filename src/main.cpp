@@ -97,6 +97,7 @@ bool fCheckBlockIndex = false;
 bool fCheckpointsEnabled = DEFAULT_CHECKPOINTS_ENABLED;
 size_t nCoinCacheUsage = 5000 * 300;
 uint64_t nPruneTarget = 0;
+int nMTPDataPruneDepth = DEFAULT_MTP_DATA_PRUNE_DEPTH;
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
 bool fEnableReplacement = DEFAULT_ENABLE_REPLACEMENT;
 
@@ -1749,6 +1750,32 @@ bool AcceptToMemoryPool(
     return res;
 }
 
+static bool ReadTransactionFromDisk(const uint256 &hash, const CDiskTxPos &postx, CTransaction &txOut, uint256 &hashBlock) {
+    int nType;
+    CAutoFile file(OpenBlockRecord(postx, nType), nType, CLIENT_VERSION);
+    if (file.IsNull())
+        return error("%s: OpenBlockFile failed", __func__);
+    CBlockHeader header;
+    try {
+        file >> header;
+        fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
+        file >> txOut;
+    } catch (const std::exception &e) {
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+    hashBlock = header.GetHash();
+    if (txOut.GetHash() != hash)
+        return error("%s: txid mismatch", __func__);
+    return true;
+}
+
+bool ReadTransactionFromTxIndex(const uint256 &hash, CTransaction &txOut, uint256 &hashBlock) {
+    CDiskTxPos postx;
+    if (!fTxIndex || !pblocktree->ReadTxIndex(hash, postx))
+        return false;
+    return ReadTransactionFromDisk(hash, postx, txOut, hashBlock);
+}
+
 /** Return transaction in txOut, and if it was found inside a block, its hash is placed in hashBlock */
 bool
 GetTransaction(const uint256 &hash, CTransaction &txOut, const Consensus::Params &consensusParams, uint256 &hashBlock,
@@ -1765,23 +1792,8 @@ GetTransaction(const uint256 &hash, CTransaction &txOut, const Consensus::Params
 
     if (fTxIndex) {
         CDiskTxPos postx;
-        if (pblocktree->ReadTxIndex(hash, postx)) {
-            CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-            if (file.IsNull())
-                return error("%s: OpenBlockFile failed", __func__);
-            CBlockHeader header;
-            try {
-                file >> header;
-                fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-                file >> txOut;
-            } catch (const std::exception &e) {
-                return error("%s: Deserialize or I/O error - %s", __func__, e.what());
-            }
-            hashBlock = header.GetHash();
-            if (txOut.GetHash() != hash)
-                return error("%s: txid mismatch", __func__);
-            return true;
-        }
+        if (pblocktree->ReadTxIndex(hash, postx))
+            return ReadTransactionFromDisk(hash, postx, txOut, hashBlock);
     }
 
     if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
@@ -1863,6 +1875,43 @@ bool GetAddressUnspent(uint160 addressHash, AddressType type,
     return true;
 }
 
+bool GetAddressIndex(uint160 addressHash, AddressType type,
+                     boost::function<bool (const CAddressIndexKey&, CAmount)> visitor,
+                     int start, int end, const CAddressIndexKey *pfrom)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressIndex(addressHash, type, visitor, start, end, pfrom))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool GetAddressUnspent(uint160 addressHash, AddressType type,
+                       boost::function<bool (const CAddressUnspentKey&, const CAddressUnspentValue&)> visitor,
+                       const CAddressUnspentKey *pfrom)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, visitor, pfrom))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool GetAddressBalance(uint160 addressHash, AddressType type, CAddressBalanceValue &value)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressBalance(addressHash, type, value))
+        return error("unable to get balance for address");
+
+    return true;
+}
+
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1870,15 +1919,16 @@ bool GetAddressUnspent(uint160 addressHash, AddressType type,
 // CBlock and CBlockIndex
 //
 
-bool WriteBlockToDisk(const CBlock &block, CDiskBlockPos &pos, const CMessageHeader::MessageStartChars &messageStart) {
+bool WriteBlockToDisk(const CBlock &block, CDiskBlockPos &pos, const CMessageHeader::MessageStartChars &messageStart, bool fWithoutMTPData) {
     // Open history file to append
-    CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
+    CAutoFile fileout(OpenBlockFile(pos), fWithoutMTPData ? SER_DISK | SER_WITHOUT_MTP_DATA : SER_DISK, CLIENT_VERSION);
     if (fileout.IsNull())
         return error("WriteBlockToDisk: OpenBlockFile failed");
 
-    // Write index header
+    // Write index header. Flag in the size tells readers how the block is stored
     unsigned int nSize = fileout.GetSerializeSize(block);
-    fileout << FLATDATA(messageStart) << nSize;
+    unsigned int nRecordSize = fWithoutMTPData ? nSize | BLOCK_RECORD_WITHOUT_MTP_DATA : nSize;
+    fileout << FLATDATA(messageStart) << nRecordSize;
 
     // Write block
     long fileOutPos = ftell(fileout.Get());
@@ -1889,11 +1939,36 @@ bool WriteBlockToDisk(const CBlock &block, CDiskBlockPos &pos, const CMessageHea
     return true;
 }
 
+FILE *OpenBlockRecord(const CDiskBlockPos &pos, int &nType) {
+    nType = SER_DISK;
+    if (pos.nPos < sizeof(uint32_t))
+        return NULL;
+
+    // Size of the block record is stored right before the block
+    CAutoFile filein(OpenBlockFile(CDiskBlockPos(pos.nFile, pos.nPos - sizeof(uint32_t)), true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return NULL;
+
+    uint32_t nRecordSize;
+    try {
+        filein >> nRecordSize;
+    }
+    catch (const std::exception &e) {
+        LogPrintf("%s: Deserialize or I/O error - %s at %s\n", __func__, e.what(), pos.ToString());
+        return NULL;
+    }
+
+    if (nRecordSize & BLOCK_RECORD_WITHOUT_MTP_DATA)
+        nType |= SER_WITHOUT_MTP_DATA;
+    return filein.release();
+}
+
 bool ReadBlockFromDisk(CBlock &block, const CDiskBlockPos &pos, int nHeight, const Consensus::Params &consensusParams) {
     block.SetNull();
 
     // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+    int nType;
+    CAutoFile filein(OpenBlockRecord(pos, nType), nType, CLIENT_VERSION);
     if (filein.IsNull())
         return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
 
@@ -1906,7 +1981,9 @@ bool ReadBlockFromDisk(CBlock &block, const CDiskBlockPos &pos, int nHeight, con
     }
 
     // Zcoin - MTP
-    if (!CheckMerkleTreeProof(block, consensusParams)){
+    // Proof pruned from the block file was verified before the block was written
+    block.fMTPDataPruned = (nType & SER_WITHOUT_MTP_DATA) != 0;
+    if (!block.fMTPDataPruned && !CheckMerkleTreeProof(block, consensusParams)){
     	return error("ReadBlockFromDisk: CheckMerkleTreeProof: Errors in block header at %s", pos.ToString());
     }
 
@@ -2418,6 +2495,41 @@ static bool ApplyTxInUndo(const CTxInUndo &undo, CCoinsViewCache &view, const CO
     return fClean;
 }
 
+/** Apply the coinbase subsidy and the zerocoin mints and spends of the block to the supply in the block index database */
+static bool ApplyBlockToSupply(const CBlock &block, const CBlockIndex *pindex, CAmount nSubsidy, bool fConnect,
+                               bool *pfFollows = NULL) {
+    vector<pair<CBigNum, int> > spends;
+    vector<int> mints;
+    ZerocoinGetSupplyChanges(block, spends, mints);
+    return pblocktree->UpdateSupply(pindex->GetBlockHash(), pindex->pprev->GetBlockHash(), nSubsidy, spends, mints,
+                                    fConnect, pfFollows);
+}
+
+static bool RebuildSupply(const CChainParams &chainparams, const CBlockIndex *pindexLast);
+
+/** Set when the supply couldn't be calculated, it's not attempted again until restart */
+static bool fSupplyUnavailable = false;
+
+/** Same, if the block doesn't follow the supply it's calculated again for the chain ending with the block */
+static bool UpdateSupply(const CBlock &block, const CBlockIndex *pindex, CAmount nSubsidy, bool fConnect) {
+    bool fFollows = true;
+    if (!ApplyBlockToSupply(block, pindex, nSubsidy, fConnect, &fFollows))
+        return false;
+
+    if (!fFollows && !fSupplyUnavailable) {
+        LogPrintf("%s: calculating the supply...\n", __func__);
+        if (!RebuildSupply(Params(), pindex->pprev)) {
+            LogPrintf("%s: the supply is not available, blocks are pruned or can't be read. Use -reindex to calculate it\n", __func__);
+            fSupplyUnavailable = true;
+            return true;
+        }
+        if (fConnect)
+            return ApplyBlockToSupply(block, pindex, nSubsidy, true);
+    }
+
+    return true;
+}
+
 bool DisconnectBlock(const CBlock &block, CValidationState &state, const CBlockIndex *pindex, CCoinsViewCache &view,
                      bool *pfClean) {
     assert(pindex->GetBlockHash() == view.GetBestBlock());
@@ -2500,10 +2612,10 @@ bool DisconnectBlock(const CBlock &block, CValidationState &state, const CBlockI
                 AbortNode(state, "Failed to write address unspent index");
                 return error("Failed to write address unspent index");
             }
-            if (!pblocktree->AddTotalSupply(-(block.vtx[0].GetValueOut() - nFees))) {
-                AbortNode(state, "Failed to write total supply");
-                return error("Failed to write total supply");
-            }
+        }
+        if (!UpdateSupply(block, pindex, block.vtx[0].GetValueOut() - nFees, false)) {
+            AbortNode(state, "Failed to write total supply");
+            return error("Failed to write total supply");
         }
     }
 
@@ -2541,11 +2653,6 @@ bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigne
 
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
-void ThreadScriptCheck() {
-    RenameThread("bitcoin-scriptch");
-    scriptcheckqueue.Thread();
-}
-
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2829,6 +2936,11 @@ bool ConnectBlock(const CBlock &block, CValidationState &state, CBlockIndex *pin
         pos.nTxOffset += ::GetSerializeSize(tx, SER_DISK, CLIENT_VERSION);
     }
 
+    // Proofs of zerocoin spends collected by the stateful checks above are verified all at once
+    if (!block.zerocoinTxInfo->VerifySpends())
+        return state.DoS(100, error("ConnectBlock(): zerocoin spend verification failed"),
+                         REJECT_INVALID, "bad-txns-zerocoin");
+
     block.zerocoinTxInfo->Complete();
 
     int64_t nTime3 = GetTimeMicros();
@@ -2868,6 +2980,9 @@ bool ConnectBlock(const CBlock &block, CValidationState &state, CBlockIndex *pin
     nTimeVerify += nTime4 - nTime2;
     LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime4 - nTime2),
              nInputs <= 1 ? 0 : 0.001 * (nTime4 - nTime2) / (nInputs - 1), nTimeVerify * 0.000001);
+    CExecutor::Stats executorStats = GetExecutor().GetStats();
+    LogPrint("bench", "    - Executor: %d threads, queue depth %u, %u tasks executed, %u stolen\n", executorStats.nThreads,
+             executorStats.nQueueDepth, executorStats.nExecuted, executorStats.nStolen);
 
     if (!fJustCheck)
         MTPState::GetMTPState()->SetLastBlock(pindex, chainparams.GetConsensus());
@@ -2878,6 +2993,9 @@ bool ConnectBlock(const CBlock &block, CValidationState &state, CBlockIndex *pin
     if (fJustCheck)
         return true;
 
+    // ConnectBlockZC may have changed BLOCK_HAVE_ZEROCOIN flag
+    setDirtyBlockIndex.insert(pindex);
+
     // Write undo information to disk
     if (pindex->GetUndoPos().IsNull() || !pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
         if (pindex->GetUndoPos().IsNull()) {
@@ -2905,11 +3023,11 @@ bool ConnectBlock(const CBlock &block, CValidationState &state, CBlockIndex *pin
 
         if (!pblocktree->UpdateAddressUnspentIndex(dbIndexHelper.getAddressUnspentIndex()))
             return AbortNode(state, "Failed to write address unspent index");
-
-        if (!pblocktree->AddTotalSupply(block.vtx[0].GetValueOut() - nFees))
-            return AbortNode(state, "Failed to write total supply");
     }
 
+    if (!UpdateSupply(block, pindex, block.vtx[0].GetValueOut() - nFees, true))
+        return AbortNode(state, "Failed to write total supply");
+
     if (fSpentIndex)
         if (!pblocktree->UpdateSpentIndex(dbIndexHelper.getSpentIndex()))
             return AbortNode(state, "Failed to write transaction index");
@@ -3052,9 +3170,16 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode) {
                     vBlocks.push_back(*it);
                     setDirtyBlockIndex.erase(it++);
                 }
-                if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks)) {
+                std::vector<std::pair<uint256, std::shared_ptr<const CZerocoinBlockData> > > vZerocoinData;
+                ZerocoinGetDirtyBlockData(vZerocoinData);
+                std::vector<std::pair<uint256, const CZerocoinBlockData *> > vZerocoinBlocks;
+                vZerocoinBlocks.reserve(vZerocoinData.size());
+                for (const auto &zerocoinData: vZerocoinData)
+                    vZerocoinBlocks.push_back(make_pair(zerocoinData.first, zerocoinData.second.get()));
+                if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks, vZerocoinBlocks)) {
                     return AbortNode(state, "Files to write to block index database");
                 }
+                ZerocoinBlockDataFlushed(vZerocoinData);
             }
             // Finally remove any pruned files
             if (fFlushForPrune)
@@ -3191,7 +3316,8 @@ bool static DisconnectTip(CValidationState &state, const CChainParams &chainpara
     }
     LogPrint("bench", "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
 
-	DisconnectTipZC(block, pindexDelete);
+    if (!DisconnectTipZC(block, pindexDelete))
+        return AbortNode(state, "Failed to read zerocoin data of the disconnected block");
     // Roll back MTP state
     MTPState::GetMTPState()->SetLastBlock(pindexDelete->pprev, chainparams.GetConsensus());
 
@@ -4108,7 +4234,7 @@ bool CheckBlock(const CBlock &block, CValidationState &state,
             }
 
                 // Zcoin - MTP
-            if (block.IsMTP() && !CheckMerkleTreeProof(block, consensusParams))
+            if (block.IsMTP() && !block.fMTPDataPruned && !CheckMerkleTreeProof(block, consensusParams))
                 return state.DoS(100, false, REJECT_INVALID, "bad-diffbits", false, "incorrect proof of work");
         }
 
@@ -4513,14 +4639,18 @@ AcceptBlock(const CBlock &block, CValidationState &state, const CChainParams &ch
 
     // Write block to history file
     try {
-        unsigned int nBlockSize = ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+        // Zcoin - MTP
+        // Proof of a block deep enough below the best header has been verified and won't be served to peers
+        bool fWithoutMTPData = block.IsMTP() && nMTPDataPruneDepth > 0 && pindexBestHeader != NULL &&
+                pindexBestHeader->nHeight - nHeight >= nMTPDataPruneDepth;
+        unsigned int nBlockSize = ::GetSerializeSize(block, fWithoutMTPData ? SER_DISK | SER_WITHOUT_MTP_DATA : SER_DISK, CLIENT_VERSION);
         CDiskBlockPos blockPos;
         if (dbp != NULL)
             blockPos = *dbp;
         if (!FindBlockPos(state, blockPos, nBlockSize + 8, nHeight, block.GetBlockTime(), dbp != NULL))
             return error("AcceptBlock(): FindBlockPos failed");
         if (dbp == NULL)
-            if (!WriteBlockToDisk(block, blockPos, chainparams.MessageStart()))
+            if (!WriteBlockToDisk(block, blockPos, chainparams.MessageStart(), fWithoutMTPData))
                 AbortNode(state, "Failed to write block");
         if (!ReceivedBlockTransactions(block, state, pindex, blockPos))
             return error("AcceptBlock(): ReceivedBlockTransactions failed");
@@ -4774,6 +4904,50 @@ CBlockIndex *InsertBlockIndex(uint256 hash) {
     return pindexNew;
 }
 
+/** Compute the supply of the chain up to pindexLast, for a block index database created before the supply was
+ * maintained or a supply which doesn't follow the chain */
+static bool RebuildSupply(const CChainParams &chainparams, const CBlockIndex *pindexLast) {
+    if (!pblocktree->ResetSupply())
+        return error("%s: failed to reset the supply", __func__);
+
+    // The genesis block is not connected and doesn't contribute to the supply
+    for (int nHeight = 1; nHeight <= pindexLast->nHeight; nHeight++) {
+        boost::this_thread::interruption_point();
+
+        const CBlockIndex *pindex = pindexLast->GetAncestor(nHeight);
+
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
+            return error("%s: failed to read block %s", __func__, pindex->GetBlockHash().ToString());
+
+        CBlockUndo blockUndo;
+        CDiskBlockPos pos = pindex->GetUndoPos();
+        if (pos.IsNull() || !UndoReadFromDisk(blockUndo, pos, pindex->pprev->GetBlockHash()) ||
+                blockUndo.vtxundo.size() + 1 != block.vtx.size())
+            return error("%s: failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+
+        // Same fees as in ConnectBlock, the inputs are taken from the undo data
+        CAmount nFees = 0;
+        for (unsigned int i = 1; i < block.vtx.size(); i++) {
+            const CTransaction &tx = block.vtx[i];
+            if (tx.IsZerocoinSpend())
+                continue;
+            BOOST_FOREACH(const CTxInUndo &undo, blockUndo.vtxundo[i - 1].vprevout) {
+                nFees += undo.txout.nValue;
+            }
+            nFees -= tx.GetValueOut();
+        }
+
+        if (!ApplyBlockToSupply(block, pindex, block.vtx[0].GetValueOut() - nFees, true))
+            return error("%s: failed to write the supply", __func__);
+
+        if (pindex->nHeight % 1000 == 0)
+            uiInterface.InitMessage(strprintf(_("Calculating the supply... (block %d of %d)"), pindex->nHeight, pindexLast->nHeight));
+    }
+
+    return pblocktree->WriteFlag("supply", true);
+}
+
 bool static LoadBlockIndexDB() {
     LogPrintf("LoadBlockIndexDB\n");
     const CChainParams &chainparams = Params();
@@ -4877,6 +5051,17 @@ bool static LoadBlockIndexDB() {
     pblocktree->ReadFlag("addressindex", fAddressIndex);
     LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
 
+    // Sum up the balances of an address index, which was created before the balances were maintained
+    if (fAddressIndex) {
+        bool fAddressBalances = false;
+        pblocktree->ReadFlag("addressbalances", fAddressBalances);
+        if (!fAddressBalances) {
+            LogPrintf("%s: building address balances...\n", __func__);
+            if (!pblocktree->RebuildAddressBalances() || !pblocktree->WriteFlag("addressbalances", true))
+                return error("%s: failed to build address balances", __func__);
+        }
+    }
+
     // Check whether we have a timestamp index
     pblocktree->ReadFlag("timestampindex", fTimestampIndex);
     LogPrintf("%s: timestamp index %s\n", __func__, fTimestampIndex ? "enabled" : "disabled");
@@ -4898,14 +5083,39 @@ bool static LoadBlockIndexDB() {
 
     // some blocks in index can change as a result of ZerocoinBuildStateFromIndex() call
     set<CBlockIndex *> changes;
-    ZerocoinBuildStateFromIndex(&chainActive, changes);
+    if (!ZerocoinBuildStateFromIndex(&chainActive, changes))
+        return error("LoadBlockIndexDB: failed to build zerocoin state");
     if (!changes.empty()) {
         setDirtyBlockIndex.insert(changes.begin(), changes.end());
         FlushStateToDisk();
     }
+    // Recalculated accumulators are on disk now, remember the tip so the next start skips the verified coin groups
+    pblocktree->WriteZerocoinVerifiedBlock(chainActive.Tip()->GetBlockHash());
     // Initialize MTP state
     MTPState::GetMTPState()->InitializeFromChain(&chainActive, chainparams.GetConsensus());
 
+    // The supply is maintained as blocks are connected and disconnected, older databases need a scan of the chain once
+    bool fSupply = false;
+    pblocktree->ReadFlag("supply", fSupply);
+    if (fSupply) {
+        // After a crash the supply can be ahead of the chainstate. The block after the tip is not counted twice when
+        // it's connected again, the supply is recalculated when it's further ahead. An empty supply is only valid
+        // at the genesis block
+        CZerocoinSupply supply;
+        pblocktree->ReadZerocoinSupply(supply);
+        BlockMap::const_iterator mi = mapBlockIndex.find(supply.hashBlock);
+        if (supply.hashBlock.IsNull() ? chainActive.Tip() != chainActive.Genesis() : (mi == mapBlockIndex.end() ||
+                (mi->second != chainActive.Tip() && mi->second->pprev != chainActive.Tip())))
+            fSupply = false;
+    }
+    if (!fSupply) {
+        LogPrintf("%s: calculating the supply...\n", __func__);
+        if (!RebuildSupply(chainparams, chainActive.Tip())) {
+            fSupplyUnavailable = true;
+            LogPrintf("%s: the supply is not available, blocks are pruned or can't be read. Use -reindex to calculate it\n", __func__);
+        }
+    }
+
     LogPrintf("%s: hashBestChain=%s height=%d date=%s progress=%f\n", __func__,
               chainActive.Tip()->GetBlockHash().ToString(), chainActive.Height(),
               DateTimeStrFormat("%Y-%m-%d %H:%M:%S", chainActive.Tip()->GetBlockTime()),
@@ -5178,6 +5388,9 @@ bool InitBlockIndex(const CChainParams &chainparams) {
     // Use the provided setting for -addressindex in the new database
     fAddressIndex = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
     pblocktree->WriteFlag("addressindex", fAddressIndex);
+    // The balances of the address index and the supply are maintained from the start
+    pblocktree->WriteFlag("addressbalances", true);
+    pblocktree->WriteFlag("supply", true);
 
     fSpentIndex = GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
     pblocktree->WriteFlag("spentindex", fSpentIndex);
@@ -5228,6 +5441,7 @@ bool LoadExternalBlockFile(const CChainParams &chainparams, FILE *fileIn, CDiskB
             nRewind++; // start one byte further next time, in case of failure
             blkdat.SetLimit(); // remove former limit
             unsigned int nSize = 0;
+            bool fWithoutMTPData = false;
             try {
                 // locate a header
                 unsigned char buf[MESSAGE_START_SIZE];
@@ -5238,8 +5452,14 @@ bool LoadExternalBlockFile(const CChainParams &chainparams, FILE *fileIn, CDiskB
                     continue;
                 // read size
                 blkdat >> nSize;
+                fWithoutMTPData = (nSize & BLOCK_RECORD_WITHOUT_MTP_DATA) != 0;
+                nSize &= ~BLOCK_RECORD_WITHOUT_MTP_DATA;
                 if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
                     continue;
+                // Zcoin - MTP
+                // Blocks without MTP proof are only accepted from our own block files
+                if (fWithoutMTPData && dbp == NULL)
+                    continue;
             } catch (const std::exception &) {
                 // no valid block header found; don't complain
                 break;
@@ -5252,7 +5472,8 @@ bool LoadExternalBlockFile(const CChainParams &chainparams, FILE *fileIn, CDiskB
                 blkdat.SetLimit(nBlockPos + nSize);
                 blkdat.SetPos(nBlockPos);
                 CBlock block;
-                blkdat >> block;
+                ::Unserialize(blkdat, block, fWithoutMTPData ? SER_DISK | SER_WITHOUT_MTP_DATA : SER_DISK, CLIENT_VERSION);
+                block.fMTPDataPruned = fWithoutMTPData;
                 nRewind = blkdat.GetPos();
 
                 // detect out of order blocks, and store them for later
@@ -5737,7 +5958,14 @@ void static ProcessGetData(CNode *pfrom, const Consensus::Params &consensusParam
                     CBlock block;
                     if (!ReadBlockFromDisk(block, (*mi).second, consensusParams))
                         assert(!"cannot load block from disk");
-                    if (inv.type == MSG_BLOCK)
+                    // Zcoin - MTP
+                    // Block without MTP proof data can't be deserialized by the peer, let it ask someone else
+                    if (block.fMTPDataPruned) {
+                        LogPrint("net", "%s: block %s requested by peer=%i has no MTP data\n",
+                                __func__, inv.hash.ToString(), pfrom->GetId());
+                        vNotFound.push_back(inv);
+                    }
+                    else if (inv.type == MSG_BLOCK)
                         pfrom->PushMessageWithFlag(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::BLOCK, block);
                     else if (inv.type == MSG_WITNESS_BLOCK)
                         pfrom->PushMessage(NetMsgType::BLOCK, block);
@@ -7163,6 +7391,38 @@ bool static ProcessMessage(CNode *pfrom, string strCommand,
             ReadCompactSize(vRecv); // ignore tx count; assume it is 0.
         }
 
+        // Calculate PoW hashes of pre-MTP headers in parallel without holding cs_main. AcceptBlockHeader
+        // finds them in the PoW hash cache then. A sequence that doesn't chain together is rejected below without
+        // any PoW check, and headers known already are accepted without one
+        if (nCount > 1 && !headers.front().IsMTP()) {
+            std::vector<uint256> hashes(nCount);
+            bool fContinuous = true;
+            for (unsigned int n = 0; n < nCount && fContinuous; n++) {
+                hashes[n] = headers[n].GetHash();
+                fContinuous = n == 0 || headers[n].hashPrevBlock == hashes[n-1];
+            }
+
+            std::vector<CBlockHeader> newHeaders;
+            std::vector<int> nHeights;
+            if (fContinuous) {
+                LOCK(cs_main);
+                BlockMap::iterator mi = mapBlockIndex.find(headers[0].hashPrevBlock);
+                if (mi != mapBlockIndex.end()) {
+                    int nPrevHeight = mi->second->nHeight;
+                    for (unsigned int n = 0; n < nCount; n++) {
+                        if (mapBlockIndex.count(hashes[n]) == 0) {
+                            newHeaders.push_back(headers[n]);
+                            nHeights.push_back(nPrevHeight + 1 + n);
+                        }
+                    }
+                }
+            }
+            if (newHeaders.size() > 1) {
+                std::vector<uint256> powHashes;
+                CalculatePoWHashes(newHeaders, nHeights, powHashes);
+            }
+        }
+
         {
             LOCK(cs_main);
 
@@ -32,6 +32,7 @@
 #include <vector>
 #include "libzerocoin/Zerocoin.h"
 
+#include <boost/function.hpp>
 #include <boost/unordered_map.hpp>
 
 class CBlockIndex;
@@ -230,6 +231,12 @@ extern uint64_t nPruneTarget;
 /** Block files containing a block-height within MIN_BLOCKS_TO_KEEP of chainActive.Tip() will not be pruned. */
 static const unsigned int MIN_BLOCKS_TO_KEEP = 288;
 
+/** Zcoin - MTP: blocks at least that deep below the best header are written without MTP proof data, 0 = never */
+extern int nMTPDataPruneDepth;
+static const int DEFAULT_MTP_DATA_PRUNE_DEPTH = 0;
+/** Bit set in the size of a block record in blk*.dat if the block is stored without MTP proof data */
+static const unsigned int BLOCK_RECORD_WITHOUT_MTP_DATA = 0x80000000;
+
 static const signed int DEFAULT_CHECKBLOCKS = 6;
 static const unsigned int DEFAULT_CHECKLEVEL = 3;
 
@@ -265,6 +272,8 @@ bool ProcessNewBlock(CValidationState& state, const CChainParams& chainparams, C
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
 /** Open a block file (blk?????.dat) */
 FILE* OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly = false);
+/** Open a block file at the block stored at pos (read-only). nType is set to the serialization type of the block */
+FILE* OpenBlockRecord(const CDiskBlockPos &pos, int &nType);
 /** Open an undo file (rev?????.dat) */
 FILE* OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 /** Translation to a filesystem path */
@@ -285,8 +294,6 @@ bool ProcessMessages(CNode* pfrom);
  * @param[in]   pto             The node which we are sending messages to.
  */
 bool SendMessages(CNode* pto);
-/** Run an instance of the script checking thread */
-void ThreadScriptCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Format a string that describes several potential problems detected by the core.
@@ -299,6 +306,8 @@ bool IsInitialBlockDownload();
 std::string GetWarnings(const std::string& strFor);
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
 bool GetTransaction(const uint256 &hash, CTransaction &tx, const Consensus::Params& params, uint256 &hashBlock, bool fAllowSlow = false);
+/** Read confirmed transaction using the transaction index only. Doesn't need cs_main */
+bool ReadTransactionFromTxIndex(const uint256 &hash, CTransaction &txOut, uint256 &hashBlock);
 /** Find the best known block, and make it the tip of the block chain */
 bool ActivateBestChain(CValidationState& state, const CChainParams& chainparams, const CBlock* pblock = NULL);
 CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams, int nTime = 1475020800);
@@ -504,9 +513,18 @@ bool GetAddressIndex(uint160 addressHash, AddressType type,
                      int start = 0, int end = 0);
 bool GetAddressUnspent(uint160 addressHash, AddressType type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
+/** Streams the address index entries to the visitor, until it returns false, optionally starting at the entry pfrom */
+bool GetAddressIndex(uint160 addressHash, AddressType type,
+                     boost::function<bool (const CAddressIndexKey&, CAmount)> visitor,
+                     int start = 0, int end = 0, const CAddressIndexKey *pfrom = NULL);
+bool GetAddressUnspent(uint160 addressHash, AddressType type,
+                       boost::function<bool (const CAddressUnspentKey&, const CAddressUnspentValue&)> visitor,
+                       const CAddressUnspentKey *pfrom = NULL);
+/** Returns the balance and the total received amount of an address, which are maintained along with the address index */
+bool GetAddressBalance(uint160 addressHash, AddressType type, CAddressBalanceValue &value);
 
 /** Functions for disk access for blocks */
-bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
+bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart, bool fWithoutMTPData = false);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
 
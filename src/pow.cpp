@@ -142,6 +142,32 @@ bool CheckMerkleTreeProof(const CBlockHeader &block, const Consensus::Params &pa
     return true;
 }
 
+bool CheckMerkleTreeProofs(const std::vector<const CBlockHeader*> &blocks, const Consensus::Params &params, std::vector<bool> &results) {
+    std::vector<const CBlockHeader*> mtpBlocks;
+    BOOST_FOREACH(const CBlockHeader *block, blocks) {
+        if (block->IsMTP())
+            mtpBlocks.push_back(block);
+    }
+
+    std::vector<bool> mtpResults;
+    std::vector<uint256> calculatedMtpHashValues;
+    mtp::verify(mtpBlocks, params.powLimit, mtpResults, &calculatedMtpHashValues);
+
+    bool fAllVerified = true;
+    results.resize(blocks.size());
+    for (size_t i = 0, j = 0; i < blocks.size(); i++) {
+        if (!blocks[i]->IsMTP()) {
+            results[i] = true;
+            continue;
+        }
+        results[i] = mtpResults[j] && blocks[i]->mtpHashValue == calculatedMtpHashValues[j];
+        fAllVerified = fAllVerified && results[i];
+        j++;
+    }
+
+    return fAllVerified;
+}
+
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params &params) {
     bool fNegative;
     bool fOverflow;
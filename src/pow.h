@@ -9,6 +9,7 @@
 #include "consensus/params.h"
 
 #include <stdint.h>
+#include <vector>
 
 class CBlockHeader;
 
@@ -28,5 +29,7 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params
 
 // Zcoin - MTP
 bool CheckMerkleTreeProof(const CBlockHeader &block, const Consensus::Params &params);
+/** Verify MTP proofs of several blocks. Returns true if all of them are valid */
+bool CheckMerkleTreeProofs(const std::vector<const CBlockHeader*> &blocks, const Consensus::Params &params, std::vector<bool> &results);
 
 #endif // BITCOIN_POW_H
@@ -17,12 +17,14 @@
 #include "crypto/Lyra2Z/Lyra2.h"
 #include "crypto/MerkleTreeProof/mtp.h"
 #include "util.h"
+#include "executor.h"
 #include <iostream>
 #include <chrono>
 #include <fstream>
 #include <algorithm>
 #include <string>
 #include "precomputed_hash.h"
+#include "powhashcache.h"
 
 
 
@@ -61,24 +63,22 @@ uint256 CBlockHeader::GetPoWHash(int nHeight, bool forceCalc) const {
 //    int64_t start = std::chrono::duration_cast<std::chrono::milliseconds>(
 //            std::chrono::system_clock::now().time_since_epoch()).count();
     bool fTestNet = (Params().NetworkIDString() == CBaseChainParams::TESTNET);
-    if (!fTestNet) {
-        if (nHeight < 20500) {
-            if (!mapPoWHash.count(1)) {
-//            std::cout << "Start Build Map" << std::endl;
-                buildMapPoWHash();
-            }
-        }
-        if (!forceCalc && mapPoWHash.count(nHeight)) {
-//        std::cout << "GetPowHash nHeight=" << nHeight << ", hash= " << mapPoWHash[nHeight].ToString() << std::endl;
-            return mapPoWHash[nHeight];
-        }
-    }
     uint256 powHash;
+    if (!fTestNet && !forceCalc && nHeight >= 1 && nHeight < 20500) {
+        memcpy(powHash.begin(), precomputedPoWHash[nHeight-1], powHash.size());
+        return powHash;
+    }
+
     // Zcoin - MTP
+    if (IsMTP())
+        return mtpHashValue;
+
+    uint256 headerHash = GetHash();
+    if (!forceCalc && powHashCache.Get(nHeight, headerHash, powHash))
+        return powHash;
+
     try {
-    	if (IsMTP()) {
-            powHash = mtpHashValue;
-		} else if (!fTestNet && nHeight >= HF_LYRA2Z_HEIGHT) {
+		if (!fTestNet && nHeight >= HF_LYRA2Z_HEIGHT) {
             lyra2z_hash(BEGIN(nVersion), BEGIN(powHash));
         } else if (!fTestNet && nHeight >= HF_LYRA2_HEIGHT) {
             LYRA2(BEGIN(powHash), 32, BEGIN(nVersion), 80, BEGIN(nVersion), 80, 2, 8192, 256);
@@ -100,14 +100,32 @@ uint256 CBlockHeader::GetPoWHash(int nHeight, bool forceCalc) const {
 //    int64_t end = std::chrono::duration_cast<std::chrono::milliseconds>(
 //            std::chrono::system_clock::now().time_since_epoch()).count();
 //    std::cout << "GetPowHash nHeight=" << nHeight << ", hash= " << powHash.ToString() << " done in= " << (end - start) << " miliseconds" << std::endl;
-    mapPoWHash.insert(make_pair(nHeight, powHash));
+    powHashCache.Put(nHeight, headerHash, powHash);
 //    SetPoWHash(thash);
     return powHash;
 }
 
 void CBlockHeader::InvalidateCachedPoWHash(int nHeight) const {
-    if (nHeight >= 20500 && mapPoWHash.count(nHeight) > 0)
-        mapPoWHash.erase(nHeight);
+    if (nHeight >= 20500)
+        powHashCache.Erase(nHeight, GetHash());
+}
+
+void CalculatePoWHashes(const std::vector<CBlockHeader> &headers, const std::vector<int> &nHeights, std::vector<uint256> &powHashes) {
+    // Lyra2Z hash takes microseconds so every task processes a range of headers
+    const size_t nBatchSize = 16;
+
+    assert(headers.size() == nHeights.size());
+    powHashes.resize(headers.size());
+
+    CExecutorTaskGroup tasks;
+    for (size_t nStart = 0; nStart < headers.size(); nStart += nBatchSize) {
+        size_t nEnd = std::min(nStart + nBatchSize, headers.size());
+        tasks.Add([&headers, &nHeights, &powHashes, nStart, nEnd] {
+            for (size_t i = nStart; i < nEnd; i++)
+                powHashes[i] = headers[i].GetPoWHash(nHeights[i]);
+        });
+    }
+    tasks.Wait();
 }
 
 std::string CBlock::ToString() const {
@@ -37,7 +37,7 @@ class CMTPHashData {
 public:
     uint8_t hashRootMTP[16]; // 16 is 128 bit of blake2b
     uint64_t nBlockMTP[mtp::MTP_L*2][128]; // 128 is ARGON2_QWORDS_IN_BLOCK
-    std::deque<std::vector<uint8_t>> nProofMTP[mtp::MTP_L*3];
+    CMTPProofs nProofMTP;
 
     CMTPHashData() {
         memset(nBlockMTP, 0, sizeof(nBlockMTP));
@@ -46,7 +46,8 @@ public:
     ADD_SERIALIZE_METHODS;
 
     /**
-     * Custom serialization scheme is in place because of speed reasons
+     * Custom serialization scheme is in place because of speed reasons. Every proof is written
+     * as the number of nodes followed by the nodes themselves, straight from/to the proof buffer
      */
 
     // Function for write/getting size
@@ -54,15 +55,12 @@ public:
     inline void SerializationOp(Stream &s, Operation ser_action, int nType, int nVersion) {
         READWRITE(hashRootMTP);
         READWRITE(nBlockMTP);
-        for (int i = 0; i < mtp::MTP_L*3; i++) {
-            assert(nProofMTP[i].size() < 256);
-            uint8_t numberOfProofBlocks = (uint8_t)nProofMTP[i].size();
+        for (int i = 0; i < CMTPProofs::PROOF_COUNT; i++) {
+            assert(nProofMTP.GetProofSize(i) < 256);
+            uint8_t numberOfProofBlocks = (uint8_t)nProofMTP.GetProofSize(i);
             READWRITE(numberOfProofBlocks);
-            for (const std::vector<uint8_t> &mtpData: nProofMTP[i]) {
-                // data size should be 16 for each block
-                assert(mtpData.size() == 16);
-                s.write((const char *)mtpData.data(), 16);
-            }
+            if (numberOfProofBlocks > 0)
+                s.write((const char *)nProofMTP.GetProof(i), numberOfProofBlocks * CMTPProofs::NODE_SIZE);
         }
     }
 
@@ -71,14 +69,13 @@ public:
     inline void SerializationOp(Stream &s, CSerActionUnserialize ser_action, int nType, int nVersion) {
         READWRITE(hashRootMTP);
         READWRITE(nBlockMTP);
-        for (int i = 0; i < mtp::MTP_L*3; i++) {
+        nProofMTP.Clear();
+        for (int i = 0; i < CMTPProofs::PROOF_COUNT; i++) {
             uint8_t numberOfProofBlocks;
             READWRITE(numberOfProofBlocks);
-            for (uint8_t j=0; j<numberOfProofBlocks; j++) {
-                vector<uint8_t> mtpData(16, 0);
-                s.read((char *)mtpData.data(), 16);
-                nProofMTP[i].emplace_back(std::move(mtpData));
-            }
+            uint8_t *proof = nProofMTP.AppendProof(numberOfProofBlocks);
+            if (numberOfProofBlocks > 0)
+                s.read((char *)proof, numberOfProofBlocks * CMTPProofs::NODE_SIZE);
         }
     }
 };
@@ -137,11 +134,16 @@ public:
             READWRITE(reserved[0]);
             READWRITE(reserved[1]);
             if (ser_action.ForRead()) {
-                mtpHashData = make_shared<CMTPHashData>();
-                READWRITE(*mtpHashData);
+                if (!(nType & SER_WITHOUT_MTP_DATA)) {
+                    mtpHashData = make_shared<CMTPHashData>();
+                    READWRITE(*mtpHashData);
+                }
+                else {
+                    mtpHashData.reset();
+                }
             }
             else {
-                if (mtpHashData && !(nType & SER_GETHASH))
+                if (mtpHashData && !(nType & (SER_GETHASH | SER_WITHOUT_MTP_DATA)))
                     READWRITE(*mtpHashData);
             }
         }
@@ -229,6 +231,9 @@ public:
     mutable std::vector<CTxOut> voutSuperblock; // superblock payment
     mutable bool fChecked;
 
+    // memory only, MTP proof data was not stored in the block file (see -prunemtpdata)
+    bool fMTPDataPruned;
+
     // memory only, zerocoin tx info
     mutable std::shared_ptr<CZerocoinTxInfo> zerocoinTxInfo;
 
@@ -270,6 +275,7 @@ public:
         txoutZnode = CTxOut();
         voutSuperblock.clear();
         fChecked = false;
+        fMTPDataPruned = false;
     }
 
     CBlockHeader GetBlockHeader() const
@@ -333,4 +339,11 @@ struct CBlockLocator
 /** Compute the consensus-critical block weight (see BIP 141). */
 int64_t GetBlockWeight(const CBlock& tx);
 
+/**
+ * Calculate PoW hashes of many headers in parallel on the shared executor. nHeights[i] is the height
+ * of headers[i]. Calculated hashes are put into the PoW hash cache so following GetPoWHash() calls
+ * for these headers don't have to recalculate them
+ */
+void CalculatePoWHashes(const std::vector<CBlockHeader> &headers, const std::vector<int> &nHeights, std::vector<uint256> &powHashes);
+
 #endif // BITCOIN_PRIMITIVES_BLOCK_H
@@ -0,0 +1,90 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "primitives/powhashcache.h"
+
+#include <algorithm>
+
+CPoWHashCache powHashCache;
+
+CPoWHashCache::CPoWHashCache(size_t nMaxSizeIn) :
+    shards(nShards), nMaxShardSize(std::max<size_t>(nMaxSizeIn / nShards, 1)), nHits(0), nMisses(0)
+{
+}
+
+bool CPoWHashCache::Get(int nHeight, const uint256 &headerHash, uint256 &powHash)
+{
+    Key key(nHeight, headerHash);
+    Shard &shard = GetShard(key);
+
+    std::unique_lock<std::mutex> lock(shard.cs);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        nMisses++;
+        return false;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    powHash = it->second->second;
+    nHits++;
+    return true;
+}
+
+void CPoWHashCache::Put(int nHeight, const uint256 &headerHash, const uint256 &powHash)
+{
+    Key key(nHeight, headerHash);
+    Shard &shard = GetShard(key);
+
+    std::unique_lock<std::mutex> lock(shard.cs);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        it->second->second = powHash;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    shard.entries.emplace_front(key, powHash);
+    shard.index[key] = shard.entries.begin();
+
+    if (shard.entries.size() > nMaxShardSize) {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+    }
+}
+
+void CPoWHashCache::Erase(int nHeight, const uint256 &headerHash)
+{
+    Key key(nHeight, headerHash);
+    Shard &shard = GetShard(key);
+
+    std::unique_lock<std::mutex> lock(shard.cs);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        shard.entries.erase(it->second);
+        shard.index.erase(it);
+    }
+}
+
+void CPoWHashCache::Clear()
+{
+    for (Shard &shard: shards) {
+        std::unique_lock<std::mutex> lock(shard.cs);
+        shard.entries.clear();
+        shard.index.clear();
+    }
+}
+
+CPoWHashCache::Stats CPoWHashCache::GetStats() const
+{
+    Stats stats;
+    stats.nHits = nHits;
+    stats.nMisses = nMisses;
+    stats.nSize = 0;
+    for (const Shard &shard: shards) {
+        std::unique_lock<std::mutex> lock(shard.cs);
+        stats.nSize += shard.entries.size();
+    }
+    stats.nMaxSize = nMaxShardSize * nShards;
+    return stats;
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_PRIMITIVES_POWHASHCACHE_H
+#define BITCOIN_PRIMITIVES_POWHASHCACHE_H
+
+#include "uint256.h"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** Default maximum number of entries in the PoW hash cache */
+static const size_t DEFAULT_POW_HASH_CACHE_SIZE = 16384;
+
+/**
+ * Bounded cache of computed PoW hashes keyed by (height, block header hash). The cache is split
+ * into independently locked shards with LRU eviction so header validation from several threads
+ * doesn't contend on one lock.
+ */
+class CPoWHashCache
+{
+public:
+    typedef std::pair<int, uint256> Key;
+
+    struct Stats {
+        uint64_t nHits;
+        uint64_t nMisses;
+        size_t nSize;
+        size_t nMaxSize;
+    };
+
+    CPoWHashCache(size_t nMaxSizeIn = DEFAULT_POW_HASH_CACHE_SIZE);
+
+    bool Get(int nHeight, const uint256 &headerHash, uint256 &powHash);
+    void Put(int nHeight, const uint256 &headerHash, const uint256 &powHash);
+    void Erase(int nHeight, const uint256 &headerHash);
+    void Clear();
+
+    Stats GetStats() const;
+
+private:
+    static const int nShards = 16;
+
+    struct KeyHasher {
+        size_t operator()(const Key &key) const { return key.second.GetCheapHash() ^ (size_t)key.first; }
+    };
+
+    struct Shard {
+        mutable std::mutex cs;
+        // most recently used entries are at the front
+        std::list<std::pair<Key, uint256>> entries;
+        std::unordered_map<Key, std::list<std::pair<Key, uint256>>::iterator, KeyHasher> index;
+    };
+
+    std::vector<Shard> shards;
+    size_t nMaxShardSize;
+
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+
+    Shard &GetShard(const Key &key) { return shards[KeyHasher()(key) % nShards]; }
+};
+
+/** Cache used by CBlockHeader::GetPoWHash */
+extern CPoWHashCache powHashCache;
+
+#endif // BITCOIN_PRIMITIVES_POWHASHCACHE_H
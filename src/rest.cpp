@@ -163,10 +163,16 @@ static bool rest_headers(HTTPRequest* req,
     }
 
     CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
-    BOOST_FOREACH(const CBlockIndex *pindex, headers) {
-    	CBlock block;
-    	ReadBlockFromDisk(block, pindex, Params().GetConsensus());
-        ssHeader << block.GetBlockHeader();
+    if (rf != RF_JSON) {
+        BOOST_FOREACH(const CBlockIndex *pindex, headers) {
+            CBlock block;
+            ReadBlockFromDisk(block, pindex, Params().GetConsensus());
+            // Zcoin - MTP
+            // MTP header without proof data can't be deserialized
+            if (block.fMTPDataPruned)
+                return RESTERR(req, HTTP_NOT_FOUND, pindex->GetBlockHash().GetHex() + " MTP data not available (pruned data)");
+            ssHeader << block.GetBlockHeader();
+        }
     }
 
     switch (rf) {
@@ -230,6 +236,11 @@ static bool rest_block(HTTPRequest* req,
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
     }
 
+    // Zcoin - MTP
+    // Serialized block without MTP proof data can't be deserialized, JSON doesn't include it
+    if (block.fMTPDataPruned && rf != RF_JSON)
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " MTP data not available (pruned data)");
+
     CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
     ssBlock << block;
 
@@ -11,6 +11,7 @@
 #include "consensus/validation.h"
 #include "main.h"
 #include "policy/policy.h"
+#include "primitives/powhashcache.h"
 #include "primitives/transaction.h"
 #include "rpc/server.h"
 #include "streams.h"
@@ -672,6 +673,8 @@ UniValue getblock(const UniValue& params, bool fHelp)
 
     if (!fVerbose)
     {
+        if (block.fMTPDataPruned)
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Block MTP data not available (pruned data)");
         CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
         ssBlock << block;
         std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
@@ -1176,6 +1179,34 @@ UniValue getmempoolinfo(const UniValue& params, bool fHelp)
     return mempoolInfoToJSON();
 }
 
+UniValue getpowhashcacheinfo(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getpowhashcacheinfo\n"
+            "\nReturns statistics of the block PoW hash cache.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"size\": xxxxx,               (numeric) Number of cached hashes\n"
+            "  \"maxsize\": xxxxx,            (numeric) Maximum number of cached hashes\n"
+            "  \"hits\": xxxxx,               (numeric) Number of lookups that found the hash in the cache\n"
+            "  \"misses\": xxxxx              (numeric) Number of lookups that required hash calculation\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getpowhashcacheinfo", "")
+            + HelpExampleRpc("getpowhashcacheinfo", "")
+        );
+
+    CPoWHashCache::Stats stats = powHashCache.GetStats();
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("size", (int64_t) stats.nSize));
+    ret.push_back(Pair("maxsize", (int64_t) stats.nMaxSize));
+    ret.push_back(Pair("hits", (int64_t) stats.nHits));
+    ret.push_back(Pair("misses", (int64_t) stats.nMisses));
+    return ret;
+}
+
 UniValue invalidateblock(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
@@ -1267,6 +1298,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  true  },
     { "blockchain",         "getmempoolentry",        &getmempoolentry,        true  },
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         true  },
+    { "blockchain",         "getpowhashcacheinfo",    &getpowhashcacheinfo,    true  },
     { "blockchain",         "getrawmempool",          &getrawmempool,          true  },
     { "blockchain",         "clearmempool",           &clearmempool,           true  },
     { "blockchain",         "gettxout",               &gettxout,               true  },
@@ -25,6 +25,7 @@
 #include <stdint.h>
 
 #include <boost/assign/list_of.hpp>
+#include <boost/optional.hpp>
 
 #include <univalue.h>
 
@@ -591,6 +592,78 @@ bool timestampSort(std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+namespace {
+/** Returns the page size of a paginated address history call, or 0 if the whole history is requested */
+int getHistoryLimitFromParams(const UniValue& params)
+{
+    if (!params[0].isObject())
+        return 0;
+
+    UniValue limitValue = find_value(params[0].get_obj(), "limit");
+    if (limitValue.isNull())
+        return 0;
+
+    int limit = limitValue.get_int();
+    if (limit <= 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit is expected to be positive");
+    }
+    return limit;
+}
+
+/** The cursor of a page is the serialized index key, at which the next page starts */
+template <typename Key>
+std::string encodeHistoryCursor(const Key& key)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << key;
+    return HexStr(ss.begin(), ss.end());
+}
+
+template <typename Key>
+boost::optional<Key> getHistoryCursorFromParams(const UniValue& params)
+{
+    UniValue cursorValue = find_value(params[0].get_obj(), "cursor");
+    if (cursorValue.isNull())
+        return boost::none;
+
+    if (!cursorValue.isStr() || !IsHex(cursorValue.get_str())) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+
+    CDataStream ss(ParseHex(cursorValue.get_str()), SER_DISK, CLIENT_VERSION);
+    Key key;
+    try {
+        ss >> key;
+    } catch (const std::exception&) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+    if (!ss.empty()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+    return key;
+}
+
+/** Returns the position of the address, which the cursor belongs to; pages continue from there */
+template <typename Key>
+size_t findCursorAddress(const std::vector<std::pair<uint160, AddressType> > &addresses, const Key& key)
+{
+    for (size_t i = 0; i < addresses.size(); i++) {
+        if (addresses[i].first == key.hashBytes && addresses[i].second == key.type)
+            return i;
+    }
+    throw JSONRPCError(RPC_INVALID_PARAMETER, "Cursor does not belong to any of the addresses");
+}
+
+template <typename Key>
+UniValue makeHistoryPage(const std::string& name, const UniValue& entries, const boost::optional<Key>& next)
+{
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair(name, entries));
+    result.push_back(Pair("cursor", next ? UniValue(encodeHistoryCursor(*next)) : NullUniValue));
+    return result;
+}
+}
+
 UniValue getaddressmempool(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
@@ -674,6 +747,8 @@ UniValue getaddressutxos(const UniValue& params, bool fHelp)
                         "      \"address\"  (string) The base58check encoded address\n"
                         "      ,...\n"
                         "    ]\n"
+                        "  \"limit\" (number, optional) Return at most this many outputs per call\n"
+                        "  \"cursor\" (string, optional) The cursor returned by the previous call\n"
                         "}\n"
                         "\nResult\n"
                         "[\n"
@@ -686,8 +761,14 @@ UniValue getaddressutxos(const UniValue& params, bool fHelp)
                         "    \"height\"  (number) The block height\n"
                         "  }\n"
                         "]\n"
+                        "\nResult (with limit)\n"
+                        "{\n"
+                        "  \"utxos\"  (array) The outputs as above, ordered by address and outpoint instead of height\n"
+                        "  \"cursor\"  (string) The cursor of the next page, or null if this is the last one\n"
+                        "}\n"
                         "\nExamples:\n"
                 + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+                + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
                 + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -697,6 +778,43 @@ UniValue getaddressutxos(const UniValue& params, bool fHelp)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    int limit = getHistoryLimitFromParams(params);
+    if (limit > 0) {
+        boost::optional<CAddressUnspentKey> from = getHistoryCursorFromParams<CAddressUnspentKey>(params);
+        boost::optional<CAddressUnspentKey> next;
+        size_t first = from ? findCursorAddress(addresses, *from) : 0;
+        UniValue utxos(UniValue::VARR);
+
+        for (size_t i = first; i < addresses.size() && !next; i++) {
+            std::string address;
+            if (!getAddressFromIndex(addresses[i].second, addresses[i].first, address)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+            }
+
+            auto visitor = [&](const CAddressUnspentKey& key, const CAddressUnspentValue& value) {
+                if (utxos.size() == (size_t)limit) {
+                    next = key;
+                    return false;
+                }
+                UniValue output(UniValue::VOBJ);
+                output.push_back(Pair("address", address));
+                output.push_back(Pair("txid", key.txhash.GetHex()));
+                output.push_back(Pair("outputIndex", (int)key.index));
+                output.push_back(Pair("script", HexStr(value.script.begin(), value.script.end())));
+                output.push_back(Pair("satoshis", value.satoshis));
+                output.push_back(Pair("height", value.blockHeight));
+                utxos.push_back(output);
+                return true;
+            };
+
+            if (!GetAddressUnspent(addresses[i].first, addresses[i].second, visitor, i == first && from ? from.get_ptr() : NULL)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        }
+
+        return makeHistoryPage("utxos", utxos, next);
+    }
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
 
     for (std::vector<std::pair<uint160, AddressType> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -743,6 +861,8 @@ UniValue getaddressdeltas(const UniValue& params, bool fHelp)
                         "    ]\n"
                         "  \"start\" (number) The start block height\n"
                         "  \"end\" (number) The end block height\n"
+                        "  \"limit\" (number, optional) Return at most this many deltas per call\n"
+                        "  \"cursor\" (string, optional) The cursor returned by the previous call\n"
                         "}\n"
                         "\nResult:\n"
                         "[\n"
@@ -755,8 +875,14 @@ UniValue getaddressdeltas(const UniValue& params, bool fHelp)
                         "    \"address\"  (string) The base58check encoded address\n"
                         "  }\n"
                         "]\n"
+                        "\nResult (with limit):\n"
+                        "{\n"
+                        "  \"deltas\"  (array) The deltas as above\n"
+                        "  \"cursor\"  (string) The cursor of the next page, or null if this is the last one\n"
+                        "}\n"
                         "\nExamples:\n"
                 + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+                + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
                 + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -781,6 +907,49 @@ UniValue getaddressdeltas(const UniValue& params, bool fHelp)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    int limit = getHistoryLimitFromParams(params);
+    if (limit > 0) {
+        // Like below, the block range applies only if both heights are given
+        if (start <= 0 || end <= 0) {
+            start = 0;
+            end = 0;
+        }
+
+        boost::optional<CAddressIndexKey> from = getHistoryCursorFromParams<CAddressIndexKey>(params);
+        boost::optional<CAddressIndexKey> next;
+        size_t first = from ? findCursorAddress(addresses, *from) : 0;
+        UniValue deltas(UniValue::VARR);
+
+        for (size_t i = first; i < addresses.size() && !next; i++) {
+            std::string address;
+            if (!getAddressFromIndex(addresses[i].second, addresses[i].first, address)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+            }
+
+            auto visitor = [&](const CAddressIndexKey& key, CAmount amount) {
+                if (deltas.size() == (size_t)limit) {
+                    next = key;
+                    return false;
+                }
+                UniValue delta(UniValue::VOBJ);
+                delta.push_back(Pair("satoshis", amount));
+                delta.push_back(Pair("txid", key.txhash.GetHex()));
+                delta.push_back(Pair("index", (int)key.index));
+                delta.push_back(Pair("blockindex", (int)key.txindex));
+                delta.push_back(Pair("height", key.blockHeight));
+                delta.push_back(Pair("address", address));
+                deltas.push_back(delta);
+                return true;
+            };
+
+            if (!GetAddressIndex(addresses[i].first, addresses[i].second, visitor, start, end, i == first && from ? from.get_ptr() : NULL)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        }
+
+        return makeHistoryPage("deltas", deltas, next);
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, AddressType> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -846,22 +1015,16 @@ UniValue getaddressbalance(const UniValue& params, bool fHelp)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    for (std::vector<std::pair<uint160, AddressType> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
-    }
-
     CAmount balance = 0;
     CAmount received = 0;
 
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
+    for (std::vector<std::pair<uint160, AddressType> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+        CAddressBalanceValue value;
+        if (!GetAddressBalance((*it).first, (*it).second, value)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
-        balance += it->second;
+        balance += value.balance;
+        received += value.received;
     }
 
     UniValue result(UniValue::VOBJ);
@@ -887,14 +1050,22 @@ UniValue getaddresstxids(const UniValue& params, bool fHelp)
                         "    ]\n"
                         "  \"start\" (number) The start block height\n"
                         "  \"end\" (number) The end block height\n"
+                        "  \"limit\" (number, optional) Return at most this many txids per call\n"
+                        "  \"cursor\" (string, optional) The cursor returned by the previous call\n"
                         "}\n"
                         "\nResult:\n"
                         "[\n"
                         "  \"transactionid\"  (string) The transaction id\n"
                         "  ,...\n"
                         "]\n"
+                        "\nResult (with limit):\n"
+                        "{\n"
+                        "  \"txids\"  (array) The txids of one address after another, a txid may repeat for another address\n"
+                        "  \"cursor\"  (string) The cursor of the next page, or null if this is the last one\n"
+                        "}\n"
                         "\nExamples:\n"
                 + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+                + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
                 + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -915,6 +1086,42 @@ UniValue getaddresstxids(const UniValue& params, bool fHelp)
         }
     }
 
+    int limit = getHistoryLimitFromParams(params);
+    if (limit > 0) {
+        // Like below, the block range applies only if both heights are given
+        if (start <= 0 || end <= 0) {
+            start = 0;
+            end = 0;
+        }
+
+        boost::optional<CAddressIndexKey> from = getHistoryCursorFromParams<CAddressIndexKey>(params);
+        boost::optional<CAddressIndexKey> next;
+        size_t first = from ? findCursorAddress(addresses, *from) : 0;
+        UniValue txids(UniValue::VARR);
+
+        for (size_t i = first; i < addresses.size() && !next; i++) {
+            // The entries of a transaction are adjacent, and a page never ends within them
+            uint256 lastTxid;
+            auto visitor = [&](const CAddressIndexKey& key, CAmount) {
+                if (key.txhash == lastTxid)
+                    return true;
+                if (txids.size() == (size_t)limit) {
+                    next = key;
+                    return false;
+                }
+                lastTxid = key.txhash;
+                txids.push_back(key.txhash.GetHex());
+                return true;
+            };
+
+            if (!GetAddressIndex(addresses[i].first, addresses[i].second, visitor, start, end, i == first && from ? from.get_ptr() : NULL)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        }
+
+        return makeHistoryPage("txids", txids, next);
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, AddressType> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -1003,6 +1210,15 @@ UniValue getspentinfo(const UniValue& params, bool fHelp)
     return obj;
 }
 
+namespace {
+// The supply is maintained in the block index database, unless it couldn't be calculated for an older database
+bool isSupplyAvailable()
+{
+    bool fSupply = false;
+    return pblocktree->ReadFlag("supply", fSupply) && fSupply;
+}
+}
+
 UniValue gettotalsupply(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 0)
@@ -1021,8 +1237,10 @@ UniValue gettotalsupply(const UniValue& params, bool fHelp)
 
     CAmount total = 0;
 
-    if(!pblocktree->ReadTotalSupply(total))
-        throw JSONRPCError(RPC_DATABASE_ERROR, "Cannot read the total supply from the database. This functionality requires -addressindex to be enabled. Enabling -addressindex requires reindexing.");
+    if (!isSupplyAvailable())
+        throw JSONRPCError(RPC_DATABASE_ERROR, "The supply is not available. Restart with -reindex to calculate it.");
+
+    pblocktree->ReadTotalSupply(total);
 
     UniValue result(UniValue::VOBJ);
     result.push_back(Pair("total", total));
@@ -1030,93 +1248,53 @@ UniValue gettotalsupply(const UniValue& params, bool fHelp)
     return result;
 }
 
-namespace {
-bool getZerocoinSupply(CAmount & amount) {
-    using idx_rec = std::pair<CAddressIndexKey, CAmount>;
-    std::vector<idx_rec> addressIndex;
-
-    if(!GetAddressIndex(uint160(), AddressType::zerocoinSpend, addressIndex))
-        return false;
-
-    auto predicate = [](idx_rec const & lhs, idx_rec const & rhs) {
-        if(lhs.first.blockHeight < rhs.first.blockHeight)
-            return true;
-        if(lhs.first.blockHeight > rhs.first.blockHeight)
-            return false;
-        return lhs.first.txindex < lhs.first.txindex;
-    };
-
-    if(!std::is_sorted(addressIndex.begin(), addressIndex.end(), predicate))
-        std::sort(addressIndex.begin(), addressIndex.end(), predicate);
-
-    using spend_value = std::pair<uint256, size_t>;
-    std::map<CBigNum, spend_value> originalSerials;
-    CAmount amt = 0;
-
-    for(idx_rec const & idr : addressIndex) {
-        CTransaction tx;
-        uint256 hash;
-
-        if(!GetTransaction(idr.first.txhash, tx, Params().GetConsensus(), hash, true))
-            return false;
-
-        size_t num = 0;
-        for(CTxIn const & in : tx.vin) {
-            ++num;
-            if(!in.IsZerocoinSpend())
-                continue;
-
-            CBigNum zspendSerial = CBigNum(0);
-            libzerocoin::CoinDenomination zspendAmount;
-
-            try {
-                CDataStream serializedCoinSpend((const char *)&*(in.scriptSig.begin() + 4),
-                                            (const char *)&*in.scriptSig.end(),
-                                            SER_NETWORK, PROTOCOL_VERSION);
-                libzerocoin::CoinSpend spend(in.nSequence >= ZC_MODULUS_V2_BASE_ID ? ZCParamsV2 : ZCParams, serializedCoinSpend);
-                zspendSerial = spend.getCoinSerialNumber();
-                zspendAmount = spend.getDenomination();
-            }
-            catch (const std::runtime_error &) {
-                continue;
-            }
-
-            auto const iter = originalSerials.find(zspendSerial);
-            if(iter == originalSerials.end())
-                originalSerials.insert({zspendSerial, spend_value(tx.GetHash(), num)});
-            else if(iter->second != spend_value(tx.GetHash(), num)){
-                amt += zspendAmount * COIN;
-            }
-        }
-    }
-    amount = amt;
-    return true;
-}
-}
-
 UniValue getzerocoinsupply(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() > 1)
         throw runtime_error(
                 "getzerocoinsupply\n"
-                        "\nReturns zerocoin amount. This function is very slow by design.\n"
+                        "\nReturns the zerocoin amount created by spends of already spent serials, and the mints and spends per denomination.\n"
                         "\nArguments: none\n"
                         "\nResult:\n"
                         "{\n"
-                        "  \"total\"  (string) The total supply in duffs\n"
+                        "  \"total\"  (string) The zerocoin supply in duffs\n"
+                        "  \"denominations\"\n"
+                        "    [\n"
+                        "      {\n"
+                        "        \"denomination\"  (number) The denomination\n"
+                        "        \"minted\"  (number) The number of minted coins\n"
+                        "        \"spent\"  (number) The number of spends\n"
+                        "        \"duplicatespent\"  (number) The number of spends of already spent serials\n"
+                        "        \"total\"  (string) The zerocoin supply of the denomination in duffs\n"
+                        "      }\n"
+                        "      ,...\n"
+                        "    ]\n"
                         "}\n"
                         "\nExamples:\n"
                 + HelpExampleCli("getzerocoinsupply", "")
                 + HelpExampleRpc("getzerocoinsupply", "")
         );
 
-    CAmount total = 0;
-
-    if(!getZerocoinSupply(total))
-        throw JSONRPCError(RPC_DATABASE_ERROR, "Cannot read the zerocoin supply from the database. This functionality requires -addressindex to be enabled. Enabling -addressindex requires reindexing.");
+    if (!isSupplyAvailable())
+        throw JSONRPCError(RPC_DATABASE_ERROR, "The supply is not available. Restart with -reindex to calculate it.");
+
+    CZerocoinSupply supply;
+    pblocktree->ReadZerocoinSupply(supply);
+
+    UniValue denominations(UniValue::VARR);
+    for (std::map<int, CZerocoinSupply::CDenominationSupply>::const_iterator it = supply.denominations.begin(); it != supply.denominations.end(); ++it) {
+        UniValue denomination(UniValue::VOBJ);
+        denomination.push_back(Pair("denomination", it->first));
+        denomination.push_back(Pair("minted", it->second.nMinted));
+        denomination.push_back(Pair("spent", it->second.nSpent));
+        denomination.push_back(Pair("duplicatespent", it->second.nDuplicateSpent));
+        denomination.push_back(Pair("total", it->second.nDuplicateSpent * it->first * COIN));
+        denominations.push_back(denomination);
+    }
 
     UniValue result(UniValue::VOBJ);
-    result.push_back(Pair("total", total));
+    result.push_back(Pair("total", supply.GetDuplicateSpendAmount()));
+    result.push_back(Pair("denominations", denominations));
 
     return result;
 }
@@ -1126,7 +1304,7 @@ UniValue getinfoex(const UniValue& params, bool fHelp)
     if (fHelp || params.size() != 0)
     throw runtime_error(
         "getinfoex\n"
-        "An engineering version of getinfo. Takes significant time to finish.\n"
+        "An engineering version of getinfo.\n"
         "Returns an object containing various state info.\n"
         "\nResult:\n"
         "{\n"
@@ -1155,15 +1333,15 @@ UniValue getinfoex(const UniValue& params, bool fHelp)
 
     UniValue info = getinfo(params, fHelp);
 
-    CAmount total = 0, zerocoin = 0;
-
-    if(!pblocktree->ReadTotalSupply(total))
-        throw JSONRPCError(RPC_DATABASE_ERROR, "Cannot read the total supply from the database");
+    if (!isSupplyAvailable())
+        throw JSONRPCError(RPC_DATABASE_ERROR, "The supply is not available. Restart with -reindex to calculate it.");
 
-    if(!getZerocoinSupply(zerocoin))
-        throw JSONRPCError(RPC_DATABASE_ERROR, "Cannot read the total supply from the database");
+    CAmount total = 0;
+    CZerocoinSupply zerocoin;
+    pblocktree->ReadTotalSupply(total);
+    pblocktree->ReadZerocoinSupply(zerocoin);
 
-    info.push_back(Pair("moneysupply", total + zerocoin));
+    info.push_back(Pair("moneysupply", total + zerocoin.GetDuplicateSpendAmount()));
 
     return info;
 }
@@ -1184,7 +1362,7 @@ static const CRPCCommand commands[] =
     { "addressindex",       "getaddressdeltas",       &getaddressdeltas,       false },
     { "addressindex",       "getaddresstxids",        &getaddresstxids,        false },
     { "addressindex",       "getaddressbalance",      &getaddressbalance,      false },
-    { "addressindex",       "gettotalsupply",         &gettotalsupply,         false },
+    { "util",               "gettotalsupply",         &gettotalsupply,         false },
 
     /* Not shown in help */
     { "hidden",             "setmocktime",            &setmocktime,            true  },
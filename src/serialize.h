@@ -175,6 +175,9 @@ enum
     SER_NETWORK         = (1 << 0),
     SER_DISK            = (1 << 1),
     SER_GETHASH         = (1 << 2),
+
+    // Zcoin - MTP: block header is (de)serialized without the MTP proof data
+    SER_WITHOUT_MTP_DATA = (1 << 3),
 };
 
 #define READWRITE(obj)      (::SerReadWrite(s, (obj), nType, nVersion, ser_action))
@@ -372,5 +372,36 @@ struct CAddressIndexIteratorHeightKey {
     }
 };
 
+struct CAddressBalanceValue {
+    CAmount balance;
+    CAmount received;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(balance);
+        READWRITE(received);
+    }
+
+    CAddressBalanceValue(CAmount balanceValue, CAmount receivedValue) {
+        balance = balanceValue;
+        received = receivedValue;
+    }
+
+    CAddressBalanceValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+    }
+
+    bool IsNull() const {
+        return (balance == 0 && received == 0);
+    }
+};
+
 
 #endif // BITCOIN_SPENTINDEX_H
@@ -9,6 +9,7 @@
 #include "crypto/sha512.h"
 #include "crypto/hmac_sha256.h"
 #include "crypto/hmac_sha512.h"
+#include "crypto/Lyra2Z/Lyra2.h"
 #include "random.h"
 #include "utilstrencodings.h"
 #include "test/test_bitcoin.h"
@@ -439,4 +440,28 @@ BOOST_AUTO_TEST_CASE(aes_cbc_testvectors) {
                   "b2eb05e2c39be9fcda6c19078c6a9d1b3f461796d6b0d6b2e0c2a72b4d80e644");
 }
 
+BOOST_AUTO_TEST_CASE(lyra2_testvectors) {
+    std::vector<unsigned char> in(80);
+    for (int i = 0; i < 80; i++)
+        in[i] = i;
+
+    // generic and AVX2 implementations of the sponge give the same result
+    for (int fAllowAVX2 = 0; fAllowAVX2 <= 1; fAllowAVX2++) {
+        lyra2_select_sponge(fAllowAVX2);
+        std::vector<unsigned char> out(32);
+        // Lyra2Z parameters
+        BOOST_CHECK_EQUAL(LYRA2(out.data(), 32, in.data(), 80, in.data(), 80, 8, 8, 8), 0);
+        BOOST_CHECK_EQUAL(HexStr(out), "ea355bda2f66e86076dcc10acb3259c537513f17e4b2d1fb07dba08479743a4b");
+        // repeated call reuses the scratch buffer
+        BOOST_CHECK_EQUAL(LYRA2(out.data(), 32, in.data(), 80, in.data(), 80, 8, 8, 8), 0);
+        BOOST_CHECK_EQUAL(HexStr(out), "ea355bda2f66e86076dcc10acb3259c537513f17e4b2d1fb07dba08479743a4b");
+        // Lyra2 with number of rows equal to block height
+        BOOST_CHECK_EQUAL(LYRA2(out.data(), 32, in.data(), 80, in.data(), 80, 2, 600, 256), 0);
+        BOOST_CHECK_EQUAL(HexStr(out), "60e57deaf0aadd05dbc31537dcf164c0a6e5ad5b16602166b8cc2ef72fdca1b4");
+        BOOST_CHECK_EQUAL(LYRA2(out.data(), 32, in.data(), 80, in.data(), 80, 2, 8192, 256), 0);
+        BOOST_CHECK_EQUAL(HexStr(out), "fd9276dd35422e4f5e9f42a758af761592efdd88237b9985d048fd1f97b42d89");
+    }
+    lyra2_detect_avx2();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
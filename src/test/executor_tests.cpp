@@ -0,0 +1,176 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "checkqueue.h"
+#include "executor.h"
+
+#include "test/test_bitcoin.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(executor_tests, BasicTestingSetup)
+
+namespace {
+
+struct CountingCheck {
+    std::atomic<int> *pCounter;
+    bool fResult;
+
+    CountingCheck() : pCounter(NULL), fResult(true) {}
+    CountingCheck(std::atomic<int> *pCounterIn, bool fResultIn) : pCounter(pCounterIn), fResult(fResultIn) {}
+
+    bool operator()() {
+        (*pCounter)++;
+        return fResult;
+    }
+
+    void swap(CountingCheck &check) {
+        std::swap(pCounter, check.pCounter);
+        std::swap(fResult, check.fResult);
+    }
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(executor_task_group)
+{
+    CExecutor executor;
+    executor.Start(3);
+    BOOST_CHECK_EQUAL(executor.GetThreadCount(), 3);
+
+    std::vector<int> results(1000, 0);
+    CExecutorTaskGroup tasks(executor);
+    for (int i = 0; i < 1000; i++)
+        tasks.Add([i, &results] { results[i] = i * 2; });
+    tasks.Wait();
+
+    for (int i = 0; i < 1000; i++)
+        BOOST_CHECK_EQUAL(results[i], i * 2);
+
+    // workers count a task after it has signalled its completion, join them before reading the counter
+    executor.Stop();
+    CExecutor::Stats stats = executor.GetStats();
+    BOOST_CHECK_EQUAL(stats.nQueueDepth, 0U);
+    BOOST_CHECK_EQUAL(stats.nExecuted, 1000U);
+}
+
+BOOST_AUTO_TEST_CASE(executor_nested_tasks)
+{
+    CExecutor executor;
+    executor.Start(2);
+
+    // every outer task waits for its own inner tasks. Waiting threads execute pending tasks so
+    // this completes even though there are more outer tasks than threads
+    std::atomic<int> counter(0);
+    CExecutorTaskGroup outerTasks(executor);
+    for (int i = 0; i < 8; i++) {
+        outerTasks.Add([&executor, &counter] {
+            CExecutorTaskGroup innerTasks(executor);
+            for (int j = 0; j < 16; j++)
+                innerTasks.Add([&counter] { counter++; });
+            innerTasks.Wait();
+        });
+    }
+    outerTasks.Wait();
+
+    BOOST_CHECK_EQUAL(counter, 8 * 16);
+}
+
+BOOST_AUTO_TEST_CASE(executor_without_threads)
+{
+    // waiting thread runs everything itself
+    CExecutor executor;
+    int counter = 0;
+    CExecutorTaskGroup tasks(executor);
+    for (int i = 0; i < 10; i++)
+        tasks.Add([&counter] { counter++; });
+    tasks.Wait();
+    BOOST_CHECK_EQUAL(counter, 10);
+
+    // exception is passed to the waiting thread
+    tasks.Add([] { throw std::runtime_error("task failed"); });
+    BOOST_CHECK_THROW(tasks.Wait(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(executor_foreign_tasks)
+{
+    CExecutor executor;
+    executor.Start(1);
+
+    // keep the only worker busy with a long task of nobody's group
+    std::mutex cs;
+    std::condition_variable cond;
+    bool fStarted = false, fRelease = false;
+    executor.Submit([&] {
+        std::unique_lock<std::mutex> lock(cs);
+        fStarted = true;
+        cond.notify_all();
+        cond.wait(lock, [&] { return fRelease; });
+    });
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        cond.wait(lock, [&] { return fStarted; });
+    }
+
+    // another long task waits in the shared queue, the waiting thread must not pick it up
+    std::atomic<bool> fForeignRun(false);
+    std::thread::id foreignThread;
+    executor.Submit([&] {
+        foreignThread = std::this_thread::get_id();
+        fForeignRun = true;
+    });
+
+    int counter = 0;
+    CExecutorTaskGroup tasks(executor);
+    for (int i = 0; i < 10; i++)
+        tasks.Add([&counter] { counter++; });
+    tasks.Wait();
+
+    BOOST_CHECK_EQUAL(counter, 10);
+    BOOST_CHECK(!fForeignRun);
+
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        fRelease = true;
+    }
+    cond.notify_all();
+    // the worker runs the rest before it stops
+    executor.Stop();
+    BOOST_CHECK(fForeignRun);
+    BOOST_CHECK(foreignThread != std::this_thread::get_id());
+}
+
+BOOST_AUTO_TEST_CASE(executor_check_queue)
+{
+    CExecutor executor;
+    executor.Start(3);
+    CCheckQueue<CountingCheck> queue(16, executor);
+
+    for (int nRun = 0; nRun < 2; nRun++) {
+        std::atomic<int> counter(0);
+        bool fExpected = nRun == 0;
+        {
+            CCheckQueueControl<CountingCheck> control(&queue);
+            for (int i = 0; i < 100; i++) {
+                std::vector<CountingCheck> vChecks;
+                for (int j = 0; j < 10; j++)
+                    vChecks.push_back(CountingCheck(&counter, fExpected || j != 5));
+                control.Add(vChecks);
+            }
+            BOOST_CHECK_EQUAL(control.Wait(), fExpected);
+        }
+        if (fExpected)
+            BOOST_CHECK_EQUAL(counter, 1000);
+        BOOST_CHECK(queue.IsIdle());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
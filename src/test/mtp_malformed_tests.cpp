@@ -157,10 +157,8 @@ BOOST_AUTO_TEST_CASE(mtp_malformed)
     previousHeight = chainActive.Height();
     memset(bMtp.mtpHashData->hashRootMTP, 0, sizeof(bMtp.mtpHashData->hashRootMTP));
     memset(bMtp.mtpHashData->nBlockMTP, 0, sizeof(bMtp.mtpHashData->nBlockMTP));
-    for(unsigned int i = 0; i < 192; i++)
-        for(unsigned int j = 0; j < bMtp.mtpHashData->nProofMTP[i].size(); j++)
-            for(unsigned int k = 0; k < bMtp.mtpHashData->nProofMTP[i][j].size(); k++)
-                bMtp.mtpHashData->nProofMTP[i][j][k] = 0;
+    memset(bMtp.mtpHashData->nProofMTP.GetProof(0), 0,
+            bMtp.mtpHashData->nProofMTP.GetNodeCount() * CMTPProofs::NODE_SIZE);
     ProcessBlock(bMtp);
     BOOST_CHECK_MESSAGE(previousHeight == chainActive.Height(), "Block connected with incorrect proof");
 
@@ -171,10 +169,8 @@ BOOST_AUTO_TEST_CASE(mtp_malformed)
 
 
     bMtp = CreateBlock(noTxns, scriptPubKeyMtpMalformed, mtp);
-    for(unsigned int i = 0; i < 192; i++)
-        for(unsigned int j = 0; j < bMtp.mtpHashData->nProofMTP[i].size(); j++)
-            for(unsigned int k = 0; k < bMtp.mtpHashData->nProofMTP[i][j].size(); k++)
-                bMtp.mtpHashData->nProofMTP[i][j][k] = 0;
+    memset(bMtp.mtpHashData->nProofMTP.GetProof(0), 0,
+            bMtp.mtpHashData->nProofMTP.GetNodeCount() * CMTPProofs::NODE_SIZE);
     ProcessBlock(bMtp);
     BOOST_CHECK_MESSAGE(previousHeight == chainActive.Height(), "Block connected with missing proof");
 
@@ -185,18 +181,19 @@ BOOST_AUTO_TEST_CASE(mtp_malformed)
     for(unsigned int i = 0; i < mtp::MTP_L*2; i++)
         for(unsigned int j = 0; j < 128; j++)
         bMtp.mtpHashData->nBlockMTP[i][j] = rand();
-    for(unsigned int i = 0; i < 192; i++)
-        for(unsigned int j = 0; j < bMtp.mtpHashData->nProofMTP[i].size(); j++)
-            for(unsigned int k = 0; k < bMtp.mtpHashData->nProofMTP[i][j].size(); k++)
-                bMtp.mtpHashData->nProofMTP[i][j][k] = rand()%256;
+    for(unsigned int i = 0; i < bMtp.mtpHashData->nProofMTP.GetNodeCount() * CMTPProofs::NODE_SIZE; i++)
+        bMtp.mtpHashData->nProofMTP.GetProof(0)[i] = rand()%256;
     ProcessBlock(bMtp);
     BOOST_CHECK_MESSAGE(previousHeight == chainActive.Height(), "Block connected with incorrect proof");
 
     bMtp = CreateBlock(noTxns, scriptPubKeyMtpMalformed, mtp);
     previousHeight = chainActive.Height();
-    for(unsigned int i = 0; i < 192; i++)
-        for(unsigned int j = 0; j < bMtp.mtpHashData->nProofMTP[i].size(); j++)
-            bMtp.mtpHashData->nProofMTP[i][j].resize(bMtp.mtpHashData->nProofMTP[i][j].size()/2);
+    {
+        CMTPProofs proofs;
+        for(int i = 0; i < CMTPProofs::PROOF_COUNT; i++)
+            proofs.AddProof(bMtp.mtpHashData->nProofMTP.GetProof(i), bMtp.mtpHashData->nProofMTP.GetProofSize(i)/2);
+        bMtp.mtpHashData->nProofMTP = proofs;
+    }
     ProcessBlock(bMtp);
     BOOST_CHECK_MESSAGE(previousHeight == chainActive.Height(), "Block connected with incorrect proof");
 
@@ -209,11 +206,7 @@ BOOST_AUTO_TEST_CASE(mtp_malformed)
         == 0, "Serialize does not match unserialize");
     BOOST_CHECK_MESSAGE(memcmp(outh.nBlockMTP, bMtp.mtpHashData->nBlockMTP, sizeof(outh.nBlockMTP))
         == 0, "Serialize does not match unserialize");
-    for(unsigned int i = 0; i < 192; i++)
-        for(unsigned int j = 0; j < bMtp.mtpHashData->nProofMTP[i].size(); j++)
-            for(unsigned int k = 0; k < bMtp.mtpHashData->nProofMTP[i][j].size(); k++)
-                BOOST_CHECK_MESSAGE(outh.nProofMTP[i][j][k] == bMtp.mtpHashData->nProofMTP[i][j][k],
-                     "Serialize does not match unserialize");
+    BOOST_CHECK_MESSAGE(outh.nProofMTP == bMtp.mtpHashData->nProofMTP, "Serialize does not match unserialize");
 
     mybufstream.clear();
     mybufstream << *bMtp.mtpHashData;
@@ -40,7 +40,7 @@ BOOST_AUTO_TEST_CASE(mtp_impl_integrity_test)
     uint8_t hash_root_mtp[16];
     unsigned int nonce;
     uint64_t block_mtp[mtp::MTP_L*2][128];
-    std::deque<std::vector<uint8_t>> proof_mtp[mtp::MTP_L*3];
+    CMTPProofs proof_mtp;
     uint256 output;
 
     mtp::impl::mtp_hash(input, target, hash_root_mtp, nonce, block_mtp, proof_mtp,
@@ -94,5 +94,87 @@ BOOST_AUTO_TEST_CASE(mtp_block_integrity_test)
     BOOST_CHECK(false == mtp::verify(block3.nNonce+1, block3, pow_limit));
 }
 
+BOOST_AUTO_TEST_CASE(mtp_batch_verify_test)
+{
+    RandAddSeed();
+
+    CBlock block1;
+    block1.nVersion = CBlock::CURRENT_VERSION;
+    block1.hashPrevBlock = GetRandHash();
+    block1.hashMerkleRoot = GetRandHash();
+    block1.nTime = GetRandInt(std::numeric_limits<decltype(block1.nTime)>::max());
+    block1.nBits = 0x2000ffffUL;
+    block1.nVersionMTP = 1;
+
+    CBlock block2(block1);
+    block2.hashMerkleRoot = GetRandHash();
+
+    uint256 pow_limit = uint256S("00ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    uint256 hash1 = mtp::hash(block1, pow_limit);
+    uint256 hash2 = mtp::hash(block2, pow_limit);
+
+    // same proof with a broken Merkle path, other one without MTP data at all
+    CBlock block3(block2);
+    block3.mtpHashData = std::make_shared<CMTPHashData>(*block2.mtpHashData);
+    block3.mtpHashData->nProofMTP.GetProof(mtp::MTP_L)[0] ^= 1;
+    CBlock block4(block1);
+    block4.mtpHashData.reset();
+
+    std::vector<const CBlockHeader*> headers = {&block1, &block2, &block3, &block4};
+    std::vector<bool> results;
+    std::vector<uint256> hashValues;
+    mtp::verify(headers, pow_limit, results, &hashValues);
+
+    BOOST_CHECK_EQUAL(results.size(), 4U);
+    BOOST_CHECK(results[0] && hashValues[0] == hash1);
+    BOOST_CHECK(results[1] && hashValues[1] == hash2);
+    BOOST_CHECK(!results[2]);
+    BOOST_CHECK(!results[3]);
+}
+
+BOOST_AUTO_TEST_CASE(mtp_proofs_serialization_test)
+{
+    // proofs of different lengths, including the empty ones
+    CMTPHashData data;
+    for (int i = 0; i < CMTPProofs::PROOF_COUNT; i++) {
+        std::vector<uint8_t> nodes((i % 5) * CMTPProofs::NODE_SIZE);
+        for (size_t j = 0; j < nodes.size(); j++)
+            nodes[j] = (uint8_t)(i + j);
+        data.nProofMTP.AddProof(nodes.data(), i % 5);
+    }
+    BOOST_CHECK_EQUAL(data.nProofMTP.GetProofSize(7), 2U);
+    BOOST_CHECK_EQUAL(data.nProofMTP.GetProof(7)[17], 7 + 17);
+
+    // every proof is a length byte followed by the nodes
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << data;
+    BOOST_CHECK_EQUAL(ss.size(), sizeof(data.hashRootMTP) + sizeof(data.nBlockMTP) + CMTPProofs::PROOF_COUNT +
+            data.nProofMTP.GetNodeCount() * CMTPProofs::NODE_SIZE);
+
+    CMTPHashData data2;
+    data2.nProofMTP.AddProof(data.nProofMTP.GetProof(3), 3);
+    ss >> data2;
+    BOOST_CHECK(data2.nProofMTP == data.nProofMTP);
+}
+
+BOOST_AUTO_TEST_CASE(mtp_header_without_mtp_data_test)
+{
+    CBlockHeader header;
+    header.nTime = std::numeric_limits<decltype(header.nTime)>::max();
+    header.nNonce = 1234;
+    header.mtpHashValue = GetRandHash();
+    header.mtpHashData = std::make_shared<CMTPHashData>();
+    BOOST_REQUIRE(header.IsMTP());
+
+    CDataStream ss(SER_DISK | SER_WITHOUT_MTP_DATA, CLIENT_VERSION);
+    ss << header;
+    BOOST_CHECK_EQUAL(ss.size(), ::GetSerializeSize(header, SER_GETHASH, CLIENT_VERSION));
+
+    CBlockHeader header2;
+    ss >> header2;
+    BOOST_CHECK(ss.empty());
+    BOOST_CHECK(!header2.mtpHashData);
+    BOOST_CHECK(header2.GetHash() == header.GetHash());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
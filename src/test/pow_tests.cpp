@@ -5,6 +5,7 @@
 #include "chain.h"
 #include "chainparams.h"
 #include "pow.h"
+#include "primitives/powhashcache.h"
 #include "random.h"
 #include "util.h"
 #include "test/test_bitcoin.h"
@@ -95,4 +96,45 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(pow_hash_cache)
+{
+    CPoWHashCache cache(32);
+    uint256 headerHash1 = uint256S("01"), headerHash2 = uint256S("02"), powHash;
+
+    cache.Put(100, headerHash1, uint256S("1001"));
+    cache.Put(100, headerHash2, uint256S("1002"));
+
+    // different headers at the same height don't share the entry
+    BOOST_CHECK(cache.Get(100, headerHash1, powHash));
+    BOOST_CHECK(powHash == uint256S("1001"));
+    BOOST_CHECK(cache.Get(100, headerHash2, powHash));
+    BOOST_CHECK(powHash == uint256S("1002"));
+    BOOST_CHECK(!cache.Get(101, headerHash1, powHash));
+
+    cache.Erase(100, headerHash1);
+    BOOST_CHECK(!cache.Get(100, headerHash1, powHash));
+
+    CPoWHashCache::Stats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.nHits, 2U);
+    BOOST_CHECK_EQUAL(stats.nMisses, 2U);
+    BOOST_CHECK_EQUAL(stats.nSize, 1U);
+
+    // cache doesn't grow over its limit
+    for (int i = 0; i < 1000; i++)
+        cache.Put(i, ArithToUint256(arith_uint256(i)), uint256());
+    BOOST_CHECK(cache.GetStats().nSize <= cache.GetStats().nMaxSize);
+    BOOST_CHECK(cache.Get(999, ArithToUint256(arith_uint256(999)), powHash));
+}
+
+BOOST_AUTO_TEST_CASE(pow_hash_precomputed)
+{
+    SelectParams(CBaseChainParams::MAIN);
+
+    // hash of early mainnet blocks comes from the precomputed table whatever the header is
+    CBlockHeader header;
+    header.SetNull();
+    BOOST_CHECK_EQUAL(header.GetPoWHash(1).ToString(), "00000da58fce09f363bf5bb42409fbc2aabfc8b58c2211b24a3d7e2a7deedc90");
+    BOOST_CHECK_EQUAL(header.GetPoWHash(20499).ToString(), "0000001f3ae8427fd5c6ae82f345b67a5bfa81812b3013d106dc1bab080a2074");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
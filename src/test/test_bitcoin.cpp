@@ -10,6 +10,7 @@
 #include "chainparams.h"
 #include "consensus/consensus.h"
 #include "consensus/validation.h"
+#include "executor.h"
 #include "key.h"
 #include "main.h"
 #include "miner.h"
@@ -81,8 +82,7 @@ TestingSetup::TestingSetup(const std::string& chainName, std::string suf) : Basi
             BOOST_CHECK(ok);
         }
         nScriptCheckThreads = 3;
-        for (int i=0; i < nScriptCheckThreads-1; i++)
-            threadGroup.create_thread(&ThreadScriptCheck);
+        GetExecutor().Start(nScriptCheckThreads-1);
         RegisterNodeSignals(GetNodeSignals());
 }
 
@@ -92,6 +92,7 @@ TestingSetup::~TestingSetup()
         exodus_shutdown();
         threadGroup.interrupt_all();
         threadGroup.join_all();
+        GetExecutor().Stop();
         UnloadBlockIndex();
         delete pcoinsTip;
         delete pcoinsdbview;
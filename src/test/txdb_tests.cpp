@@ -1,4 +1,5 @@
 #include "txdb.h"
+#include "chainparams.h"
 #include "uint256.h"
 #include "random.h"
 #include "test/test_bitcoin.h"
@@ -339,4 +340,133 @@ BOOST_AUTO_TEST_CASE(dbindexhelper_zerospend)
     }
 }
 
+BOOST_AUTO_TEST_CASE(supply_update)
+{
+    uint256 const hash0 = Params().GetConsensus().hashGenesisBlock, hash1 = uint256S("2"), hash2 = uint256S("3");
+    std::vector<std::pair<CBigNum, int> > const spends1 {{CBigNum(7), 10}, {CBigNum(8), 1}};
+    std::vector<std::pair<CBigNum, int> > const spends2 {{CBigNum(7), 10}, {CBigNum(7), 10}};
+    std::vector<int> const mints {10, 10, 1};
+
+    CBlockTreeDB blockTree(1 << 20, true);
+    CAmount total = 0;
+    CZerocoinSupply supply;
+
+    BOOST_CHECK(blockTree.UpdateSupply(hash1, hash0, 50 * COIN, spends1, mints, true));
+    BOOST_CHECK(blockTree.UpdateSupply(hash2, hash1, 40 * COIN, spends2, std::vector<int>(), true));
+    // connecting the block again after a crash doesn't count it twice
+    BOOST_CHECK(blockTree.UpdateSupply(hash2, hash1, 40 * COIN, spends2, std::vector<int>(), true));
+
+    BOOST_CHECK(blockTree.ReadTotalSupply(total));
+    BOOST_CHECK_EQUAL(total, 90 * COIN);
+    BOOST_CHECK(blockTree.ReadZerocoinSupply(supply));
+    BOOST_CHECK(supply.hashBlock == hash2);
+    BOOST_CHECK_EQUAL(supply.denominations[10].nMinted, 2);
+    BOOST_CHECK_EQUAL(supply.denominations[10].nSpent, 3);
+    BOOST_CHECK_EQUAL(supply.denominations[10].nDuplicateSpent, 2);
+    BOOST_CHECK_EQUAL(supply.denominations[1].nSpent, 1);
+    BOOST_CHECK_EQUAL(supply.denominations[1].nDuplicateSpent, 0);
+    BOOST_CHECK_EQUAL(supply.GetDuplicateSpendAmount(), 20 * COIN);
+
+    BOOST_CHECK(blockTree.UpdateSupply(hash2, hash1, 40 * COIN, spends2, std::vector<int>(), false));
+    BOOST_CHECK(blockTree.UpdateSupply(hash2, hash1, 40 * COIN, spends2, std::vector<int>(), false));
+
+    BOOST_CHECK(blockTree.ReadTotalSupply(total));
+    BOOST_CHECK_EQUAL(total, 50 * COIN);
+    BOOST_CHECK(blockTree.ReadZerocoinSupply(supply));
+    BOOST_CHECK(supply.hashBlock == hash1);
+    BOOST_CHECK_EQUAL(supply.denominations[10].nSpent, 1);
+    BOOST_CHECK_EQUAL(supply.GetDuplicateSpendAmount(), 0);
+
+    BOOST_CHECK(blockTree.UpdateSupply(hash1, hash0, 50 * COIN, spends1, mints, false));
+
+    BOOST_CHECK(blockTree.ReadTotalSupply(total));
+    BOOST_CHECK_EQUAL(total, 0);
+    BOOST_CHECK(blockTree.ReadZerocoinSupply(supply));
+    BOOST_CHECK(supply.denominations.empty());
+}
+
+BOOST_AUTO_TEST_CASE(supply_replay)
+{
+    uint256 const hash0 = Params().GetConsensus().hashGenesisBlock, hash1 = uint256S("2"), hash2 = uint256S("3"), hash3 = uint256S("4");
+    std::vector<std::pair<CBigNum, int> > const spends {{CBigNum(7), 10}};
+    std::vector<int> const mints {10};
+
+    CBlockTreeDB blockTree(1 << 20, true);
+    CAmount total = 0;
+    CZerocoinSupply supply;
+    bool fSupply = false;
+
+    BOOST_CHECK(blockTree.WriteFlag("supply", true));
+    BOOST_CHECK(blockTree.UpdateSupply(hash1, hash0, 50 * COIN, std::vector<std::pair<CBigNum, int> >(), mints, true));
+    BOOST_CHECK(blockTree.UpdateSupply(hash2, hash1, 40 * COIN, spends, std::vector<int>(), true));
+    BOOST_CHECK(blockTree.UpdateSupply(hash3, hash2, 30 * COIN, std::vector<std::pair<CBigNum, int> >(), mints, true));
+
+    // the chainstate is at hash1 after a crash, connecting hash2 again doesn't change the supply
+    BOOST_CHECK(blockTree.UpdateSupply(hash2, hash1, 40 * COIN, spends, std::vector<int>(), true));
+    BOOST_CHECK(blockTree.ReadFlag("supply", fSupply));
+    BOOST_CHECK(!fSupply);
+
+    BOOST_CHECK(blockTree.ReadTotalSupply(total));
+    BOOST_CHECK_EQUAL(total, 120 * COIN);
+    BOOST_CHECK(blockTree.ReadZerocoinSupply(supply));
+    BOOST_CHECK(supply.hashBlock == hash3);
+    BOOST_CHECK_EQUAL(supply.denominations[10].nMinted, 2);
+    BOOST_CHECK_EQUAL(supply.denominations[10].nSpent, 1);
+    BOOST_CHECK_EQUAL(supply.GetDuplicateSpendAmount(), 0);
+
+    // neither is a block below the supply disconnected from it
+    BOOST_CHECK(blockTree.UpdateSupply(hash1, hash0, 50 * COIN, std::vector<std::pair<CBigNum, int> >(), mints, false));
+    BOOST_CHECK(blockTree.ReadTotalSupply(total));
+    BOOST_CHECK_EQUAL(total, 120 * COIN);
+
+    // the supply calculated again starts from the first block, an empty supply isn't the base of any other block
+    BOOST_CHECK(blockTree.ResetSupply());
+    bool fFollows = true;
+    BOOST_CHECK(blockTree.UpdateSupply(hash2, hash1, 40 * COIN, spends, std::vector<int>(), true, &fFollows));
+    BOOST_CHECK(!fFollows);
+    BOOST_CHECK(blockTree.ReadTotalSupply(total));
+    BOOST_CHECK_EQUAL(total, 0);
+    BOOST_CHECK(blockTree.UpdateSupply(hash1, hash0, 50 * COIN, std::vector<std::pair<CBigNum, int> >(), mints, true, &fFollows));
+    BOOST_CHECK(fFollows);
+    BOOST_CHECK(blockTree.UpdateSupply(hash2, hash1, 40 * COIN, spends, std::vector<int>(), true));
+    BOOST_CHECK(blockTree.ReadTotalSupply(total));
+    BOOST_CHECK_EQUAL(total, 90 * COIN);
+    BOOST_CHECK(blockTree.ReadZerocoinSupply(supply));
+    BOOST_CHECK(supply.hashBlock == hash2);
+    BOOST_CHECK_EQUAL(supply.denominations[10].nSpent, 1);
+    BOOST_CHECK_EQUAL(supply.denominations[10].nDuplicateSpent, 0);
+}
+
+BOOST_AUTO_TEST_CASE(address_balance_replay)
+{
+    uint160 const address = uint160(ParseHex("0000000000000000000000000000000000000001"));
+    uint256 const txid1 = uint256S("2"), txid2 = uint256S("3");
+    AddressType const type = AddressType::payToPubKeyHash;
+
+    // the address receives 100 in one transaction of the block and spends 30 of them in the other one
+    std::vector<std::pair<CAddressIndexKey, CAmount> > const entries {
+        {CAddressIndexKey(type, address, 10, 1, txid1, 0, false), 100},
+        {CAddressIndexKey(type, address, 10, 2, txid2, 0, true), -30}};
+
+    CBlockTreeDB blockTree(1 << 20, true);
+    CAddressBalanceValue value;
+
+    // the block connected again after a crash doesn't change the balance twice
+    BOOST_CHECK(blockTree.WriteAddressIndex(entries));
+    BOOST_CHECK(blockTree.WriteAddressIndex(entries));
+    BOOST_CHECK(blockTree.ReadAddressBalance(address, type, value));
+    BOOST_CHECK_EQUAL(value.balance, 70);
+    BOOST_CHECK_EQUAL(value.received, 100);
+
+    // neither does disconnecting it twice
+    BOOST_CHECK(blockTree.EraseAddressIndex(entries));
+    BOOST_CHECK(blockTree.EraseAddressIndex(entries));
+    BOOST_CHECK(blockTree.ReadAddressBalance(address, type, value));
+    BOOST_CHECK(value.IsNull());
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    BOOST_CHECK(blockTree.ReadAddressIndex(address, type, addressIndex));
+    BOOST_CHECK(addressIndex.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "zerocoin.h"
+
+#include "test/test_bitcoin.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(zerocoin_params_tests, BasicTestingSetup)
+
+namespace {
+
+// Exponents around the interesting values for a group of the given order, the order is 0 for a group without a
+// known order
+std::vector<CBigNum> TestExponents(const CBigNum& order, const CBigNum& modulus)
+{
+    const CBigNum bound = order > 0 ? order : modulus;
+    const CBigNum random = CBigNum::randBignum(bound);
+
+    std::vector<CBigNum> exponents {CBigNum(0), CBigNum(1), CBigNum(2), CBigNum(15), CBigNum(16), CBigNum(17),
+                                    random, bound - 1, bound, bound + 1, bound * 3 + random,
+                                    CBigNum(-1), CBigNum(-16), CBigNum(0) - random, CBigNum(0) - bound - 1};
+    return exponents;
+}
+
+void CheckGroup(const libzerocoin::IntegerGroupParams& group)
+{
+    for (const CBigNum& e : TestExponents(group.groupOrder, group.modulus)) {
+        const CBigNum g = group.g.pow_mod(e, group.modulus);
+        const CBigNum h = group.h.pow_mod(e, group.modulus);
+
+        BOOST_CHECK_MESSAGE(group.gPow(e) == g, "gPow, exponent " << e.ToString());
+        BOOST_CHECK_MESSAGE(group.hPow(e) == h, "hPow, exponent " << e.ToString());
+        BOOST_CHECK_MESSAGE(group.g.pow_mod(e, group.modulus, group.montgomery()) == g, "pow_mod, exponent " << e.ToString());
+        BOOST_CHECK_MESSAGE(group.g.pow_mod2(e, group.h, e + 1, group.modulus, group.montgomery()) ==
+                            g.mul_mod(group.h.pow_mod(e + 1, group.modulus), group.modulus),
+                            "pow_mod2, exponent " << e.ToString());
+    }
+
+    // A copy sets up its own tables
+    libzerocoin::IntegerGroupParams copy(group);
+    const CBigNum e = CBigNum::randBignum(group.modulus);
+    BOOST_CHECK(copy.gPow(e) == group.g.pow_mod(e, group.modulus));
+    BOOST_CHECK(copy.hPow(e) == group.h.pow_mod(e, group.modulus));
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(precomputed_powers)
+{
+    CheckGroup(ZCParams->coinCommitmentGroup);
+    CheckGroup(ZCParams->serialNumberSoKCommitmentGroup);
+    CheckGroup(ZCParams->accumulatorParams.accumulatorPoKCommitmentGroup);
+    CheckGroup(ZCParamsV2->coinCommitmentGroup);
+}
+
+BOOST_AUTO_TEST_CASE(precomputed_powers_without_order)
+{
+    // The QRN generators are used modulo the accumulator modulus, the order of the group is unknown so the powers are
+    // computed with the Montgomery context only
+    const libzerocoin::AccumulatorAndProofParams& params = ZCParams->accumulatorParams;
+    libzerocoin::IntegerGroupParams group(params.accumulatorQRNCommitmentGroup);
+    group.modulus = params.accumulatorModulus;
+    BOOST_REQUIRE(group.groupOrder == 0);
+    CheckGroup(group);
+
+    for (const CBigNum& e : TestExponents(CBigNum(0), params.accumulatorModulus)) {
+        BOOST_CHECK(group.g.pow_mod(e, params.accumulatorModulus, params.accumulatorMontgomery()) ==
+                    group.g.pow_mod(e, params.accumulatorModulus));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
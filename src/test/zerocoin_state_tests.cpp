@@ -0,0 +1,439 @@
+#include "chainparams.h"
+#include "main.h"
+#include "random.h"
+#include "txdb.h"
+#include "zerocoin.h"
+
+#include "test/test_bitcoin.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+struct ZerocoinStateTestingSetup : public BasicTestingSetup {
+    vector<uint256> hashes;
+    vector<CBlockIndex> blocks;
+
+    ZerocoinStateTestingSetup(int nBlocks = 5) : hashes(nBlocks), blocks(nBlocks)
+    {
+        for (int i = 0; i < nBlocks; i++) {
+            hashes[i] = ArithToUint256(arith_uint256(i + 300));
+            blocks[i].phashBlock = &hashes[i];
+            blocks[i].pprev = i > 0 ? &blocks[i-1] : NULL;
+            blocks[i].nHeight = i;
+        }
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(zerocoin_state_tests, ZerocoinStateTestingSetup)
+
+BOOST_AUTO_TEST_CASE(zerocoin_accumulator_checkpoints)
+{
+    const Consensus::Params &params = Params().GetConsensus();
+    CZerocoinState state;
+
+    // blocks 0, 2 and 4 change accumulator for <1,1>, block 3 changes accumulator for <10,1>
+    vector<CZerocoinBlockData> blockData(blocks.size());
+    blockData[0].accumulatorChanges[make_pair(1, 1)] = make_pair(CBigNum(100), 1);
+    blockData[2].accumulatorChanges[make_pair(1, 1)] = make_pair(CBigNum(102), 2);
+    blockData[3].accumulatorChanges[make_pair(10, 1)] = make_pair(CBigNum(1003), 1);
+    blockData[4].accumulatorChanges[make_pair(1, 1)] = make_pair(CBigNum(104), 1);
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        ZerocoinWriteBlockData(&blocks[i], blockData[i]);
+        BOOST_CHECK(state.AddBlock(&blocks[i], params));
+    }
+
+    CZerocoinState::CAccumulatorCheckpoint checkpoint;
+    BOOST_CHECK(state.GetAccumulatorCheckpoint(1, 1, hashes[2], checkpoint));
+    BOOST_CHECK(checkpoint.block == &blocks[2]);
+    BOOST_CHECK_EQUAL(checkpoint.nHeight, 2);
+    BOOST_CHECK(checkpoint.accumulatorValue == CBigNum(102));
+    BOOST_CHECK_EQUAL(checkpoint.nMints, 2);
+    BOOST_CHECK(state.FindAccumulatorCheckpoint(make_pair(1, 1), &blocks[2]) != NULL);
+    BOOST_CHECK(state.FindAccumulatorCheckpoint(make_pair(1, 1), &blocks[3]) == NULL);
+    BOOST_CHECK(state.FindAccumulatorCheckpoint(make_pair(10, 1), hashes[3]) == state.FindAccumulatorCheckpoint(make_pair(10, 1), &blocks[3]));
+
+    // coin group counts the mints recorded by the checkpoints
+    CZerocoinState::CoinGroupInfo coinGroup;
+    BOOST_CHECK(state.GetCoinGroupInfo(1, 1, coinGroup));
+    BOOST_CHECK(coinGroup.firstBlock == &blocks[0]);
+    BOOST_CHECK(coinGroup.lastBlock == &blocks[4]);
+    BOOST_CHECK_EQUAL(coinGroup.nCoins, 4);
+
+    // block didn't change this coin group
+    BOOST_CHECK(!state.GetAccumulatorCheckpoint(1, 1, hashes[1], checkpoint));
+    BOOST_CHECK(!state.GetAccumulatorCheckpoint(1, 1, hashes[3], checkpoint));
+    BOOST_CHECK(state.GetAccumulatorCheckpoint(10, 1, hashes[3], checkpoint));
+    BOOST_CHECK(checkpoint.accumulatorValue == CBigNum(1003));
+
+    // disconnecting blocks removes their checkpoints and rolls the coin group back to the previous one
+    BOOST_CHECK(state.RemoveBlock(&blocks[4]));
+    BOOST_CHECK(!state.GetAccumulatorCheckpoint(1, 1, hashes[4], checkpoint));
+    BOOST_CHECK(state.GetAccumulatorCheckpoint(1, 1, hashes[2], checkpoint));
+    BOOST_CHECK(state.GetCoinGroupInfo(1, 1, coinGroup));
+    BOOST_CHECK(coinGroup.lastBlock == &blocks[2]);
+    BOOST_CHECK_EQUAL(coinGroup.nCoins, 3);
+
+    state.Reset();
+    BOOST_CHECK(!state.GetAccumulatorCheckpoint(1, 1, hashes[0], checkpoint));
+}
+
+BOOST_FIXTURE_TEST_CASE(zerocoin_block_data, TestingSetup)
+{
+    const Consensus::Params &params = Params().GetConsensus();
+    CZerocoinState state;
+
+    uint256 hash = ArithToUint256(arith_uint256(1));
+    CBlockIndex index;
+    index.phashBlock = &hash;
+    index.nHeight = params.nCheckBugFixedAtBlock + 1;
+
+    // block without zerocoin transactions doesn't have anything in the database
+    std::shared_ptr<const CZerocoinBlockData> cachedBlockData;
+    BOOST_CHECK(ZerocoinGetBlockData(&index, cachedBlockData));
+    BOOST_CHECK(cachedBlockData->IsNull());
+    BOOST_CHECK(!(index.nStatus & BLOCK_HAVE_ZEROCOIN));
+
+    CZerocoinBlockData blockData;
+    blockData.mintedPubCoins[make_pair(1, 1)].push_back(CBigNum(1001));
+    blockData.mintedPubCoins[make_pair(1, 1)].push_back(CBigNum(1002));
+    blockData.spentSerials.insert(CBigNum(2001));
+    blockData.accumulatorChanges[make_pair(1, 1)] = make_pair(CBigNum(3001), 2);
+
+    ZerocoinWriteBlockData(&index, blockData);
+    BOOST_CHECK(index.nStatus & BLOCK_HAVE_ZEROCOIN);
+
+    // the data is written to the database with the next block index flush only
+    CZerocoinBlockData diskBlockData;
+    BOOST_CHECK(!pblocktree->ReadZerocoinBlockData(hash, diskBlockData));
+    BOOST_CHECK(ZerocoinGetBlockData(&index, cachedBlockData));
+    BOOST_CHECK(cachedBlockData->mintedPubCoins == blockData.mintedPubCoins);
+
+    FlushStateToDisk();
+    BOOST_CHECK(pblocktree->ReadZerocoinBlockData(hash, diskBlockData));
+    BOOST_CHECK(diskBlockData.mintedPubCoins == blockData.mintedPubCoins);
+    BOOST_CHECK(diskBlockData.spentSerials == blockData.spentSerials);
+    BOOST_CHECK(diskBlockData.accumulatorChanges == blockData.accumulatorChanges);
+    BOOST_CHECK(ZerocoinGetBlockData(&index, cachedBlockData));
+    BOOST_CHECK(cachedBlockData->mintedPubCoins == blockData.mintedPubCoins);
+
+    // state is built from the data stored outside of the index
+    BOOST_CHECK(state.AddBlock(&index, params));
+    BOOST_CHECK(state.HasCoin(CBigNum(1001)));
+    BOOST_CHECK(state.HasCoin(CBigNum(1002)));
+    BOOST_CHECK(state.IsUsedCoinSerial(CBigNum(2001)));
+    CZerocoinState::CAccumulatorCheckpoint checkpoint;
+    BOOST_CHECK(state.GetAccumulatorCheckpoint(1, 1, hash, checkpoint));
+    BOOST_CHECK(checkpoint.accumulatorValue == CBigNum(3001));
+
+    BOOST_CHECK(state.RemoveBlock(&index));
+    BOOST_CHECK(!state.HasCoin(CBigNum(1001)));
+    BOOST_CHECK(!state.IsUsedCoinSerial(CBigNum(2001)));
+
+    // writing empty data resets the flag and erases the record with the next flush
+    ZerocoinWriteBlockData(&index, CZerocoinBlockData());
+    BOOST_CHECK(!(index.nStatus & BLOCK_HAVE_ZEROCOIN));
+    BOOST_CHECK(ZerocoinGetBlockData(&index, cachedBlockData));
+    BOOST_CHECK(cachedBlockData->IsNull());
+    FlushStateToDisk();
+    BOOST_CHECK(!pblocktree->ReadZerocoinBlockData(hash, diskBlockData));
+
+    // data that can't be read fails the state update instead of throwing
+    index.nStatus |= BLOCK_HAVE_ZEROCOIN;
+    BOOST_CHECK(!ZerocoinGetBlockData(&index, cachedBlockData));
+    BOOST_CHECK(!state.AddBlock(&index, params));
+    BOOST_CHECK(!state.HasCoin(CBigNum(1001)));
+}
+
+BOOST_FIXTURE_TEST_CASE(zerocoin_witness_update, TestingSetup)
+{
+    const Consensus::Params &params = Params().GetConsensus();
+    const libzerocoin::CoinDenomination d = libzerocoin::ZQ_LOVELACE;
+    const pair<int, int> denomAndId = make_pair((int)d, 1);
+    bool fModulusV2 = IsZerocoinTxV2(d, params, 1);
+    libzerocoin::Params *zcParams = fModulusV2 ? ZCParamsV2 : ZCParams;
+
+    // block 1 mints two coins, blocks 2 and 4 one coin each
+    vector<vector<CBigNum>> mints = {{}, {CBigNum(1001), CBigNum(1003)}, {CBigNum(1007)}, {}, {CBigNum(1009)}};
+    vector<uint256> hashes(mints.size());
+    vector<CBlockIndex> blocks(mints.size());
+    vector<CBigNum> accumulatorValues;
+    CZerocoinState state;
+    CChain chain;
+
+    libzerocoin::Accumulator accumulator(zcParams, d);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        hashes[i] = ArithToUint256(arith_uint256(i + 100));
+        blocks[i].phashBlock = &hashes[i];
+        blocks[i].pprev = i > 0 ? &blocks[i-1] : NULL;
+        blocks[i].nHeight = i;
+
+        CZerocoinBlockData blockData;
+        if (!mints[i].empty()) {
+            for (const CBigNum &coin: mints[i])
+                accumulator += libzerocoin::PublicCoin(zcParams, coin, d);
+            blockData.mintedPubCoins[denomAndId] = mints[i];
+            blockData.accumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), (int)mints[i].size());
+        }
+        accumulatorValues.push_back(accumulator.getValue());
+
+        ZerocoinWriteBlockData(&blocks[i], blockData);
+        BOOST_CHECK(state.AddBlock(&blocks[i], params));
+    }
+    chain.SetTip(&blocks.back());
+
+    // witness of the second coin of block 1 calculated from scratch
+    CBigNum witnessStart;
+    vector<CBigNum> newCoins;
+    BOOST_CHECK(state.GetWitnessUpdate(&chain, -1, 4, d, 1, CBigNum(1003), fModulusV2, witnessStart, newCoins));
+    BOOST_CHECK(witnessStart == zcParams->accumulatorParams.accumulatorBase);
+    BOOST_CHECK(newCoins == vector<CBigNum>({CBigNum(1001), CBigNum(1007), CBigNum(1009)}));
+
+    // witness calculated up to block 2 needs only the coins minted later
+    BOOST_CHECK(!state.GetWitnessUpdate(&chain, 2, 4, d, 1, CBigNum(1003), fModulusV2, witnessStart, newCoins));
+    BOOST_CHECK(newCoins == vector<CBigNum>({CBigNum(1009)}));
+    BOOST_CHECK(!state.GetWitnessUpdate(&chain, 2, 3, d, 1, CBigNum(1003), fModulusV2, witnessStart, newCoins));
+    BOOST_CHECK(newCoins.empty());
+
+    // coin minted later starts from the accumulator value preceding its mint
+    BOOST_CHECK(state.GetWitnessUpdate(&chain, -1, 3, d, 1, CBigNum(1007), fModulusV2, witnessStart, newCoins));
+    BOOST_CHECK(witnessStart == accumulatorValues[1]);
+    BOOST_CHECK(newCoins.empty());
+
+    // incrementally advanced witness is the same as the one calculated at once
+    libzerocoin::Accumulator witnessValue(zcParams, zcParams->accumulatorParams.accumulatorBase, d);
+    state.GetWitnessUpdate(&chain, -1, 2, d, 1, CBigNum(1003), fModulusV2, witnessStart, newCoins);
+    for (const CBigNum &coin: newCoins)
+        witnessValue += libzerocoin::PublicCoin(zcParams, coin, d);
+    state.GetWitnessUpdate(&chain, 2, 4, d, 1, CBigNum(1003), fModulusV2, witnessStart, newCoins);
+    for (const CBigNum &coin: newCoins)
+        witnessValue += libzerocoin::PublicCoin(zcParams, coin, d);
+
+    libzerocoin::PublicCoin pubCoin(zcParams, CBigNum(1003), d);
+    libzerocoin::AccumulatorWitness witness = state.GetWitnessForSpend(&chain, 4, d, 1, CBigNum(1003), fModulusV2);
+    BOOST_CHECK(witness.getValue() == witnessValue.getValue());
+    BOOST_CHECK(witness.VerifyWitness(libzerocoin::Accumulator(zcParams, accumulatorValues[4], d), pubCoin));
+
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it)
+        BOOST_CHECK(state.RemoveBlock(&*it));
+}
+
+BOOST_FIXTURE_TEST_CASE(zerocoin_recalculate_accumulators, TestingSetup)
+{
+    const Consensus::Params &params = Params().GetConsensus();
+    const libzerocoin::CoinDenomination d1 = libzerocoin::ZQ_LOVELACE, d10 = libzerocoin::ZQ_GOLDWASSER;
+    const pair<int, int> group1 = make_pair((int)d1, params.nSpendV2ID_1), group10 = make_pair((int)d10, params.nSpendV2ID_10);
+
+    vector<uint256> hashes(4);
+    vector<CBlockIndex> blocks(4);
+    CZerocoinState state;
+    CChain chain;
+
+    // both groups have mints in blocks 1 and 3. Group of denomination 1 has values calculated with the old modulus
+    libzerocoin::Accumulator acc1(ZCParamsV2, d1), acc10(ZCParamsV2, d10), accOld(ZCParams, d1);
+    vector<CBigNum> values1;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        hashes[i] = ArithToUint256(arith_uint256(i + 200));
+        blocks[i].phashBlock = &hashes[i];
+        blocks[i].pprev = i > 0 ? &blocks[i-1] : NULL;
+        blocks[i].nHeight = i;
+
+        CZerocoinBlockData blockData;
+        if (i % 2 == 1) {
+            CBigNum coin1(1001 + i), coin10(2001 + i);
+            acc1 += libzerocoin::PublicCoin(ZCParamsV2, coin1, d1);
+            acc10 += libzerocoin::PublicCoin(ZCParamsV2, coin10, d10);
+            accOld += libzerocoin::PublicCoin(ZCParams, coin1, d1);
+            blockData.mintedPubCoins[group1].push_back(coin1);
+            blockData.mintedPubCoins[group10].push_back(coin10);
+            blockData.accumulatorChanges[group1] = make_pair(accOld.getValue(), 1);
+            blockData.accumulatorChanges[group10] = make_pair(acc10.getValue(), 1);
+            values1.push_back(acc1.getValue());
+        }
+
+        ZerocoinWriteBlockData(&blocks[i], blockData);
+        BOOST_CHECK(state.AddBlock(&blocks[i], params));
+    }
+    chain.SetTip(&blocks.back());
+
+    // groups verified before are not checked
+    set<CBlockIndex *> changes;
+    BOOST_CHECK(state.RecalculateAccumulators(&chain, changes, 3));
+    BOOST_CHECK(changes.empty());
+
+    // only the group with wrong values is recalculated
+    BOOST_CHECK(state.RecalculateAccumulators(&chain, changes));
+    BOOST_CHECK(changes == set<CBlockIndex *>({&blocks[1], &blocks[3]}));
+    CZerocoinState::CAccumulatorCheckpoint checkpoint;
+    BOOST_CHECK(state.GetAccumulatorCheckpoint(group1.first, group1.second, hashes[1], checkpoint));
+    BOOST_CHECK(checkpoint.accumulatorValue == values1[0]);
+    BOOST_CHECK(state.GetAccumulatorCheckpoint(group1.first, group1.second, hashes[3], checkpoint));
+    BOOST_CHECK(checkpoint.accumulatorValue == values1[1]);
+    BOOST_CHECK(state.GetAccumulatorCheckpoint(group10.first, group10.second, hashes[3], checkpoint));
+    BOOST_CHECK(checkpoint.accumulatorValue == acc10.getValue());
+
+    // new values are written to the block data to be stored with the changed index entries
+    std::shared_ptr<const CZerocoinBlockData> blockData;
+    BOOST_CHECK(ZerocoinGetBlockData(&blocks[3], blockData));
+    BOOST_CHECK(blockData->accumulatorChanges.at(group1) == make_pair(values1[1], 1));
+    BOOST_CHECK(blockData->accumulatorChanges.at(group10) == make_pair(acc10.getValue(), 1));
+
+    // nothing to do the second time
+    BOOST_CHECK(state.RecalculateAccumulators(&chain, changes));
+    BOOST_CHECK(changes.empty());
+}
+
+BOOST_AUTO_TEST_CASE(zerocoin_serial_set)
+{
+    CZerocoinSerialSet serials;
+    vector<CBigNum> values;
+    for (int i = 0; i < 1000; i++) {
+        CBigNum serial;
+        uint256 value = GetRandHash();
+        BN_bin2bn(value.begin(), value.size(), &serial);
+        values.push_back(serial);
+        BOOST_CHECK(serials.insert(serial));
+    }
+    BOOST_CHECK_EQUAL(serials.size(), 1000U);
+    BOOST_CHECK(!serials.insert(values[0]));
+
+    // erase every third serial, the rest should be still reachable
+    for (int i = 0; i < 1000; i += 3)
+        BOOST_CHECK_EQUAL(serials.erase(values[i]), 1U);
+    BOOST_CHECK_EQUAL(serials.erase(values[0]), 0U);
+    for (int i = 0; i < 1000; i++)
+        BOOST_CHECK_EQUAL(serials.count(values[i]), i % 3 == 0 ? 0U : 1U);
+
+    // small, negative and oversized serials have distinct digests
+    CBigNum negative = values[1];
+    BN_set_negative(&negative, 1);
+    CBigNum oversized = values[1] << 256;
+    BOOST_CHECK(GetZerocoinSerialDigest(CBigNum(0)) != GetZerocoinSerialDigest(CBigNum(1)));
+    BOOST_CHECK(GetZerocoinSerialDigest(negative) != GetZerocoinSerialDigest(values[1]));
+    BOOST_CHECK(!serials.count(negative));
+    BOOST_CHECK(!serials.count(oversized));
+    BOOST_CHECK(serials.insert(CBigNum(0)));
+    BOOST_CHECK(serials.count(CBigNum(0)));
+
+    // state uses the set for both the chain and the mempool
+    CZerocoinState state;
+    state.AddSpend(values[1]);
+    BOOST_CHECK(state.IsUsedCoinSerial(values[1]));
+    BOOST_CHECK(!state.CanAddSpendToMempool(values[1]));
+    BOOST_CHECK(state.AddSpendToMempool(values[2], ArithToUint256(arith_uint256(7))));
+    BOOST_CHECK(!state.CanAddSpendToMempool(values[2]));
+    BOOST_CHECK(state.GetMempoolConflictingTxHash(values[2]) == ArithToUint256(arith_uint256(7)));
+    state.RemoveSpendFromMempool(values[2]);
+    BOOST_CHECK(state.CanAddSpendToMempool(values[2]));
+
+    serials.clear();
+    BOOST_CHECK(serials.empty());
+    BOOST_CHECK(!serials.count(values[1]));
+}
+
+BOOST_AUTO_TEST_CASE(zerocoin_batch_spend_verify)
+{
+    libzerocoin::Params *zcParams = ZCParamsV2;
+
+    libzerocoin::PrivateCoin coin1(zcParams, libzerocoin::ZQ_LOVELACE, ZEROCOIN_TX_VERSION_2);
+    libzerocoin::PrivateCoin coin2(zcParams, libzerocoin::ZQ_LOVELACE, ZEROCOIN_TX_VERSION_2);
+
+    libzerocoin::Accumulator accumulator(zcParams, libzerocoin::ZQ_LOVELACE);
+    libzerocoin::AccumulatorWitness witness1(zcParams, accumulator, coin1.getPublicCoin());
+    libzerocoin::AccumulatorWitness witness2(zcParams, accumulator, coin2.getPublicCoin());
+    accumulator += coin1.getPublicCoin();
+    accumulator += coin2.getPublicCoin();
+    witness1.AddElement(coin2.getPublicCoin());
+    witness2.AddElement(coin1.getPublicCoin());
+
+    libzerocoin::SpendMetaData metaData(1, ArithToUint256(arith_uint256(1)));
+    libzerocoin::CoinSpend spend1(zcParams, coin1, accumulator, witness1, metaData);
+    libzerocoin::CoinSpend spend2(zcParams, coin2, accumulator, witness2, metaData);
+    spend1.setVersion(ZEROCOIN_TX_VERSION_2);
+    spend2.setVersion(ZEROCOIN_TX_VERSION_2);
+
+    vector<const libzerocoin::CoinSpend *> spends = {&spend1, &spend2};
+    vector<libzerocoin::Accumulator> accumulators(2, accumulator);
+    vector<libzerocoin::SpendMetaData> spendMetaData(2, metaData);
+    vector<bool> results;
+
+    BOOST_CHECK(libzerocoin::CoinSpend::VerifyBatch(spends, accumulators, spendMetaData, results));
+    BOOST_CHECK(results[0] && results[1]);
+
+    // only the spend checked against wrong accumulator value fails
+    accumulators[1] = libzerocoin::Accumulator(zcParams, libzerocoin::ZQ_LOVELACE);
+    BOOST_CHECK(!libzerocoin::CoinSpend::VerifyBatch(spends, accumulators, spendMetaData, results));
+    BOOST_CHECK(results[0] && !results[1]);
+    BOOST_CHECK(!spend2.Verify(accumulators[1], metaData));
+
+    // spends are collected during the block check and verified at once
+    CZerocoinTxInfo zerocoinTxInfo;
+    zerocoinTxInfo.spendsToVerify.push_back({uint256(), std::make_shared<libzerocoin::CoinSpend>(spend1), accumulator, metaData});
+    zerocoinTxInfo.spendsToVerify.push_back({uint256(), std::make_shared<libzerocoin::CoinSpend>(spend2), accumulator, metaData});
+    BOOST_CHECK(zerocoinTxInfo.VerifySpends());
+    BOOST_CHECK(zerocoinTxInfo.spendsToVerify.empty());
+
+    zerocoinTxInfo.spendsToVerify.push_back({uint256(), std::make_shared<libzerocoin::CoinSpend>(spend1), accumulators[1], metaData});
+    BOOST_CHECK(!zerocoinTxInfo.VerifySpends());
+}
+
+BOOST_AUTO_TEST_CASE(zerocoin_batch_accumulate)
+{
+    libzerocoin::Params *zcParams = ZCParamsV2;
+    libzerocoin::CoinDenomination d = libzerocoin::ZQ_LOVELACE;
+
+    vector<libzerocoin::PublicCoin> coins;
+    for (int i = 0; i < 5; i++)
+        coins.push_back(libzerocoin::PublicCoin(zcParams, CBigNum(1000 + 2 * i + 1), d));
+
+    libzerocoin::Accumulator start(zcParams, d);
+    libzerocoin::Accumulator accumulator(start), batchAccumulator(start);
+    for (const libzerocoin::PublicCoin &coin: coins)
+        accumulator += coin;
+    batchAccumulator.accumulate(coins);
+    BOOST_CHECK(batchAccumulator == accumulator);
+
+    // a coin of wrong denomination leaves the accumulator unchanged
+    vector<libzerocoin::PublicCoin> wrongCoins = coins;
+    wrongCoins.push_back(libzerocoin::PublicCoin(zcParams, CBigNum(2001), libzerocoin::ZQ_GOLDWASSER));
+    BOOST_CHECK_THROW(batchAccumulator.accumulate(wrongCoins), ZerocoinException);
+    BOOST_CHECK(batchAccumulator == accumulator);
+
+    // witness of every coin is the accumulator without that coin
+    vector<libzerocoin::AccumulatorWitness> witnesses = libzerocoin::AccumulatorWitness::ForCoins(zcParams, start, coins);
+    BOOST_CHECK_EQUAL(witnesses.size(), coins.size());
+    for (size_t i = 0; i < coins.size(); i++) {
+        libzerocoin::AccumulatorWitness witness(zcParams, start, coins[i]);
+        for (const libzerocoin::PublicCoin &coin: coins)
+            witness.AddElement(coin);
+        BOOST_CHECK(witnesses[i].getValue() == witness.getValue());
+        BOOST_CHECK(witnesses[i].VerifyWitness(accumulator, coins[i]));
+    }
+
+    BOOST_CHECK(libzerocoin::AccumulatorWitness::ForCoins(zcParams, start, vector<libzerocoin::PublicCoin>()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(zerocoin_parallel_mint)
+{
+    libzerocoin::Params *zcParams = ZCParamsV2;
+    vector<libzerocoin::CoinDenomination> denominations = {libzerocoin::ZQ_LOVELACE, libzerocoin::ZQ_WILLIAMSON,
+                                                           libzerocoin::ZQ_LOVELACE};
+
+    vector<libzerocoin::PrivateCoin> coins = libzerocoin::PrivateCoin::mintCoins(zcParams, denominations, ZEROCOIN_TX_VERSION_2);
+    BOOST_CHECK_EQUAL(coins.size(), denominations.size());
+    for (size_t i = 0; i < coins.size(); i++) {
+        BOOST_CHECK_EQUAL(coins[i].getPublicCoin().getDenomination(), denominations[i]);
+        BOOST_CHECK_EQUAL(coins[i].getVersion(), ZEROCOIN_TX_VERSION_2);
+        BOOST_CHECK(coins[i].getPublicCoin().validate());
+    }
+    BOOST_CHECK(coins[0].getPublicCoin() != coins[2].getPublicCoin());
+
+    // minting stops once cancelled
+    BOOST_CHECK_THROW(libzerocoin::PrivateCoin::mintCoins(zcParams, denominations, ZEROCOIN_TX_VERSION_2, [] { return true; }),
+                      ZerocoinException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
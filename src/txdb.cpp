@@ -24,15 +24,20 @@ static const char DB_BLOCK_FILES = 'f';
 static const char DB_TXINDEX = 't';
 static const char DB_ADDRESSINDEX = 'a';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
+static const char DB_ADDRESSBALANCE = 'A';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCK_INDEX = 'b';
+static const char DB_ZEROCOIN_BLOCK = 'z';
 
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
 static const char DB_TOTAL_SUPPLY = 'S';
+static const char DB_ZEROCOIN_VERIFIED_BLOCK = 'Z';
+static const char DB_ZEROCOIN_SUPPLY = 'Y';
+static const char DB_ZEROCOIN_SERIAL_SPENDS = 'y';
 
 
 CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true) 
@@ -144,7 +149,8 @@ void CCoinsViewDBCursor::Next()
         keyTmp.first = 0; // Invalidate cached key after last record so that Valid() and GetKey() return false
 }
 
-bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) {
+bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo,
+                                  const std::vector<std::pair<uint256, const CZerocoinBlockData*> >& zerocoinBlockData) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<int, const CBlockFileInfo*> >::const_iterator it=fileInfo.begin(); it != fileInfo.end(); it++) {
         batch.Write(make_pair(DB_BLOCK_FILES, it->first), *it->second);
@@ -153,6 +159,13 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     for (std::vector<const CBlockIndex*>::const_iterator it=blockinfo.begin(); it != blockinfo.end(); it++) {
     	batch.Write(make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), CDiskBlockIndex(*it));
     }
+    // zerocoin data goes with the BLOCK_HAVE_ZEROCOIN flag of the index entries
+    for (std::vector<std::pair<uint256, const CZerocoinBlockData*> >::const_iterator it=zerocoinBlockData.begin(); it != zerocoinBlockData.end(); it++) {
+        if (it->second->IsNull())
+            batch.Erase(make_pair(DB_ZEROCOIN_BLOCK, it->first));
+        else
+            batch.Write(make_pair(DB_ZEROCOIN_BLOCK, it->first), *it->second);
+    }
     return WriteBatch(batch, true);
 }
 
@@ -198,17 +211,32 @@ bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddres
 bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, AddressType type,
                                            std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
 
+    return ReadAddressUnspentIndex(addressHash, type, [&unspentOutputs](const CAddressUnspentKey &key, const CAddressUnspentValue &value) {
+        unspentOutputs.push_back(make_pair(key, value));
+        return true;
+    });
+}
+
+bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, AddressType type,
+                                           boost::function<bool (const CAddressUnspentKey&, const CAddressUnspentValue&)> visitor,
+                                           const CAddressUnspentKey *pfrom) {
+
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
 
-    pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    if (pfrom) {
+        pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, *pfrom));
+    } else {
+        pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
 
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressUnspentKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash && key.second.type == type) {
             CAddressUnspentValue nValue;
             if (pcursor->GetValue(nValue)) {
-                unspentOutputs.push_back(make_pair(key.second, nValue));
+                if (!visitor(key.second, nValue))
+                    break;
                 pcursor->Next();
             } else {
                 return error("failed to get address unspent value");
@@ -221,17 +249,75 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, AddressType type
     return true;
 }
 
+namespace {
+
+typedef std::map<std::pair<AddressType, uint160>, CAddressBalanceValue> AddressBalanceChanges;
+
+void AddBalanceChange(AddressBalanceChanges &changes, CAddressIndexKey const & key, CAmount amount)
+{
+    CAddressBalanceValue &change = changes[std::make_pair(key.type, key.hashBytes)];
+    change.balance += amount;
+    if (amount > 0)
+        change.received += amount;
+}
+
+void WriteBalanceChanges(CBlockTreeDB const & db, CDBBatch &batch, AddressBalanceChanges const & changes, bool fConnect)
+{
+    for (AddressBalanceChanges::const_iterator it = changes.begin(); it != changes.end(); ++it) {
+        std::pair<char, CAddressIndexIteratorKey> key(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(it->first.first, it->first.second));
+        CAddressBalanceValue value;
+        db.Read(key, value);
+        if (fConnect) {
+            value.balance += it->second.balance;
+            value.received += it->second.received;
+        } else {
+            value.balance -= it->second.balance;
+            value.received -= it->second.received;
+        }
+        if (value.IsNull()) {
+            batch.Erase(key);
+        } else {
+            batch.Write(key, value);
+        }
+    }
+}
+
+}
+
 bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
+    if (vect.empty())
+        return true;
+
+    // Entries of a block are written in one batch, if any of them is there the block is already indexed, e.g. when
+    // it's connected again after a crash, and the balances are not changed twice
+    bool fIndexed = Exists(make_pair(DB_ADDRESSINDEX, vect.front().first));
+
     CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-    batch.Write(make_pair(DB_ADDRESSINDEX, it->first), it->second);
+    AddressBalanceChanges changes;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        if (!fIndexed)
+            AddBalanceChange(changes, it->first, it->second);
+        batch.Write(make_pair(DB_ADDRESSINDEX, it->first), it->second);
+    }
+    WriteBalanceChanges(*this, batch, changes, true);
     return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
+    if (vect.empty())
+        return true;
+
+    // Same for a block disconnected again, the entries carry the amounts they were written with
+    bool fIndexed = Exists(make_pair(DB_ADDRESSINDEX, vect.front().first));
+
     CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-    batch.Erase(make_pair(DB_ADDRESSINDEX, it->first));
+    AddressBalanceChanges changes;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        if (fIndexed)
+            AddBalanceChange(changes, it->first, it->second);
+        batch.Erase(make_pair(DB_ADDRESSINDEX, it->first));
+    }
+    WriteBalanceChanges(*this, batch, changes, false);
     return WriteBatch(batch);
 }
 
@@ -239,9 +325,21 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, AddressType type,
                                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                                     int start, int end) {
 
+    return ReadAddressIndex(addressHash, type, [&addressIndex](const CAddressIndexKey &key, CAmount value) {
+        addressIndex.push_back(make_pair(key, value));
+        return true;
+    }, start, end);
+}
+
+bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, AddressType type,
+                                    boost::function<bool (const CAddressIndexKey&, CAmount)> visitor,
+                                    int start, int end, const CAddressIndexKey *pfrom) {
+
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
 
-    if (start > 0 && end > 0) {
+    if (pfrom) {
+        pcursor->Seek(make_pair(DB_ADDRESSINDEX, *pfrom));
+    } else if (start > 0 && end > 0) {
         pcursor->Seek(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
     } else {
         pcursor->Seek(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
@@ -256,7 +354,8 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, AddressType type,
             }
             CAmount nValue;
             if (pcursor->GetValue(nValue)) {
-                addressIndex.push_back(make_pair(key.second, nValue));
+                if (!visitor(key.second, nValue))
+                    break;
                 pcursor->Next();
             } else {
                 return error("failed to get address index value");
@@ -269,6 +368,78 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, AddressType type,
     return true;
 }
 
+bool CBlockTreeDB::ReadAddressBalance(uint160 addressHash, AddressType type, CAddressBalanceValue &value) {
+    value.SetNull();
+    Read(make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(type, addressHash)), value);
+    return true;
+}
+
+bool CBlockTreeDB::RebuildAddressBalances() {
+    // Number of addresses written per batch
+    static const size_t nBatchAddresses = 10000;
+
+    // Remove the existing aggregates
+    {
+        boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+        CDBBatch batch(*this);
+        for (pcursor->Seek(DB_ADDRESSBALANCE); pcursor->Valid(); pcursor->Next()) {
+            boost::this_thread::interruption_point();
+            std::pair<char, CAddressIndexIteratorKey> key;
+            if (!pcursor->GetKey(key) || key.first != DB_ADDRESSBALANCE)
+                break;
+            batch.Erase(key);
+        }
+        if (!WriteBatch(batch))
+            return error("failed to remove address balances");
+    }
+
+    // The entries of an address are stored next to each other, so the index is summed up in one pass
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(DB_ADDRESSINDEX);
+
+    bool fDone = false;
+    std::pair<AddressType, uint160> address;
+    CAddressBalanceValue value;
+
+    while (!fDone) {
+        CDBBatch batch(*this);
+        size_t nAddresses = 0;
+
+        while (true) {
+            boost::this_thread::interruption_point();
+            std::pair<char,CAddressIndexKey> key;
+            if (!pcursor->Valid() || !pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX) {
+                fDone = true;
+                break;
+            }
+            if (key.second.type != address.first || key.second.hashBytes != address.second) {
+                if (!value.IsNull()) {
+                    batch.Write(make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(address.first, address.second)), value);
+                    nAddresses++;
+                }
+                address = std::make_pair(key.second.type, key.second.hashBytes);
+                value.SetNull();
+                if (nAddresses >= nBatchAddresses)
+                    break;
+            }
+            CAmount nValue;
+            if (!pcursor->GetValue(nValue))
+                return error("failed to get address index value");
+            value.balance += nValue;
+            if (nValue > 0)
+                value.received += nValue;
+            pcursor->Next();
+        }
+
+        if (fDone && !value.IsNull())
+            batch.Write(make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(address.first, address.second)), value);
+
+        if (!WriteBatch(batch))
+            return error("failed to write address balances");
+    }
+
+    return true;
+}
 
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
     CDBBatch batch(*this);
@@ -308,6 +479,32 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+// Number of block index entries which PoW is checked at once while loading the block index
+static const size_t POW_CHECK_BATCH_SIZE = 2000;
+
+// Check PoW of the loaded block index entries. Hashes are calculated in parallel
+static bool CheckBlockIndexPoW(const std::vector<CBlockIndex*> &blocks, const Consensus::Params &consensusParams)
+{
+    std::vector<CBlockHeader> headers;
+    std::vector<int> nHeights;
+    headers.reserve(blocks.size());
+    nHeights.reserve(blocks.size());
+    BOOST_FOREACH(const CBlockIndex *pindex, blocks) {
+        headers.push_back(pindex->GetBlockHeader());
+        nHeights.push_back(pindex->nHeight);
+    }
+
+    std::vector<uint256> powHashes;
+    CalculatePoWHashes(headers, nHeights, powHashes);
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (!CheckProofOfWork(powHashes[i], blocks[i]->nBits, consensusParams))
+            if (!CheckProofOfWork(blocks[i]->GetBlockPoWHash(true), blocks[i]->nBits, consensusParams))
+                return error("LoadBlockIndex(): CheckProofOfWork failed: %s", blocks[i]->ToString());
+    }
+    return true;
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
 {
     auto consensusParams = Params().GetConsensus();
@@ -317,6 +514,12 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
 
     pcursor->Seek(make_pair(DB_BLOCK_INDEX, uint256()));
 
+    // Zerocoin data found in block index records written by older versions is moved to its own records
+    CDBBatch zerocoinMigrationBatch(*this);
+    int nZerocoinMigrated = 0;
+
+    std::vector<CBlockIndex*> blocksToCheck;
+
     // Load mapBlockIndex
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
@@ -350,13 +553,28 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
                     pindexNew->reserved[1] = diskindex.reserved[1];
                 }                
 
-                pindexNew->accumulatorChanges = diskindex.accumulatorChanges;
-                pindexNew->mintedPubCoins     = diskindex.mintedPubCoins;
-                pindexNew->spentSerials       = diskindex.spentSerials;
-
-                if (!CheckProofOfWork(pindexNew->GetBlockPoWHash(), pindexNew->nBits, consensusParams))
-                    if (!CheckProofOfWork(pindexNew->GetBlockPoWHash(true), pindexNew->nBits, consensusParams))
-                        return error("LoadBlockIndex(): CheckProofOfWork failed: %s", pindexNew->ToString());
+                if (!diskindex.mintedPubCoins.empty() || !diskindex.spentSerials.empty() || !diskindex.accumulatorChanges.empty()) {
+                    CZerocoinBlockData zerocoinData;
+                    zerocoinData.mintedPubCoins.swap(diskindex.mintedPubCoins);
+                    zerocoinData.spentSerials.swap(diskindex.spentSerials);
+                    zerocoinData.accumulatorChanges.swap(diskindex.accumulatorChanges);
+                    pindexNew->nStatus |= BLOCK_HAVE_ZEROCOIN;
+
+                    zerocoinMigrationBatch.Write(make_pair(DB_ZEROCOIN_BLOCK, pindexNew->GetBlockHash()), zerocoinData);
+                    zerocoinMigrationBatch.Write(make_pair(DB_BLOCK_INDEX, pindexNew->GetBlockHash()), CDiskBlockIndex(pindexNew));
+                    if (++nZerocoinMigrated % 1000 == 0) {
+                        if (!WriteBatch(zerocoinMigrationBatch))
+                            return error("LoadBlockIndex() : failed to write zerocoin data");
+                        zerocoinMigrationBatch.Clear();
+                    }
+                }
+
+                blocksToCheck.push_back(pindexNew);
+                if (blocksToCheck.size() >= POW_CHECK_BATCH_SIZE) {
+                    if (!CheckBlockIndexPoW(blocksToCheck, consensusParams))
+                        return false;
+                    blocksToCheck.clear();
+                }
 
                 pcursor->Next();
             } else {
@@ -367,6 +585,15 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
         }
     }
 
+    if (!CheckBlockIndexPoW(blocksToCheck, consensusParams))
+        return false;
+
+    if (nZerocoinMigrated > 0) {
+        if (!WriteBatch(zerocoinMigrationBatch, true))
+            return error("LoadBlockIndex() : failed to write zerocoin data");
+        LogPrintf("LoadBlockIndex(): moved zerocoin data of %d blocks out of block index records\n", nZerocoinMigrated);
+    }
+
     return true;
 }
 
@@ -390,12 +617,99 @@ int CBlockTreeDB::GetBlockIndexVersion()
 	return -1;
 }
 
-bool CBlockTreeDB::AddTotalSupply(CAmount const & supply)
+bool CBlockTreeDB::UpdateSupply(const uint256 &hashBlock, const uint256 &hashPrevBlock, CAmount nSubsidy,
+                                const std::vector<std::pair<CBigNum, int> > &spends, const std::vector<int> &mints, bool fConnect,
+                                bool *pfFollows)
 {
-    CAmount current = 0;
-    Read(DB_TOTAL_SUPPLY, current);
-    current += supply;
-    return Write(DB_TOTAL_SUPPLY, current);
+    if (pfFollows)
+        *pfFollows = true;
+
+    CZerocoinSupply supply;
+    Read(DB_ZEROCOIN_SUPPLY, supply);
+    // The supply is written as blocks are connected while the chainstate is flushed periodically, the block the
+    // supply is at is connected or disconnected again after a crash
+    if (supply.hashBlock == (fConnect ? hashBlock : hashPrevBlock))
+        return true;
+    // Any other block doesn't follow the supply and the supply has to be calculated again. An empty supply is the
+    // base of the first block after the genesis block only
+    bool fEmptyBase = fConnect && supply.hashBlock.IsNull() && hashPrevBlock == Params().GetConsensus().hashGenesisBlock;
+    if (supply.hashBlock != (fConnect ? hashPrevBlock : hashBlock) && !fEmptyBase) {
+        LogPrintf("%s: the supply at block %s can't be updated with block %s\n",
+                  __func__, supply.hashBlock.ToString(), hashBlock.ToString());
+        if (pfFollows)
+            *pfFollows = false;
+        return WriteFlag("supply", false);
+    }
+
+    CDBBatch batch(*this);
+
+    CAmount total = 0;
+    Read(DB_TOTAL_SUPPLY, total);
+    total += fConnect ? nSubsidy : -nSubsidy;
+    batch.Write(DB_TOTAL_SUPPLY, total);
+
+    BOOST_FOREACH(int denomination, mints) {
+        supply.denominations[denomination].nMinted += fConnect ? 1 : -1;
+    }
+
+    // Number of spends of every serial, spends after the first one are duplicates. Spends are rolled back in
+    // reverse order, serials spent more than once in the block are counted in the map
+    std::map<CBigNum, int> serialSpends;
+    for (size_t i = 0; i < spends.size(); i++) {
+        const std::pair<CBigNum, int> &spend = spends[fConnect ? i : spends.size() - 1 - i];
+        CZerocoinSupply::CDenominationSupply &denomination = supply.denominations[spend.second];
+
+        std::map<CBigNum, int>::iterator it = serialSpends.find(spend.first);
+        if (it == serialSpends.end()) {
+            int nSpends = 0;
+            Read(make_pair(DB_ZEROCOIN_SERIAL_SPENDS, spend.first), nSpends);
+            it = serialSpends.insert(std::make_pair(spend.first, nSpends)).first;
+        }
+
+        if (fConnect) {
+            if (it->second++ > 0)
+                denomination.nDuplicateSpent++;
+            denomination.nSpent++;
+        } else {
+            if (--it->second > 0)
+                denomination.nDuplicateSpent--;
+            denomination.nSpent--;
+        }
+    }
+
+    for (std::map<CBigNum, int>::const_iterator it = serialSpends.begin(); it != serialSpends.end(); ++it) {
+        if (it->second > 0)
+            batch.Write(make_pair(DB_ZEROCOIN_SERIAL_SPENDS, it->first), it->second);
+        else
+            batch.Erase(make_pair(DB_ZEROCOIN_SERIAL_SPENDS, it->first));
+    }
+
+    for (std::map<int, CZerocoinSupply::CDenominationSupply>::iterator it = supply.denominations.begin(); it != supply.denominations.end(); ) {
+        if (it->second.IsNull())
+            supply.denominations.erase(it++);
+        else
+            ++it;
+    }
+    supply.hashBlock = fConnect ? hashBlock : hashPrevBlock;
+    batch.Write(DB_ZEROCOIN_SUPPLY, supply);
+
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ResetSupply()
+{
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+    for (pcursor->Seek(DB_ZEROCOIN_SERIAL_SPENDS); pcursor->Valid(); pcursor->Next()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CBigNum> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ZEROCOIN_SERIAL_SPENDS)
+            break;
+        batch.Erase(key);
+    }
+    batch.Erase(DB_TOTAL_SUPPLY);
+    batch.Erase(DB_ZEROCOIN_SUPPLY);
+    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadTotalSupply(CAmount & supply)
@@ -408,6 +722,27 @@ bool CBlockTreeDB::ReadTotalSupply(CAmount & supply)
     return false;
 }
 
+bool CBlockTreeDB::ReadZerocoinSupply(CZerocoinSupply &supply)
+{
+    return Read(DB_ZEROCOIN_SUPPLY, supply);
+}
+
+bool CBlockTreeDB::ReadZerocoinBlockData(const uint256 &blockHash, CZerocoinBlockData &data) {
+    return Read(make_pair(DB_ZEROCOIN_BLOCK, blockHash), data);
+}
+
+bool CBlockTreeDB::WriteZerocoinBlockData(const uint256 &blockHash, const CZerocoinBlockData &data) {
+    return Write(make_pair(DB_ZEROCOIN_BLOCK, blockHash), data);
+}
+
+bool CBlockTreeDB::ReadZerocoinVerifiedBlock(uint256 &blockHash) {
+    return Read(DB_ZEROCOIN_VERIFIED_BLOCK, blockHash);
+}
+
+bool CBlockTreeDB::WriteZerocoinVerifiedBlock(const uint256 &blockHash) {
+    return Write(DB_ZEROCOIN_VERIFIED_BLOCK, blockHash);
+}
+
 /******************************************************************************/
 
 CDbIndexHelper::CDbIndexHelper(bool addressIndex_, bool spentIndex_)
@@ -108,7 +108,8 @@ private:
     CBlockTreeDB(const CBlockTreeDB&);
     void operator=(const CBlockTreeDB&);
 public:
-    bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo);
+    bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo,
+                        const std::vector<std::pair<uint256, const CZerocoinBlockData*> >& zerocoinBlockData);
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo &fileinfo);
     bool ReadLastBlockFile(int &nFile);
     bool WriteReindexing(bool fReindex);
@@ -120,11 +121,19 @@ public:
     bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
     bool ReadAddressUnspentIndex(uint160 addressHash, AddressType type,
                                  std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
+    bool ReadAddressUnspentIndex(uint160 addressHash, AddressType type,
+                                 boost::function<bool (const CAddressUnspentKey&, const CAddressUnspentValue&)> visitor,
+                                 const CAddressUnspentKey *pfrom = NULL);
     bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
     bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
     bool ReadAddressIndex(uint160 addressHash, AddressType type,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                           int start = 0, int end = 0);
+    bool ReadAddressIndex(uint160 addressHash, AddressType type,
+                          boost::function<bool (const CAddressIndexKey&, CAmount)> visitor,
+                          int start = 0, int end = 0, const CAddressIndexKey *pfrom = NULL);
+    bool ReadAddressBalance(uint160 addressHash, AddressType type, CAddressBalanceValue &value);
+    bool RebuildAddressBalances();
 
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
@@ -132,8 +141,19 @@ public:
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
     int GetBlockIndexVersion();
-    bool AddTotalSupply(CAmount const & supply);
+    //! Applies the coinbase subsidy and the zerocoin spends <serial,denomination> and mints (denominations) of a
+    //! block to the supply. A block connected or disconnected again after a crash is not applied twice, a block that
+    //! doesn't follow the supply clears the "supply" flag and *pfFollows so that the supply is calculated again
+    bool UpdateSupply(const uint256 &hashBlock, const uint256 &hashPrevBlock, CAmount nSubsidy,
+                      const std::vector<std::pair<CBigNum, int> > &spends, const std::vector<int> &mints, bool fConnect,
+                      bool *pfFollows = NULL);
+    bool ResetSupply();
     bool ReadTotalSupply(CAmount & supply);
+    bool ReadZerocoinSupply(CZerocoinSupply &supply);
+    bool ReadZerocoinBlockData(const uint256 &blockHash, CZerocoinBlockData &data);
+    bool WriteZerocoinBlockData(const uint256 &blockHash, const CZerocoinBlockData &data);
+    bool ReadZerocoinVerifiedBlock(uint256 &blockHash);
+    bool WriteZerocoinVerifiedBlock(const uint256 &blockHash);
 };
 
 
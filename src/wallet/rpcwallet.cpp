@@ -2715,56 +2715,31 @@ UniValue mintzerocoin(const UniValue& params, bool fHelp)
     LogPrintf("rpcWallet.mintzerocoin() denomination = %s, nAmount = %s \n", denomination, nAmount);
 
 
-    // Always use modulus v2
-    libzerocoin::Params *zcParams = ZCParamsV2;
-
-    // The following constructor does all the work of minting a brand
-    // new zerocoin. It stores all the private values inside the
-    // PrivateCoin object. This includes the coin secrets, which must be
-    // stored in a secure location (wallet) at the client.
-    libzerocoin::PrivateCoin newCoin(zcParams, denomination, ZEROCOIN_TX_VERSION_2);
-    // Get a copy of the 'public' portion of the coin. You should
-    // embed this into a Zerocoin 'MINT' transaction along with a series
-    // of currency inputs totaling the assigned value of one zerocoin.
-    libzerocoin::PublicCoin pubCoin = newCoin.getPublicCoin();
-
-    // Validate
-    if (pubCoin.validate()) {
-        CScript scriptSerializedCoin =
-                CScript() << OP_ZEROCOINMINT << pubCoin.getValue().getvch().size() << pubCoin.getValue().getvch();
+    if (pwalletMain->IsLocked())
+        throw JSONRPCError(RPC_WALLET_UNLOCK_NEEDED, "Error: Please enter the wallet passphrase with walletpassphrase first.");
 
-        if (pwalletMain->IsLocked())
-            throw JSONRPCError(RPC_WALLET_UNLOCK_NEEDED, "Error: Please enter the wallet passphrase with walletpassphrase first.");
+    // The coin is taken from the mint pool or minted, the mint pool coins passed
+    // the validation when they were generated
+    CZerocoinEntry zerocoinTx = pwalletMain->GenerateZerocoinMints(
+            vector<libzerocoin::CoinDenomination>(1, denomination)).front();
 
-        // Wallet comments
-        CWalletTx wtx;
+    CScript scriptSerializedCoin =
+            CScript() << OP_ZEROCOINMINT << zerocoinTx.value.getvch().size() << zerocoinTx.value.getvch();
 
-        string strError = pwalletMain->MintZerocoin(scriptSerializedCoin, nAmount, wtx);
+    // Wallet comments
+    CWalletTx wtx;
 
-        if (strError != "")
-            throw JSONRPCError(RPC_WALLET_ERROR, strError);
+    string strError = pwalletMain->MintZerocoin(scriptSerializedCoin, nAmount, wtx);
 
-        CWalletDB walletdb(pwalletMain->strWalletFile);
-        CZerocoinEntry zerocoinTx;
-        zerocoinTx.IsUsed = false;
-        zerocoinTx.denomination = denomination;
-        zerocoinTx.value = pubCoin.getValue();
-        libzerocoin::PublicCoin checkPubCoin(zcParams, zerocoinTx.value, denomination);
-        if (!checkPubCoin.validate()) {
-            return false;
-        }
-        zerocoinTx.randomness = newCoin.getRandomness();
-        zerocoinTx.serialNumber = newCoin.getSerialNumber();
-        const unsigned char *ecdsaSecretKey = newCoin.getEcdsaSeckey();
-        zerocoinTx.ecdsaSecretKey = std::vector<unsigned char>(ecdsaSecretKey, ecdsaSecretKey+32);
-        pwalletMain->NotifyZerocoinChanged(pwalletMain, zerocoinTx.value.GetHex(), "New (" + std::to_string(zerocoinTx.denomination) + " mint)", CT_NEW);
-        walletdb.WriteZerocoinEntry(zerocoinTx);
-
-        return wtx.GetHash().GetHex();
-    } else {
-        return "";
+    if (strError != "") {
+        pwalletMain->ReturnZerocoinMints(vector<CZerocoinEntry>(1, zerocoinTx));
+        throw JSONRPCError(RPC_WALLET_ERROR, strError);
     }
 
+    pwalletMain->NotifyZerocoinChanged(pwalletMain, zerocoinTx.value.GetHex(), "New (" + std::to_string(zerocoinTx.denomination) + " mint)", CT_NEW);
+    pwalletMain->WriteZerocoinEntry(zerocoinTx);
+
+    return wtx.GetHash().GetHex();
 }
 
 UniValue mintmanyzerocoin(const UniValue& params, bool fHelp)
@@ -2798,11 +2773,9 @@ UniValue mintmanyzerocoin(const UniValue& params, bool fHelp)
 
     int64_t denominationInt = 0;
     libzerocoin::CoinDenomination denomination;
-    // Always use modulus v2
-    libzerocoin::Params *zcParams = ZCParamsV2;
 
     vector<CRecipient> vecSend;
-    vector<libzerocoin::PrivateCoin> privCoins;
+    vector<libzerocoin::CoinDenomination> denominations;
     CWalletTx wtx;
 
     vector<string> keys = sendTo.getKeys();
@@ -2842,43 +2815,28 @@ UniValue mintmanyzerocoin(const UniValue& params, bool fHelp)
                     "amounts must be greater than 0.\n");
         }
 
-        for(int64_t i=0; i<amount; i++){
-            // The following constructor does all the work of minting a brand
-            // new zerocoin. It stores all the private values inside the
-            // PrivateCoin object. This includes the coin secrets, which must be
-            // stored in a secure location (wallet) at the client.
-            libzerocoin::PrivateCoin newCoin(zcParams, denomination, ZEROCOIN_TX_VERSION_2);
-            // Get a copy of the 'public' portion of the coin. You should
-            // embed this into a Zerocoin 'MINT' transaction along with a series
-            // of currency inputs totaling the assigned value of one zerocoin.
-            
-            libzerocoin::PublicCoin pubCoin = newCoin.getPublicCoin();
-            
-            //Validate
-            bool validCoin = pubCoin.validate();
-
-            // loop until we find a valid coin
-            while(!validCoin){
-                newCoin = libzerocoin::PrivateCoin(zcParams, denomination, ZEROCOIN_TX_VERSION_2);
-                pubCoin = newCoin.getPublicCoin();
-                validCoin = pubCoin.validate();
-            }
+        denominations.insert(denominations.end(), amount, denomination);
+    }
 
-            // Create script for coin
-            CScript scriptSerializedCoin =
-                    CScript() << OP_ZEROCOINMINT << pubCoin.getValue().getvch().size() << pubCoin.getValue().getvch();
+    // Coins are taken from the mint pool or minted in parallel, minting is cancelled on shutdown
+    vector<CZerocoinEntry> mints = pwalletMain->GenerateZerocoinMints(denominations);
 
-            CRecipient recipient = {scriptSerializedCoin, (denominationInt * COIN), false};
+    BOOST_FOREACH(const CZerocoinEntry &mint, mints) {
+        // Create script for coin
+        CScript scriptSerializedCoin =
+                CScript() << OP_ZEROCOINMINT << mint.value.getvch().size() << mint.value.getvch();
 
-            vecSend.push_back(recipient);
-            privCoins.push_back(newCoin);
-        }
+        CRecipient recipient = {scriptSerializedCoin, (mint.denomination * COIN), false};
+
+        vecSend.push_back(recipient);
     }
 
-    string strError = pwalletMain->MintAndStoreZerocoin(vecSend, privCoins, wtx);
+    string strError = pwalletMain->MintAndStoreZerocoin(vecSend, mints, wtx);
 
-    if (strError != "")
+    if (strError != "") {
+        pwalletMain->ReturnZerocoinMints(mints);
         throw runtime_error(strError);
+    }
 
     return wtx.GetHash().GetHex();
 }
@@ -3058,8 +3016,7 @@ UniValue resetmintzerocoin(const UniValue& params, bool fHelp) {
                 + HelpRequiringPassphrase());
 
     list <CZerocoinEntry> listPubcoin;
-    CWalletDB walletdb(pwalletMain->strWalletFile);
-    walletdb.ListPubCoin(listPubcoin);
+    pwalletMain->ListZerocoinEntries(listPubcoin);
 
     BOOST_FOREACH(const CZerocoinEntry &zerocoinItem, listPubcoin){
         if (zerocoinItem.randomness != 0 && zerocoinItem.serialNumber != 0) {
@@ -3071,7 +3028,7 @@ UniValue resetmintzerocoin(const UniValue& params, bool fHelp) {
             zerocoinTx.nHeight = -1;
             zerocoinTx.randomness = zerocoinItem.randomness;
             zerocoinTx.ecdsaSecretKey = zerocoinItem.ecdsaSecretKey;
-            walletdb.WriteZerocoinEntry(zerocoinTx);
+            pwalletMain->WriteZerocoinEntry(zerocoinTx);
         }
     }
 
@@ -3093,8 +3050,7 @@ UniValue listmintzerocoins(const UniValue& params, bool fHelp) {
     }
 
     list <CZerocoinEntry> listPubcoin;
-    CWalletDB walletdb(pwalletMain->strWalletFile);
-    walletdb.ListPubCoin(listPubcoin);
+    pwalletMain->ListZerocoinEntries(listPubcoin);
     UniValue results(UniValue::VARR);
 
     BOOST_FOREACH(const CZerocoinEntry &zerocoinItem, listPubcoin) {
@@ -3130,13 +3086,12 @@ UniValue listpubcoins(const UniValue& params, bool fHelp) {
     }
 
     list <CZerocoinEntry> listPubcoin;
-    CWalletDB walletdb(pwalletMain->strWalletFile);
-    walletdb.ListPubCoin(listPubcoin);
+    pwalletMain->ListZerocoinEntries(listPubcoin, denomination);
     UniValue results(UniValue::VARR);
     listPubcoin.sort(CompID);
 
     BOOST_FOREACH(const CZerocoinEntry &zerocoinItem, listPubcoin) {
-        if (zerocoinItem.id > 0 && (denomination < 0 || zerocoinItem.denomination == denomination)) {
+        if (zerocoinItem.id > 0) {
             UniValue entry(UniValue::VOBJ);
             entry.push_back(Pair("id", zerocoinItem.id));
             entry.push_back(Pair("IsUsed", zerocoinItem.IsUsed));
@@ -3167,51 +3122,42 @@ UniValue setmintzerocoinstatus(const UniValue& params, bool fHelp) {
     bool fStatus = true;
     fStatus = params[1].get_bool();
 
-    list <CZerocoinEntry> listPubcoin;
-    CWalletDB walletdb(pwalletMain->strWalletFile);
-    walletdb.ListPubCoin(listPubcoin);
-
     UniValue results(UniValue::VARR);
 
-    BOOST_FOREACH(const CZerocoinEntry &zerocoinItem, listPubcoin) {
-        if (zerocoinItem.serialNumber != 0) {
-            LogPrintf("zerocoinItem.serialNumber = %s\n", zerocoinItem.serialNumber.GetHex());
-            if (zerocoinItem.serialNumber == coinSerial) {
-                LogPrintf("setmintzerocoinstatus Found!\n");
-                CZerocoinEntry zerocoinTx;
-                zerocoinTx.id = zerocoinItem.id;
-                zerocoinTx.IsUsed = fStatus;
-                zerocoinTx.denomination = zerocoinItem.denomination;
-                zerocoinTx.value = zerocoinItem.value;
-                zerocoinTx.serialNumber = zerocoinItem.serialNumber;
-                zerocoinTx.nHeight = zerocoinItem.nHeight;
-                zerocoinTx.randomness = zerocoinItem.randomness;
-                zerocoinTx.ecdsaSecretKey = zerocoinItem.ecdsaSecretKey;
-                const std::string& isUsedDenomStr = zerocoinTx.IsUsed
-                        ? "Used (" + std::to_string(zerocoinTx.denomination) + " mint)"
-                        : "New (" + std::to_string(zerocoinTx.denomination) + " mint)";
-                pwalletMain->NotifyZerocoinChanged(pwalletMain, zerocoinTx.value.GetHex(), isUsedDenomStr, CT_UPDATED);
-                walletdb.WriteZerocoinEntry(zerocoinTx);
-
-                if (!fStatus) {
-                    // erase zerocoin spend entry
-                    CZerocoinSpendEntry spendEntry;
-                    spendEntry.coinSerial = coinSerial;
-                    walletdb.EraseCoinSpendSerialEntry(spendEntry);
-                }
-
-                UniValue entry(UniValue::VOBJ);
-                entry.push_back(Pair("id", zerocoinTx.id));
-                entry.push_back(Pair("IsUsed", zerocoinTx.IsUsed));
-                entry.push_back(Pair("denomination", zerocoinTx.denomination));
-                entry.push_back(Pair("value", zerocoinTx.value.GetHex()));
-                entry.push_back(Pair("serialNumber", zerocoinTx.serialNumber.GetHex()));
-                entry.push_back(Pair("nHeight", zerocoinTx.nHeight));
-                entry.push_back(Pair("randomness", zerocoinTx.randomness.GetHex()));
-                results.push_back(entry);
-                break;
-            }
+    CZerocoinEntry zerocoinItem;
+    if (coinSerial != 0 && pwalletMain->GetZerocoinEntryBySerial(coinSerial, zerocoinItem)) {
+        LogPrintf("setmintzerocoinstatus Found!\n");
+        CZerocoinEntry zerocoinTx;
+        zerocoinTx.id = zerocoinItem.id;
+        zerocoinTx.IsUsed = fStatus;
+        zerocoinTx.denomination = zerocoinItem.denomination;
+        zerocoinTx.value = zerocoinItem.value;
+        zerocoinTx.serialNumber = zerocoinItem.serialNumber;
+        zerocoinTx.nHeight = zerocoinItem.nHeight;
+        zerocoinTx.randomness = zerocoinItem.randomness;
+        zerocoinTx.ecdsaSecretKey = zerocoinItem.ecdsaSecretKey;
+        const std::string& isUsedDenomStr = zerocoinTx.IsUsed
+                ? "Used (" + std::to_string(zerocoinTx.denomination) + " mint)"
+                : "New (" + std::to_string(zerocoinTx.denomination) + " mint)";
+        pwalletMain->NotifyZerocoinChanged(pwalletMain, zerocoinTx.value.GetHex(), isUsedDenomStr, CT_UPDATED);
+        pwalletMain->WriteZerocoinEntry(zerocoinTx);
+
+        if (!fStatus) {
+            // erase zerocoin spend entry
+            CZerocoinSpendEntry spendEntry;
+            spendEntry.coinSerial = coinSerial;
+            CWalletDB(pwalletMain->strWalletFile).EraseCoinSpendSerialEntry(spendEntry);
         }
+
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("id", zerocoinTx.id));
+        entry.push_back(Pair("IsUsed", zerocoinTx.IsUsed));
+        entry.push_back(Pair("denomination", zerocoinTx.denomination));
+        entry.push_back(Pair("value", zerocoinTx.value.GetHex()));
+        entry.push_back(Pair("serialNumber", zerocoinTx.serialNumber.GetHex()));
+        entry.push_back(Pair("nHeight", zerocoinTx.nHeight));
+        entry.push_back(Pair("randomness", zerocoinTx.randomness.GetHex()));
+        results.push_back(entry);
     }
 
     return results;
@@ -351,4 +351,51 @@ BOOST_AUTO_TEST_CASE(ApproximateBestSubset)
     BOOST_CHECK_EQUAL(setCoinsRet.size(), 2U);
 }*/
 
+
+BOOST_AUTO_TEST_CASE(zerocoin_entry_index)
+{
+    CWallet zerocoinWallet;
+
+    for (int i = 0; i < 6; i++) {
+        CZerocoinEntry entry;
+        entry.value = CBigNum(100 + i);
+        entry.serialNumber = CBigNum(200 + i);
+        entry.denomination = i % 2 ? libzerocoin::ZQ_GOLDWASSER : libzerocoin::ZQ_LOVELACE;
+        entry.IsUsed = false;
+        entry.id = -1;
+        entry.nHeight = -1;
+        zerocoinWallet.LoadZerocoinEntry(entry);
+    }
+
+    std::list<CZerocoinEntry> listPubCoin;
+    zerocoinWallet.ListZerocoinEntries(listPubCoin);
+    BOOST_CHECK_EQUAL(listPubCoin.size(), 6U);
+
+    listPubCoin.clear();
+    zerocoinWallet.ListZerocoinEntries(listPubCoin, libzerocoin::ZQ_GOLDWASSER);
+    BOOST_CHECK_EQUAL(listPubCoin.size(), 3U);
+    BOOST_FOREACH(const CZerocoinEntry& entry, listPubCoin)
+        BOOST_CHECK_EQUAL(entry.denomination, libzerocoin::ZQ_GOLDWASSER);
+
+    // an update replaces the entry in every index
+    CZerocoinEntry entry;
+    BOOST_CHECK(zerocoinWallet.GetZerocoinEntryBySerial(CBigNum(203), entry));
+    BOOST_CHECK(entry.value == CBigNum(103));
+    entry.IsUsed = true;
+    entry.id = 1;
+    entry.nHeight = 10;
+    BOOST_CHECK(zerocoinWallet.WriteZerocoinEntry(entry));
+
+    BOOST_CHECK(zerocoinWallet.GetZerocoinEntry(CBigNum(103), entry));
+    BOOST_CHECK(entry.IsUsed);
+    BOOST_CHECK_EQUAL(entry.nHeight, 10);
+
+    listPubCoin.clear();
+    zerocoinWallet.ListZerocoinEntries(listPubCoin);
+    BOOST_CHECK_EQUAL(listPubCoin.size(), 6U);
+
+    BOOST_CHECK(!zerocoinWallet.GetZerocoinEntry(CBigNum(300), entry));
+    BOOST_CHECK(!zerocoinWallet.GetZerocoinEntryBySerial(CBigNum(300), entry));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,7 @@
 #include "coincontrol.h"
 #include "consensus/consensus.h"
 #include "consensus/validation.h"
+#include "init.h"
 #include "key.h"
 #include "keystore.h"
 #include "main.h"
@@ -33,6 +34,7 @@
 #include "random.h"
 
 #include <assert.h>
+#include <tuple>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/thread.hpp>
@@ -980,23 +982,19 @@ bool CWallet::AbandonTransaction(const uint256 &hashTx) {
             CBigNum serial = spend.getCoinSerialNumber();
 
             // mark corresponding mint as unspent
-            list <CZerocoinEntry> pubCoins;
-            walletdb.ListPubCoin(pubCoins);
-
-            BOOST_FOREACH(const CZerocoinEntry &zerocoinItem, pubCoins) {
-                if (zerocoinItem.serialNumber == serial) {
-                    CZerocoinEntry modifiedItem = zerocoinItem;
-                    modifiedItem.IsUsed = false;
-                    pwalletMain->NotifyZerocoinChanged(pwalletMain, zerocoinItem.value.GetHex(),
-                                                       std::string("New (") + std::to_string(zerocoinItem.denomination) + "mint)",
-                                                       CT_UPDATED);
-                    walletdb.WriteZerocoinEntry(modifiedItem);
-
-                    // erase zerocoin spend entry
-                    CZerocoinSpendEntry spendEntry;
-                    spendEntry.coinSerial = serial;
-                    walletdb.EraseCoinSpendSerialEntry(spendEntry);
-                }
+            CZerocoinEntry zerocoinItem;
+            if (GetZerocoinEntryBySerial(serial, zerocoinItem)) {
+                CZerocoinEntry modifiedItem = zerocoinItem;
+                modifiedItem.IsUsed = false;
+                pwalletMain->NotifyZerocoinChanged(pwalletMain, zerocoinItem.value.GetHex(),
+                                                   std::string("New (") + std::to_string(zerocoinItem.denomination) + "mint)",
+                                                   CT_UPDATED);
+                WriteZerocoinEntry(modifiedItem);
+
+                // erase zerocoin spend entry
+                CZerocoinSpendEntry spendEntry;
+                spendEntry.coinSerial = serial;
+                walletdb.EraseCoinSpendSerialEntry(spendEntry);
             }
 
         }
@@ -2283,10 +2281,7 @@ void CWallet::ListAvailableCoinsMintCoins(vector <COutput> &vCoins, bool fOnlyCo
     vCoins.clear();
     {
         LOCK(cs_wallet);
-        list <CZerocoinEntry> listPubCoin = list<CZerocoinEntry>();
-        CWalletDB walletdb(pwalletMain->strWalletFile);
-        walletdb.ListPubCoin(listPubCoin);
-        LogPrintf("listPubCoin.size()=%s\n", listPubCoin.size());
+        LogPrintf("setZerocoinEntries.size()=%s\n", setZerocoinEntries.size());
         for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it) {
             const CWalletTx *pcoin = &(*it).second;
 //            LogPrintf("pcoin=%s\n", pcoin->GetHash().ToString());
@@ -2323,17 +2318,11 @@ void CWallet::ListAvailableCoinsMintCoins(vector <COutput> &vCoins, bool fOnlyCo
                     pubCoin.setvch(vchZeroMint);
                     LogPrintf("Pubcoin=%s\n", pubCoin.ToString());
                     // CHECKING PROCESS
-                    BOOST_FOREACH(const CZerocoinEntry &pubCoinItem, listPubCoin) {
-//                        LogPrintf("*******\n");
-//                        LogPrintf("pubCoinItem.value=%s,\n", pubCoinItem.value.ToString());
-//                        LogPrintf("pubCoinItem.IsUsed=%s\n, ", pubCoinItem.IsUsed);
-//                        LogPrintf("pubCoinItem.randomness=%s\n, ", pubCoinItem.randomness);
-//                        LogPrintf("pubCoinItem.serialNumber=%s\n, ", pubCoinItem.serialNumber);
-                        if (pubCoinItem.value == pubCoin && pubCoinItem.IsUsed == false &&
-                            pubCoinItem.randomness != 0 && pubCoinItem.serialNumber != 0) {
-                            vCoins.push_back(COutput(pcoin, i, nDepth, true, true));
-                            LogPrintf("-->OK\n");
-                        }
+                    CZerocoinEntry pubCoinItem;
+                    if (GetZerocoinEntry(pubCoin, pubCoinItem) && pubCoinItem.IsUsed == false &&
+                        pubCoinItem.randomness != 0 && pubCoinItem.serialNumber != 0) {
+                        vCoins.push_back(COutput(pcoin, i, nDepth, true, true));
+                        LogPrintf("-->OK\n");
                     }
 
                 }
@@ -3213,11 +3202,9 @@ bool CWallet::CreateZerocoinMintModel(string &stringError, std::vector<std::pair
     return false;
 
     libzerocoin::CoinDenomination denomination;
-    // Always use modulus v2
-    libzerocoin::Params *zcParams = ZCParamsV2;
 
     vector<CRecipient> vecSend;
-    vector<libzerocoin::PrivateCoin> privCoins;
+    vector<libzerocoin::CoinDenomination> denominations;
     CWalletTx wtx;
 
     std::pair<int,int> denominationPair;
@@ -3253,48 +3240,252 @@ bool CWallet::CreateZerocoinMintModel(string &stringError, std::vector<std::pair
                     "mintzerocoin <amount>(1,10,25,50,100) (\"zcoinaddress\")\n");
         }
 
-        for(int64_t i=0; i<amount; i++){
-            // The following constructor does all the work of minting a brand
-            // new zerocoin. It stores all the private values inside the
-            // PrivateCoin object. This includes the coin secrets, which must be
-            // stored in a secure location (wallet) at the client.
-            libzerocoin::PrivateCoin newCoin(zcParams, denomination, ZEROCOIN_TX_VERSION_2);
-            // Get a copy of the 'public' portion of the coin. You should
-            // embed this into a Zerocoin 'MINT' transaction along with a series
-            // of currency inputs totaling the assigned value of one zerocoin.
-            
-            libzerocoin::PublicCoin pubCoin = newCoin.getPublicCoin();
-            
-            //Validate
-            bool validCoin = pubCoin.validate();
-
-            // loop until we find a valid coin
-            while(!validCoin){
-                newCoin = libzerocoin::PrivateCoin(zcParams, denomination, ZEROCOIN_TX_VERSION_2);
-                pubCoin = newCoin.getPublicCoin();
-                validCoin = pubCoin.validate();
-            }
+        denominations.insert(denominations.end(), amount, denomination);
+    }
 
-            // Create script for coin
-            CScript scriptSerializedCoin =
-                    CScript() << OP_ZEROCOINMINT << pubCoin.getValue().getvch().size() << pubCoin.getValue().getvch();
+    // Coins are taken from the mint pool or minted in parallel
+    vector<CZerocoinEntry> mints;
+    try {
+        mints = GenerateZerocoinMints(denominations);
+    }
+    catch (const ZerocoinException &e) {
+        stringError = e.what();
+        return false;
+    }
 
-            CRecipient recipient = {scriptSerializedCoin, (denominationValue * COIN), false};
+    BOOST_FOREACH(const CZerocoinEntry &mint, mints) {
+        // Create script for coin
+        CScript scriptSerializedCoin =
+                CScript() << OP_ZEROCOINMINT << mint.value.getvch().size() << mint.value.getvch();
 
-            vecSend.push_back(recipient);
-            privCoins.push_back(newCoin);
-        }
+        CRecipient recipient = {scriptSerializedCoin, (mint.denomination * COIN), false};
+
+        vecSend.push_back(recipient);
     }
 
-    string strError = pwalletMain->MintAndStoreZerocoin(vecSend, privCoins, wtx);
+    string strError = pwalletMain->MintAndStoreZerocoin(vecSend, mints, wtx);
 
     if (strError != ""){
+        ReturnZerocoinMints(mints);
+        stringError = strError;
         return false;
     }
 
     return true;
 }
 
+void CWallet::LoadZerocoinEntry(const CZerocoinEntry &zerocoin) {
+    setZerocoinEntries.insert(zerocoin);
+}
+
+void CWallet::LoadZerocoinWitness(const CZerocoinWitnessEntry &witness) {
+    mapZerocoinWitnesses[witness.pubCoin] = witness;
+}
+
+bool CWallet::WriteZerocoinEntry(const CZerocoinEntry &zerocoin) {
+    LOCK(cs_wallet);
+
+    CZerocoinEntrySet::index<zerocoin_value>::type::iterator it = setZerocoinEntries.get<zerocoin_value>().find(zerocoin.value);
+    if (it == setZerocoinEntries.get<zerocoin_value>().end())
+        setZerocoinEntries.insert(zerocoin);
+    else
+        setZerocoinEntries.get<zerocoin_value>().replace(it, zerocoin);
+
+    if (!fFileBacked)
+        return true;
+    return CWalletDB(strWalletFile).WriteZerocoinEntry(zerocoin);
+}
+
+bool CWallet::GetZerocoinEntry(const CBigNum &pubCoin, CZerocoinEntry &zerocoin) const {
+    LOCK(cs_wallet);
+
+    CZerocoinEntrySet::index<zerocoin_value>::type::const_iterator it = setZerocoinEntries.get<zerocoin_value>().find(pubCoin);
+    if (it == setZerocoinEntries.get<zerocoin_value>().end())
+        return false;
+    zerocoin = *it;
+    return true;
+}
+
+bool CWallet::GetZerocoinEntryBySerial(const CBigNum &serialNumber, CZerocoinEntry &zerocoin) const {
+    LOCK(cs_wallet);
+
+    CZerocoinEntrySet::index<zerocoin_serial>::type::const_iterator it = setZerocoinEntries.get<zerocoin_serial>().find(serialNumber);
+    if (it == setZerocoinEntries.get<zerocoin_serial>().end())
+        return false;
+    zerocoin = *it;
+    return true;
+}
+
+void CWallet::ListZerocoinEntries(std::list<CZerocoinEntry> &listPubCoin, int denomination) const {
+    LOCK(cs_wallet);
+
+    const CZerocoinEntrySet::index<zerocoin_denomination>::type &index = setZerocoinEntries.get<zerocoin_denomination>();
+    if (denomination < 0)
+        listPubCoin.insert(listPubCoin.end(), index.begin(), index.end());
+    else {
+        auto range = index.equal_range(boost::make_tuple(denomination));
+        listPubCoin.insert(listPubCoin.end(), range.first, range.second);
+    }
+}
+
+std::vector<CZerocoinEntry> CWallet::GenerateZerocoinMints(const std::vector<libzerocoin::CoinDenomination>& denominations) {
+    // Always use modulus v2
+    libzerocoin::Params *zcParams = ZCParamsV2;
+
+    vector<CZerocoinEntry> mints(denominations.size());
+    vector<size_t> missingMints;
+    {
+        // Coins are removed from the pool right away so concurrent mints can't take them too, a mint that fails
+        // returns them with ReturnZerocoinMints
+        LOCK(cs_wallet);
+        CWalletDB walletdb(strWalletFile);
+        list<CZerocoinEntry> listMintPool;
+        walletdb.ListZerocoinMintPool(listMintPool);
+
+        for (size_t i = 0; i < denominations.size(); i++) {
+            list<CZerocoinEntry>::iterator it = listMintPool.begin();
+            while (it != listMintPool.end() && it->denomination != denominations[i])
+                ++it;
+
+            if (it == listMintPool.end()) {
+                missingMints.push_back(i);
+                continue;
+            }
+
+            walletdb.EraseZerocoinMintPoolEntry(*it);
+            mints[i] = *it;
+            listMintPool.erase(it);
+        }
+    }
+
+    if (missingMints.empty())
+        return mints;
+
+    LogPrintf("GenerateZerocoinMints: %d of %d coins are not in the mint pool, minting them\n",
+              missingMints.size(), denominations.size());
+
+    vector<libzerocoin::CoinDenomination> missingDenominations;
+    BOOST_FOREACH(size_t i, missingMints) {
+        missingDenominations.push_back(denominations[i]);
+    }
+    vector<libzerocoin::PrivateCoin> newCoins = libzerocoin::PrivateCoin::mintCoins(zcParams, missingDenominations,
+            ZEROCOIN_TX_VERSION_2, [] { return ShutdownRequested(); });
+
+    for (size_t n = 0; n < missingMints.size(); n++) {
+        const libzerocoin::PrivateCoin &newCoin = newCoins[n];
+        CZerocoinEntry &mint = mints[missingMints[n]];
+        mint.IsUsed = false;
+        mint.denomination = newCoin.getPublicCoin().getDenomination();
+        mint.value = newCoin.getPublicCoin().getValue();
+        mint.randomness = newCoin.getRandomness();
+        mint.serialNumber = newCoin.getSerialNumber();
+        const unsigned char *ecdsaSecretKey = newCoin.getEcdsaSeckey();
+        mint.ecdsaSecretKey = std::vector<unsigned char>(ecdsaSecretKey, ecdsaSecretKey+32);
+    }
+
+    return mints;
+}
+
+void CWallet::ReturnZerocoinMints(const std::vector<CZerocoinEntry>& mints) {
+    // The coins are not used by any transaction. Coins that were minted because the pool was short are kept too, as
+    // long as the pool has less than -zerocoinmintpool coins of the denomination
+    int nPoolSize = GetArg("-zerocoinmintpool", DEFAULT_ZEROCOIN_MINT_POOL_SIZE);
+    if (nPoolSize <= 0)
+        return;
+
+    LOCK(cs_wallet);
+    CWalletDB walletdb(strWalletFile);
+    list<CZerocoinEntry> listMintPool;
+    walletdb.ListZerocoinMintPool(listMintPool);
+    map<int, int> poolCoins;
+    BOOST_FOREACH(const CZerocoinEntry &mint, listMintPool) {
+        poolCoins[mint.denomination]++;
+    }
+
+    BOOST_FOREACH(const CZerocoinEntry &mint, mints) {
+        if (poolCoins[mint.denomination] >= nPoolSize)
+            continue;
+        walletdb.WriteZerocoinMintPoolEntry(mint);
+        poolCoins[mint.denomination]++;
+    }
+}
+
+void CWallet::RefillZerocoinMintPool() {
+    static const libzerocoin::CoinDenomination denominations[] = {
+        libzerocoin::ZQ_LOVELACE, libzerocoin::ZQ_GOLDWASSER, libzerocoin::ZQ_RACKOFF,
+        libzerocoin::ZQ_PEDERSEN, libzerocoin::ZQ_WILLIAMSON
+    };
+
+    int nPoolSize = GetArg("-zerocoinmintpool", DEFAULT_ZEROCOIN_MINT_POOL_SIZE);
+    if (nPoolSize <= 0)
+        return;
+
+    map<int, int> poolCoins;
+    {
+        LOCK(cs_wallet);
+        list<CZerocoinEntry> listMintPool;
+        CWalletDB(strWalletFile).ListZerocoinMintPool(listMintPool);
+        BOOST_FOREACH(const CZerocoinEntry &mint, listMintPool) {
+            poolCoins[mint.denomination]++;
+        }
+    }
+
+    // Coins are minted one at a time on the calling thread. A mint takes seconds, so it doesn't go to the executor
+    // that block validation uses. Every coin is stored as soon as it's ready
+    int nAdded = 0;
+    BOOST_FOREACH(libzerocoin::CoinDenomination denomination, denominations) {
+        for (int i = poolCoins[denomination]; i < nPoolSize; i++) {
+            std::unique_ptr<libzerocoin::PrivateCoin> newCoin;
+            do {
+                newCoin.reset(new libzerocoin::PrivateCoin(ZCParamsV2, denomination, ZEROCOIN_TX_VERSION_2,
+                        [] { return ShutdownRequested(); }));
+            } while (!newCoin->getPublicCoin().validate());
+
+            CZerocoinEntry mint;
+            mint.IsUsed = false;
+            mint.denomination = newCoin->getPublicCoin().getDenomination();
+            mint.value = newCoin->getPublicCoin().getValue();
+            mint.randomness = newCoin->getRandomness();
+            mint.serialNumber = newCoin->getSerialNumber();
+            const unsigned char *ecdsaSecretKey = newCoin->getEcdsaSeckey();
+            mint.ecdsaSecretKey = std::vector<unsigned char>(ecdsaSecretKey, ecdsaSecretKey+32);
+
+            LOCK(cs_wallet);
+            CWalletDB(strWalletFile).WriteZerocoinMintPoolEntry(mint);
+            nAdded++;
+        }
+    }
+
+    if (nAdded > 0)
+        LogPrint("zerocoin", "RefillZerocoinMintPool: added %d coins to the mint pool\n", nAdded);
+}
+
+void ThreadZerocoinMintPool(CWallet *pwallet) {
+    RenameThread("zcoin-zcmintpool");
+
+    while (true) {
+        try {
+            pwallet->RefillZerocoinMintPool();
+        }
+        catch (const ZerocoinException &e) {
+            // minting is cancelled on shutdown
+            LogPrintf("ThreadZerocoinMintPool: %s\n", e.what());
+            return;
+        }
+        catch (const boost::thread_interrupted &) {
+            throw;
+        }
+        catch (const std::exception &e) {
+            // the pool is filled again after the interval
+            PrintExceptionContinue(&e, "ThreadZerocoinMintPool()");
+        }
+        catch (...) {
+            PrintExceptionContinue(NULL, "ThreadZerocoinMintPool()");
+        }
+        MilliSleep(ZEROCOIN_MINT_POOL_REFILL_INTERVAL);
+    }
+}
+
 bool CWallet::CreateZerocoinMintModel(string &stringError, string denomAmount) {
     // temporarily disable zerocoin
     stringError = "Zerocoin functionality has been disabled until the pending Sigma release.";
@@ -3374,7 +3565,7 @@ bool CWallet::CreateZerocoinMintModel(string &stringError, string denomAmount) {
         LogPrintf("pubcoin=%s, isUsed=%s\n", zerocoinTx.value.GetHex(), zerocoinTx.IsUsed);
         LogPrintf("randomness=%s, serialNumber=%s\n", zerocoinTx.randomness, zerocoinTx.serialNumber);
         NotifyZerocoinChanged(this, zerocoinTx.value.GetHex(), "New (" + std::to_string(zerocoinTx.denomination) + " mint)", CT_NEW);
-        if (!CWalletDB(strWalletFile).WriteZerocoinEntry(zerocoinTx))
+        if (!WriteZerocoinEntry(zerocoinTx))
             return false;
         return true;
     } else {
@@ -3805,6 +3996,235 @@ CWallet::CreateZerocoinMintTransaction(CScript pubCoin, int64_t nValue, CWalletT
                                          coinControl);
 }
 
+// Cached witness can be advanced only if the block it was calculated for is still in the active chain
+static bool IsZerocoinWitnessUsable(const CZerocoinWitnessEntry &witness, int maxHeight, int denomination, int id, bool fModulusV2)
+{
+    AssertLockHeld(cs_main);
+
+    if (witness.denomination != denomination || witness.id != id || witness.fModulusV2 != fModulusV2 ||
+            witness.nHeight < 0 || witness.nHeight > maxHeight)
+        return false;
+
+    CBlockIndex *pindex = chainActive[witness.nHeight];
+    return pindex != NULL && *pindex->phashBlock == witness.hashBlock;
+}
+
+libzerocoin::AccumulatorWitness CWallet::GetZerocoinWitness(int maxHeight, int denomination, int id, const CBigNum &pubCoin, bool fModulusV2)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
+    libzerocoin::Params *zcParams = fModulusV2 ? ZCParamsV2 : ZCParams;
+    libzerocoin::CoinDenomination d = (libzerocoin::CoinDenomination)denomination;
+
+    CZerocoinWitnessEntry witness;
+    int fromHeight = -1;
+    auto cached = mapZerocoinWitnesses.find(pubCoin);
+    if (cached != mapZerocoinWitnesses.end() && IsZerocoinWitnessUsable(cached->second, maxHeight, denomination, id, fModulusV2)) {
+        witness = cached->second;
+        fromHeight = witness.nHeight;
+    }
+
+    CBigNum witnessStart;
+    vector<CBigNum> newCoins;
+    if (zerocoinState->GetWitnessUpdate(&chainActive, fromHeight, maxHeight, denomination, id, pubCoin, fModulusV2, witnessStart, newCoins))
+        witness.witnessValue = witnessStart;
+
+    vector<libzerocoin::PublicCoin> pubCoins;
+    BOOST_FOREACH(const CBigNum &coin, newCoins) {
+        pubCoins.push_back(libzerocoin::PublicCoin(zcParams, coin, d));
+    }
+    libzerocoin::Accumulator accumulator(zcParams, witness.witnessValue, d);
+    accumulator.accumulate(pubCoins);
+
+    if (fromHeight != maxHeight) {
+        witness.pubCoin = pubCoin;
+        witness.denomination = denomination;
+        witness.id = id;
+        witness.fModulusV2 = fModulusV2;
+        witness.nHeight = maxHeight;
+        witness.hashBlock = *chainActive[maxHeight]->phashBlock;
+        witness.witnessValue = accumulator.getValue();
+        CWalletDB walletdb(strWalletFile);
+        WriteZerocoinWitness(walletdb, witness);
+    }
+
+    return libzerocoin::AccumulatorWitness(zcParams, accumulator, libzerocoin::PublicCoin(zcParams, pubCoin, d));
+}
+
+void CWallet::WriteZerocoinWitness(CWalletDB &walletdb, const CZerocoinWitnessEntry &witness)
+{
+    AssertLockHeld(cs_wallet);
+
+    mapZerocoinWitnesses[witness.pubCoin] = witness;
+    walletdb.WriteZerocoinWitness(witness);
+}
+
+void CWallet::UpdateZerocoinWitnesses()
+{
+    struct WitnessUpdate {
+        CZerocoinWitnessEntry witness;
+        vector<CBigNum> newCoins;
+        int nMintHeight;
+        bool fFromScratch;
+        bool fDone;
+    };
+    vector<WitnessUpdate> updates;
+
+    // Collect coins minted since the last update while holding the locks, exponentiations are done without them
+    {
+        LOCK2(cs_main, cs_wallet);
+
+        if (IsInitialBlockDownload())
+            return;
+
+        int maxHeight = chainActive.Height() - (ZC_MINT_CONFIRMATIONS-1);
+        if (maxHeight <= 0 || *chainActive[maxHeight]->phashBlock == hashZerocoinWitnessBlock)
+            return;
+
+        bool fModulusV2 = chainActive.Height() >= Params().GetConsensus().nModulusV2StartBlock;
+        CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
+
+        // Witnesses of the spent coins are not needed anymore
+        CWalletDB walletdb(strWalletFile);
+        for (auto it = mapZerocoinWitnesses.begin(); it != mapZerocoinWitnesses.end(); ) {
+            auto coin = setZerocoinEntries.get<zerocoin_value>().find(it->first);
+            if (coin != setZerocoinEntries.get<zerocoin_value>().end() && coin->IsUsed) {
+                walletdb.EraseZerocoinWitness(it->first);
+                it = mapZerocoinWitnesses.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        // Only the unspent coins are walked, spent ones of each denomination are skipped at once
+        const CZerocoinEntrySet::index<zerocoin_denomination>::type &index = setZerocoinEntries.get<zerocoin_denomination>();
+        for (auto it = index.begin(); it != index.end(); ) {
+            if (it->IsUsed) {
+                it = index.upper_bound(boost::make_tuple(it->denomination, true));
+                continue;
+            }
+            const CZerocoinEntry &coin = *it++;
+
+            WitnessUpdate update;
+            auto cached = mapZerocoinWitnesses.find(coin.value);
+            bool fHaveWitness = cached != mapZerocoinWitnesses.end();
+            if (fHaveWitness)
+                update.witness = cached->second;
+
+            int id;
+            int mintHeight = zerocoinState->GetMintedCoinHeightAndId(coin.value, coin.denomination, id);
+            if (mintHeight <= 0 || mintHeight > maxHeight)
+                continue;
+
+            int fromHeight = -1;
+            if (fHaveWitness && IsZerocoinWitnessUsable(update.witness, maxHeight, coin.denomination, id, fModulusV2))
+                fromHeight = update.witness.nHeight;
+            if (fromHeight == maxHeight)
+                continue;
+
+            CBigNum witnessStart;
+            update.fFromScratch = zerocoinState->GetWitnessUpdate(&chainActive, fromHeight, maxHeight, coin.denomination, id,
+                                                                  coin.value, fModulusV2, witnessStart, update.newCoins);
+            if (update.fFromScratch)
+                update.witness.witnessValue = witnessStart;
+            update.nMintHeight = mintHeight;
+            update.fDone = false;
+
+            update.witness.pubCoin = coin.value;
+            update.witness.denomination = coin.denomination;
+            update.witness.id = id;
+            update.witness.fModulusV2 = fModulusV2;
+            update.witness.nHeight = maxHeight;
+            update.witness.hashBlock = *chainActive[maxHeight]->phashBlock;
+            updates.push_back(update);
+        }
+
+        hashZerocoinWitnessBlock = *chainActive[maxHeight]->phashBlock;
+    }
+
+    // New witnesses of coins minted in the same block start with the same accumulator value and differ only by
+    // the coin itself. The other coins of the block and the later ones are accumulated once, the wallet coins are
+    // then distributed between the witnesses in one pass
+    typedef std::tuple<bool,int,int,int> MintBlockKey;
+    map<MintBlockKey, vector<WitnessUpdate *>> mintBlocks;
+    BOOST_FOREACH(WitnessUpdate &update, updates) {
+        if (update.fFromScratch) {
+            MintBlockKey key(update.witness.fModulusV2, update.witness.denomination, update.witness.id, update.nMintHeight);
+            mintBlocks[key].push_back(&update);
+        }
+    }
+
+    for (auto &mintBlock: mintBlocks) {
+        const vector<WitnessUpdate *> &mints = mintBlock.second;
+        if (mints.size() < 2)
+            continue;
+
+        // Coins accumulated into every witness, the wallet coins of the block removed. Distinct coins of the block
+        // are missing from the witnesses just once, anything else is left for one by one calculation
+        vector<CBigNum> commonCoins = mints[0]->newCoins;
+        bool fShared = true;
+        for (size_t i = 1; i < mints.size() && fShared; i++) {
+            auto coin = std::find(commonCoins.begin(), commonCoins.end(), mints[i]->witness.pubCoin);
+            fShared = coin != commonCoins.end() &&
+                      mints[i]->newCoins.size() == mints[0]->newCoins.size() &&
+                      mints[i]->witness.witnessValue == mints[0]->witness.witnessValue;
+            if (fShared)
+                commonCoins.erase(coin);
+        }
+        if (!fShared)
+            continue;
+
+        boost::this_thread::interruption_point();
+
+        libzerocoin::Params *zcParams = mints[0]->witness.fModulusV2 ? ZCParamsV2 : ZCParams;
+        libzerocoin::CoinDenomination d = (libzerocoin::CoinDenomination)mints[0]->witness.denomination;
+        vector<libzerocoin::PublicCoin> pubCoins, walletCoins;
+        BOOST_FOREACH(const CBigNum &coin, commonCoins) {
+            pubCoins.push_back(libzerocoin::PublicCoin(zcParams, coin, d));
+        }
+        BOOST_FOREACH(const WitnessUpdate *update, mints) {
+            walletCoins.push_back(libzerocoin::PublicCoin(zcParams, update->witness.pubCoin, d));
+        }
+
+        libzerocoin::Accumulator accumulator(zcParams, mints[0]->witness.witnessValue, d);
+        accumulator.accumulate(pubCoins);
+        vector<libzerocoin::AccumulatorWitness> witnesses = libzerocoin::AccumulatorWitness::ForCoins(zcParams, accumulator, walletCoins);
+        for (size_t i = 0; i < mints.size(); i++) {
+            mints[i]->witness.witnessValue = witnesses[i].getValue();
+            mints[i]->fDone = true;
+        }
+    }
+
+    BOOST_FOREACH(WitnessUpdate &update, updates) {
+        if (update.fDone)
+            continue;
+
+        boost::this_thread::interruption_point();
+
+        libzerocoin::Params *zcParams = update.witness.fModulusV2 ? ZCParamsV2 : ZCParams;
+        libzerocoin::CoinDenomination d = (libzerocoin::CoinDenomination)update.witness.denomination;
+        vector<libzerocoin::PublicCoin> pubCoins;
+        BOOST_FOREACH(const CBigNum &coin, update.newCoins) {
+            pubCoins.push_back(libzerocoin::PublicCoin(zcParams, coin, d));
+        }
+        libzerocoin::Accumulator accumulator(zcParams, update.witness.witnessValue, d);
+        accumulator.accumulate(pubCoins);
+        update.witness.witnessValue = accumulator.getValue();
+    }
+
+    if (!updates.empty()) {
+        // Witnesses of coins spent meanwhile are erased by the next update
+        LOCK(cs_wallet);
+        CWalletDB walletdb(strWalletFile);
+        BOOST_FOREACH(const WitnessUpdate &update, updates) {
+            WriteZerocoinWitness(walletdb, update.witness);
+        }
+        LogPrint("zerocoin", "UpdateZerocoinWitnesses: %d witnesses updated\n", updates.size());
+    }
+}
+
 /**
  * @brief CWallet::CreateZerocoinSpendTransaction
  * @param nValue
@@ -3818,6 +4238,54 @@ CWallet::CreateZerocoinMintTransaction(CScript pubCoin, int64_t nValue, CWalletT
  * @param strFailReason
  * @return
  */
+bool CWallet::SelectZerocoinToSpend(libzerocoin::CoinDenomination denomination, bool forceUsed, bool fModulusV2,
+                                    const set<CBigNum> &coinsToSkip, CZerocoinEntry &coinToUse, int &coinId, int &coinHeight,
+                                    CBigNum &accumulatorValue, uint256 &accumulatorBlockHash) {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    struct GroupAccumulator {
+        int nCoins;
+        CBigNum value;
+        uint256 blockHash;
+    };
+    // Every coin group is looked up in the chain only once
+    map<int, GroupAccumulator> groupAccumulators;
+
+    CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
+    int maxHeight = chainActive.Height() - (ZC_MINT_CONFIRMATIONS-1);
+
+    coinId = INT_MAX;
+    auto range = setZerocoinEntries.get<zerocoin_denomination>().equal_range(boost::make_tuple((int)denomination, forceUsed));
+    for (auto it = range.first; it != range.second; ++it) {
+        const CZerocoinEntry &minIdPubcoin = *it;
+        if (minIdPubcoin.randomness == 0 || minIdPubcoin.serialNumber == 0 || coinsToSkip.count(minIdPubcoin.value) > 0)
+            continue;
+
+        int id;
+        int mintHeight = zerocoinState->GetMintedCoinHeightAndId(minIdPubcoin.value, minIdPubcoin.denomination, id);
+        if (mintHeight <= 0 || id >= coinId || mintHeight > maxHeight)
+            continue;
+
+        map<int, GroupAccumulator>::iterator group = groupAccumulators.find(id);
+        if (group == groupAccumulators.end()) {
+            group = groupAccumulators.insert(make_pair(id, GroupAccumulator())).first;
+            group->second.nCoins = zerocoinState->GetAccumulatorValueForSpend(&chainActive, maxHeight, denomination, id,
+                    group->second.value, group->second.blockHash, fModulusV2);
+        }
+
+        if (group->second.nCoins > 1) {
+            coinId = id;
+            coinHeight = mintHeight;
+            coinToUse = minIdPubcoin;
+            accumulatorValue = group->second.value;
+            accumulatorBlockHash = group->second.blockHash;
+        }
+    }
+
+    return coinId != INT_MAX;
+}
+
 bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int64_t nValue, libzerocoin::CoinDenomination denomination,
                                              CWalletTx &wtxNew, CReserveKey &reservekey, CBigNum &coinSerial,
                                              uint256 &txHash, CBigNum &zcSelectedValue, bool &zcSelectedIsUsed,
@@ -3875,12 +4343,7 @@ bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int
             libzerocoin::Params *zcParams = fModulusV2 ? ZCParamsV2 : ZCParams;
 
             // Select not yet used coin from the wallet with minimal possible id
-
-            list <CZerocoinEntry> listPubCoin;
-            CWalletDB(strWalletFile).ListPubCoin(listPubCoin);
-            listPubCoin.sort(CompHeight);
             CZerocoinEntry coinToUse;
-            CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
 
             CBigNum accumulatorValue;
             uint256 accumulatorBlockHash;      // to be used in zerocoin spend v2
@@ -3888,31 +4351,8 @@ bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int
             int coinId = INT_MAX;
             int coinHeight;
 
-            BOOST_FOREACH(const CZerocoinEntry &minIdPubcoin, listPubCoin) {
-                if (minIdPubcoin.denomination == denomination
-                        && ((minIdPubcoin.IsUsed == false && !forceUsed) || (minIdPubcoin.IsUsed == true && forceUsed))
-                        && minIdPubcoin.randomness != 0
-                        && minIdPubcoin.serialNumber != 0) {
-
-                    int id;
-                    coinHeight = zerocoinState->GetMintedCoinHeightAndId(minIdPubcoin.value, minIdPubcoin.denomination, id);
-                    if (coinHeight > 0
-                            && id < coinId
-                            && coinHeight + (ZC_MINT_CONFIRMATIONS-1) <= chainActive.Height()
-                            && zerocoinState->GetAccumulatorValueForSpend(
-                                    &chainActive,
-                                    chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
-                                    denomination,
-                                    id,
-                                    accumulatorValue,
-                                    accumulatorBlockHash,
-                                    fModulusV2) > 1
-                            ) {
-                        coinId = id;
-                        coinToUse = minIdPubcoin;
-                    }
-                }
-            }
+            SelectZerocoinToSpend(denomination, forceUsed, fModulusV2, set<CBigNum>(), coinToUse, coinId, coinHeight,
+                                  accumulatorValue, accumulatorBlockHash);
 
             if (coinId == INT_MAX){
                 strFailReason = _("it has to have at least two mint coins with at least 6 confirmation in order to spend a coin");
@@ -3934,11 +4374,10 @@ bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int
 
             // 4. Get witness from the index
             libzerocoin::AccumulatorWitness witness =
-                    zerocoinState->GetWitnessForSpend(&chainActive,
-                                                      chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
-                                                      denomination, coinId,
-                                                      coinToUse.value,
-                                                      fModulusV2);
+                    GetZerocoinWitness(chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
+                                       denomination, coinId,
+                                       coinToUse.value,
+                                       fModulusV2);
 
             int serializedId = coinId + (fModulusV2 ? ZC_MODULUS_V2_BASE_ID : 0);
 
@@ -4026,7 +4465,7 @@ bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int
                     pubCoinTx.serialNumber = coinToUse.serialNumber;
                     pubCoinTx.value = coinToUse.value;
                     pubCoinTx.ecdsaSecretKey = coinToUse.ecdsaSecretKey;
-                    CWalletDB(strWalletFile).WriteZerocoinEntry(pubCoinTx);
+                    WriteZerocoinEntry(pubCoinTx);
                     LogPrintf("CreateZerocoinSpendTransaction() -> NotifyZerocoinChanged\n");
                     LogPrintf("pubcoin=%s, isUsed=Used\n", coinToUse.value.GetHex());
                     pwalletMain->NotifyZerocoinChanged(pwalletMain, coinToUse.value.GetHex(), "Used (" + std::to_string(coinToUse.denomination) + " mint)",
@@ -4056,7 +4495,7 @@ bool CWallet::CreateZerocoinSpendTransaction(std::string &thirdPartyaddress, int
             coinToUse.IsUsed = true;
             coinToUse.id = coinId;
             coinToUse.nHeight = coinHeight;
-            CWalletDB(strWalletFile).WriteZerocoinEntry(coinToUse);
+            WriteZerocoinEntry(coinToUse);
             pwalletMain->NotifyZerocoinChanged(pwalletMain, coinToUse.value.GetHex(), "Used (" + std::to_string(coinToUse.denomination) + " mint)",
                                                CT_UPDATED);
         }
@@ -4146,41 +4585,14 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
             
                 // Fill vin
                 // Select not yet used coin from the wallet with minimal possible id
-                list <CZerocoinEntry> listPubCoin;
-                CWalletDB(strWalletFile).ListPubCoin(listPubCoin);
-                listPubCoin.sort(CompHeight);
                 CZerocoinEntry coinToUse;
-                CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
                 CBigNum accumulatorValue;
                 uint256 accumulatorBlockHash;      // to be used in zerocoin spend v2
                 int coinId = INT_MAX;
                 int coinHeight;
-                BOOST_FOREACH(const CZerocoinEntry &minIdPubcoin, listPubCoin) {
-                    if (minIdPubcoin.denomination == denomination
-                        && ((minIdPubcoin.IsUsed == false && !forceUsed) || (minIdPubcoin.IsUsed == true && forceUsed))
-                        && minIdPubcoin.randomness != 0
-                        && minIdPubcoin.serialNumber != 0
-                        && (tempCoinsToUse.find(minIdPubcoin.value)==tempCoinsToUse.end())) {
-                        int id;
-                        coinHeight = zerocoinState->GetMintedCoinHeightAndId(minIdPubcoin.value, minIdPubcoin.denomination, id);
-                        if (coinHeight > 0
-                            && id < coinId
-                            && coinHeight + (ZC_MINT_CONFIRMATIONS-1) <= chainActive.Height()
-                            && zerocoinState->GetAccumulatorValueForSpend(
-                                    &chainActive,
-                                    chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
-                                    denomination,
-                                    id,
-                                    accumulatorValue,
-                                    accumulatorBlockHash,
-                                    fModulusV2) > 1) {
-                            coinId = id;
-                            coinToUse = minIdPubcoin;
-                            tempCoinsToUse.insert(minIdPubcoin.value);
-                            break;
-                        }
-                    }
-                }
+                if (SelectZerocoinToSpend(denomination, forceUsed, fModulusV2, tempCoinsToUse, coinToUse, coinId, coinHeight,
+                                          accumulatorValue, accumulatorBlockHash))
+                    tempCoinsToUse.insert(coinToUse.value);
 
                 // If no suitable coin found, fail.
                 if (coinId == INT_MAX){
@@ -4201,11 +4613,10 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
                 }
                  // 4. Get witness for the accumulator and selected coin
                 libzerocoin::AccumulatorWitness witness =
-                        zerocoinState->GetWitnessForSpend(&chainActive,
-                                                          chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
-                                                          denomination, coinId,
-                                                          coinToUse.value,
-                                                          fModulusV2);
+                        GetZerocoinWitness(chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
+                                           denomination, coinId,
+                                           coinToUse.value,
+                                           fModulusV2);
 
                 // Generate TxIn info
                 int serializedId = coinId + (fModulusV2 ? ZC_MODULUS_V2_BASE_ID : 0);
@@ -4291,13 +4702,11 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
                 CZerocoinEntry coinToUse = tempStorage.coinToUse;
 
                  //have to recreate coin witness as it can't be stored in an object, hence we can't store it in tempStorage..
-                CZerocoinState *zerocoinState = CZerocoinState::GetZerocoinState();
                 libzerocoin::AccumulatorWitness witness =
-                zerocoinState->GetWitnessForSpend(&chainActive,
-                                                  chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
-                                                  tempStorage.denomination, tempStorage.coinId,
-                                                  coinToUse.value,
-                                                  fModulusV2);
+                GetZerocoinWitness(chainActive.Height()-(ZC_MINT_CONFIRMATIONS-1),
+                                   tempStorage.denomination, tempStorage.coinId,
+                                   coinToUse.value,
+                                   fModulusV2);
 
                 // Recreate CoinSpend object
                  libzerocoin::CoinSpend spend(zcParams, 
@@ -4338,7 +4747,7 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
                         pubCoinTx.serialNumber = coinToUse.serialNumber;
                         pubCoinTx.value = coinToUse.value;
                         pubCoinTx.ecdsaSecretKey = coinToUse.ecdsaSecretKey;
-                        CWalletDB(strWalletFile).WriteZerocoinEntry(pubCoinTx);
+                        WriteZerocoinEntry(pubCoinTx);
                         LogPrintf("CreateZerocoinSpendTransaction() -> NotifyZerocoinChanged\n");
                         LogPrintf("pubcoin=%s, isUsed=Used\n", coinToUse.value.GetHex());
                         pwalletMain->NotifyZerocoinChanged(pwalletMain, coinToUse.value.GetHex(), "Used (" + std::to_string(coinToUse.denomination) + " mint)",
@@ -4384,7 +4793,7 @@ bool CWallet::CreateMultipleZerocoinSpendTransaction(std::string &thirdPartyaddr
                 coinToUse.IsUsed = true;
                 coinToUse.id = tempStorage.coinId;
                 coinToUse.nHeight = tempStorage.coinHeight;
-                CWalletDB(strWalletFile).WriteZerocoinEntry(coinToUse);
+                WriteZerocoinEntry(coinToUse);
                 pwalletMain->NotifyZerocoinChanged(pwalletMain, coinToUse.value.GetHex(), "Used (" + std::to_string(coinToUse.denomination) + " mint)", CT_UPDATED);
             }
         }
@@ -4434,7 +4843,7 @@ bool CWallet::CommitZerocoinSpendTransaction(CWalletTx &wtxNew, CReserveKey &res
 }
 
 string CWallet::MintAndStoreZerocoin(vector<CRecipient> vecSend, 
-                                     vector<libzerocoin::PrivateCoin> privCoins, 
+                                     const vector<CZerocoinEntry>& mints,
                                      CWalletTx &wtxNew, bool fAskFee) {
     // temporarily disable zerocoin
     return "Zerocoin functionality has been disabled until the pending Sigma release.";
@@ -4479,24 +4888,10 @@ string CWallet::MintAndStoreZerocoin(vector<CRecipient> vecSend,
         return "ABORTED";
     }
 
-    CWalletDB walletdb(pwalletMain->strWalletFile);
-    libzerocoin::Params *zcParams = ZCParamsV2;
-
-    BOOST_FOREACH(libzerocoin::PrivateCoin privCoin, privCoins){
-        CZerocoinEntry zerocoinTx;
-        zerocoinTx.IsUsed = false;                         
-        zerocoinTx.denomination = privCoin.getPublicCoin().getDenomination();
-        zerocoinTx.value = privCoin.getPublicCoin().getValue();
-        libzerocoin::PublicCoin checkPubCoin(zcParams, zerocoinTx.value, privCoin.getPublicCoin().getDenomination());
-        if (!checkPubCoin.validate()) {
-            return "error: pubCoin not validated.";
-        }
-        zerocoinTx.randomness = privCoin.getRandomness();
-        zerocoinTx.serialNumber = privCoin.getSerialNumber();
-        const unsigned char *ecdsaSecretKey = privCoin.getEcdsaSeckey();
-        zerocoinTx.ecdsaSecretKey = std::vector<unsigned char>(ecdsaSecretKey, ecdsaSecretKey+32);
+    // Coins were validated when they were minted (see GenerateZerocoinMints)
+    BOOST_FOREACH(const CZerocoinEntry &zerocoinTx, mints){
         NotifyZerocoinChanged(this, zerocoinTx.value.GetHex(), "New (" + std::to_string(zerocoinTx.denomination) + " mint)", CT_NEW);
-        walletdb.WriteZerocoinEntry(zerocoinTx);
+        WriteZerocoinEntry(zerocoinTx);
     }
 
     if (!CommitTransaction(wtxNew, reservekey)) {
@@ -4605,26 +5000,20 @@ string CWallet::SpendZerocoin(std::string &thirdPartyaddress, int64_t nValue, li
     if (!CommitZerocoinSpendTransaction(wtxNew, reservekey)) {
         LogPrintf("CommitZerocoinSpendTransaction() -> FAILED!\n");
         CZerocoinEntry pubCoinTx;
-        list <CZerocoinEntry> listPubCoin;
-        listPubCoin.clear();
-
-        CWalletDB walletdb(pwalletMain->strWalletFile);
-        walletdb.ListPubCoin(listPubCoin);
-        BOOST_FOREACH(const CZerocoinEntry &pubCoinItem, listPubCoin) {
-            if (zcSelectedValue == pubCoinItem.value) {
-                pubCoinTx.id = pubCoinItem.id;
-                pubCoinTx.IsUsed = false; // having error, so set to false, to be able to use again
-                pubCoinTx.value = pubCoinItem.value;
-                pubCoinTx.nHeight = pubCoinItem.nHeight;
-                pubCoinTx.randomness = pubCoinItem.randomness;
-                pubCoinTx.serialNumber = pubCoinItem.serialNumber;
-                pubCoinTx.denomination = pubCoinItem.denomination;
-                pubCoinTx.ecdsaSecretKey = pubCoinItem.ecdsaSecretKey;
-                CWalletDB(strWalletFile).WriteZerocoinEntry(pubCoinTx);
-                LogPrintf("SpendZerocoin failed, re-updated status -> NotifyZerocoinChanged\n");
-                LogPrintf("pubcoin=%s, isUsed=New\n", pubCoinItem.value.GetHex());
-                pwalletMain->NotifyZerocoinChanged(pwalletMain, pubCoinItem.value.GetHex(), "New", CT_UPDATED);
-            }
+        CZerocoinEntry pubCoinItem;
+        if (GetZerocoinEntry(zcSelectedValue, pubCoinItem)) {
+            pubCoinTx.id = pubCoinItem.id;
+            pubCoinTx.IsUsed = false; // having error, so set to false, to be able to use again
+            pubCoinTx.value = pubCoinItem.value;
+            pubCoinTx.nHeight = pubCoinItem.nHeight;
+            pubCoinTx.randomness = pubCoinItem.randomness;
+            pubCoinTx.serialNumber = pubCoinItem.serialNumber;
+            pubCoinTx.denomination = pubCoinItem.denomination;
+            pubCoinTx.ecdsaSecretKey = pubCoinItem.ecdsaSecretKey;
+            WriteZerocoinEntry(pubCoinTx);
+            LogPrintf("SpendZerocoin failed, re-updated status -> NotifyZerocoinChanged\n");
+            LogPrintf("pubcoin=%s, isUsed=New\n", pubCoinItem.value.GetHex());
+            pwalletMain->NotifyZerocoinChanged(pwalletMain, pubCoinItem.value.GetHex(), "New", CT_UPDATED);
         }
         CZerocoinSpendEntry entry;
         entry.coinSerial = coinSerial;
@@ -4673,29 +5062,24 @@ string CWallet::SpendMultipleZerocoin(std::string &thirdPartyaddress, const std:
     if (!CommitZerocoinSpendTransaction(wtxNew, reservekey)) {
         LogPrintf("CommitZerocoinSpendTransaction() -> FAILED!\n");
         CZerocoinEntry pubCoinTx;
-        list <CZerocoinEntry> listPubCoin;
-        listPubCoin.clear();
-        CWalletDB walletdb(pwalletMain->strWalletFile);
-        walletdb.ListPubCoin(listPubCoin);
 
         for (std::vector<CBigNum>::iterator it = coinSerials.begin(); it != coinSerials.end(); it++){
             unsigned index = it - coinSerials.begin();
             CBigNum zcSelectedValue = zcSelectedValues[index];
-            BOOST_FOREACH(const CZerocoinEntry &pubCoinItem, listPubCoin) {
-                if (zcSelectedValue == pubCoinItem.value) {
-                    pubCoinTx.id = pubCoinItem.id;
-                    pubCoinTx.IsUsed = false; // having error, so set to false, to be able to use again
-                    pubCoinTx.value = pubCoinItem.value;
-                    pubCoinTx.nHeight = pubCoinItem.nHeight;
-                    pubCoinTx.randomness = pubCoinItem.randomness;
-                    pubCoinTx.serialNumber = pubCoinItem.serialNumber;
-                    pubCoinTx.denomination = pubCoinItem.denomination;
-                    pubCoinTx.ecdsaSecretKey = pubCoinItem.ecdsaSecretKey;
-                    NotifyZerocoinChanged(this, pubCoinTx.value.GetHex(), "New", CT_UPDATED);
-                    CWalletDB(strWalletFile).WriteZerocoinEntry(pubCoinTx);
-                    LogPrintf("SpendZerocoin failed, re-updated status -> NotifyZerocoinChanged\n");
-                    LogPrintf("pubcoin=%s, isUsed=New\n", pubCoinItem.value.GetHex());
-                }
+            CZerocoinEntry pubCoinItem;
+            if (GetZerocoinEntry(zcSelectedValue, pubCoinItem)) {
+                pubCoinTx.id = pubCoinItem.id;
+                pubCoinTx.IsUsed = false; // having error, so set to false, to be able to use again
+                pubCoinTx.value = pubCoinItem.value;
+                pubCoinTx.nHeight = pubCoinItem.nHeight;
+                pubCoinTx.randomness = pubCoinItem.randomness;
+                pubCoinTx.serialNumber = pubCoinItem.serialNumber;
+                pubCoinTx.denomination = pubCoinItem.denomination;
+                pubCoinTx.ecdsaSecretKey = pubCoinItem.ecdsaSecretKey;
+                NotifyZerocoinChanged(this, pubCoinTx.value.GetHex(), "New", CT_UPDATED);
+                WriteZerocoinEntry(pubCoinTx);
+                LogPrintf("SpendZerocoin failed, re-updated status -> NotifyZerocoinChanged\n");
+                LogPrintf("pubcoin=%s, isUsed=New\n", pubCoinItem.value.GetHex());
             }
             CZerocoinSpendEntry entry;
             entry.coinSerial = coinSerials[index];
@@ -5432,6 +5816,9 @@ std::string CWallet::GetWalletHelpString(bool showDebug) {
                                                    strprintf(_("(default: %u)"), DEFAULT_WALLETBROADCAST));
     strUsage += HelpMessageOpt("-walletnotify=<cmd>",
                                _("Execute command when a wallet transaction changes (%s in cmd is replaced by TxID)"));
+    strUsage += HelpMessageOpt("-zerocoinmintpool=<n>", strprintf(
+            _("Keep <n> pregenerated zerocoin mints of every denomination so mints don't have to wait for them (default: %u)"),
+            DEFAULT_ZEROCOIN_MINT_POOL_SIZE));
     strUsage += HelpMessageOpt("-zapwallettxes=<mode>",
                                _("Delete all wallet transactions and only recover those parts of the blockchain through -rescan on startup") +
                                " " +
@@ -5616,7 +6003,7 @@ bool CWallet::InitLoadWallet() {
                 //   3. Mark all used mints as not used if there is no matching spend serial
                 list <CZerocoinEntry> listPubCoin;
                 CWalletDB walletdb(walletFile);
-                walletdb.ListPubCoin(listPubCoin);
+                walletInstance->ListZerocoinEntries(listPubCoin);
                 bool usedMintsFound = false;
                 BOOST_FOREACH(CZerocoinEntry const & entry, listPubCoin) {
                     if(entry.IsUsed) {
@@ -5633,7 +6020,7 @@ bool CWallet::InitLoadWallet() {
                         if(entry.IsUsed) {
                             if(!zerocoinState->IsUsedCoinSerial(entry.serialNumber)) {
                                 entry.IsUsed = false;
-                                walletdb.WriteZerocoinEntry(entry);
+                                walletInstance->WriteZerocoinEntry(entry);
                                 std::list <CZerocoinSpendEntry>::const_iterator const
                                     se_iter = std::find_if(listCoinSpendSerial.begin(), listCoinSpendSerial.end(),
                                         [&entry](CZerocoinSpendEntry const & spendEntry){ return entry.serialNumber == spendEntry.coinSerial;});
@@ -30,6 +30,10 @@
 #include <utility>
 #include <vector>
 
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
 #include <boost/shared_ptr.hpp>
 
 extern CWallet* pwalletMain;
@@ -66,6 +70,13 @@ static const bool DEFAULT_WALLETBROADCAST = true;
 //! if set, all keys will be derived by using BIP32
 static const bool DEFAULT_USE_HD_WALLET = true;
 
+//! Interval in seconds between updates of the cached witnesses of zerocoin mints
+static const int64_t ZEROCOIN_WITNESS_UPDATE_INTERVAL = 60;
+//! -zerocoinmintpool default, number of pregenerated zerocoin mints of every denomination
+static const int DEFAULT_ZEROCOIN_MINT_POOL_SIZE = 0;
+//! Interval in milliseconds between refills of the zerocoin mint pool
+static const int64_t ZEROCOIN_MINT_POOL_REFILL_INTERVAL = 10 * 1000;
+
 extern const char * DEFAULT_WALLET_DAT;
 
 class CBlockIndex;
@@ -579,6 +590,159 @@ private:
 };
 
 
+class CZerocoinEntry
+{
+private:
+    template <typename Stream>
+    auto is_eof_helper(Stream &s, bool) -> decltype(s.eof()) {
+        return s.eof();
+    }
+
+    template <typename Stream>
+    bool is_eof_helper(Stream &s, int) {
+        return false;
+    }
+
+    template<typename Stream>
+    bool is_eof(Stream &s) {
+        return is_eof_helper(s, true);
+    }
+
+public:
+    //public
+    Bignum value;
+    int denomination;
+    //private
+    Bignum randomness;
+    Bignum serialNumber;
+    vector<unsigned char> ecdsaSecretKey;
+
+    bool IsUsed;
+    int nHeight;
+    int id;
+
+    CZerocoinEntry()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        IsUsed = false;
+        randomness = 0;
+        serialNumber = 0;
+        value = 0;
+        denomination = -1;
+        nHeight = -1;
+        id = -1;
+    }
+
+    bool IsCorrectV2Mint() const {
+        return value > 0 && randomness > 0 && serialNumber > 0 && serialNumber.bitSize() <= 160 &&
+                ecdsaSecretKey.size() >= 32;
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(IsUsed);
+        READWRITE(randomness);
+        READWRITE(serialNumber);
+        READWRITE(value);
+        READWRITE(denomination);
+        READWRITE(nHeight);
+        READWRITE(id);
+        if (ser_action.ForRead()) {
+            if (!is_eof(s)) {
+                int nStoredVersion = 0;
+                READWRITE(nStoredVersion);
+                if (nStoredVersion >= ZC_ADVANCED_WALLETDB_MINT_VERSION)
+                    READWRITE(ecdsaSecretKey);
+            }
+        }
+        else {
+            READWRITE(nVersion);
+            READWRITE(ecdsaSecretKey);
+        }
+    }
+
+};
+
+// Tags of the indices of CZerocoinEntrySet
+struct zerocoin_value {};
+struct zerocoin_serial {};
+struct zerocoin_denomination {};
+
+/**
+ * Zerocoin mints of the wallet, unique by the public coin value as the "zerocoin" records of the wallet
+ * database. Spend coin selection and listings walk the index ordered by (denomination, IsUsed, id, nHeight)
+ */
+typedef boost::multi_index_container<
+    CZerocoinEntry,
+    boost::multi_index::indexed_by<
+        boost::multi_index::ordered_unique<
+            boost::multi_index::tag<zerocoin_value>,
+            boost::multi_index::member<CZerocoinEntry, Bignum, &CZerocoinEntry::value>
+        >,
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<zerocoin_serial>,
+            boost::multi_index::member<CZerocoinEntry, Bignum, &CZerocoinEntry::serialNumber>
+        >,
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<zerocoin_denomination>,
+            boost::multi_index::composite_key<
+                CZerocoinEntry,
+                boost::multi_index::member<CZerocoinEntry, int, &CZerocoinEntry::denomination>,
+                boost::multi_index::member<CZerocoinEntry, bool, &CZerocoinEntry::IsUsed>,
+                boost::multi_index::member<CZerocoinEntry, int, &CZerocoinEntry::id>,
+                boost::multi_index::member<CZerocoinEntry, int, &CZerocoinEntry::nHeight>
+            >
+        >
+    >
+> CZerocoinEntrySet;
+
+/** Witness of the zerocoin mint as of the block nHeight, kept to avoid recalculation for every spend */
+class CZerocoinWitnessEntry
+{
+public:
+    Bignum pubCoin;
+    int denomination;
+    int id;
+    bool fModulusV2;
+    int nHeight;
+    uint256 hashBlock;
+    Bignum witnessValue;
+
+    CZerocoinWitnessEntry()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        pubCoin = 0;
+        denomination = 0;
+        id = 0;
+        fModulusV2 = false;
+        nHeight = -1;
+        hashBlock.SetNull();
+        witnessValue = 0;
+    }
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(pubCoin);
+        READWRITE(denomination);
+        READWRITE(id);
+        READWRITE(fModulusV2);
+        READWRITE(nHeight);
+        READWRITE(hashBlock);
+        READWRITE(witnessValue);
+    }
+};
+
 /**
  * A CWallet is an extension of a keystore, which also maintains a set of transactions and balances,
  * and provides the ability to create new transactions.
@@ -628,6 +792,13 @@ private:
     /* the HD chain data model (external chain counters) */
     CHDChain hdChain;
 
+    /* Block the cached zerocoin witnesses were last updated for */
+    uint256 hashZerocoinWitnessBlock;
+    /* Cached zerocoin witnesses by the public coin value, loaded with the wallet and written through to the database */
+    std::map<CBigNum, CZerocoinWitnessEntry> mapZerocoinWitnesses;
+
+    void WriteZerocoinWitness(CWalletDB &walletdb, const CZerocoinWitnessEntry &witness);
+
 public:
     /*
      * Main wallet lock.
@@ -685,10 +856,14 @@ public:
         fAnonymizableTallyCachedNonDenom = false;
         vecAnonymizableTallyCached.clear();
         vecAnonymizableTallyCachedNonDenom.clear();
+        hashZerocoinWitnessBlock.SetNull();
+        mapZerocoinWitnesses.clear();
     }
 
     std::map<uint256, CWalletTx> mapWallet;
     std::list<CAccountingEntry> laccentries;
+    //! Zerocoin mints, loaded with the wallet and kept in sync with the database by WriteZerocoinEntry
+    CZerocoinEntrySet setZerocoinEntries;
     bool EraseFromWallet(uint256 hash);
     typedef std::pair<CWalletTx*, CAccountingEntry*> TxPair;
     typedef std::multimap<int64_t, TxPair > TxItems;
@@ -843,6 +1018,13 @@ public:
                            std::string& strFailReason, const CCoinControl *coinControl = NULL, bool sign = true);
     bool CreateZerocoinMintTransaction(CScript pubCoin, int64_t nValue,
                                        CWalletTx& wtxNew, CReserveKey& reservekey, int64_t& nFeeRet, std::string& strFailReason, const CCoinControl *coinControl=NULL);
+    /**
+     * Select the spendable mint of the denomination with the lowest coin group id, along with the accumulator to
+     * spend it with. Requires cs_main and cs_wallet
+     */
+    bool SelectZerocoinToSpend(libzerocoin::CoinDenomination denomination, bool forceUsed, bool fModulusV2,
+                               const std::set<CBigNum>& coinsToSkip, CZerocoinEntry& coinToUse, int& coinId, int& coinHeight,
+                               CBigNum& accumulatorValue, uint256& accumulatorBlockHash);
     bool CreateZerocoinSpendTransaction(std::string& thirdPartyaddress, int64_t nValue, libzerocoin::CoinDenomination denomination,
                                         CWalletTx& wtxNew, CReserveKey& reservekey, CBigNum& coinSerial, uint256& txHash, CBigNum& zcSelectedValue, bool& zcSelectedIsUsed,  std::string& strFailReason, bool forceUsed = false);
     bool CreateMultipleZerocoinSpendTransaction(std::string& thirdPartyaddress, const std::vector<std::pair<int64_t, libzerocoin::CoinDenomination>>& denominations,
@@ -851,10 +1033,22 @@ public:
     std::string SendMoney(CScript scriptPubKey, int64_t nValue, CWalletTx& wtxNew, bool fAskFee=false);
     std::string SendMoneyToDestination(const CTxDestination &address, int64_t nValue, CWalletTx& wtxNew, bool fAskFee=false);
     std::string MintZerocoin(CScript pubCoin, int64_t nValue, CWalletTx& wtxNew, bool fAskFee=false);
-    std::string MintAndStoreZerocoin(vector<CRecipient> vecSend, vector<libzerocoin::PrivateCoin> privCoins, CWalletTx &wtxNew, bool fAskFee=false);
+    std::string MintAndStoreZerocoin(vector<CRecipient> vecSend, const vector<CZerocoinEntry>& mints, CWalletTx &wtxNew, bool fAskFee=false);
     std::string SpendZerocoin(std::string& thirdPartyaddress, int64_t nValue, libzerocoin::CoinDenomination denomination, CWalletTx& wtxNew, CBigNum& coinSerial, uint256& txHash, CBigNum& zcSelectedValue, bool& zcSelectedIsUsed, bool forceUsed = false);
     std::string SpendMultipleZerocoin(std::string& thirdPartyaddress, const std::vector<std::pair<int64_t, libzerocoin::CoinDenomination>>& denominations, CWalletTx& wtxNew, vector<CBigNum>& coinSerials, uint256& txHash, vector<CBigNum>& zcSelectedValues, bool forceUsed = false);
 
+    /**
+     * Generate the coins of a zerocoin mint transaction. Coins are taken from the mint pool (see -zerocoinmintpool)
+     * while it has coins of the denomination, the rest are minted in parallel. The coins are removed from the pool,
+     * the caller returns them with ReturnZerocoinMints if no transaction is created. Throws ZerocoinException if
+     * minting is interrupted by shutdown
+     */
+    std::vector<CZerocoinEntry> GenerateZerocoinMints(const std::vector<libzerocoin::CoinDenomination>& denominations);
+    //! Put the coins of a mint that failed into the mint pool, up to -zerocoinmintpool coins of every denomination
+    void ReturnZerocoinMints(const std::vector<CZerocoinEntry>& mints);
+    //! Mint the coins missing in the mint pool one by one in the calling thread
+    void RefillZerocoinMintPool();
+
     bool CreateZerocoinMintModel(string &stringError, string denomAmount);
 
     bool CreateZerocoinMintModel(string &stringError, vector<string> denomAmounts);
@@ -864,6 +1058,25 @@ public:
 
     bool SetZerocoinBook(const CZerocoinEntry& zerocoinEntry);
 
+    //! Adds a zerocoin mint to the wallet (used by LoadWallet)
+    void LoadZerocoinEntry(const CZerocoinEntry& zerocoin);
+    //! Adds or updates the zerocoin mint in the wallet and the database
+    bool WriteZerocoinEntry(const CZerocoinEntry& zerocoin);
+    bool GetZerocoinEntry(const CBigNum& pubCoin, CZerocoinEntry& zerocoin) const;
+    bool GetZerocoinEntryBySerial(const CBigNum& serialNumber, CZerocoinEntry& zerocoin) const;
+    //! Adds a cached zerocoin witness to the wallet (used by LoadWallet)
+    void LoadZerocoinWitness(const CZerocoinWitnessEntry& witness);
+    //! Zerocoin mints of the denomination (all of them if negative) ordered by use state, group id and height
+    void ListZerocoinEntries(std::list<CZerocoinEntry>& listPubCoin, int denomination = -1) const;
+
+    /**
+     * Get witness for the spend of the zerocoin mint. Cached witness is advanced to maxHeight so only the coins
+     * minted since the last update are accumulated. Requires cs_main and cs_wallet
+     */
+    libzerocoin::AccumulatorWitness GetZerocoinWitness(int maxHeight, int denomination, int id, const CBigNum &pubCoin, bool fModulusV2);
+    //! Bring cached witnesses of unspent zerocoin mints up to date with the active chain
+    void UpdateZerocoinWitnesses();
+
     bool CommitTransaction(CWalletTx& wtxNew, CReserveKey& reservekey);
 
     bool CreateCollateralTransaction(CMutableTransaction& txCollateral, std::string& strReason);
@@ -1078,86 +1291,6 @@ public:
     }
 };
 
-class CZerocoinEntry
-{
-private:
-    template <typename Stream>
-    auto is_eof_helper(Stream &s, bool) -> decltype(s.eof()) {
-        return s.eof();
-    }
-
-    template <typename Stream>
-    bool is_eof_helper(Stream &s, int) {
-        return false;
-    }
-
-    template<typename Stream>
-    bool is_eof(Stream &s) {
-        return is_eof_helper(s, true);
-    }
-
-public:
-    //public
-    Bignum value;
-    int denomination;
-    //private
-    Bignum randomness;
-    Bignum serialNumber;
-    vector<unsigned char> ecdsaSecretKey;
-
-    bool IsUsed;
-    int nHeight;
-    int id;
-
-    CZerocoinEntry()
-    {
-        SetNull();
-    }
-
-    void SetNull()
-    {
-        IsUsed = false;
-        randomness = 0;
-        serialNumber = 0;
-        value = 0;
-        denomination = -1;
-        nHeight = -1;
-        id = -1;
-    }
-
-    bool IsCorrectV2Mint() const {
-        return value > 0 && randomness > 0 && serialNumber > 0 && serialNumber.bitSize() <= 160 &&
-                ecdsaSecretKey.size() >= 32;
-    }
-
-    ADD_SERIALIZE_METHODS;
-
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
-        READWRITE(IsUsed);
-        READWRITE(randomness);
-        READWRITE(serialNumber);
-        READWRITE(value);
-        READWRITE(denomination);
-        READWRITE(nHeight);
-        READWRITE(id);
-        if (ser_action.ForRead()) {
-            if (!is_eof(s)) {
-                int nStoredVersion = 0;
-                READWRITE(nStoredVersion);
-                if (nStoredVersion >= ZC_ADVANCED_WALLETDB_MINT_VERSION)
-                    READWRITE(ecdsaSecretKey);
-            }
-        }
-        else {
-            READWRITE(nVersion);
-            READWRITE(ecdsaSecretKey);
-        }
-    }
-
-};
-
-
 class CZerocoinSpendEntry
 {
 public:
@@ -1192,6 +1325,9 @@ public:
     }
 };
 
+//! Keep the zerocoin mint pool of the wallet filled
+void ThreadZerocoinMintPool(CWallet *pwallet);
+
 bool CompHeight(const CZerocoinEntry & a, const CZerocoinEntry & b);
 bool CompID(const CZerocoinEntry & a, const CZerocoinEntry & b);
 #endif // BITCOIN_WALLET_WALLET_H
@@ -245,6 +245,18 @@ CWalletDB::ReadZerocoinAccumulator(libzerocoin::Accumulator &accumulator, libzer
     return Read(std::make_tuple(string("zcaccumulator"), (unsigned int) denomination, pubcoinid), accumulator);
 }
 
+bool CWalletDB::WriteZerocoinWitness(const CZerocoinWitnessEntry &witness) {
+    return Write(make_pair(string("zcwitness"), witness.pubCoin), witness, true);
+}
+
+bool CWalletDB::ReadZerocoinWitness(const CBigNum &pubCoin, CZerocoinWitnessEntry &witness) {
+    return Read(make_pair(string("zcwitness"), pubCoin), witness);
+}
+
+bool CWalletDB::EraseZerocoinWitness(const CBigNum &pubCoin) {
+    return Erase(make_pair(string("zcwitness"), pubCoin));
+}
+
 //bool CWalletDB::EraseZerocoinAccumulator(libzerocoin::Accumulator& accumulator, libzerocoin::CoinDenomination denomination, int pubcoinid)
 //{
 //    return Erase(std::make_tuple(string("zcaccumulator"), (unsigned int) denomination, pubcoinid), accumulator);
@@ -258,6 +270,14 @@ bool CWalletDB::EraseZerocoinEntry(const CZerocoinEntry &zerocoin) {
     return Erase(make_pair(string("zerocoin"), zerocoin.value));
 }
 
+bool CWalletDB::WriteZerocoinMintPoolEntry(const CZerocoinEntry &zerocoin) {
+    return Write(make_pair(string("zcmintpool"), zerocoin.value), zerocoin, true);
+}
+
+bool CWalletDB::EraseZerocoinMintPoolEntry(const CZerocoinEntry &zerocoin) {
+    return Erase(make_pair(string("zcmintpool"), zerocoin.value));
+}
+
 // Check Calculated Blocked for Zerocoin
 bool CWalletDB::ReadCalculatedZCBlock(int &height) {
     height = 0;
@@ -301,6 +321,39 @@ void CWalletDB::ListPubCoin(std::list <CZerocoinEntry> &listPubCoin) {
     pcursor->close();
 }
 
+void CWalletDB::ListZerocoinMintPool(std::list <CZerocoinEntry> &listMintPool) {
+    Dbc *pcursor = GetCursor();
+    if (!pcursor)
+        throw runtime_error("CWalletDB::ListZerocoinMintPool() : cannot create DB cursor");
+    unsigned int fFlags = DB_SET_RANGE;
+    while (true) {
+        // Read next record
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        if (fFlags == DB_SET_RANGE)
+            ssKey << make_pair(string("zcmintpool"), CBigNum(0));
+        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        int ret = ReadAtCursor(pcursor, ssKey, ssValue, fFlags);
+        fFlags = DB_NEXT;
+        if (ret == DB_NOTFOUND)
+            break;
+        else if (ret != 0) {
+            pcursor->close();
+            throw runtime_error("CWalletDB::ListZerocoinMintPool() : error scanning DB");
+        }
+        // Unserialize
+        string strType;
+        ssKey >> strType;
+        if (strType != "zcmintpool")
+            break;
+        CBigNum value;
+        ssKey >> value;
+        CZerocoinEntry zerocoinItem;
+        ssValue >> zerocoinItem;
+        listMintPool.push_back(zerocoinItem);
+    }
+    pcursor->close();
+}
+
 void CWalletDB::ListCoinSpendSerial(std::list <CZerocoinSpendEntry> &listCoinSpendSerial) {
     Dbc *pcursor = GetCursor();
     if (!pcursor)
@@ -630,6 +683,18 @@ bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey, CDataStream &ssValue,
                 strErr = "Error reading wallet database: LoadDestData failed";
                 return false;
             }
+        } else if (strType == "zerocoin") {
+            CBigNum value;
+            ssKey >> value;
+            CZerocoinEntry zerocoin;
+            ssValue >> zerocoin;
+            pwallet->LoadZerocoinEntry(zerocoin);
+        } else if (strType == "zcwitness") {
+            CBigNum pubCoin;
+            ssKey >> pubCoin;
+            CZerocoinWitnessEntry witness;
+            ssValue >> witness;
+            pwallet->LoadZerocoinWitness(witness);
         } else if (strType == "hdchain") {
             CHDChain chain;
             ssValue >> chain;
@@ -33,6 +33,7 @@ class uint160;
 class uint256;
 class CZerocoinEntry;
 class CZerocoinSpendEntry;
+class CZerocoinWitnessEntry;
 
 /** Error statuses for the wallet database */
 enum DBErrors
@@ -174,11 +175,18 @@ public:
     bool WriteZerocoinEntry(const CZerocoinEntry& zerocoin);
     bool EraseZerocoinEntry(const CZerocoinEntry& zerocoin);
     void ListPubCoin(std::list<CZerocoinEntry>& listPubCoin);
+    //! Pregenerated zerocoin mints not used by any transaction yet
+    bool WriteZerocoinMintPoolEntry(const CZerocoinEntry& zerocoin);
+    bool EraseZerocoinMintPoolEntry(const CZerocoinEntry& zerocoin);
+    void ListZerocoinMintPool(std::list<CZerocoinEntry>& listMintPool);
     void ListCoinSpendSerial(std::list<CZerocoinSpendEntry>& listCoinSpendSerial);
     bool WriteCoinSpendSerialEntry(const CZerocoinSpendEntry& zerocoinSpend);
     bool EraseCoinSpendSerialEntry(const CZerocoinSpendEntry& zerocoinSpend);
     bool WriteZerocoinAccumulator(libzerocoin::Accumulator accumulator, libzerocoin::CoinDenomination denomination, int pubcoinid);
     bool ReadZerocoinAccumulator(libzerocoin::Accumulator& accumulator, libzerocoin::CoinDenomination denomination, int pubcoinid);
+    bool WriteZerocoinWitness(const CZerocoinWitnessEntry& witness);
+    bool ReadZerocoinWitness(const CBigNum& pubCoin, CZerocoinWitnessEntry& witness);
+    bool EraseZerocoinWitness(const CBigNum& pubCoin);
     // bool EraseZerocoinAccumulator(libzerocoin::Accumulator& accumulator, libzerocoin::CoinDenomination denomination, int pubcoinid);
 
     bool ReadCalculatedZCBlock(int& height);
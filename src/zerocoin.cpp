@@ -7,14 +7,22 @@
 #include "definition.h"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
+#include "txdb.h"
+#include "executor.h"
+#include "ui_interface.h"
 #include "znode-payments.h"
 #include "znode-sync.h"
+#include "memusage.h"
+#include "hash.h"
 
 #include <atomic>
 #include <sstream>
 #include <chrono>
+#include <list>
 
 #include <boost/foreach.hpp>
+#include <boost/thread.hpp>
+#include <boost/unordered_set.hpp>
 
 using namespace std;
 
@@ -33,6 +41,152 @@ libzerocoin::Params *ZCParamsV2 = new libzerocoin::Params(bnTrustedModulusV2, bn
 
 static CZerocoinState zerocoinState;
 
+// Number of blocks with zerocoin mints/spends kept in memory
+static const size_t ZC_BLOCK_DATA_CACHE_SIZE = 2000;
+
+// Least recently used mints/spends of blocks read from the block index database
+class CZerocoinBlockDataCache {
+private:
+    typedef pair<uint256, std::shared_ptr<const CZerocoinBlockData>> CacheEntry;
+
+    CCriticalSection cs;
+    // most recently used entries go first
+    list<CacheEntry> entries;
+    unordered_map<uint256, list<CacheEntry>::iterator, BlockHasher> entriesByHash;
+    size_t nMaxSize;
+    // entries not written to the database yet, they are not evicted. Empty data erases the record
+    map<uint256, std::shared_ptr<const CZerocoinBlockData>> dirtyEntries;
+
+public:
+    CZerocoinBlockDataCache(size_t nMaxSizeIn) : nMaxSize(nMaxSizeIn) {}
+
+    std::shared_ptr<const CZerocoinBlockData> Get(const uint256 &blockHash) {
+        LOCK(cs);
+        auto dirtyEntry = dirtyEntries.find(blockHash);
+        if (dirtyEntry != dirtyEntries.end())
+            return dirtyEntry->second;
+        auto entry = entriesByHash.find(blockHash);
+        if (entry == entriesByHash.end())
+            return nullptr;
+        entries.splice(entries.begin(), entries, entry->second);
+        return entry->second->second;
+    }
+
+    void Put(const uint256 &blockHash, std::shared_ptr<const CZerocoinBlockData> data) {
+        LOCK(cs);
+        auto entry = entriesByHash.find(blockHash);
+        if (entry != entriesByHash.end()) {
+            entry->second->second = data;
+            entries.splice(entries.begin(), entries, entry->second);
+            return;
+        }
+
+        entries.push_front(make_pair(blockHash, data));
+        entriesByHash[blockHash] = entries.begin();
+        if (entries.size() > nMaxSize) {
+            entriesByHash.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    void Erase(const uint256 &blockHash) {
+        LOCK(cs);
+        auto entry = entriesByHash.find(blockHash);
+        if (entry != entriesByHash.end()) {
+            entries.erase(entry->second);
+            entriesByHash.erase(entry);
+        }
+    }
+
+    // Keep the entry until it's written to the database with the next block index flush
+    void PutDirty(const uint256 &blockHash, std::shared_ptr<const CZerocoinBlockData> data) {
+        LOCK(cs);
+        Erase(blockHash);
+        dirtyEntries[blockHash] = data;
+    }
+
+    void GetDirty(vector<pair<uint256, std::shared_ptr<const CZerocoinBlockData>>> &result) {
+        LOCK(cs);
+        result.assign(dirtyEntries.begin(), dirtyEntries.end());
+    }
+
+    // Written entries become regular cache entries unless they were changed since GetDirty()
+    void MarkFlushed(const vector<pair<uint256, std::shared_ptr<const CZerocoinBlockData>>> &flushed) {
+        LOCK(cs);
+        for (const auto &flushedEntry: flushed) {
+            auto dirtyEntry = dirtyEntries.find(flushedEntry.first);
+            if (dirtyEntry == dirtyEntries.end() || dirtyEntry->second != flushedEntry.second)
+                continue;
+            dirtyEntries.erase(dirtyEntry);
+            if (!flushedEntry.second->IsNull())
+                Put(flushedEntry.first, flushedEntry.second);
+        }
+    }
+};
+
+static CZerocoinBlockDataCache zerocoinBlockDataCache(ZC_BLOCK_DATA_CACHE_SIZE);
+
+// Number of blocks with zerocoin data read from the database at once while building the state from the index
+static const size_t ZC_BUILD_STATE_BATCH_SIZE = 1000;
+static_assert(ZC_BUILD_STATE_BATCH_SIZE <= ZC_BLOCK_DATA_CACHE_SIZE, "read batch should fit into the block data cache");
+
+// Zerocoin checks that passed, in the spirit of the signature cache. Mints and spends are checked when transactions
+// enter the mempool, when the block is checked and again when it's connected, the big number work is done once
+class CZerocoinValidationCache {
+private:
+    // Entries are hashes of the nonce and the checked data, so the set needs no extra blinding
+    struct CEntryHasher {
+        size_t operator()(const uint256 &entry) const { return entry.GetCheapHash(); }
+    };
+
+    uint256 nonce;
+    typedef boost::unordered_set<uint256, CEntryHasher> set_type;
+    set_type setValid;
+    boost::shared_mutex cs;
+
+public:
+    CZerocoinValidationCache() {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    // primality and range check of the minted coin
+    uint256 MintEntry(const CBigNum &pubCoin, int denomination) const {
+        CHashWriter hasher(SER_GETHASH, 0);
+        hasher << nonce << 'm' << pubCoin << denomination;
+        return hasher.GetHash();
+    }
+
+    // proof of the spend input checked against the accumulator value under the given modulus
+    uint256 SpendEntry(const uint256 &txHash, int nInput, int spendVersion, bool fModulusV2,
+                       const libzerocoin::Accumulator &accumulator) const {
+        CHashWriter hasher(SER_GETHASH, 0);
+        hasher << nonce << 's' << txHash << nInput << spendVersion << fModulusV2 << accumulator;
+        return hasher.GetHash();
+    }
+
+    bool Get(const uint256 &entry) {
+        boost::shared_lock<boost::shared_mutex> lock(cs);
+        return setValid.count(entry) > 0;
+    }
+
+    void Set(const uint256 &entry) {
+        size_t nMaxCacheSize = GetArg("-maxzerocoincachesize", DEFAULT_MAX_ZEROCOIN_CACHE_SIZE) * ((size_t) 1 << 20);
+        if (nMaxCacheSize <= 0)
+            return;
+
+        boost::unique_lock<boost::shared_mutex> lock(cs);
+        while (memusage::DynamicUsage(setValid) > nMaxCacheSize) {
+            set_type::size_type bucket = GetRand(setValid.bucket_count());
+            set_type::local_iterator it = setValid.begin(bucket);
+            if (it != setValid.end(bucket))
+                setValid.erase(*it);
+        }
+        setValid.insert(entry);
+    }
+};
+
+static CZerocoinValidationCache zerocoinValidationCache;
+
 static bool CheckZerocoinSpendSerial(CValidationState &state, const Consensus::Params &params, CZerocoinTxInfo *zerocoinTxInfo, libzerocoin::CoinDenomination denomination, const CBigNum &serial, int nHeight, bool fConnectTip) {
     if (nHeight > params.nCheckBugFixedAtBlock) {
         // check for zerocoin transaction in this block as well
@@ -133,8 +287,9 @@ bool CheckSpendZcoinTransaction(const CTransaction &tx,
             }
         }
 
-        if (fModulusV2InIndex != fModulusV2 && fStatefulZerocoinCheck)
-            zerocoinState.CalculateAlternativeModulusAccumulatorValues(&chainActive, (int)targetDenominations[vinIndex], pubcoinId);
+        if (fModulusV2InIndex != fModulusV2 && fStatefulZerocoinCheck &&
+                !zerocoinState.CalculateAlternativeModulusAccumulatorValues(&chainActive, (int)targetDenominations[vinIndex], pubcoinId))
+            return state.Error("CheckSpendZcoinTransaction: can't read zerocoin data of the coin group");
 
         uint256 txHashForMetadata;
 
@@ -223,23 +378,50 @@ bool CheckSpendZcoinTransaction(const CTransaction &tx,
 			spendHasBlockHash = true;
 			uint256 accumulatorBlockHash = newSpend.getAccumulatorBlockHash();
 
-			// find index for block with hash of accumulatorBlockHash or set index to the coinGroup.firstBlock if not found
-			while (index != coinGroup.firstBlock && index->GetBlockHash() != accumulatorBlockHash)
-				index = index->pprev;
+			// look up block with hash of accumulatorBlockHash in the accumulator index. If it's not there find index
+			// for this block the slow way or set index to the coinGroup.firstBlock if not found
+			const CZerocoinState::CAccumulatorCheckpoint *checkpoint =
+			        zerocoinState.FindAccumulatorCheckpoint(denominationAndId, accumulatorBlockHash);
+			if (checkpoint)
+				index = checkpoint->block;
+			else
+				while (index != coinGroup.firstBlock && index->GetBlockHash() != accumulatorBlockHash)
+					index = index->pprev;
 		}
 
-        decltype(&CBlockIndex::accumulatorChanges) accChanges = fModulusV2 == fModulusV2InIndex ?
-                    &CBlockIndex::accumulatorChanges : &CBlockIndex::alternativeAccumulatorChanges;
+        // When connecting a block there is only one accumulator value to check spend with block hash against
+        bool fDeferVerification = spendHasBlockHash && zerocoinTxInfo && !zerocoinTxInfo->fInfoIsComplete &&
+                nHeight != INT_MAX && !isVerifyDB && !isCheckWallet;
+
+        bool fAlternativeModulus = fModulusV2 != fModulusV2InIndex;
 
-        // Enumerate all the accumulator changes seen in the blockchain starting with the latest block
+        // Enumerate all the accumulator checkpoints seen in the blockchain starting with the latest block
         // In most cases the latest accumulator value will be used for verification
         do {
-            if ((index->*accChanges).count(denominationAndId) > 0) {
+            const CZerocoinState::CAccumulatorCheckpoint *checkpoint = zerocoinState.FindAccumulatorCheckpoint(denominationAndId, index);
+            // alternative modulus value is zero if it wasn't calculated for this block
+            if (checkpoint && (fAlternativeModulus ? checkpoint->alternativeAccumulatorValue : checkpoint->accumulatorValue) != 0) {
                 libzerocoin::Accumulator accumulator(zcParams,
-                                                     (index->*accChanges)[denominationAndId].first,
+                                                     fAlternativeModulus ? checkpoint->alternativeAccumulatorValue : checkpoint->accumulatorValue,
                                                      targetDenominations[vinIndex]);
                 LogPrintf("CheckSpendZcoinTransaction: accumulator=%s\n", accumulator.getValue().ToString().substr(0,15));
-                passVerify = newSpend.Verify(accumulator, newMetadata);
+                uint256 cacheEntry = zerocoinValidationCache.SpendEntry(hashTx, vinIndex, spendVersion,
+                                                                            fModulusV2, accumulator);
+                if (zerocoinValidationCache.Get(cacheEntry)) {
+                    // the proof was verified with this accumulator value before
+                    passVerify = true;
+                }
+                else if (fDeferVerification) {
+                    // proofs are checked later for all the spends of the block at once (CZerocoinTxInfo::VerifySpends)
+                    zerocoinTxInfo->spendsToVerify.push_back({hashTx, std::make_shared<libzerocoin::CoinSpend>(newSpend),
+                                                              accumulator, newMetadata, cacheEntry});
+                    passVerify = true;
+                }
+                else {
+                    passVerify = newSpend.Verify(accumulator, newMetadata);
+                    if (passVerify)
+                        zerocoinValidationCache.Set(cacheEntry);
+                }
             }
 
             // if spend has block hash we don't need to look further
@@ -255,15 +437,19 @@ bool CheckSpendZcoinTransaction(const CTransaction &tx,
         if (!passVerify && spendVersion == ZEROCOIN_TX_VERSION_1) {
             // Build vector of coins sorted by the time of mint
             index = coinGroup.lastBlock;
-            vector<CBigNum> pubCoins = index->mintedPubCoins[denominationAndId];
-            if (index != coinGroup.firstBlock) {
-                do {
-                    index = index->pprev;
-                    if (index->mintedPubCoins.count(denominationAndId) > 0)
-                        pubCoins.insert(pubCoins.begin(),
-                                        index->mintedPubCoins[denominationAndId].cbegin(),
-                                        index->mintedPubCoins[denominationAndId].cend());
-                } while (index != coinGroup.firstBlock);
+            vector<CBigNum> pubCoins;
+            for (;;) {
+                if (zerocoinState.FindAccumulatorCheckpoint(denominationAndId, index)) {
+                    std::shared_ptr<const CZerocoinBlockData> blockData;
+                    if (!ZerocoinGetBlockData(index, blockData))
+                        return state.Error("CheckSpendZcoinTransaction: can't read zerocoin data of the coin group");
+                    auto blockPubCoins = blockData->mintedPubCoins.find(denominationAndId);
+                    if (blockPubCoins != blockData->mintedPubCoins.end())
+                        pubCoins.insert(pubCoins.begin(), blockPubCoins->second.cbegin(), blockPubCoins->second.cend());
+                }
+                if (index == coinGroup.firstBlock)
+                    break;
+                index = index->pprev;
             }
 
             libzerocoin::Accumulator accumulator(zcParams, targetDenominations[vinIndex]);
@@ -362,12 +548,16 @@ bool CheckMintZcoinTransaction(const CTxOut &txout,
     case libzerocoin::ZQ_PEDERSEN*COIN:
     case libzerocoin::ZQ_WILLIAMSON*COIN:
         libzerocoin::CoinDenomination denomination = (libzerocoin::CoinDenomination)(txout.nValue / COIN);
-        libzerocoin::PublicCoin checkPubCoin(ZCParamsV2, pubCoin, denomination);
-        if (!checkPubCoin.validate())
-            return state.DoS(100,
-                false,
-                PUBCOIN_NOT_VALIDATE,
-                "CheckZerocoinTransaction : PubCoin validation failed");
+        uint256 cacheEntry = zerocoinValidationCache.MintEntry(pubCoin, denomination);
+        if (!zerocoinValidationCache.Get(cacheEntry)) {
+            libzerocoin::PublicCoin checkPubCoin(ZCParamsV2, pubCoin, denomination);
+            if (!checkPubCoin.validate())
+                return state.DoS(100,
+                    false,
+                    PUBCOIN_NOT_VALIDATE,
+                    "CheckZerocoinTransaction : PubCoin validation failed");
+            zerocoinValidationCache.Set(cacheEntry);
+        }
 
         if (zerocoinTxInfo != NULL && !zerocoinTxInfo->fInfoIsComplete) {
             // Update public coin list in the info
@@ -599,8 +789,8 @@ bool CheckZerocoinTransaction(const CTransaction &tx,
     return true;
 }
 
-void DisconnectTipZC(CBlock & /*block*/, CBlockIndex *pindexDelete) {
-    zerocoinState.RemoveBlock(pindexDelete);
+bool DisconnectTipZC(CBlock & /*block*/, CBlockIndex *pindexDelete) {
+    return zerocoinState.RemoveBlock(pindexDelete);
 }
 
 CBigNum ZerocoinGetSpendSerialNumber(const CTransaction &tx, const CTxIn &txin) {
@@ -618,6 +808,78 @@ CBigNum ZerocoinGetSpendSerialNumber(const CTransaction &tx, const CTxIn &txin)
     }
 }
 
+void ZerocoinGetSupplyChanges(const CBlock &block, vector<pair<CBigNum,int> > &spends, vector<int> &mints) {
+    BOOST_FOREACH(const CTransaction &tx, block.vtx) {
+        if (tx.IsZerocoinSpend()) {
+            BOOST_FOREACH(const CTxIn &txin, tx.vin) {
+                if (!txin.IsZerocoinSpend())
+                    continue;
+                try {
+                    CDataStream serializedCoinSpend((const char *)&*(txin.scriptSig.begin() + 4),
+                                                (const char *)&*txin.scriptSig.end(),
+                                                SER_NETWORK, PROTOCOL_VERSION);
+                    libzerocoin::CoinSpend spend(txin.nSequence >= ZC_MODULUS_V2_BASE_ID ? ZCParamsV2 : ZCParams, serializedCoinSpend);
+                    spends.push_back(make_pair(spend.getCoinSerialNumber(), (int)spend.getDenomination()));
+                }
+                catch (const std::runtime_error &) {
+                }
+            }
+        }
+
+        if (tx.IsZerocoinMint()) {
+            BOOST_FOREACH(const CTxOut &txout, tx.vout) {
+                if (txout.scriptPubKey.IsZerocoinMint())
+                    mints.push_back((int)(txout.nValue / COIN));
+            }
+        }
+    }
+}
+
+bool ZerocoinGetBlockData(const CBlockIndex *index, std::shared_ptr<const CZerocoinBlockData> &blockData) {
+    static const std::shared_ptr<const CZerocoinBlockData> emptyBlockData = std::make_shared<CZerocoinBlockData>();
+
+    if (!(index->nStatus & BLOCK_HAVE_ZEROCOIN)) {
+        blockData = emptyBlockData;
+        return true;
+    }
+
+    uint256 blockHash = index->GetBlockHash();
+    blockData = zerocoinBlockDataCache.Get(blockHash);
+    if (!blockData) {
+        std::shared_ptr<CZerocoinBlockData> diskBlockData = std::make_shared<CZerocoinBlockData>();
+        if (!pblocktree->ReadZerocoinBlockData(blockHash, *diskBlockData))
+            return error("ZerocoinGetBlockData: can't read zerocoin data for block %s", blockHash.ToString());
+        blockData = diskBlockData;
+        zerocoinBlockDataCache.Put(blockHash, blockData);
+    }
+
+    return true;
+}
+
+void ZerocoinWriteBlockData(CBlockIndex *index, const CZerocoinBlockData &data) {
+    uint256 blockHash = index->GetBlockHash();
+
+    if (data.IsNull()) {
+        if (index->nStatus & BLOCK_HAVE_ZEROCOIN) {
+            // erase the record of an earlier connection of the block
+            index->nStatus &= ~BLOCK_HAVE_ZEROCOIN;
+            zerocoinBlockDataCache.PutDirty(blockHash, std::make_shared<const CZerocoinBlockData>());
+        }
+        return;
+    }
+
+    index->nStatus |= BLOCK_HAVE_ZEROCOIN;
+    zerocoinBlockDataCache.PutDirty(blockHash, std::make_shared<const CZerocoinBlockData>(data));
+}
+
+void ZerocoinGetDirtyBlockData(vector<pair<uint256, std::shared_ptr<const CZerocoinBlockData>>> &blockData) {
+    zerocoinBlockDataCache.GetDirty(blockData);
+}
+
+void ZerocoinBlockDataFlushed(const vector<pair<uint256, std::shared_ptr<const CZerocoinBlockData>>> &blockData) {
+    zerocoinBlockDataCache.MarkFlushed(blockData);
+}
+
 /**
  * Connect a new ZCblock to chainActive. pblock is either NULL or a pointer to a CBlock
  * corresponding to pindexNew, to bypass loading it again from disk.
@@ -635,21 +897,16 @@ bool ConnectBlockZC(CValidationState &state, const CChainParams &chainParams, CB
             }
         }
 
-	    if (!fJustCheck) {
-            // clear the state
-			pindexNew->spentSerials.clear();
-            pindexNew->mintedPubCoins.clear();
-            pindexNew->accumulatorChanges.clear();
-            pindexNew->alternativeAccumulatorChanges.clear();
-        }
-	    
+        // mints, spends and accumulator changes of the block, stored separately from the index
+        CZerocoinBlockData blockData;
+
         if (pindexNew->nHeight > chainParams.GetConsensus().nCheckBugFixedAtBlock) {
             BOOST_FOREACH(const PAIRTYPE(CBigNum,int) &serial, pblock->zerocoinTxInfo->spentSerials) {
                 if (!CheckZerocoinSpendSerial(state, chainParams.GetConsensus(), pblock->zerocoinTxInfo.get(), (libzerocoin::CoinDenomination)serial.second, serial.first, pindexNew->nHeight, true))
                     return false;
                 
                 if (!fJustCheck) {
-                    pindexNew->spentSerials.insert(serial.first);
+                    blockData.spentSerials.insert(serial.first);
                     zerocoinState.AddSpend(serial.first);
                 }
 
@@ -659,46 +916,55 @@ bool ConnectBlockZC(CValidationState &state, const CChainParams &chainParams, CB
         if (fJustCheck)
             return true;
 
-        // Update minted values and accumulators
+        // Update minted values and accumulators. Mints of the block with the same denomination share the coin
+        // group, its accumulator is updated once with all of them
+        struct CoinGroupMints {
+            libzerocoin::Params *zcParams;
+            CBigNum oldAccValue;
+            vector<libzerocoin::PublicCoin> pubCoins;
+        };
+        map<pair<int,int>, CoinGroupMints> groupMints;
+
         BOOST_FOREACH(const PAIRTYPE(int,CBigNum) &mint, pblock->zerocoinTxInfo->mints) {
             CBigNum oldAccValue(0);
             int denomination = mint.first;
             int mintId = zerocoinState.AddMint(pindexNew, denomination, mint.second, oldAccValue);
 
-            libzerocoin::Params *zcParams = IsZerocoinTxV2((libzerocoin::CoinDenomination)denomination, 
-                                                chainParams.GetConsensus(), mintId) ? ZCParamsV2 : ZCParams;
-
-            if (!oldAccValue)
-                oldAccValue = zcParams->accumulatorParams.accumulatorBase;
-
             LogPrintf("ConnectTipZC: mint added denomination=%d, id=%d\n", denomination, mintId);
             pair<int,int> denomAndId = make_pair(denomination, mintId);
 
-            pindexNew->mintedPubCoins[denomAndId].push_back(mint.second);
+            blockData.mintedPubCoins[denomAndId].push_back(mint.second);
 
-            CZerocoinState::CoinGroupInfo coinGroupInfo;
-            zerocoinState.GetCoinGroupInfo(denomination, mintId, coinGroupInfo);
+            auto group = groupMints.find(denomAndId);
+            if (group == groupMints.end()) {
+                // accumulator value before the block is returned for the first mint of the group only
+                libzerocoin::Params *zcParams = IsZerocoinTxV2((libzerocoin::CoinDenomination)denomination,
+                                                    chainParams.GetConsensus(), mintId) ? ZCParamsV2 : ZCParams;
+                if (!oldAccValue)
+                    oldAccValue = zcParams->accumulatorParams.accumulatorBase;
+                group = groupMints.insert(make_pair(denomAndId, CoinGroupMints{zcParams, oldAccValue, {}})).first;
+            }
+            group->second.pubCoins.push_back(libzerocoin::PublicCoin(group->second.zcParams, mint.second,
+                                                                     (libzerocoin::CoinDenomination)denomination));
+        }
 
-            libzerocoin::PublicCoin pubCoin(zcParams, mint.second, (libzerocoin::CoinDenomination)denomination);
-            libzerocoin::Accumulator accumulator(zcParams,
-                                                 oldAccValue,
-                                                 (libzerocoin::CoinDenomination)denomination);
-            accumulator += pubCoin;
+        for (const auto &group: groupMints) {
+            const pair<int,int> &denomAndId = group.first;
+            libzerocoin::Accumulator accumulator(group.second.zcParams,
+                                                 group.second.oldAccValue,
+                                                 (libzerocoin::CoinDenomination)denomAndId.first);
+            accumulator.accumulate(group.second.pubCoins);
 
-            if (pindexNew->accumulatorChanges.count(denomAndId) > 0) {
-                pair<CBigNum,int> &accChange = pindexNew->accumulatorChanges[denomAndId];
-                accChange.first = accumulator.getValue();
-                accChange.second++;
-            }
-            else {
-                pindexNew->accumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), 1);
-            }
-            // invalidate alternative accumulator value for this denomination and id
-            pindexNew->alternativeAccumulatorChanges.erase(denomAndId);
+            int nMints = (int)group.second.pubCoins.size();
+            blockData.accumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), nMints);
+            zerocoinState.AddAccumulatorCheckpoint(pindexNew, denomAndId.first, denomAndId.second, accumulator.getValue(), nMints);
         }
+
+        ZerocoinWriteBlockData(pindexNew, blockData);
     }
     else if (!fJustCheck) {
-        zerocoinState.AddBlock(pindexNew, chainParams.GetConsensus());
+        if (!zerocoinState.AddBlock(pindexNew, chainParams.GetConsensus()))
+            return state.Error("ConnectBlockZC: can't read zerocoin data of the block");
     }
 
     return true;
@@ -720,10 +986,47 @@ bool ZerocoinBuildStateFromIndex(CChain *chain, set<CBlockIndex *> &changes) {
     auto params = Params().GetConsensus();
 
     zerocoinState.Reset();
-    for (CBlockIndex *blockIndex = chain->Genesis(); blockIndex; blockIndex=chain->Next(blockIndex))
-        zerocoinState.AddBlock(blockIndex, params);
 
-    changes = zerocoinState.RecalculateAccumulators(chain);
+    // Zerocoin data of the next batch of blocks is read from the database in parallel, then the blocks are added
+    // to the state in order and hit the cache
+    CBlockIndex *blockIndex = chain->Genesis();
+    while (blockIndex) {
+        CBlockIndex *batchStart = blockIndex;
+        vector<const CBlockIndex *> blocksWithData;
+        for (; blockIndex && blocksWithData.size() < ZC_BUILD_STATE_BATCH_SIZE; blockIndex = chain->Next(blockIndex)) {
+            if (blockIndex->nStatus & BLOCK_HAVE_ZEROCOIN)
+                blocksWithData.push_back(blockIndex);
+        }
+
+        CExecutorTaskGroup tasks;
+        BOOST_FOREACH(const CBlockIndex *index, blocksWithData) {
+            tasks.Add([index] {
+                std::shared_ptr<const CZerocoinBlockData> blockData;
+                ZerocoinGetBlockData(index, blockData);
+            });
+        }
+        tasks.Wait();
+
+        for (CBlockIndex *index = batchStart; index != blockIndex; index = chain->Next(index)) {
+            if (!zerocoinState.AddBlock(index, params))
+                return error("ZerocoinBuildStateFromIndex: can't read zerocoin data of block %s", index->GetBlockHash().ToString());
+        }
+
+        if (blockIndex)
+            uiInterface.InitMessage(strprintf(_("Loading zerocoin state... (block %d of %d)"), blockIndex->nHeight, chain->Height()));
+    }
+
+    // Coin groups that didn't change since the last verification don't need to be checked again
+    int nVerifiedHeight = -1;
+    uint256 verifiedBlockHash;
+    if (pblocktree->ReadZerocoinVerifiedBlock(verifiedBlockHash)) {
+        BlockMap::iterator mi = mapBlockIndex.find(verifiedBlockHash);
+        if (mi != mapBlockIndex.end() && chain->Contains(mi->second))
+            nVerifiedHeight = mi->second->nHeight;
+    }
+
+    if (!zerocoinState.RecalculateAccumulators(chain, changes, nVerifiedHeight))
+        return error("ZerocoinBuildStateFromIndex: can't recalculate zerocoin accumulators");
 
     // DEBUG
     LogPrintf("Latest IDs are %d, %d, %d, %d, %d\n",
@@ -752,6 +1055,32 @@ void CZerocoinTxInfo::Complete() {
     fInfoIsComplete = true;
 }
 
+bool CZerocoinTxInfo::VerifySpends() {
+    if (spendsToVerify.empty())
+        return true;
+
+    vector<const libzerocoin::CoinSpend *> spends;
+    vector<libzerocoin::Accumulator> accumulators;
+    vector<libzerocoin::SpendMetaData> metaData;
+    BOOST_FOREACH(const CSpendToVerify &spendToVerify, spendsToVerify) {
+        spends.push_back(spendToVerify.spend.get());
+        accumulators.push_back(spendToVerify.accumulator);
+        metaData.push_back(spendToVerify.metaData);
+    }
+
+    vector<bool> results;
+    bool fPassed = libzerocoin::CoinSpend::VerifyBatch(spends, accumulators, metaData, results);
+    for (size_t i = 0; i < spendsToVerify.size(); i++) {
+        if (!results[i])
+            LogPrintf("CZerocoinTxInfo::VerifySpends: verification of spend in tx %s failed\n", spendsToVerify[i].txHash.ToString());
+        else if (!spendsToVerify[i].cacheEntry.IsNull())
+            zerocoinValidationCache.Set(spendsToVerify[i].cacheEntry);
+    }
+
+    spendsToVerify.clear();
+    return fPassed;
+}
+
 // CZerocoinState::CBigNumHash
 
 std::size_t CZerocoinState::CBigNumHash::operator ()(const CBigNum &bn) const noexcept {
@@ -764,6 +1093,13 @@ std::size_t CZerocoinState::CBigNumHash::operator ()(const CBigNum &bn) const no
         return ((size_t*)bnData.data())[1];
 }
 
+// CZerocoinState::CAccumulatorCheckpointKeyHash
+
+std::size_t CZerocoinState::CAccumulatorCheckpointKeyHash::operator ()(const pair<pair<int,int>,uint256> &key) const noexcept {
+    // block hash is random enough, mix in denomination and id to separate coin groups changed by the same block
+    return key.second.GetCheapHash() ^ ((size_t)key.first.first << 16) ^ (size_t)key.first.second;
+}
+
 // CZerocoinState
 
 CZerocoinState::CZerocoinState() {
@@ -789,7 +1125,10 @@ int CZerocoinState::AddMint(CBlockIndex *index, int denomination, const CBigNum
             coinGroup.firstBlock = coinGroup.lastBlock = index;
         }
         else {
-            previousAccValue = coinGroup.lastBlock->accumulatorChanges[make_pair(denomination,mintId)].first;
+            // checkpoint of the current block is added after all its mints
+            const CAccumulatorCheckpoint *checkpoint = FindAccumulatorCheckpoint(make_pair(denomination,mintId), coinGroup.lastBlock);
+            if (checkpoint)
+                previousAccValue = checkpoint->accumulatorValue;
             coinGroup.lastBlock = index;
         }
     }
@@ -813,8 +1152,12 @@ void CZerocoinState::AddSpend(const CBigNum &serial) {
     usedCoinSerials.insert(serial);
 }
 
-void CZerocoinState::AddBlock(CBlockIndex *index, const Consensus::Params &params) {
-    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), PAIRTYPE(CBigNum,int)) &accUpdate, index->accumulatorChanges)
+bool CZerocoinState::AddBlock(CBlockIndex *index, const Consensus::Params &params) {
+    std::shared_ptr<const CZerocoinBlockData> blockData;
+    if (!ZerocoinGetBlockData(index, blockData))
+        return false;
+
+    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), PAIRTYPE(CBigNum,int)) &accUpdate, blockData->accumulatorChanges)
     {
         CoinGroupInfo   &coinGroup = coinGroups[accUpdate.first];
 
@@ -822,9 +1165,11 @@ void CZerocoinState::AddBlock(CBlockIndex *index, const Consensus::Params &param
             coinGroup.firstBlock = index;
         coinGroup.lastBlock = index;
         coinGroup.nCoins += accUpdate.second.second;
+
+        AddAccumulatorCheckpoint(index, accUpdate.first.first, accUpdate.first.second, accUpdate.second.first, accUpdate.second.second);
     }
 
-    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int),vector<CBigNum>) &pubCoins, index->mintedPubCoins) {
+    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int),vector<CBigNum>) &pubCoins, blockData->mintedPubCoins) {
         latestCoinIds[pubCoins.first.first] = pubCoins.first.second;
         BOOST_FOREACH(const CBigNum &coin, pubCoins.second) {
             CMintedCoinInfo coinInfo;
@@ -836,21 +1181,29 @@ void CZerocoinState::AddBlock(CBlockIndex *index, const Consensus::Params &param
     }
 
     if (index->nHeight > params.nCheckBugFixedAtBlock) {
-        BOOST_FOREACH(const CBigNum &serial, index->spentSerials) {
+        BOOST_FOREACH(const CBigNum &serial, blockData->spentSerials) {
             usedCoinSerials.insert(serial);
         }
     }
+
+    return true;
 }
 
-void CZerocoinState::RemoveBlock(CBlockIndex *index) {
+bool CZerocoinState::RemoveBlock(CBlockIndex *index) {
+    std::shared_ptr<const CZerocoinBlockData> blockData;
+    if (!ZerocoinGetBlockData(index, blockData))
+        return false;
+
     // roll back accumulator updates
-    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), PAIRTYPE(CBigNum,int)) &accUpdate, index->accumulatorChanges)
+    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), PAIRTYPE(CBigNum,int)) &accUpdate, blockData->accumulatorChanges)
     {
         CoinGroupInfo   &coinGroup = coinGroups[accUpdate.first];
         int  nMintsToForget = accUpdate.second.second;
 
         assert(coinGroup.nCoins >= nMintsToForget);
 
+        accumulatorCheckpoints.erase(make_pair(accUpdate.first, index->GetBlockHash()));
+
         if ((coinGroup.nCoins -= nMintsToForget) == 0) {
             // all the coins of this group have been erased, remove the group altogether
             coinGroups.erase(accUpdate.first);
@@ -862,12 +1215,12 @@ void CZerocoinState::RemoveBlock(CBlockIndex *index) {
             do {
                 assert(coinGroup.lastBlock != coinGroup.firstBlock);
                 coinGroup.lastBlock = coinGroup.lastBlock->pprev;
-            } while (coinGroup.lastBlock->accumulatorChanges.count(accUpdate.first) == 0);
+            } while (!FindAccumulatorCheckpoint(accUpdate.first, coinGroup.lastBlock));
         }
     }
 
     // roll back mints
-    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int),vector<CBigNum>) &pubCoins, index->mintedPubCoins) {
+    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int),vector<CBigNum>) &pubCoins, blockData->mintedPubCoins) {
         BOOST_FOREACH(const CBigNum &coin, pubCoins.second) {
             auto coins = mintedPubCoins.equal_range(coin);
             auto coinIt = find_if(coins.first, coins.second, [=](const decltype(mintedPubCoins)::value_type &v) {
@@ -880,9 +1233,11 @@ void CZerocoinState::RemoveBlock(CBlockIndex *index) {
     }
 
     // roll back spends
-    BOOST_FOREACH(const CBigNum &serial, index->spentSerials) {
+    BOOST_FOREACH(const CBigNum &serial, blockData->spentSerials) {
         usedCoinSerials.erase(serial);
     }
+
+    return true;
 }
 
 bool CZerocoinState::GetCoinGroupInfo(int denomination, int id, CoinGroupInfo &result) {
@@ -894,6 +1249,39 @@ bool CZerocoinState::GetCoinGroupInfo(int denomination, int id, CoinGroupInfo &r
     return true;
 }
 
+void CZerocoinState::AddAccumulatorCheckpoint(CBlockIndex *index, int denomination, int id, const CBigNum &accumulatorValue, int nMints) {
+    // replacing the checkpoint invalidates alternative accumulator value calculated for the block
+    CAccumulatorCheckpoint &checkpoint = accumulatorCheckpoints[make_pair(make_pair(denomination, id), index->GetBlockHash())];
+    checkpoint = CAccumulatorCheckpoint();
+    checkpoint.block = index;
+    checkpoint.nHeight = index->nHeight;
+    checkpoint.accumulatorValue = accumulatorValue;
+    checkpoint.nMints = nMints;
+}
+
+bool CZerocoinState::GetAccumulatorCheckpoint(int denomination, int id, const uint256 &blockHash, CAccumulatorCheckpoint &result) {
+    const CAccumulatorCheckpoint *checkpoint = FindAccumulatorCheckpoint(make_pair(denomination, id), blockHash);
+    if (!checkpoint)
+        return false;
+
+    result = *checkpoint;
+    return true;
+}
+
+const CZerocoinState::CAccumulatorCheckpoint *CZerocoinState::FindAccumulatorCheckpoint(const pair<int,int> &denomAndId, const uint256 &blockHash) const {
+    auto checkpoint = accumulatorCheckpoints.find(make_pair(denomAndId, blockHash));
+    return checkpoint != accumulatorCheckpoints.end() ? &checkpoint->second : NULL;
+}
+
+const CZerocoinState::CAccumulatorCheckpoint *CZerocoinState::FindAccumulatorCheckpoint(const pair<int,int> &denomAndId, const CBlockIndex *index) const {
+    return FindAccumulatorCheckpoint(denomAndId, index->GetBlockHash());
+}
+
+CZerocoinState::CAccumulatorCheckpoint *CZerocoinState::FindAccumulatorCheckpointToUpdate(const pair<int,int> &denomAndId, const CBlockIndex *index) {
+    auto checkpoint = accumulatorCheckpoints.find(make_pair(denomAndId, index->GetBlockHash()));
+    return checkpoint != accumulatorCheckpoints.end() ? &checkpoint->second : NULL;
+}
+
 bool CZerocoinState::IsUsedCoinSerial(const CBigNum &coinSerial) {
     return usedCoinSerials.count(coinSerial) != 0;
 }
@@ -913,33 +1301,27 @@ int CZerocoinState::GetAccumulatorValueForSpend(CChain *chain, int maxHeight, in
     CoinGroupInfo coinGroup = coinGroups[denomAndId];
     CBlockIndex *lastBlock = coinGroup.lastBlock;
 
-    assert(lastBlock->accumulatorChanges.count(denomAndId) > 0);
-    assert(coinGroup.firstBlock->accumulatorChanges.count(denomAndId) > 0);
+    assert(FindAccumulatorCheckpoint(denomAndId, lastBlock) != NULL);
+    assert(FindAccumulatorCheckpoint(denomAndId, coinGroup.firstBlock) != NULL);
 
     // is native modulus for denomination and id v2?
     bool nativeModulusIsV2 = IsZerocoinTxV2((libzerocoin::CoinDenomination)denomination, Params().GetConsensus(), id);
-    // field in the block index structure for accesing accumulator changes
-    decltype(&CBlockIndex::accumulatorChanges) accChangeField;
-    if (nativeModulusIsV2 != useModulusV2) {
-        CalculateAlternativeModulusAccumulatorValues(chain, denomination, id);
-        accChangeField = &CBlockIndex::alternativeAccumulatorChanges;
-    }
-    else {
-        accChangeField = &CBlockIndex::accumulatorChanges;
-    }
+    bool fAlternativeModulus = nativeModulusIsV2 != useModulusV2;
+    if (fAlternativeModulus && !CalculateAlternativeModulusAccumulatorValues(chain, denomination, id))
+        throw std::runtime_error("GetAccumulatorValueForSpend: can't read zerocoin data of the coin group");
 
     int numberOfCoins = 0;
     for (;;) {
-        map<pair<int,int>, pair<CBigNum,int>> &accumulatorChanges = lastBlock->*accChangeField;
-        if (accumulatorChanges.count(denomAndId) > 0) {
+        const CAccumulatorCheckpoint *checkpoint = FindAccumulatorCheckpoint(denomAndId, lastBlock);
+        if (checkpoint) {
             if (lastBlock->nHeight <= maxHeight) {
                 if (numberOfCoins == 0) {
                     // latest block satisfying given conditions
                     // remember accumulator value and block hash
-                    accumulator = accumulatorChanges[denomAndId].first;
+                    accumulator = fAlternativeModulus ? checkpoint->alternativeAccumulatorValue : checkpoint->accumulatorValue;
                     blockHash = lastBlock->GetBlockHash();
                 }
-                numberOfCoins += accumulatorChanges[denomAndId].second;
+                numberOfCoins += checkpoint->nMints;
             }
         }
 
@@ -956,6 +1338,26 @@ libzerocoin::AccumulatorWitness CZerocoinState::GetWitnessForSpend(CChain *chain
                                                                    int id, const CBigNum &pubCoin, bool useModulusV2) {
 
     libzerocoin::CoinDenomination d = (libzerocoin::CoinDenomination)denomination;
+    libzerocoin::Params *zcParams = useModulusV2 ? ZCParamsV2 : ZCParams;
+
+    CBigNum witnessStart;
+    vector<CBigNum> newCoins;
+    GetWitnessUpdate(chain, -1, maxHeight, denomination, id, pubCoin, useModulusV2, witnessStart, newCoins);
+
+    vector<libzerocoin::PublicCoin> pubCoins;
+    for (const CBigNum &coin: newCoins)
+        pubCoins.push_back(libzerocoin::PublicCoin(zcParams, coin, d));
+
+    libzerocoin::Accumulator accumulator(zcParams, witnessStart, d);
+    accumulator.accumulate(pubCoins);
+
+    return libzerocoin::AccumulatorWitness(zcParams, accumulator, libzerocoin::PublicCoin(zcParams, pubCoin, d));
+}
+
+bool CZerocoinState::GetWitnessUpdate(CChain *chain, int fromHeight, int maxHeight, int denomination, int id,
+                                      const CBigNum &pubCoin, bool useModulusV2, CBigNum &witnessStart,
+                                      vector<CBigNum> &newCoins) {
+
     pair<int, int> denomAndId = pair<int, int>(denomination, id);
 
     assert(coinGroups.count(denomAndId) > 0);
@@ -967,45 +1369,55 @@ libzerocoin::AccumulatorWitness CZerocoinState::GetWitnessForSpend(CChain *chain
 
     assert(coinId == id);
 
-    libzerocoin::Params *zcParams = useModulusV2 ? ZCParamsV2 : ZCParams;
-    bool nativeModulusIsV2 = IsZerocoinTxV2((libzerocoin::CoinDenomination)denomination, Params().GetConsensus(), id);
-    decltype(&CBlockIndex::accumulatorChanges) accChangeField;
-    if (nativeModulusIsV2 != useModulusV2) {
-        CalculateAlternativeModulusAccumulatorValues(chain, denomination, id);
-        accChangeField = &CBlockIndex::alternativeAccumulatorChanges;
-    }
-    else {
-        accChangeField = &CBlockIndex::accumulatorChanges;
+    CBlockIndex *mintBlock = (*chain)[mintHeight];
+    bool fFromScratch = fromHeight < mintHeight;
+
+    newCoins.clear();
+
+    if (fFromScratch) {
+        libzerocoin::Params *zcParams = useModulusV2 ? ZCParamsV2 : ZCParams;
+        bool nativeModulusIsV2 = IsZerocoinTxV2((libzerocoin::CoinDenomination)denomination, Params().GetConsensus(), id);
+        bool fAlternativeModulus = nativeModulusIsV2 != useModulusV2;
+        if (fAlternativeModulus && !CalculateAlternativeModulusAccumulatorValues(chain, denomination, id))
+            throw std::runtime_error("GetWitnessUpdate: can't read zerocoin data of the coin group");
+
+        // Find accumulator value preceding mint operation
+        CBlockIndex *block = mintBlock;
+        witnessStart = zcParams->accumulatorParams.accumulatorBase;
+        if (block != coinGroup.firstBlock) {
+            const CAccumulatorCheckpoint *checkpoint;
+            do {
+                block = block->pprev;
+            } while ((checkpoint = FindAccumulatorCheckpoint(denomAndId, block)) == NULL);
+            witnessStart = fAlternativeModulus ? checkpoint->alternativeAccumulatorValue : checkpoint->accumulatorValue;
+        }
+
+        fromHeight = mintHeight - 1;
     }
 
-    // Find accumulator value preceding mint operation
-    CBlockIndex *mintBlock = (*chain)[mintHeight];
-    CBlockIndex *block = mintBlock;
-    libzerocoin::Accumulator accumulator(zcParams, d);
-    if (block != coinGroup.firstBlock) {
-        do {
-            block = block->pprev;
-        } while ((block->*accChangeField).count(denomAndId) == 0);
-        accumulator = libzerocoin::Accumulator(zcParams, (block->*accChangeField)[denomAndId].first, d);
+    // Collect every coin minted after fromHeight except pubCoin, oldest blocks first
+    vector<CBlockIndex *> blocksWithMints;
+    for (CBlockIndex *block = coinGroup.lastBlock; block && block->nHeight > fromHeight; block = block->pprev) {
+        if (block->nHeight <= maxHeight && FindAccumulatorCheckpoint(denomAndId, block))
+            blocksWithMints.push_back(block);
+        if (block == coinGroup.firstBlock)
+            break;
     }
 
-    // Now add to the accumulator every coin minted since that moment except pubCoin
-    block = coinGroup.lastBlock;
-    for (;;) {
-        if (block->nHeight <= maxHeight && block->mintedPubCoins.count(denomAndId) > 0) {
-            vector<CBigNum> &pubCoins = block->mintedPubCoins[denomAndId];
-            for (const CBigNum &coin: pubCoins) {
-                if (block != mintBlock || coin != pubCoin)
-                    accumulator += libzerocoin::PublicCoin(zcParams, coin, d);
+    for (auto it = blocksWithMints.rbegin(); it != blocksWithMints.rend(); ++it) {
+        std::shared_ptr<const CZerocoinBlockData> blockData;
+        if (!ZerocoinGetBlockData(*it, blockData))
+            throw std::runtime_error("GetWitnessUpdate: can't read zerocoin data of the coin group");
+        auto pubCoins = blockData->mintedPubCoins.find(denomAndId);
+        if (pubCoins != blockData->mintedPubCoins.end()) {
+            for (const CBigNum &coin: pubCoins->second) {
+                if (*it != mintBlock || coin != pubCoin)
+                    newCoins.push_back(coin);
             }
         }
-        if (block != mintBlock)
-            block = block->pprev;
-        else
-            break;
     }
 
-    return libzerocoin::AccumulatorWitness(zcParams, accumulator, libzerocoin::PublicCoin(zcParams, pubCoin, d));
+    return fFromScratch;
 }
 
 int CZerocoinState::GetMintedCoinHeightAndId(const CBigNum &pubCoin, int denomination, int &id) {
@@ -1021,7 +1433,7 @@ int CZerocoinState::GetMintedCoinHeightAndId(const CBigNum &pubCoin, int denomin
         return -1;
 }
 
-void CZerocoinState::CalculateAlternativeModulusAccumulatorValues(CChain *chain, int denomination, int id) {
+bool CZerocoinState::CalculateAlternativeModulusAccumulatorValues(CChain *chain, int denomination, int id) {
     libzerocoin::CoinDenomination d = (libzerocoin::CoinDenomination)denomination;
     pair<int, int> denomAndId = pair<int, int>(denomination, id);
     libzerocoin::Params *altParams = IsZerocoinTxV2(d, Params().GetConsensus(), id) ? ZCParams : ZCParamsV2;
@@ -1029,25 +1441,31 @@ void CZerocoinState::CalculateAlternativeModulusAccumulatorValues(CChain *chain,
 
     if (coinGroups.count(denomAndId) == 0) {
         // Can happen when verification is done prior to syncing with network
-        return;
+        return true;
     }
 
     CoinGroupInfo coinGroup = coinGroups[denomAndId];
 
     CBlockIndex *block = coinGroup.firstBlock;
     for (;;) {
-        if (block->accumulatorChanges.count(denomAndId) > 0) {
-            if (block->alternativeAccumulatorChanges.count(denomAndId) > 0)
+        CAccumulatorCheckpoint *checkpoint = FindAccumulatorCheckpointToUpdate(denomAndId, block);
+        if (checkpoint) {
+            if (checkpoint->alternativeAccumulatorValue != 0)
                 // already calculated, update accumulator with cached value
-                accumulator = libzerocoin::Accumulator(altParams, block->alternativeAccumulatorChanges[denomAndId].first, d);
+                accumulator = libzerocoin::Accumulator(altParams, checkpoint->alternativeAccumulatorValue, d);
             else {
                 // re-create accumulator changes with alternative params
-                assert(block->mintedPubCoins.count(denomAndId) > 0);
-                const vector<CBigNum> &mintedCoins = block->mintedPubCoins[denomAndId];
+                std::shared_ptr<const CZerocoinBlockData> blockData;
+                if (!ZerocoinGetBlockData(block, blockData))
+                    return false;
+                assert(blockData->mintedPubCoins.count(denomAndId) > 0);
+                const vector<CBigNum> &mintedCoins = blockData->mintedPubCoins.at(denomAndId);
+                vector<libzerocoin::PublicCoin> pubCoins;
                 BOOST_FOREACH(const CBigNum &c, mintedCoins) {
-                    accumulator += libzerocoin::PublicCoin(altParams, c, d);
+                    pubCoins.push_back(libzerocoin::PublicCoin(altParams, c, d));
                 }
-                block->alternativeAccumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), (int)mintedCoins.size());
+                accumulator.accumulate(pubCoins);
+                checkpoint->alternativeAccumulatorValue = accumulator.getValue();
             }
         }
 
@@ -1056,6 +1474,8 @@ void CZerocoinState::CalculateAlternativeModulusAccumulatorValues(CChain *chain,
         else
             break;
     }
+
+    return true;
 }
 
 bool CZerocoinState::TestValidity(CChain *chain) {
@@ -1069,22 +1489,27 @@ bool CZerocoinState::TestValidity(CChain *chain) {
 
         CBlockIndex *block = coinGroup.second.firstBlock;
         for (;;) {
-            if (block->accumulatorChanges.count(coinGroup.first) > 0) {
-                if (block->mintedPubCoins.count(coinGroup.first) == 0) {
+            const CAccumulatorCheckpoint *checkpoint = FindAccumulatorCheckpoint(coinGroup.first, block);
+            if (checkpoint) {
+                std::shared_ptr<const CZerocoinBlockData> blockData;
+                if (!ZerocoinGetBlockData(block, blockData) || blockData->mintedPubCoins.count(coinGroup.first) == 0) {
                     fprintf(stderr, "  no minted coins\n");
                     return false;
                 }
 
-                BOOST_FOREACH(const CBigNum &pubCoin, block->mintedPubCoins[coinGroup.first]) {
-                    acc += libzerocoin::PublicCoin(zcParams, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first);
+                const vector<CBigNum> &mintedCoins = blockData->mintedPubCoins.at(coinGroup.first);
+                vector<libzerocoin::PublicCoin> pubCoins;
+                BOOST_FOREACH(const CBigNum &pubCoin, mintedCoins) {
+                    pubCoins.push_back(libzerocoin::PublicCoin(zcParams, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first));
                 }
+                acc.accumulate(pubCoins);
 
-                if (acc.getValue() != block->accumulatorChanges[coinGroup.first].first) {
+                if (acc.getValue() != checkpoint->accumulatorValue) {
                     fprintf (stderr, "  accumulator value mismatch at height %d\n", block->nHeight);
                     return false;
                 }
 
-                if (block->accumulatorChanges[coinGroup.first].second != (int)block->mintedPubCoins[coinGroup.first].size()) {
+                if (checkpoint->nMints != (int)mintedCoins.size()) {
                     fprintf(stderr, "  number of minted coins mismatch at height %d\n", block->nHeight);
                     return false;
                 }
@@ -1102,80 +1527,144 @@ bool CZerocoinState::TestValidity(CChain *chain) {
     return true;
 }
 
-set<CBlockIndex *> CZerocoinState::RecalculateAccumulators(CChain *chain) {
-    set<CBlockIndex *> changes;
+bool CZerocoinState::RecalculateAccumulators(CChain *chain, set<CBlockIndex *> &changes, int nVerifiedHeight) {
+    changes.clear();
+
+    // Coin groups are independent from each other and are recalculated in parallel. New accumulator values are
+    // collected by the tasks and applied once all of them are done
+    struct CoinGroupRecalculation {
+        pair<int,int> denomAndId;
+        CoinGroupInfo coinGroup;
+        vector<pair<CBlockIndex *, pair<CBigNum,int>>> newValues;
+        bool fFailed;
+    };
+    vector<CoinGroupRecalculation> recalculations;
 
     BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), CoinGroupInfo) &coinGroup, coinGroups) {
         // Skip non-modulusv2 groups
         if (!IsZerocoinTxV2((libzerocoin::CoinDenomination)coinGroup.first.first, Params().GetConsensus(), coinGroup.first.second))
             continue;
+        // Skip groups verified during previous run
+        if (coinGroup.second.lastBlock->nHeight <= nVerifiedHeight)
+            continue;
+        recalculations.push_back({coinGroup.first, coinGroup.second, {}, false});
+    }
 
-        libzerocoin::Accumulator acc(&ZCParamsV2->accumulatorParams, (libzerocoin::CoinDenomination)coinGroup.first.first);
-
-        // Try to calculate accumulator for the first batch of mints. If it doesn't match we need to recalculate the rest of it
-        CBlockIndex *block = coinGroup.second.firstBlock;
-        for (;;) {
-            if (block->accumulatorChanges.count(coinGroup.first) > 0) {
-                BOOST_FOREACH(const CBigNum &pubCoin, block->mintedPubCoins[coinGroup.first]) {
-                    acc += libzerocoin::PublicCoin(ZCParamsV2, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first);
-                }
-
-                // First block case is special: do the check
-                if (block == coinGroup.second.firstBlock) {
-                    if (acc.getValue() != block->accumulatorChanges[coinGroup.first].first)
-                        // recalculation is needed
-                        LogPrintf("ZerocoinState: accumulator recalculation for denomination=%d, id=%d\n", coinGroup.first.first, coinGroup.first.second);
-                    else
-                        // everything's ok
+    if (recalculations.empty())
+        return true;
+
+    std::mutex csProgress;
+    size_t nDone = 0;
+
+    CExecutorTaskGroup tasks;
+    BOOST_FOREACH(CoinGroupRecalculation &recalculation, recalculations) {
+        tasks.Add([this, &recalculation, &recalculations, &csProgress, &nDone, chain] {
+            const pair<int,int> &denomAndId = recalculation.denomAndId;
+            libzerocoin::Accumulator acc(&ZCParamsV2->accumulatorParams, (libzerocoin::CoinDenomination)denomAndId.first);
+
+            // Try to calculate accumulator for the first batch of mints. If it doesn't match we need to recalculate the rest of it
+            CBlockIndex *block = recalculation.coinGroup.firstBlock;
+            for (;;) {
+                // checkpoints aren't modified until all the tasks are done
+                const CAccumulatorCheckpoint *checkpoint = FindAccumulatorCheckpoint(denomAndId, block);
+                if (checkpoint) {
+                    std::shared_ptr<const CZerocoinBlockData> blockData;
+                    if (!ZerocoinGetBlockData(block, blockData)) {
+                        recalculation.fFailed = true;
                         break;
+                    }
+                    const vector<CBigNum> &mintedCoins = blockData->mintedPubCoins.at(denomAndId);
+                    vector<libzerocoin::PublicCoin> pubCoins;
+                    BOOST_FOREACH(const CBigNum &pubCoin, mintedCoins) {
+                        pubCoins.push_back(libzerocoin::PublicCoin(ZCParamsV2, pubCoin, (libzerocoin::CoinDenomination)denomAndId.first));
+                    }
+                    acc.accumulate(pubCoins);
+
+                    // First block case is special: do the check
+                    if (block == recalculation.coinGroup.firstBlock) {
+                        if (acc.getValue() != checkpoint->accumulatorValue)
+                            // recalculation is needed
+                            LogPrintf("ZerocoinState: accumulator recalculation for denomination=%d, id=%d\n", denomAndId.first, denomAndId.second);
+                        else
+                            // everything's ok
+                            break;
+                    }
+
+                    recalculation.newValues.push_back(make_pair(block, make_pair(acc.getValue(), (int)mintedCoins.size())));
                 }
 
-                block->accumulatorChanges[coinGroup.first] = make_pair(acc.getValue(), (int)block->mintedPubCoins[coinGroup.first].size());
-                changes.insert(block);
+                if (block != recalculation.coinGroup.lastBlock)
+                    block = (*chain)[block->nHeight+1];
+                else
+                    break;
             }
 
-            if (block != coinGroup.second.lastBlock)
-                block = (*chain)[block->nHeight+1];
-            else
-                break;
+            std::unique_lock<std::mutex> lock(csProgress);
+            uiInterface.InitMessage(strprintf(_("Verifying zerocoin accumulators... (%u/%u)"), ++nDone, recalculations.size()));
+        });
+    }
+    tasks.Wait();
+
+    BOOST_FOREACH(const CoinGroupRecalculation &recalculation, recalculations) {
+        if (recalculation.fFailed)
+            return false;
+    }
+
+    BOOST_FOREACH(const CoinGroupRecalculation &recalculation, recalculations) {
+        BOOST_FOREACH(const PAIRTYPE(CBlockIndex *, PAIRTYPE(CBigNum,int)) &newValue, recalculation.newValues) {
+            CBlockIndex *block = newValue.first;
+            AddAccumulatorCheckpoint(block, recalculation.denomAndId.first, recalculation.denomAndId.second,
+                                     newValue.second.first, newValue.second.second);
+
+            // block data is written with the index entries returned in changes
+            std::shared_ptr<const CZerocoinBlockData> blockData;
+            if (!ZerocoinGetBlockData(block, blockData))
+                return false;
+            CZerocoinBlockData newBlockData(*blockData);
+            newBlockData.accumulatorChanges[recalculation.denomAndId] = newValue.second;
+            ZerocoinWriteBlockData(block, newBlockData);
+            changes.insert(block);
         }
     }
 
-    return changes;
+    return true;
 }
 
 bool CZerocoinState::AddSpendToMempool(const vector<CBigNum> &coinSerials, uint256 txHash) {
     BOOST_FOREACH(CBigNum coinSerial, coinSerials){
-        if (IsUsedCoinSerial(coinSerial) || mempoolCoinSerials.count(coinSerial))
+        uint256 serialDigest = GetZerocoinSerialDigest(coinSerial);
+        if (IsUsedCoinSerial(coinSerial) || mempoolCoinSerials.count(serialDigest))
             return false;
 
-        mempoolCoinSerials[coinSerial] = txHash;        
+        mempoolCoinSerials[serialDigest] = txHash;
     }
 
     return true;
 }
 
 bool CZerocoinState::AddSpendToMempool(const CBigNum &coinSerial, uint256 txHash) {
-    if (IsUsedCoinSerial(coinSerial) || mempoolCoinSerials.count(coinSerial))
+    uint256 serialDigest = GetZerocoinSerialDigest(coinSerial);
+    if (IsUsedCoinSerial(coinSerial) || mempoolCoinSerials.count(serialDigest))
         return false;
 
-    mempoolCoinSerials[coinSerial] = txHash;
+    mempoolCoinSerials[serialDigest] = txHash;
     return true;
 }
 
 void CZerocoinState::RemoveSpendFromMempool(const CBigNum &coinSerial) {
-    mempoolCoinSerials.erase(coinSerial);
+    mempoolCoinSerials.erase(GetZerocoinSerialDigest(coinSerial));
 }
 
 uint256 CZerocoinState::GetMempoolConflictingTxHash(const CBigNum &coinSerial) {
-    if (mempoolCoinSerials.count(coinSerial) == 0)
+    auto entry = mempoolCoinSerials.find(GetZerocoinSerialDigest(coinSerial));
+    if (entry == mempoolCoinSerials.end())
         return uint256();
 
-    return mempoolCoinSerials[coinSerial];
+    return entry->second;
 }
 
 bool CZerocoinState::CanAddSpendToMempool(const CBigNum &coinSerial) {
-    return !IsUsedCoinSerial(coinSerial) && mempoolCoinSerials.count(coinSerial) == 0;
+    return !IsUsedCoinSerial(coinSerial) && mempoolCoinSerials.count(GetZerocoinSerialDigest(coinSerial)) == 0;
 }
 
 void CZerocoinState::Reset() {
@@ -1184,6 +1673,7 @@ void CZerocoinState::Reset() {
     mintedPubCoins.clear();
     latestCoinIds.clear();
     mempoolCoinSerials.clear();
+    accumulatorCheckpoints.clear();
 }
 
 CZerocoinState *CZerocoinState::GetZerocoinState() {
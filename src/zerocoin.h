@@ -7,13 +7,18 @@
 #include "consensus/validation.h"
 #include "libzerocoin/Zerocoin.h"
 #include "zerocoin_params.h"
+#include "zerocoin_serialset.h"
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 
 // zerocoin parameters
 extern libzerocoin::Params *ZCParams, *ZCParamsV2;
 
+// Limit of the cache of zerocoin checks that passed, in MiB
+static const unsigned int DEFAULT_MAX_ZEROCOIN_CACHE_SIZE = 4;
+
 // Test for zerocoin transaction version 2
 inline bool IsZerocoinTxV2(libzerocoin::CoinDenomination denomination, const Consensus::Params &params, int coinId) {
 	return ((denomination == libzerocoin::ZQ_LOVELACE) && (coinId >= params.nSpendV2ID_1))
@@ -40,9 +45,23 @@ public:
     // information about transactions in the block is complete
     bool fInfoIsComplete;
 
+    // v1.5/v2 spends with known accumulator value. Their proofs are verified all together once all
+    // the transactions of the block are checked
+    struct CSpendToVerify {
+        uint256 txHash;
+        std::shared_ptr<libzerocoin::CoinSpend> spend;
+        libzerocoin::Accumulator accumulator;
+        libzerocoin::SpendMetaData metaData;
+        // entry of the zerocoin validation cache recorded once the proof passes, null if none
+        uint256 cacheEntry;
+    };
+    vector<CSpendToVerify> spendsToVerify;
+
     CZerocoinTxInfo(): fHasSpendV1(false), fInfoIsComplete(false) {}
     // finalize everything
     void Complete();
+    // verify proofs of all the spends collected so far, returns false if any of them is invalid
+    bool VerifySpends();
 };
 
 bool CheckZerocoinFoundersInputs(const CTransaction &tx, CValidationState &state, const Consensus::Params &params, int nHeight, bool fMTP);
@@ -56,7 +75,7 @@ bool CheckZerocoinTransaction(const CTransaction &tx,
     bool fZerocoinStateCheck,
     CZerocoinTxInfo *zerocoinTxInfo);
 
-void DisconnectTipZC(CBlock &block, CBlockIndex *pindexDelete);
+bool DisconnectTipZC(CBlock &block, CBlockIndex *pindexDelete);
 bool ConnectBlockZC(CValidationState &state, const CChainParams &chainparams, CBlockIndex *pindexNew, const CBlock *pblock, bool fJustCheck=false);
 
 int ZerocoinGetNHeight(const CBlockHeader &block);
@@ -65,6 +84,21 @@ bool ZerocoinBuildStateFromIndex(CChain *chain, set<CBlockIndex *> &changes);
 
 CBigNum ZerocoinGetSpendSerialNumber(const CTransaction &tx, const CTxIn &txin);
 
+// Get <serial,denomination> of every zerocoin spend and the denomination of every mint of the block, in block order.
+// Spends that can't be parsed are skipped
+void ZerocoinGetSupplyChanges(const CBlock &block, vector<pair<CBigNum,int> > &spends, vector<int> &mints);
+
+// Get mints and spends of the block from the block index database (through the cache). Returns empty data
+// if there are none, false if the data can't be read
+bool ZerocoinGetBlockData(const CBlockIndex *index, std::shared_ptr<const CZerocoinBlockData> &blockData);
+// Set mints and spends of the block and update BLOCK_HAVE_ZEROCOIN flag of the index. The caller marks the index
+// dirty, the data is written to the block index database together with it
+void ZerocoinWriteBlockData(CBlockIndex *index, const CZerocoinBlockData &data);
+// Get block data changed since the last block index flush. Empty data means the record is to be erased
+void ZerocoinGetDirtyBlockData(vector<pair<uint256, std::shared_ptr<const CZerocoinBlockData>>> &blockData);
+// Forget the dirty state of block data written to the block index database
+void ZerocoinBlockDataFlushed(const vector<pair<uint256, std::shared_ptr<const CZerocoinBlockData>>> &blockData);
+
 /*
  * State of minted/spent coins as extracted from the index
  */
@@ -82,12 +116,34 @@ public:
         int nCoins;
     };
 
+    // Accumulator value recorded after the block that changed it for given denomination and id. This is the only
+    // in-memory copy of accumulator values, block index database keeps them in CZerocoinBlockData
+    struct CAccumulatorCheckpoint {
+        CAccumulatorCheckpoint() : block(NULL), nHeight(0), nMints(0) {}
+
+        // block where accumulator was changed
+        CBlockIndex *block;
+        // height of this block
+        int nHeight;
+        // accumulator value after this block (native modulus)
+        CBigNum accumulatorValue;
+        // number of coins with given denomination and id minted in this block
+        int nMints;
+        // accumulator value after this block with alternative modulus, zero until calculated
+        CBigNum alternativeAccumulatorValue;
+    };
+
 private:
     // Custom hash for big numbers
     struct CBigNumHash {
         std::size_t operator()(const CBigNum &bn) const noexcept;
     };
 
+    // Custom hash for <<denomination,id>,block hash> keys
+    struct CAccumulatorCheckpointKeyHash {
+        std::size_t operator()(const pair<pair<int,int>,uint256> &key) const noexcept;
+    };
+
     struct CMintedCoinInfo {
         int         denomination;
         int         id;
@@ -100,30 +156,45 @@ private:
     unordered_multimap<CBigNum,CMintedCoinInfo,CBigNumHash> mintedPubCoins;
     // Latest IDs of coins by denomination
     map<int, int> latestCoinIds;
+    // Index of accumulator values. Map from <<denomination,id>,block hash> to CAccumulatorCheckpoint structure
+    unordered_map<pair<pair<int,int>,uint256>,CAccumulatorCheckpoint,CAccumulatorCheckpointKeyHash> accumulatorCheckpoints;
+
+    // Find checkpoint to store alternative accumulator value in
+    CAccumulatorCheckpoint *FindAccumulatorCheckpointToUpdate(const pair<int,int> &denomAndId, const CBlockIndex *index);
 
 
 public:
     CZerocoinState();
 
-    // Set of all used coin serials. Allows multiple entries for the same coin serial for historical reasons
-    unordered_multiset<CBigNum,CBigNumHash> usedCoinSerials;
+    // Set of all used coin serials
+    CZerocoinSerialSet usedCoinSerials;
 
-    // serials of spends currently in the mempool mapped to tx hashes
-    unordered_map<CBigNum,uint256,CBigNumHash> mempoolCoinSerials;
+    // digests of serials of spends currently in the mempool mapped to tx hashes
+    unordered_map<uint256,uint256,CZerocoinSerialHasher> mempoolCoinSerials;
 
     // Add mint, automatically assigning id to it. Returns id and previous accumulator value (if any)
     int AddMint(CBlockIndex *index, int denomination, const CBigNum &pubCoin, CBigNum &previousAccValue);
     // Add serial to the list of used ones
     void AddSpend(const CBigNum &serial);
 
-    // Add everything from the block to the state
-    void AddBlock(CBlockIndex *index, const Consensus::Params &params);
-    // Disconnect block from the chain rolling back mints and spends
-    void RemoveBlock(CBlockIndex *index);
+    // Add everything from the block to the state. Returns false if zerocoin data of the block can't be read
+    bool AddBlock(CBlockIndex *index, const Consensus::Params &params);
+    // Disconnect block from the chain rolling back mints and spends. Returns false if zerocoin data of the block
+    // can't be read, the state is left unchanged then
+    bool RemoveBlock(CBlockIndex *index);
 
     // Query coin group with given denomination and id
     bool GetCoinGroupInfo(int denomination, int id, CoinGroupInfo &result);
 
+    // Record accumulator value for given denomination and id after the block along with the number of coins minted in it
+    void AddAccumulatorCheckpoint(CBlockIndex *index, int denomination, int id, const CBigNum &accumulatorValue, int nMints);
+    // Query accumulator value for given denomination and id after the block with given hash
+    bool GetAccumulatorCheckpoint(int denomination, int id, const uint256 &blockHash, CAccumulatorCheckpoint &result);
+    // Find the checkpoint without copying it, returns NULL if the block didn't change accumulator for given
+    // denomination and id
+    const CAccumulatorCheckpoint *FindAccumulatorCheckpoint(const pair<int,int> &denomAndId, const uint256 &blockHash) const;
+    const CAccumulatorCheckpoint *FindAccumulatorCheckpoint(const pair<int,int> &denomAndId, const CBlockIndex *index) const;
+
     // Query if the coin serial was previously used
     bool IsUsedCoinSerial(const CBigNum &coinSerial);
     // Query if there is a coin with given pubCoin value
@@ -137,11 +208,18 @@ public:
     // Get witness
     libzerocoin::AccumulatorWitness GetWitnessForSpend(CChain *chain, int maxHeight, int denomination, int id, const CBigNum &pubCoin, bool useModulusV2);
 
+    // Get data needed to advance the witness of pubCoin from the block at fromHeight to the block at maxHeight:
+    // coins minted in between are returned in newCoins. If fromHeight is below the height of the mint block the
+    // witness is calculated from scratch, its starting value is stored in witnessStart and true is returned
+    bool GetWitnessUpdate(CChain *chain, int fromHeight, int maxHeight, int denomination, int id, const CBigNum &pubCoin,
+                          bool useModulusV2, CBigNum &witnessStart, std::vector<CBigNum> &newCoins);
+
     // Return height of mint transaction and id of minted coin
     int GetMintedCoinHeightAndId(const CBigNum &pubCoin, int denomination, int &id);
 
     // If needed calculate accumulators for alternative accumulator modulus
-    void CalculateAlternativeModulusAccumulatorValues(CChain *chain, int denomination, int id);
+    // Returns false if zerocoin data of the coin group can't be read
+    bool CalculateAlternativeModulusAccumulatorValues(CChain *chain, int denomination, int id);
 
     // Reset to initial values
     void Reset();
@@ -149,9 +227,10 @@ public:
     // Test function
     bool TestValidity(CChain *chain);
 
-    // Recalculate accumulators. Needed if upgrade from pre-modulusv2 version is detected
-    // Returns set of indices that changed
-    set<CBlockIndex *> RecalculateAccumulators(CChain *chain);
+    // Recalculate accumulators. Needed if upgrade from pre-modulusv2 version is detected. Coin groups are processed
+    // in parallel, groups ending at or below nVerifiedHeight were verified earlier and are skipped
+    // Stores set of indices that changed in changes, returns false if zerocoin data can't be read
+    bool RecalculateAccumulators(CChain *chain, set<CBlockIndex *> &changes, int nVerifiedHeight = -1);
 
     // Check if there is a conflicting tx in the blockchain or mempool
     bool CanAddSpendToMempool(const CBigNum &coinSerial);
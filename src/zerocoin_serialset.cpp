@@ -0,0 +1,176 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "zerocoin_serialset.h"
+
+#include "crypto/sha256.h"
+#include "random.h"
+
+#include <limits>
+
+// Minimum number of table slots, filter needs at least one block
+static const size_t MIN_SERIAL_SET_SLOTS = 64;
+// Number of filter bits set for every element
+static const int SERIAL_FILTER_HASHES = 4;
+
+uint256 GetZerocoinSerialDigest(const CBigNum &serial)
+{
+    uint256 digest;
+    const BIGNUM *bn = &serial;
+    int nBytes = BN_num_bytes(bn);
+    if (!BN_is_negative(bn) && nBytes <= (int)digest.size()) {
+        BN_bn2bin(bn, digest.begin() + digest.size() - nBytes);
+        return digest;
+    }
+
+    std::vector<unsigned char> vch = serial.getvch();
+    CSHA256().Write(vch.data(), vch.size()).Finalize(digest.begin());
+    return digest;
+}
+
+CZerocoinSerialHasher::CZerocoinSerialHasher() :
+    k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+// CZerocoinSerialSet
+
+CZerocoinSerialSet::CZerocoinSerialSet() : nElements(0) {}
+
+void CZerocoinSerialSet::SetUsed(size_t nSlot, bool fUsed)
+{
+    if (fUsed)
+        slotUsed[nSlot >> 6] |= (uint64_t)1 << (nSlot & 63);
+    else
+        slotUsed[nSlot >> 6] &= ~((uint64_t)1 << (nSlot & 63));
+}
+
+// Filter block is selected by the upper bits of the hash, bit positions inside the block by the lower 36 bits
+void CZerocoinSerialSet::AddToFilter(uint64_t nHash)
+{
+    uint64_t *block = &filter[((nHash >> 36) & (filter.size() / 8 - 1)) * 8];
+    for (int i = 0; i < SERIAL_FILTER_HASHES; i++) {
+        unsigned int nBit = (nHash >> (9 * i)) & 511;
+        block[nBit >> 6] |= (uint64_t)1 << (nBit & 63);
+    }
+}
+
+bool CZerocoinSerialSet::FilterContains(uint64_t nHash) const
+{
+    const uint64_t *block = &filter[((nHash >> 36) & (filter.size() / 8 - 1)) * 8];
+    for (int i = 0; i < SERIAL_FILTER_HASHES; i++) {
+        unsigned int nBit = (nHash >> (9 * i)) & 511;
+        if (!((block[nBit >> 6] >> (nBit & 63)) & 1))
+            return false;
+    }
+    return true;
+}
+
+size_t CZerocoinSerialSet::Find(const uint256 &digest, uint64_t nHash) const
+{
+    size_t nMask = slots.size() - 1;
+    for (size_t nSlot = nHash & nMask; IsUsed(nSlot); nSlot = (nSlot + 1) & nMask) {
+        if (slots[nSlot] == digest)
+            return nSlot;
+    }
+    return slots.size();
+}
+
+void CZerocoinSerialSet::InsertNew(const uint256 &digest, uint64_t nHash)
+{
+    size_t nMask = slots.size() - 1;
+    size_t nSlot = nHash & nMask;
+    while (IsUsed(nSlot))
+        nSlot = (nSlot + 1) & nMask;
+
+    slots[nSlot] = digest;
+    SetUsed(nSlot, true);
+    AddToFilter(nHash);
+    nElements++;
+}
+
+void CZerocoinSerialSet::Resize(size_t nSlots)
+{
+    std::vector<uint256> oldSlots;
+    std::vector<uint64_t> oldSlotUsed;
+    oldSlots.swap(slots);
+    oldSlotUsed.swap(slotUsed);
+
+    slots.resize(nSlots);
+    slotUsed.assign((nSlots + 63) / 64, 0);
+    filter.assign(nSlots / 8, 0);
+    nElements = 0;
+
+    for (size_t i = 0; i < oldSlots.size(); i++) {
+        if ((oldSlotUsed[i >> 6] >> (i & 63)) & 1)
+            InsertNew(oldSlots[i], hasher(oldSlots[i]));
+    }
+}
+
+bool CZerocoinSerialSet::insert(const CBigNum &serial)
+{
+    uint256 digest = GetZerocoinSerialDigest(serial);
+    uint64_t nHash = hasher(digest);
+
+    if (nElements > 0 && FilterContains(nHash) && Find(digest, nHash) != slots.size())
+        return false;
+
+    // keep the load factor at or below 3/4
+    if ((nElements + 1) * 4 > slots.size() * 3)
+        Resize(std::max(MIN_SERIAL_SET_SLOTS, slots.size() * 2));
+
+    InsertNew(digest, nHash);
+    return true;
+}
+
+size_t CZerocoinSerialSet::erase(const CBigNum &serial)
+{
+    if (nElements == 0)
+        return 0;
+
+    uint256 digest = GetZerocoinSerialDigest(serial);
+    size_t nSlot = Find(digest, hasher(digest));
+    if (nSlot == slots.size())
+        return 0;
+
+    // Backward shift deletion: move up the following elements of the cluster that can't be reached
+    // from their home slot through the emptied one
+    size_t nMask = slots.size() - 1;
+    for (size_t nNext = (nSlot + 1) & nMask; IsUsed(nNext); nNext = (nNext + 1) & nMask) {
+        size_t nHome = hasher(slots[nNext]) & nMask;
+        bool fStays = nSlot <= nNext ? (nSlot < nHome && nHome <= nNext) : (nSlot < nHome || nHome <= nNext);
+        if (!fStays) {
+            slots[nSlot] = slots[nNext];
+            nSlot = nNext;
+        }
+    }
+
+    SetUsed(nSlot, false);
+    nElements--;
+    return 1;
+}
+
+size_t CZerocoinSerialSet::count(const CBigNum &serial) const
+{
+    if (nElements == 0)
+        return 0;
+
+    uint256 digest = GetZerocoinSerialDigest(serial);
+    uint64_t nHash = hasher(digest);
+    if (!FilterContains(nHash))
+        return 0;
+
+    return Find(digest, nHash) != slots.size() ? 1 : 0;
+}
+
+void CZerocoinSerialSet::clear()
+{
+    std::vector<uint256>().swap(slots);
+    std::vector<uint64_t>().swap(slotUsed);
+    std::vector<uint64_t>().swap(filter);
+    nElements = 0;
+}
+
+size_t CZerocoinSerialSet::DynamicMemoryUsage() const
+{
+    return slots.capacity() * sizeof(uint256) + (slotUsed.capacity() + filter.capacity()) * sizeof(uint64_t);
+}
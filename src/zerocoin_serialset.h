@@ -0,0 +1,80 @@
+// Copyright (c) 2019 The Zcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_ZEROCOIN_SERIALSET_H
+#define BITCOIN_ZEROCOIN_SERIALSET_H
+
+#include "hash.h"
+#include "uint256.h"
+#include "libzerocoin/bitcoin_bignum/bignum.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Fixed width key of the coin serial. Non-negative serials of up to 256 bits (every valid serial) are stored
+ * as is (big endian, zero padded), anything else is hashed with SHA256
+ */
+uint256 GetZerocoinSerialDigest(const CBigNum &serial);
+
+/** Salted hasher of serial digests */
+class CZerocoinSerialHasher
+{
+private:
+    uint64_t k0, k1;
+
+public:
+    CZerocoinSerialHasher();
+
+    size_t operator()(const uint256 &digest) const {
+        return SipHashUint256(k0, k1, digest);
+    }
+};
+
+/**
+ * Set of coin serials stored as 32-byte digests in the open addressing table with linear probing. Blocked
+ * Bloom filter in front of the table answers most of the queries for serials that are not in the set without
+ * touching the table. Lookups don't allocate memory.
+ *
+ * Erasing an element doesn't clear its bits in the filter (it only gets a bit less selective), the filter is
+ * rebuilt every time the table is resized.
+ */
+class CZerocoinSerialSet
+{
+public:
+    CZerocoinSerialSet();
+
+    //! Returns false if the serial is already in the set
+    bool insert(const CBigNum &serial);
+    //! Returns number of erased elements (0 or 1)
+    size_t erase(const CBigNum &serial);
+    size_t count(const CBigNum &serial) const;
+    void clear();
+
+    size_t size() const { return nElements; }
+    bool empty() const { return nElements == 0; }
+    size_t DynamicMemoryUsage() const;
+
+private:
+    CZerocoinSerialHasher hasher;
+    //! Table slots, number of slots is zero or a power of two
+    std::vector<uint256> slots;
+    //! Bitmap of occupied slots
+    std::vector<uint64_t> slotUsed;
+    //! Filter bits, one 512-bit block per 64 slots
+    std::vector<uint64_t> filter;
+    size_t nElements;
+
+    bool IsUsed(size_t nSlot) const { return (slotUsed[nSlot >> 6] >> (nSlot & 63)) & 1; }
+    void SetUsed(size_t nSlot, bool fUsed);
+
+    //! Returns index of the slot holding digest or slots.size() if not found
+    size_t Find(const uint256 &digest, uint64_t nHash) const;
+    void InsertNew(const uint256 &digest, uint64_t nHash);
+    void AddToFilter(uint64_t nHash);
+    bool FilterContains(uint64_t nHash) const;
+    void Resize(size_t nSlots);
+};
+
+#endif // BITCOIN_ZEROCOIN_SERIALSET_H
@@ -176,6 +176,14 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
             return false;
         }
 
+        // Zcoin - MTP
+        // Subscribers can't deserialize a block without MTP proof data, skip it
+        if (block.fMTPDataPruned)
+        {
+            LogPrint("zmq", "zmq: Skip rawblock %s without MTP data\n", pindex->GetBlockHash().GetHex());
+            return true;
+        }
+
         ss << block;
     }
 